@@ -46,6 +46,10 @@
 #include <opencv2/calib3d/calib3d.hpp>
 #include <opencv2/highgui/highgui.hpp>
 
+#ifdef VISP_HAVE_OPENMP
+#include <omp.h>
+#endif
+
 #include <visp3/vision/vpCalibration.h>
 
 #include <visp3/gui/vpDisplayX.h>
@@ -177,46 +181,69 @@ int main(int argc, const char ** argv)
       }
     }
 
+    // Calibration on a single mono image is used to initialize each view
+    vpCalibration::setLambda(0.5);
+
+    // Frames are decoded by batches; the grid detection and the
+    // calibration of the frames of a batch are done in parallel, then the
+    // results are displayed and accumulated in the frame order.
+#ifdef VISP_HAVE_OPENMP
+    const size_t batchSize = 2 * (size_t)omp_get_max_threads();
+#else
+    const size_t batchSize = 1;
+#endif
+    std::vector<vpImage<unsigned char> > batch(batchSize);
+    std::vector<long> batchIndex(batchSize);
+    std::vector<std::vector<vpImagePoint> > batchData(batchSize);
+    std::vector<vpCalibration> batchCalib(batchSize);
+    std::vector<int> batchStatus(batchSize);
+    std::vector<std::string> batchError(batchSize);
+
     while(! reader.end()) {
-      reader.acquire(I);
-      long frame_index = reader.getFrameIndex();
-      vpDisplay::display(I);
-
-      cv::Mat cvI;
-      std::vector<cv::Point2f> pointBuf;
-      vpImageConvert::convert(I, cvI);
-
-      bool found = false;
-      switch( s.calibrationPattern ) // Find feature points on the input format
-      {
-      case Settings::CHESSBOARD:
-        //std::cout << "Use chessboard " << std::endl;
-        found = findChessboardCorners( cvI, s.boardSize, pointBuf,
+      size_t nbFrames = 0;
+      while(nbFrames < batchSize && ! reader.end()) {
+        reader.acquire(batch[nbFrames]);
+        batchIndex[nbFrames] = reader.getFrameIndex();
+        nbFrames ++;
+      }
+
+#ifdef VISP_HAVE_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+      for (int k=0; k < (int)nbFrames; k++) {
+        const vpImage<unsigned char> &Ik = batch[(size_t)k];
+        std::vector<vpImagePoint> &data = batchData[(size_t)k];
+        int &status = batchStatus[(size_t)k]; // 0: not found, 1: found, 2: found and calibrated
+        data.clear();
+        status = 0;
+        batchError[(size_t)k].clear();
+
+        cv::Mat cvI;
+        std::vector<cv::Point2f> pointBuf;
+        vpImageConvert::convert(Ik, cvI);
+
+        bool found = false;
+        switch( s.calibrationPattern ) // Find feature points on the input format
+        {
+        case Settings::CHESSBOARD:
+          found = findChessboardCorners( cvI, s.boardSize, pointBuf,
 #if (VISP_HAVE_OPENCV_VERSION >= 0x030000)
-                                       cv::CALIB_CB_ADAPTIVE_THRESH | cv::CALIB_CB_FAST_CHECK | cv::CALIB_CB_NORMALIZE_IMAGE);
+                                         cv::CALIB_CB_ADAPTIVE_THRESH | cv::CALIB_CB_FAST_CHECK | cv::CALIB_CB_NORMALIZE_IMAGE);
 #else
-                                       CV_CALIB_CB_ADAPTIVE_THRESH | CV_CALIB_CB_FAST_CHECK | CV_CALIB_CB_NORMALIZE_IMAGE);
+                                         CV_CALIB_CB_ADAPTIVE_THRESH | CV_CALIB_CB_FAST_CHECK | CV_CALIB_CB_NORMALIZE_IMAGE);
 #endif
           break;
-      case Settings::CIRCLES_GRID:
-        //std::cout << "Use circle grid " << std::endl;
-        found = findCirclesGrid( cvI, s.boardSize, pointBuf, cv::CALIB_CB_SYMMETRIC_GRID  );
-        break;
-      case Settings::UNDEFINED:
-      default:
-        std::cout << "Unkown calibration grid " << std::endl;
-        break;
-      }
-
-      std::cout << "frame: " << frame_index << ", status: " << found;
-      if (!found)
-        std::cout << ", image rejected" << std::endl;
-      else
-        std::cout << ", image used as input data" << std::endl;
+        case Settings::CIRCLES_GRID:
+          found = findCirclesGrid( cvI, s.boardSize, pointBuf, cv::CALIB_CB_SYMMETRIC_GRID  );
+          break;
+        case Settings::UNDEFINED:
+        default:
+          break;
+        }
 
-      if ( found)                // If done with success,
-      {
-        std::vector<vpImagePoint> data;
+        if (! found)
+          continue;
+        status = 1;
 
         if (s.calibrationPattern == Settings::CHESSBOARD) {
           // improve the found corners' coordinate accuracy for chessboard
@@ -228,18 +255,12 @@ int main(int argc, const char ** argv)
                         cv::TermCriteria( CV_TERMCRIT_EPS+CV_TERMCRIT_ITER, 30, 0.1 ));
 #endif
         }
-        std::stringstream ss;
-        ss << "image " << frame_index;
-        vpDisplay::setTitle(I, ss.str());
         for (unsigned int i=0; i < pointBuf.size(); i++) {
-          vpImagePoint ip(pointBuf[i].y, pointBuf[i].x);
-          data.push_back(ip);
-          vpDisplay::displayCross(I, ip, 10, vpColor::red);
+          data.push_back(vpImagePoint(pointBuf[i].y, pointBuf[i].x));
         }
 
         // Calibration on a single mono image
-        vpCalibration calib;
-        calib.setLambda(0.5);
+        vpCalibration &calib = batchCalib[(size_t)k];
         calib.clearPoint();
         for (unsigned int i=0; i<model.size(); i++) {
           calib.addPoint(model[i].get_oX(), model[i].get_oY(), model[i].get_oZ(), data[i]);
@@ -250,29 +271,60 @@ int main(int argc, const char ** argv)
         // Set (u0,v0) in the middle of the image
         double px = cam.get_px();
         double py = cam.get_px();
-        double u0 = I.getWidth()/2;
-        double v0 = I.getHeight()/2;
+        double u0 = Ik.getWidth()/2;
+        double v0 = Ik.getHeight()/2;
         cam.initPersProjWithoutDistortion(px, py, u0, v0);
 
-        if (calib.computeCalibration(vpCalibration::CALIB_VIRTUAL_VS, cMo, cam, false) == 0) {
-          //std::cout << "camera parameters: " << cam << std::endl;
-          calibrator.push_back(calib);
+        // The static settings of vpCalibration are only read here and nothing
+        // is printed without the verbose mode. The error of a frame is
+        // printed with its status below.
+        try {
+          if (calib.computeCalibration(vpCalibration::CALIB_VIRTUAL_VS, cMo, cam, false) == 0)
+            status = 2;
+        }
+        catch(const vpException &e) {
+          batchError[(size_t)k] = e.getStringMessage();
         }
       }
 
-      if (found)
-        vpDisplay::displayText(I, 15, 15, "Image processing succeed", vpColor::green);
-      else
-        vpDisplay::displayText(I, 15, 15, "Image processing fails", vpColor::green);
+      for (size_t k=0; k < nbFrames; k++) {
+        I = batch[k];
+        vpDisplay::display(I);
+
+        bool found = (batchStatus[k] != 0);
+        std::cout << "frame: " << batchIndex[k] << ", status: " << found;
+        if (!found)
+          std::cout << ", image rejected" << std::endl;
+        else
+          std::cout << ", image used as input data" << std::endl;
+        if (! batchError[k].empty())
+          std::cout << "frame: " << batchIndex[k] << ", calibration failed: " << batchError[k] << std::endl;
+
+        if (found) {
+          std::stringstream ss;
+          ss << "image " << batchIndex[k];
+          vpDisplay::setTitle(I, ss.str());
+          for (unsigned int i=0; i < batchData[k].size(); i++)
+            vpDisplay::displayCross(I, batchData[k][i], 10, vpColor::red);
+
+          if (batchStatus[k] == 2)
+            calibrator.push_back(batchCalib[k]);
+        }
+
+        if (found)
+          vpDisplay::displayText(I, 15, 15, "Image processing succeed", vpColor::green);
+        else
+          vpDisplay::displayText(I, 15, 15, "Image processing fails", vpColor::green);
 
-      if (s.tempo > 10.f) {
-        vpDisplay::displayText(I, 35, 15, "A click to process the next image", vpColor::green);
-        vpDisplay::flush(I);
-        vpDisplay::getClick(I);
-      }
-      else {
-        vpDisplay::flush(I);
-        vpTime::wait(s.tempo*1000);
+        if (s.tempo > 10.f) {
+          vpDisplay::displayText(I, 35, 15, "A click to process the next image", vpColor::green);
+          vpDisplay::flush(I);
+          vpDisplay::getClick(I);
+        }
+        else {
+          vpDisplay::flush(I);
+          vpTime::wait(s.tempo*1000);
+        }
       }
     }
 
@@ -54,6 +54,7 @@
 #include <visp3/core/vpHistogramPeak.h>
 #include <visp3/core/vpHistogramValey.h>
 #include <visp3/core/vpColor.h>
+#include <visp3/core/vpRect.h>
 
 #ifdef VISP_BUILD_DEPRECATED_FUNCTIONS
 #  include <visp3/core/vpList.h>
@@ -241,6 +242,11 @@ public:
   };
 
   void     calculate(const vpImage<unsigned char> &I, const unsigned int nbins=256, const unsigned int nbThreads=1);
+  void     calculate(const vpImage<unsigned char> &I, const vpRect &roi, const vpImage<unsigned char> *mask=NULL,
+                     const unsigned int nbins=256);
+  static void calculateJoint(const vpImage<unsigned char> &I1, const vpImage<unsigned char> &I2,
+                             std::vector<unsigned int> &joint, const unsigned int nbins1=256,
+                             const unsigned int nbins2=256, const vpImage<unsigned char> *mask=NULL);
 
   void     display(const vpImage<unsigned char> &I, const vpColor &color=vpColor::white, const unsigned int thickness=2,
                    const unsigned int maxValue_=0);
@@ -68,6 +68,9 @@
 class VISP_EXPORT vpImageFilter
 {
 public:
+  static void boxFilter(const vpImage<unsigned char> &I, vpImage<double> &If, const unsigned int size);
+  static void boxFilter(const vpImage<unsigned char> &I, vpImage<unsigned char> &If, const unsigned int size);
+
 #if defined(VISP_HAVE_OPENCV) && (VISP_HAVE_OPENCV_VERSION >= 0x020100)
   static void canny(const vpImage<unsigned char>& I,
                     vpImage<unsigned char>& Ic,
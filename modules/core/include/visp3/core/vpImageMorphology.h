@@ -63,6 +63,14 @@
 
   \author Fabien Spindler  (Fabien.Spindler@irisa.fr) Irisa / Inria Rennes
 
+  Besides the 3x3 operators that use a 4 or 8 connexity, the grayscale
+  operators accept a rectangular structuring element of any size, a
+  horizontal or vertical line being a rectangle of width or height 1. They
+  rely on the van Herk / Gil-Werman algorithm, whose cost doesn't depend on
+  the size of the structuring element:
+  \code
+  vpImageMorphology::opening(I, 15, 15); // Remove the bright details smaller than 15x15 pixels
+  \endcode
 
 */
 class VISP_EXPORT vpImageMorphology
@@ -89,6 +97,13 @@ public:
 
   static void erosion(vpImage<unsigned char> &I, const vpConnexityType &connexity = CONNEXITY_4);
   static void dilatation(vpImage<unsigned char> &I, const vpConnexityType &connexity = CONNEXITY_4);
+
+  static void erosion(vpImage<unsigned char> &I, unsigned int width, unsigned int height);
+  static void dilatation(vpImage<unsigned char> &I, unsigned int width, unsigned int height);
+  static void opening(vpImage<unsigned char> &I, unsigned int width, unsigned int height);
+  static void closing(vpImage<unsigned char> &I, unsigned int width, unsigned int height);
+  static void topHat(vpImage<unsigned char> &I, unsigned int width, unsigned int height);
+  static void gradient(vpImage<unsigned char> &I, unsigned int width, unsigned int height);
 } ;
 
 /*!
@@ -130,6 +130,10 @@ public:
                                       const vpImage<vpRGBa> &I2,
                                       vpImage<vpRGBa> &Idiff);
 
+  template<class Type>
+  static inline Type boxSum(const vpImage<Type> &II, const unsigned int top, const unsigned int left,
+                            const unsigned int height, const unsigned int width);
+
   static void imageAdd(const vpImage<unsigned char> &I1,
                        const vpImage<unsigned char> &I2,
                        vpImage<unsigned char> &Ires,
@@ -140,6 +144,11 @@ public:
                             vpImage<unsigned char> &Ires,
                             const bool saturate=false);
 
+  static void integralImage(const vpImage<unsigned char> &I, vpImage<unsigned int> &II);
+  static void integralImage(const vpImage<unsigned char> &I, vpImage<unsigned long long> &II);
+  static void integralImage(const vpImage<unsigned char> &I, vpImage<unsigned int> &II,
+                            vpImage<unsigned long long> &IIsq);
+
   template<class Type>
   static void resize(const vpImage<Type> &I,
                      vpImage<Type> &Ires,
@@ -246,6 +255,31 @@ void vpImageTools::createSubImage(const vpImage<Type> &I,
 
 #endif // #if defined(VISP_BUILD_DEPRECATED_FUNCTIONS)
 
+/*!
+  Sum of the pixels of a rectangular region in constant time, from an
+  integral image computed by integralImage().
+
+  \param II : Integral image, of size (I.getHeight()+1) x (I.getWidth()+1).
+  \param top : Row of the top left corner of the region in the image I.
+  \param left : Column of the top left corner of the region in the image I.
+  \param height : Height of the region, such that top + height <= I.getHeight().
+  \param width : Width of the region, such that left + width <= I.getWidth().
+  \return Sum of the pixels I[i][j] of the region.
+
+  \code
+  vpImage<unsigned int> II;
+  vpImageTools::integralImage(I, II);
+  double mean = vpImageTools::boxSum(II, 10, 20, 30, 40) / (30.0 * 40.0);
+  \endcode
+*/
+template<class Type>
+inline Type vpImageTools::boxSum(const vpImage<Type> &II, const unsigned int top, const unsigned int left,
+                                 const unsigned int height, const unsigned int width)
+{
+  const Type *rowTop = II[top], *rowBottom = II[top + height];
+  return (Type)((rowBottom[left + width] - rowBottom[left]) - (rowTop[left + width] - rowTop[left]));
+}
+
 /*!
   Crop a region of interest (ROI) in an image. The ROI coordinates and dimension are defined in the original image.
 
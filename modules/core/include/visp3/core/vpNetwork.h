@@ -74,6 +74,17 @@
   TCP provides reliable, ordered delivery of a stream of bytes from a program 
   on one computer to another program on another computer.
   
+  Requests can be exchanged with two protocols selected by setProtocol():
+  - vpNetwork::PROTOCOL_TEXT (default) where a request is sent as a string
+    delimited by text markers. The receiver has to search these markers in the
+    received data, which is slow for large parameters like images.
+  - vpNetwork::PROTOCOL_BINARY where a request is sent as a length prefixed
+    frame. The parameters are sent with a single scatter/gather system call
+    without being concatenated, and are received directly in the parameters
+    of the decoding request. This protocol is well suited to stream images or
+    tracking results between processes.
+  Both sides of the connection have to use the same protocol.
+
   \warning This class shouldn't be used directly. You better use vpClient and
   vpServer to simulate your network. Some exemples are provided in these classes.
 
@@ -82,8 +93,33 @@
 */
 class VISP_EXPORT vpNetwork
 {
+public:
+  /*!
+    Protocol used to send and receive requests.
+  */
+  typedef enum {
+    PROTOCOL_TEXT,  /*!< Requests are strings delimited by text markers. */
+    PROTOCOL_BINARY /*!< Requests are length prefixed binary frames. */
+  } vpProtocolType;
+
 protected:
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
+  // State of a binary frame being received
+  struct vpFrame{
+    unsigned int              stage;
+    size_t                    offset;
+    unsigned int              header[3];
+    std::vector<char>         meta;
+    std::vector<unsigned int> lengths;
+    int                       request;
+    unsigned int              param;
+
+    vpFrame() : stage(0), offset(0), meta(), lengths(), request(-1), param(0)
+    {
+      header[0] = header[1] = header[2] = 0;
+    }
+  };
+
   struct vpReceptor{
 #if !defined(_WIN32) && (defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__))) // UNIX
     int                   socketFileDescriptorReceptor;
@@ -94,8 +130,9 @@ protected:
 #endif
     struct sockaddr_in    receptorAddress;
     std::string           receptorIP;
+    vpFrame               frame;
 
-    vpReceptor() : socketFileDescriptorReceptor(0), receptorAddressSize(), receptorAddress(), receptorIP() {}
+    vpReceptor() : socketFileDescriptorReceptor(0), receptorAddressSize(), receptorAddress(), receptorIP(), frame() {}
   };
   
   struct vpEmitter{
@@ -132,12 +169,15 @@ protected:
   std::vector<vpRequest*> request_list;
   
   unsigned int            max_size_message;
+  unsigned int            max_size_frame;
   std::string             separator;
   std::string             beginning;
   std::string             end;
   std::string             param_sep;
   
   std::string             currentMessageReceived;
+  std::vector<char>       receiveBuffer;
+  vpProtocolType          protocol;
     
   struct timeval          tv;
   long                    tv_sec;
@@ -154,7 +194,16 @@ private:
   void              _receiveRequestFrom(const unsigned int &receptorEmitting);
   int               _receiveRequestOnce();
   int               _receiveRequestOnceFrom(const unsigned int &receptorEmitting);
-  
+
+  std::vector<int>  _receiveFrames(const int &receptorEmitting);
+  int               _receiveFrameOnce(const int &receptorEmitting, int &numbytes);
+  int               _readFrame(const unsigned int &index, int &numbytes);
+  void              _rejectFrame(const unsigned int &index);
+  int               _sendFrameTo(vpRequest &req, const unsigned int &dest);
+
+protected:
+  virtual int       _waitForReceptors(const int &receptorEmitting, std::vector<unsigned int> &ready);
+
 public:
 
                     vpNetwork();
@@ -185,6 +234,25 @@ public:
     \return Acutal max size value.
   */
   unsigned int      getMaxSizeReceivedMessage(){ return max_size_message; }
+
+  /*!
+    Get the maximum size of the id and parameters of a binary frame that can
+    be received (in vpNetwork::PROTOCOL_BINARY mode).
+
+    \sa vpNetwork::setMaxSizeReceivedFrame()
+
+    \return Actual max size value.
+  */
+  unsigned int      getMaxSizeReceivedFrame() const { return max_size_frame; }
+
+  /*!
+    Get the protocol used to send and receive requests.
+
+    \sa vpNetwork::setProtocol()
+
+    \return Protocol in use.
+  */
+  vpProtocolType    getProtocol() const { return protocol; }
   
   void      print(const char *id = "");
   
@@ -224,6 +292,36 @@ public:
     \param s : new maximum size value.
   */
   void              setMaxSizeReceivedMessage(const unsigned int &s){ max_size_message = s;}
+
+  /*!
+    Change the maximum size of the id and parameters of a binary frame that can
+    be received (in vpNetwork::PROTOCOL_BINARY mode). Initially this value is
+    set to 64 MB.
+
+    The size is checked as soon as the header of a frame is received, before
+    allocating the memory of the parameters. A receptor sending a larger frame
+    is considered as corrupted and is disconnected.
+
+    \sa vpNetwork::getMaxSizeReceivedFrame()
+
+    \param s : new maximum size value in bytes.
+  */
+  void              setMaxSizeReceivedFrame(const unsigned int &s){ max_size_frame = s;}
+
+  /*!
+    Change the protocol used to send and receive requests. Initially the
+    protocol is vpNetwork::PROTOCOL_TEXT. Both sides of the connection have to
+    use the same protocol.
+
+    With vpNetwork::PROTOCOL_BINARY, a request is received as soon as its frame
+    is complete. The maximum size of the received messages is not used, the
+    size of a frame is bounded by setMaxSizeReceivedFrame() instead.
+
+    \sa vpNetwork::getProtocol()
+
+    \param p : new protocol.
+  */
+  void              setProtocol(const vpProtocolType &p){ protocol = p; }
   
   /*!
     Change the time the emitter spend to check if he receives a message from a receptor.
@@ -130,6 +130,8 @@ void vpRequestImage::decode(){
 */
 class VISP_EXPORT vpRequest
 {
+  friend class vpNetwork;
+
 protected:
   std::string               request_id;
   std::vector<std::string>  listOfParams;
@@ -225,13 +227,8 @@ template<typename T>
 void vpRequest::addParameterObject(T * params, const int &sizeOfObject)
 {
   if(sizeOfObject != 0){
-    char *tempS = new char [sizeOfObject];
-    memcpy((void*)tempS, (void*)params, sizeOfObject);
-    std::string returnVal(tempS, (size_t)sizeOfObject);
-  
-    listOfParams.push_back(returnVal);
-
-    delete [] tempS;
+    listOfParams.push_back(std::string());
+    listOfParams.back().assign((const char*)(const void*)params, (size_t)sizeOfObject);
   }
 }
 
@@ -154,6 +154,12 @@ int main(int argc,const char** argv)
 }
   \endcode
 
+  On Linux, the server waits for the connections and the requests of the
+  clients with epoll instead of select(), so that the cost of a wait doesn't
+  depend on the number of connected clients. As epoll has a millisecond
+  resolution, the timeout set with setTimeoutSec() and setTimeoutUSec() is
+  rounded down to the millisecond: the default timeout of 10 usec doesn't wait.
+
   \sa vpClient
   \sa vpRequest
   \sa vpNetwork
@@ -169,6 +175,14 @@ private:
   int          port;
   bool         started;
   unsigned int max_clients;
+  int          epollFileDescriptor; // Only used on Linux
+
+#if defined(__linux__)
+  int           _epollWait(bool &connection, std::vector<unsigned int> &ready);
+#endif
+
+protected:
+  virtual int   _waitForReceptors(const int &receptorEmitting, std::vector<unsigned int> &ready);
 
 public:
 
@@ -0,0 +1,241 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2017 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * Description:
+ * Ring buffer of frames in shared memory.
+ *
+ *****************************************************************************/
+
+/*!
+  \file vpSharedMemoryRing.h
+  \brief Ring buffer of frames (images, depth maps, point clouds) shared between processes.
+*/
+
+#ifndef vpSharedMemoryRing_H
+#define vpSharedMemoryRing_H
+
+#include <visp3/core/vpConfig.h>
+
+#if !defined(_WIN32) && (defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__))) // UNIX
+
+#include <string>
+#include <vector>
+
+#include <visp3/core/vpColVector.h>
+#include <visp3/core/vpException.h>
+#include <visp3/core/vpImage.h>
+#include <visp3/core/vpRGBa.h>
+
+/*!
+  \class vpSharedMemoryRing
+
+  \ingroup group_core_network
+
+  \brief Hand over frames between processes of the same computer through a
+  ring buffer in POSIX shared memory.
+
+  A producer process creates the ring with create(), giving it a name, a
+  number of slots and the maximum size of a frame. Each call to write()
+  copies a frame (grey level image, color image, 16 bits depth map or point
+  cloud) in the next slot and wakes up the consumers. Any number of consumer
+  processes can open() the same ring and get the frames in order with read(),
+  or access them without any copy with acquire().
+
+  The ring is lock-free: the producer never waits for the consumers. Each slot
+  is protected by a sequence counter that is incremented before and after the
+  slot is written, so that a consumer detects a frame overwritten while it was
+  reading it. A consumer that is too slow skips the frames overwritten by the
+  producer; getNbDroppedFrames() gives the number of skipped frames. On Linux,
+  the consumers sleep on a futex until a new frame is written, so that a frame
+  is handed over in a few microseconds. On other UNIX systems they poll the
+  ring.
+
+  A ring contains a single stream of frames of the same kind. Use one ring by
+  sensor, for example one for the color images and another one for the depth
+  maps.
+
+  Example of producer:
+  \code
+#include <visp3/core/vpSharedMemoryRing.h>
+#include <visp3/core/vpTime.h>
+
+int main()
+{
+  vpImage<unsigned char> I(480, 640);
+  vpSharedMemoryRing ring;
+  ring.create("camera", 4, I.getSize());
+  while (true) {
+    // Here the code to acquire I
+    ring.write(I, vpTime::measureTimeMs());
+  }
+}
+  \endcode
+
+  Example of consumer:
+  \code
+#include <visp3/core/vpSharedMemoryRing.h>
+
+int main()
+{
+  vpImage<unsigned char> I;
+  double timestamp;
+  vpSharedMemoryRing ring;
+  ring.open("camera");
+  while (ring.read(I, timestamp, 1000)) { // wait at most 1 second for a frame
+    // Here the code to process I
+  }
+}
+  \endcode
+
+  Example of consumer accessing the frames without copy:
+  \code
+  vpSharedMemoryRing::vpFrameView view;
+  while (ring.acquire(view, 1000)) {
+    const unsigned char *data = (const unsigned char *)view.data;
+    // Here the code to process the view.width x view.height pixels of data
+    if (! ring.isValid(view)) {
+      // The frame was overwritten by the producer during the processing
+    }
+  }
+  \endcode
+*/
+class VISP_EXPORT vpSharedMemoryRing
+{
+public:
+  //! Types of the frames.
+  typedef enum
+  {
+    FRAME_GREY = 1,      //!< vpImage<unsigned char>.
+    FRAME_RGBA = 2,      //!< vpImage<vpRGBa>.
+    FRAME_DEPTH = 3,     //!< vpImage<uint16_t>.
+    FRAME_POINTCLOUD = 5 //!< Point cloud as a vector of vpColVector, stored as floats.
+  } vpFrameType;
+
+  /*!
+    Frame stored in a slot of the ring, accessed without copy.
+    For a point cloud, the width is the number of points and the height the
+    number of coordinates of a point.
+  */
+  struct vpFrameView
+  {
+    const void *data;              //!< Frame data in the shared memory.
+    vpFrameType type;              //!< Type of the frame.
+    unsigned int width;            //!< Width of the frame.
+    unsigned int height;           //!< Height of the frame.
+    unsigned long long size;       //!< Size of the frame data in bytes.
+    double timestamp;              //!< Timestamp given by the producer.
+    unsigned long long frameIndex; //!< Index of the frame since the creation of the ring.
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+    unsigned int slot;
+    unsigned int sequence;
+#endif
+
+    vpFrameView()
+      : data(NULL), type(FRAME_GREY), width(0), height(0), size(0), timestamp(0), frameIndex(0), slot(0), sequence(0)
+    {
+    }
+  };
+
+private:
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+  vpSharedMemoryRing(const vpSharedMemoryRing &);
+  vpSharedMemoryRing &operator=(const vpSharedMemoryRing &);
+#endif
+
+  std::string m_name;
+  bool m_producer;
+  unsigned char *m_map;
+  size_t m_mapSize;
+  unsigned int m_nbSlots;
+  unsigned long long m_slotSize;
+  size_t m_slotStride;
+  //! Index of the next frame written by the producer or read by the consumer
+  unsigned long long m_next;
+  unsigned long long m_dropped;
+  bool m_writing;
+
+public:
+  vpSharedMemoryRing();
+  virtual ~vpSharedMemoryRing();
+
+  bool acquire(vpFrameView &view, double timeout = -1);
+
+  void *beginWrite(vpFrameType type, unsigned int width, unsigned int height, unsigned long long size);
+
+  void close();
+  void create(const std::string &name, unsigned int nbSlots, unsigned long long slotSize, unsigned int mode = 0600);
+
+  void endWrite(double timestamp);
+
+  unsigned long long getFrameCount() const;
+  /*!
+    Return the name of the ring.
+  */
+  inline std::string getName() const { return m_name; }
+  /*!
+    Return the number of frames skipped by this consumer because they were
+    overwritten by the producer before being read.
+  */
+  inline unsigned long long getNbDroppedFrames() const { return m_dropped; }
+  /*!
+    Return the number of slots of the ring.
+  */
+  inline unsigned int getNbSlots() const { return m_nbSlots; }
+  /*!
+    Return the maximum size in bytes of a frame.
+  */
+  inline unsigned long long getSlotSize() const { return m_slotSize; }
+
+  /*!
+    Return true if the ring is created or opened.
+  */
+  inline bool isOpened() const { return m_map != NULL; }
+  bool isValid(const vpFrameView &view) const;
+
+  void open(const std::string &name);
+
+  bool read(vpImage<unsigned char> &I, double &timestamp, double timeout = -1);
+  bool read(vpImage<vpRGBa> &I, double &timestamp, double timeout = -1);
+  bool read(vpImage<uint16_t> &I, double &timestamp, double timeout = -1);
+  bool read(std::vector<vpColVector> &pointcloud, double &timestamp, double timeout = -1);
+
+  bool wait(double timeout = -1);
+
+  void write(const vpImage<unsigned char> &I, double timestamp);
+  void write(const vpImage<vpRGBa> &I, double timestamp);
+  void write(const vpImage<uint16_t> &I, double timestamp);
+  void write(const std::vector<vpColVector> &pointcloud, double timestamp);
+
+private:
+  template <class Type> bool readImage(vpImage<Type> &I, double &timestamp, double timeout, vpFrameType type);
+};
+
+#endif
+#endif
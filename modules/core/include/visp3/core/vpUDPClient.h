@@ -46,9 +46,10 @@
 #include <winsock2.h>
 #endif
 
-#include <visp3/core/vpException.h>
+#include <vector>
 
-#define VP_MAX_UDP_PAYLOAD 508
+#include <visp3/core/vpException.h>
+#include <visp3/core/vpUDPMessage.h>
 
 /*!
   \class vpUDPClient
@@ -157,7 +158,31 @@ int main() {
 }
   \endcode
 
-  \sa vpUDPServer
+  To stream poses or velocity commands at a high rate, send vpUDPMessage
+  instead of strings. A message has a fixed binary layout independent of the
+  architecture and is encoded without any memory allocation. Several messages
+  can be sent with a single system call (sendmmsg() on Linux):
+  \code
+#include <visp3/core/vpTime.h>
+#include <visp3/core/vpUDPClient.h>
+
+int main() {
+  vpUDPClient client("127.0.0.1", 50037);
+  std::vector<vpUDPMessage> msgs(2);
+  vpHomogeneousMatrix cMo;
+  vpColVector v(6);
+  for (unsigned int seq = 0; ; seq++) {
+    // Here the code to update the pose and the velocity
+    double t = vpTime::measureTimeMs();
+    msgs[0].set(cMo, seq, t, 0); // pose on channel 0
+    msgs[1].set(v, seq, t, 1);   // velocity on channel 1
+    client.send(msgs);
+    vpTime::wait(t, 1);
+  }
+}
+  \endcode
+
+  \sa vpUDPServer, vpUDPMessage
 */
 class VISP_EXPORT vpUDPClient {
 public:
@@ -166,6 +191,8 @@ public:
 
   int receive(std::string &msg, const int timeoutMs=0);
   int send(const std::string &msg);
+  int send(const vpUDPMessage &msg);
+  int send(const std::vector<vpUDPMessage> &msgs);
 
 private:
   char m_buf[VP_MAX_UDP_PAYLOAD];
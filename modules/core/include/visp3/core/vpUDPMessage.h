@@ -0,0 +1,150 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2017 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * Description:
+ * Fixed layout binary UDP message
+ *
+ *****************************************************************************/
+
+#ifndef __vpUDPMessage_h__
+#define __vpUDPMessage_h__
+
+#include <visp3/core/vpConfig.h>
+#include <visp3/core/vpColVector.h>
+#include <visp3/core/vpHomogeneousMatrix.h>
+
+#ifndef VP_MAX_UDP_PAYLOAD
+#define VP_MAX_UDP_PAYLOAD 508
+#endif
+
+/*!
+  \class vpUDPMessage
+
+  \ingroup group_core_network
+
+  \brief Binary message with a fixed layout exchanged by vpUDPClient and
+  vpUDPServer, carrying a pose (vpHomogeneousMatrix) or a vector of values
+  (vpColVector) like a velocity command.
+
+  Each message holds a sequence number, a timestamp and a channel number
+  that allows to multiplex several data streams on the same port. The layout
+  of a message is, in little endian byte order:
+  - bytes 0-1: "VP" magic number
+  - byte 2: version of the layout
+  - byte 3: type of the message (see vpMessageType)
+  - bytes 4-7: sequence number
+  - bytes 8-15: timestamp (double)
+  - bytes 16-19: channel number
+  - bytes 20-21: number of values
+  - bytes 22-23: reserved
+  - bytes 24-: values (doubles), the first three rows of a homogeneous matrix
+    in row major order
+
+  A message is stored in a fixed size buffer, so that sending and receiving
+  messages never allocates memory. It can carry at most
+  vpUDPMessage::maxNbValues values.
+
+  \code
+#include <visp3/core/vpTime.h>
+#include <visp3/core/vpUDPClient.h>
+
+int main()
+{
+  vpUDPClient client("127.0.0.1", 50037);
+  vpHomogeneousMatrix cMo;
+  vpUDPMessage msg;
+  for (unsigned int seq = 0; ; seq++) {
+    // Here the code to update cMo
+    msg.set(cMo, seq, vpTime::measureTimeMs());
+    client.send(msg);
+    vpTime::wait(1);
+  }
+}
+  \endcode
+
+  \sa vpUDPClient, vpUDPServer
+*/
+class VISP_EXPORT vpUDPMessage
+{
+  friend class vpUDPClient;
+  friend class vpUDPServer;
+
+public:
+  //! Type of the data carried by a message.
+  typedef enum {
+    MESSAGE_UNKNOWN = 0,            //!< Not a valid message.
+    MESSAGE_HOMOGENEOUS_MATRIX = 1, //!< Pose stored as a vpHomogeneousMatrix.
+    MESSAGE_COLVECTOR = 2           //!< Values stored as a vpColVector.
+  } vpMessageType;
+
+  //! Size in bytes of the header of a message.
+  static const unsigned int headerSize = 24;
+  //! Maximum number of values carried by a message.
+  static const unsigned int maxNbValues = (VP_MAX_UDP_PAYLOAD - 24) / 8;
+
+  vpUDPMessage();
+  vpUDPMessage(const vpHomogeneousMatrix &M, const unsigned int sequence, const double timestamp,
+               const unsigned int channel = 0);
+  vpUDPMessage(const vpColVector &v, const unsigned int sequence, const double timestamp,
+               const unsigned int channel = 0);
+
+  bool get(vpHomogeneousMatrix &M) const;
+  bool get(vpColVector &v) const;
+
+  unsigned int getChannel() const;
+  /*!
+    Return the encoded message.
+  */
+  inline const char *getData() const { return m_data; }
+  /*!
+    Return the size in bytes of the encoded message.
+  */
+  inline unsigned int getLength() const { return m_length; }
+  unsigned int getNbValues() const;
+  unsigned int getSequence() const;
+  double getTimestamp() const;
+  vpMessageType getType() const;
+  double getValue(const unsigned int i) const;
+
+  bool isValid() const;
+
+  void set(const vpHomogeneousMatrix &M, const unsigned int sequence, const double timestamp,
+           const unsigned int channel = 0);
+  void set(const vpColVector &v, const unsigned int sequence, const double timestamp, const unsigned int channel = 0);
+
+private:
+  char m_data[VP_MAX_UDP_PAYLOAD];
+  unsigned int m_length;
+
+  void setHeader(const vpMessageType type, const unsigned int sequence, const double timestamp,
+                 const unsigned int channel, const unsigned int nbValues);
+};
+
+#endif
@@ -46,9 +46,10 @@
 #include <winsock2.h>
 #endif
 
-#include <visp3/core/vpException.h>
+#include <vector>
 
-#define VP_MAX_UDP_PAYLOAD 508
+#include <visp3/core/vpException.h>
+#include <visp3/core/vpUDPMessage.h>
 
 /*!
   \class vpUDPServer
@@ -182,7 +183,35 @@ int main() {
 }
   \endcode
 
-  \sa vpUDPServer
+  To stream poses or velocity commands at a high rate, the client and the
+  server can exchange vpUDPMessage instead of strings. The messages have a
+  fixed binary layout independent of the architecture and are received
+  without any memory allocation. The datagrams waiting in the socket are
+  received by batches with a single system call (recvmmsg() on Linux):
+  \code
+#include <iostream>
+#include <visp3/core/vpUDPServer.h>
+
+int main() {
+  vpUDPServer server(50037);
+  server.setBatchSize(16);
+  std::vector<vpUDPMessage> msgs;
+  vpHomogeneousMatrix cMo;
+  while (true) {
+    int nb = server.receive(msgs, 10);
+    for (int i = 0; i < nb; i++) {
+      if (msgs[i].get(cMo)) {
+        std::cout << "Pose " << msgs[i].getSequence() << " at " << msgs[i].getTimestamp() << std::endl;
+      }
+    }
+  }
+}
+  \endcode
+  With setBusyPoll(), the server polls the socket instead of sleeping until a
+  datagram arrives, which reduces the latency and its jitter at the cost of a
+  busy processor core.
+
+  \sa vpUDPClient, vpUDPMessage
 */
 class VISP_EXPORT vpUDPServer {
 public:
@@ -192,10 +221,17 @@ public:
 
   int receive(std::string &msg, const int timeoutMs=0);
   int receive(std::string &msg, std::string &hostInfo, const int timeoutMs=0);
+  int receive(vpUDPMessage &msg, const int timeoutMs=0);
+  int receive(std::vector<vpUDPMessage> &msgs, const int timeoutMs=0);
   int send(const std::string &msg, const std::string &hostname, const int port);
 
+  void setBatchSize(const unsigned int batchSize);
+  void setBusyPoll(const bool busyPoll);
+
 private:
   char m_buf[VP_MAX_UDP_PAYLOAD];
+  unsigned int m_batchSize;
+  bool m_busyPoll;
   struct sockaddr_in m_clientAddress;
   int m_clientLength;
   struct sockaddr_in m_serverAddress;
@@ -207,6 +243,8 @@ private:
 #endif
 
   void init(const std::string &hostname, const int port);
+  int receiveMessages(vpUDPMessage *msgs, const unsigned int nbMsgs);
+  int waitMessages(vpUDPMessage *msgs, const unsigned int nbMsgs, const int timeoutMs);
 };
 
 #endif
@@ -38,6 +38,7 @@
 
 #include <visp3/core/vpImageFilter.h>
 #include <visp3/core/vpImageConvert.h>
+#include <visp3/core/vpImageTools.h>
 #if defined(VISP_HAVE_OPENCV) && (VISP_HAVE_OPENCV_VERSION >= 0x020408)
 #  include <opencv2/imgproc/imgproc.hpp>
 #elif defined(VISP_HAVE_OPENCV) && (VISP_HAVE_OPENCV_VERSION >= 0x020101)
@@ -443,6 +444,111 @@ void vpImageFilter::filterY(const vpImage<double> &I, vpImage<double>& dIy, cons
   }
 }
 
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+namespace
+{
+// Mean of the size x size window around each pixel, clipped to the image, from the integral image II
+template <class IntegralType, class Type>
+void boxFilterIntegral(const vpImage<IntegralType> &II, vpImage<Type> &If, const unsigned int size, const bool round)
+{
+  const int height = (int)II.getHeight() - 1, width = (int)II.getWidth() - 1;
+  const int radius = (int)size / 2;
+  const double shift = round ? 0.5 : 0.0;
+
+#ifdef VISP_HAVE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+  for (int i = 0; i < height; i++) {
+    const int top = std::max(0, i - radius), bottom = std::min(height, i + radius + 1);
+    const IntegralType *rowTop = II[(unsigned int)top], *rowBottom = II[(unsigned int)bottom];
+    Type *dst = If[(unsigned int)i];
+    // With OpenMP, radius, width and shift are shared variables read through a pointer
+    // that may alias dst: local copies avoid reloading them after each pixel write
+    const int r = radius, w = width;
+    const double s = shift;
+
+    // Columns whose window is inside the image, with a constant number of pixels
+    const int jBegin = std::min(r, w), jEnd = std::max(jBegin, w - r);
+    // The mean is divided rather than multiplied by the inverse of the count, so that
+    // it is exactly sum / count as near the borders, which vp::adaptiveThreshold() relies on
+    const double count = (double)((bottom - top) * (2 * r + 1));
+    for (int j = jBegin; j < jEnd; j++) {
+      const IntegralType sum =
+          (rowBottom[j + r + 1] - rowBottom[j - r]) - (rowTop[j + r + 1] - rowTop[j - r]);
+      dst[j] = (Type)(sum / count + s);
+    }
+
+    // Columns near the left and right borders
+    for (int j = 0; j < w; j++) {
+      if (j == jBegin) {
+        j = jEnd;
+        if (j >= w) {
+          break;
+        }
+      }
+      const int left = std::max(0, j - r), right = std::min(w, j + r + 1);
+      const IntegralType sum = (rowBottom[right] - rowBottom[left]) - (rowTop[right] - rowTop[left]);
+      dst[j] = (Type)(sum / (double)((bottom - top) * (right - left)) + s);
+    }
+  }
+}
+
+template <class Type> void boxFilter(const vpImage<unsigned char> &I, vpImage<Type> &If, const unsigned int size)
+{
+  if (size == 0 || size % 2 == 0) {
+    throw vpException(vpException::badValue, "Box filter size (%u) should be odd", size);
+  }
+
+  If.resize(I.getHeight(), I.getWidth());
+  // The sums of the 32-bit integral image are exact for windows of less than 16843009 pixels
+  if ((unsigned long long)size * size < 16843009ULL) {
+    vpImage<unsigned int> II;
+    vpImageTools::integralImage(I, II);
+    boxFilterIntegral(II, If, size, sizeof(Type) == 1);
+  } else {
+    vpImage<unsigned long long> II;
+    vpImageTools::integralImage(I, II);
+    boxFilterIntegral(II, If, size, sizeof(Type) == 1);
+  }
+}
+}
+#endif
+
+/*!
+  Apply a box filter (mean filter) to an image, in constant time by pixel
+  whatever the filter size thanks to an integral image. Near the borders, the
+  mean is computed over the part of the window inside the image.
+
+  \param I : Input image.
+  \param If : Filtered image.
+  \param size : Filter size. This value should be odd.
+
+  \exception vpException::badValue : If the filter size is not odd.
+
+  \sa vpImageTools::integralImage()
+*/
+void vpImageFilter::boxFilter(const vpImage<unsigned char> &I, vpImage<double> &If, const unsigned int size)
+{
+  ::boxFilter(I, If, size);
+}
+
+/*!
+  Apply a box filter (mean filter) to an image, the mean being rounded to the
+  nearest gray level.
+
+  \param I : Input image.
+  \param If : Filtered image.
+  \param size : Filter size. This value should be odd.
+
+  \exception vpException::badValue : If the filter size is not odd.
+
+  \sa boxFilter(const vpImage<unsigned char> &, vpImage<double> &, const unsigned int)
+*/
+void vpImageFilter::boxFilter(const vpImage<unsigned char> &I, vpImage<unsigned char> &If, const unsigned int size)
+{
+  ::boxFilter(I, If, size);
+}
+
 /*!
   Apply a Gaussian blur to an image.
   \param I : Input image.
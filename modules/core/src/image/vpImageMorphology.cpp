@@ -38,12 +38,221 @@
 
 #include <visp3/core/vpImageMorphology.h>
 #include <visp3/core/vpCPUFeatures.h>
+#include <visp3/core/vpException.h>
+
+#include <vector>
 
 #if defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)
 #  include <emmintrin.h>
 #  define VISP_HAVE_SSE2 1
 #endif
 
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+namespace
+{
+// Structuring elements up to this size are processed directly, larger ones
+// with the van Herk / Gil-Werman algorithm
+const unsigned int vpMorphDirectMaxSize = 5;
+
+struct vpMorphMin
+{
+  static const unsigned char null_value = 255;
+  static inline unsigned char apply(unsigned char a, unsigned char b) { return (std::min)(a, b); }
+#if VISP_HAVE_SSE2
+  static inline __m128i apply(const __m128i &a, const __m128i &b) { return _mm_min_epu8(a, b); }
+#endif
+};
+
+struct vpMorphMax
+{
+  static const unsigned char null_value = 0;
+  static inline unsigned char apply(unsigned char a, unsigned char b) { return (std::max)(a, b); }
+#if VISP_HAVE_SSE2
+  static inline __m128i apply(const __m128i &a, const __m128i &b) { return _mm_max_epu8(a, b); }
+#endif
+};
+
+// dst[j] = op(a[j], b[j])
+template <class Op>
+void vpMorphApply(unsigned char *dst, const unsigned char *a, const unsigned char *b, unsigned int size,
+                  bool checkSSE2)
+{
+  unsigned int j = 0;
+#if VISP_HAVE_SSE2
+  if (checkSSE2 && size >= 16) {
+    for (; j <= size - 16; j += 16) {
+      __m128i m = Op::apply(_mm_loadu_si128((const __m128i *)(a + j)), _mm_loadu_si128((const __m128i *)(b + j)));
+      _mm_storeu_si128((__m128i *)(dst + j), m);
+    }
+  }
+#else
+  (void)checkSSE2;
+#endif
+  for (; j < size; j++) {
+    dst[j] = Op::apply(a[j], b[j]);
+  }
+}
+
+/*
+  Min or max over a window of the given size along each column, the window
+  starting size/2 rows above the pixel. The rows are processed as a whole, so
+  that the computations are vectorized across the columns. For large windows
+  the van Herk / Gil-Werman algorithm splits the padded columns in blocks of
+  size rows: h holds the suffix min/max of the current block and g the prefix
+  min/max of the next one, so that each output row is op(h, g).
+*/
+template <class Op> void vpMorphColumns(vpImage<unsigned char> &I, unsigned int size, bool checkSSE2)
+{
+  const unsigned int width = I.getWidth(), height = I.getHeight();
+  const unsigned int anchor = size / 2;
+  const unsigned char null_value = Op::null_value;
+  std::vector<unsigned char> null_row(width, null_value);
+  vpImage<unsigned char> J(I);
+  // Rows of the image padded with null rows
+  std::vector<const unsigned char *> P(height + size - 1, &null_row[0]);
+  for (unsigned int i = 0; i < height; i++) {
+    P[anchor + i] = J[i];
+  }
+
+  if (size <= vpMorphDirectMaxSize) {
+    for (unsigned int i = 0; i < height; i++) {
+      memcpy(I[i], P[i], width);
+      for (unsigned int k = 1; k < size; k++) {
+        vpMorphApply<Op>(I[i], I[i], P[i + k], width, checkSSE2);
+      }
+    }
+  } else {
+    vpImage<unsigned char> g(size, width), h(size, width);
+    for (unsigned int b = 0; b < height; b += size) {
+      const unsigned int nb_rows = (std::min)(size, height - b);
+
+      memcpy(h[size - 1], P[b + size - 1], width);
+      for (unsigned int k = size - 1; k > 0; k--) {
+        vpMorphApply<Op>(h[k - 1], h[k], P[b + k - 1], width, checkSSE2);
+      }
+      if (nb_rows > 1) {
+        memcpy(g[0], P[b + size], width);
+      }
+      for (unsigned int k = 1; k + 1 < nb_rows; k++) {
+        vpMorphApply<Op>(g[k], g[k - 1], P[b + size + k], width, checkSSE2);
+      }
+
+      memcpy(I[b], h[0], width);
+      for (unsigned int k = 1; k < nb_rows; k++) {
+        vpMorphApply<Op>(I[b + k], h[k], g[k - 1], width, checkSSE2);
+      }
+    }
+  }
+}
+
+// Transpose the rows x cols block src into dst
+void vpMorphTranspose(const unsigned char *src, unsigned int src_stride, unsigned int rows, unsigned int cols,
+                      unsigned char *dst, unsigned int dst_stride, bool checkSSE2)
+{
+  unsigned int i = 0;
+#if VISP_HAVE_SSE2
+  if (checkSSE2) {
+    for (; i + 16 <= rows; i += 16) {
+      unsigned int j = 0;
+      for (; j + 16 <= cols; j += 16) {
+        // 16x16 block transposed by four interleaving stages
+        __m128i a[16], b[16];
+        for (unsigned int k = 0; k < 16; k++) {
+          a[k] = _mm_loadu_si128((const __m128i *)(src + (i + k) * src_stride + j));
+        }
+        for (int stage = 0; stage < 4; stage++) {
+          for (int k = 0; k < 8; k++) {
+            b[2 * k] = _mm_unpacklo_epi8(a[k], a[k + 8]);
+            b[2 * k + 1] = _mm_unpackhi_epi8(a[k], a[k + 8]);
+          }
+          for (int k = 0; k < 16; k++) {
+            a[k] = b[k];
+          }
+        }
+        for (unsigned int k = 0; k < 16; k++) {
+          _mm_storeu_si128((__m128i *)(dst + (j + k) * dst_stride + i), a[k]);
+        }
+      }
+      for (; j < cols; j++) {
+        for (unsigned int k = i; k < i + 16; k++) {
+          dst[j * dst_stride + k] = src[k * src_stride + j];
+        }
+      }
+    }
+  }
+#else
+  (void)checkSSE2;
+#endif
+  for (; i < rows; i++) {
+    for (unsigned int j = 0; j < cols; j++) {
+      dst[j * dst_stride + i] = src[i * src_stride + j];
+    }
+  }
+}
+
+/*
+  Min or max over a window of the given size along each row, the window
+  starting size/2 columns on the left of the pixel. Small windows are
+  processed directly. For large ones, strips of 64 rows are transposed in a
+  small buffer and processed as columns.
+*/
+template <class Op> void vpMorphRows(vpImage<unsigned char> &I, unsigned int size, bool checkSSE2)
+{
+  const unsigned int width = I.getWidth(), height = I.getHeight();
+
+  if (size <= vpMorphDirectMaxSize) {
+    const unsigned int anchor = size / 2;
+    const unsigned char null_value = Op::null_value;
+    std::vector<unsigned char> P(width + size - 1, null_value);
+
+    for (unsigned int i = 0; i < height; i++) {
+      unsigned char *ptr_row = I[i];
+      memcpy(&P[anchor], ptr_row, width);
+      memcpy(ptr_row, &P[0], width);
+      for (unsigned int k = 1; k < size; k++) {
+        vpMorphApply<Op>(ptr_row, ptr_row, &P[k], width, checkSSE2);
+      }
+    }
+  } else {
+    const unsigned int strip_size = 64;
+    vpImage<unsigned char> S;
+    for (unsigned int i = 0; i < height; i += strip_size) {
+      const unsigned int nb_rows = (std::min)(strip_size, height - i);
+      S.resize(width, nb_rows);
+      vpMorphTranspose(I[i], width, nb_rows, width, S.bitmap, nb_rows, checkSSE2);
+      vpMorphColumns<Op>(S, size, checkSSE2);
+      vpMorphTranspose(S.bitmap, nb_rows, width, nb_rows, I[i], width, checkSSE2);
+    }
+  }
+}
+
+template <class Op> void vpMorphRectangle(vpImage<unsigned char> &I, unsigned int width, unsigned int height)
+{
+  if (width == 0 || height == 0) {
+    throw(vpException(vpException::badValue, "Bad structuring element size %ux%u", width, height));
+  }
+  if (I.getSize() == 0) {
+    std::cerr << "Input image is empty!" << std::endl;
+    return;
+  }
+
+#if VISP_HAVE_SSE2
+  bool checkSSE2 = vpCPUFeatures::checkSSE2();
+#else
+  bool checkSSE2 = false;
+#endif
+
+  // The rectangle is separable: a horizontal line followed by a vertical one
+  if (width > 1) {
+    vpMorphRows<Op>(I, width, checkSSE2);
+  }
+  if (height > 1) {
+    vpMorphColumns<Op>(I, height, checkSSE2);
+  }
+}
+}
+#endif
+
 
 /*!
   Erode a grayscale image using the given structuring element.
@@ -286,3 +495,126 @@ void vpImageMorphology::dilatation(vpImage<unsigned char> &I, const vpConnexityT
     }
   }
 }
+
+/*!
+  Erode a grayscale image with a rectangular flat structuring element, that
+  is replace each pixel by the minimum over the width x height window around
+  it. Like erosion(vpImage<unsigned char> &, const vpConnexityType &), the
+  image is assumed to be 255 outside of its domain.
+
+  The window is centered on the pixel, or starts width/2 (resp. height/2)
+  pixels before the pixel for an even size. A horizontal or vertical line
+  structuring element is a rectangle of height or width 1.
+
+  The van Herk / Gil-Werman algorithm is used, so that the cost per pixel
+  doesn't depend on the size of the structuring element.
+
+  \param I : Image to process.
+  \param width : Width of the structuring element.
+  \param height : Height of the structuring element.
+
+  \exception vpException::badValue : If the width or the height is null.
+
+  \sa dilatation(vpImage<unsigned char> &, unsigned int, unsigned int)
+*/
+void vpImageMorphology::erosion(vpImage<unsigned char> &I, unsigned int width, unsigned int height)
+{
+  vpMorphRectangle<vpMorphMin>(I, width, height);
+}
+
+/*!
+  Dilate a grayscale image with a rectangular flat structuring element, that
+  is replace each pixel by the maximum over the width x height window around
+  it. Like dilatation(vpImage<unsigned char> &, const vpConnexityType &), the
+  image is assumed to be 0 outside of its domain.
+
+  The window is centered on the pixel, or starts width/2 (resp. height/2)
+  pixels before the pixel for an even size.
+
+  \param I : Image to process.
+  \param width : Width of the structuring element.
+  \param height : Height of the structuring element.
+
+  \exception vpException::badValue : If the width or the height is null.
+
+  \sa erosion(vpImage<unsigned char> &, unsigned int, unsigned int)
+*/
+void vpImageMorphology::dilatation(vpImage<unsigned char> &I, unsigned int width, unsigned int height)
+{
+  vpMorphRectangle<vpMorphMax>(I, width, height);
+}
+
+/*!
+  Opening of a grayscale image with a rectangular flat structuring element:
+  an erosion followed by a dilatation. It removes the bright details smaller
+  than the structuring element.
+
+  \param I : Image to process.
+  \param width : Width of the structuring element.
+  \param height : Height of the structuring element.
+
+  \sa closing(), topHat()
+*/
+void vpImageMorphology::opening(vpImage<unsigned char> &I, unsigned int width, unsigned int height)
+{
+  erosion(I, width, height);
+  dilatation(I, width, height);
+}
+
+/*!
+  Closing of a grayscale image with a rectangular flat structuring element:
+  a dilatation followed by an erosion. It removes the dark details smaller
+  than the structuring element.
+
+  \param I : Image to process.
+  \param width : Width of the structuring element.
+  \param height : Height of the structuring element.
+
+  \sa opening()
+*/
+void vpImageMorphology::closing(vpImage<unsigned char> &I, unsigned int width, unsigned int height)
+{
+  dilatation(I, width, height);
+  erosion(I, width, height);
+}
+
+/*!
+  White top-hat of a grayscale image with a rectangular flat structuring
+  element: the difference between the image and its opening. It keeps the
+  bright details smaller than the structuring element.
+
+  \param I : Image to process.
+  \param width : Width of the structuring element.
+  \param height : Height of the structuring element.
+
+  \sa opening()
+*/
+void vpImageMorphology::topHat(vpImage<unsigned char> &I, unsigned int width, unsigned int height)
+{
+  vpImage<unsigned char> I_opening(I);
+  opening(I_opening, width, height);
+
+  for (unsigned int i = 0; i < I.getSize(); i++) {
+    I.bitmap[i] -= I_opening.bitmap[i];
+  }
+}
+
+/*!
+  Morphological gradient of a grayscale image with a rectangular flat
+  structuring element: the difference between its dilatation and its
+  erosion.
+
+  \param I : Image to process.
+  \param width : Width of the structuring element.
+  \param height : Height of the structuring element.
+*/
+void vpImageMorphology::gradient(vpImage<unsigned char> &I, unsigned int width, unsigned int height)
+{
+  vpImage<unsigned char> I_erosion(I);
+  erosion(I_erosion, width, height);
+  dilatation(I, width, height);
+
+  for (unsigned int i = 0; i < I.getSize(); i++) {
+    I.bitmap[i] -= I_erosion.bitmap[i];
+  }
+}
@@ -44,6 +44,105 @@
 #  define VISP_HAVE_SSE2 1
 #endif
 
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+namespace
+{
+// Prefix sums of the rows of I (or of their squares) in the rows 1 to height of II, whose first column is 0
+template <class Type> void integralRows(const vpImage<unsigned char> &I, vpImage<Type> &II, const bool squared)
+{
+  const int height = (int)I.getHeight(), width = (int)I.getWidth();
+
+#ifdef VISP_HAVE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+  for (int i = 0; i < height; i++) {
+    const unsigned char *src = I[(unsigned int)i];
+    Type *dst = II[(unsigned int)i + 1];
+    Type sum = 0;
+    dst[0] = 0;
+    if (squared) {
+      for (int j = 0; j < width; j++) {
+        sum += (Type)src[j] * (Type)src[j];
+        dst[j + 1] = sum;
+      }
+    } else {
+      for (int j = 0; j < width; j++) {
+        sum += (Type)src[j];
+        dst[j + 1] = sum;
+      }
+    }
+  }
+}
+
+#if VISP_HAVE_SSE2
+// Prefix sums of 4 consecutive 32-bit values, added to the last sum of the previous values
+inline __m128i prefixSum4(__m128i v, __m128i &carry)
+{
+  v = _mm_add_epi32(v, _mm_slli_si128(v, 4));
+  v = _mm_add_epi32(v, _mm_slli_si128(v, 8));
+  v = _mm_add_epi32(v, carry);
+  carry = _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 3, 3, 3));
+  return v;
+}
+
+void integralRowsSSE2(const vpImage<unsigned char> &I, vpImage<unsigned int> &II)
+{
+  const int height = (int)I.getHeight(), width = (int)I.getWidth();
+
+#ifdef VISP_HAVE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+  for (int i = 0; i < height; i++) {
+    const unsigned char *src = I[(unsigned int)i];
+    unsigned int *dst = II[(unsigned int)i + 1];
+    const __m128i zero = _mm_setzero_si128();
+    __m128i carry = zero;
+    dst[0] = 0;
+
+    int j = 0;
+    for (; j + 16 <= width; j += 16) {
+      const __m128i v = _mm_loadu_si128((const __m128i *)(src + j));
+      const __m128i lo = _mm_unpacklo_epi8(v, zero), hi = _mm_unpackhi_epi8(v, zero);
+      _mm_storeu_si128((__m128i *)(dst + j + 1), prefixSum4(_mm_unpacklo_epi16(lo, zero), carry));
+      _mm_storeu_si128((__m128i *)(dst + j + 5), prefixSum4(_mm_unpackhi_epi16(lo, zero), carry));
+      _mm_storeu_si128((__m128i *)(dst + j + 9), prefixSum4(_mm_unpacklo_epi16(hi, zero), carry));
+      _mm_storeu_si128((__m128i *)(dst + j + 13), prefixSum4(_mm_unpackhi_epi16(hi, zero), carry));
+    }
+
+    unsigned int sum = (unsigned int)_mm_cvtsi128_si32(carry);
+    for (; j < width; j++) {
+      sum += src[j];
+      dst[j + 1] = sum;
+    }
+  }
+}
+#endif
+
+// Accumulate the rows of II from top to bottom, the first row being set to 0
+template <class Type> void integralColumns(vpImage<Type> &II)
+{
+  const int height = (int)II.getHeight(), width = (int)II.getWidth();
+  memset(II[0], 0, (size_t)width * sizeof(Type));
+
+  // Chunks of columns processed whole rows at a time
+  const int chunkSize = 1024;
+  const int nbChunks = (width + chunkSize - 1) / chunkSize;
+#ifdef VISP_HAVE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+  for (int chunk = 0; chunk < nbChunks; chunk++) {
+    const int j0 = chunk * chunkSize, j1 = std::min(width, j0 + chunkSize);
+    for (int i = 2; i < height; i++) {
+      const Type *prev = II[(unsigned int)i - 1];
+      Type *row = II[(unsigned int)i];
+      for (int j = j0; j < j1; j++) {
+        row[j] += prev[j];
+      }
+    }
+  }
+}
+}
+#endif
 
 /*!
   Change the look up table (LUT) of an image. Considering pixel gray
@@ -113,21 +212,21 @@ void vpImageTools::changeLUT(vpImage<unsigned char>& I,
     throw (vpImageException(vpImageException::incorrectInitializationError ,
                             "Bad gray levels"));
   }
-  unsigned char v;
 
   double factor = (double)(B_star - A_star)/(double)(B - A);
 
-  for (unsigned int i=0 ; i < I.getHeight(); i++)
-    for (unsigned int j=0 ; j < I.getWidth(); j++) {
-      v = I[i][j];
+  // Construct the look-up table
+  unsigned char lut[256];
+  for (unsigned int v = 0; v < 256; v++) {
+    if (v <= A)
+      lut[v] = A_star;
+    else if (v >= B)
+      lut[v] = B_star;
+    else
+      lut[v] = (unsigned char)(A_star + factor*(v-A));
+  }
 
-      if (v <= A)
-        I[i][j] = A_star;
-      else if (v >= B)
-        I[i][j] = B_star;
-      else
-        I[i][j] = (unsigned char)(A_star + factor*(v-A));
-    }
+  I.performLut(lut);
 }
 
 /*!
@@ -378,3 +477,81 @@ float vpImageTools::cubicHermite (const float A, const float B, const float C, c
 float vpImageTools::lerp(const float A, const float B, const float t) {
   return A * (1.0f - t) + B * t;
 }
+
+/*!
+  Compute the integral image of a gray level image: each value II[i][j] is
+  the sum of the pixels I[u][v] with u < i and v < j. The integral image has
+  one more row and one more column than the image, the first ones being 0, so
+  that the sum of any rectangular region is given in constant time by
+  boxSum().
+
+  With 32-bit accumulators, the values wrap around for images of more than
+  16843009 pixels, but the sum of any region smaller than this size given by
+  boxSum() is still exact thanks to the modular arithmetic.
+
+  \param I : Gray level image.
+  \param II : Integral image, of size (I.getHeight()+1) x (I.getWidth()+1).
+
+  \sa boxSum()
+*/
+void vpImageTools::integralImage(const vpImage<unsigned char> &I, vpImage<unsigned int> &II)
+{
+  II.resize(I.getHeight() + 1, I.getWidth() + 1);
+#if VISP_HAVE_SSE2
+  if (vpCPUFeatures::checkSSE2()) {
+    integralRowsSSE2(I, II);
+  } else {
+    integralRows(I, II, false);
+  }
+#else
+  integralRows(I, II, false);
+#endif
+  integralColumns(II);
+}
+
+/*!
+  Compute the integral image of a gray level image with 64-bit accumulators,
+  so that the values never overflow.
+
+  \param I : Gray level image.
+  \param II : Integral image, of size (I.getHeight()+1) x (I.getWidth()+1).
+
+  \sa integralImage(const vpImage<unsigned char> &, vpImage<unsigned int> &), boxSum()
+*/
+void vpImageTools::integralImage(const vpImage<unsigned char> &I, vpImage<unsigned long long> &II)
+{
+  II.resize(I.getHeight() + 1, I.getWidth() + 1);
+  integralRows(I, II, false);
+  integralColumns(II);
+}
+
+/*!
+  Compute the integral image and the integral image of the squared pixel
+  values, to get the mean and the variance of any rectangular region in
+  constant time.
+
+  \param I : Gray level image.
+  \param II : Integral image, of size (I.getHeight()+1) x (I.getWidth()+1).
+  \param IIsq : Integral image of the squared values, with 64-bit accumulators.
+
+  \code
+  vpImage<unsigned int> II;
+  vpImage<unsigned long long> IIsq;
+  vpImageTools::integralImage(I, II, IIsq);
+
+  // Mean and variance of the 15x15 region whose top left corner is at (i, j)
+  double n = 15 * 15;
+  double mean = vpImageTools::boxSum(II, i, j, 15, 15) / n;
+  double variance = vpImageTools::boxSum(IIsq, i, j, 15, 15) / n - mean * mean;
+  \endcode
+
+  \sa integralImage(const vpImage<unsigned char> &, vpImage<unsigned int> &), boxSum()
+*/
+void vpImageTools::integralImage(const vpImage<unsigned char> &I, vpImage<unsigned int> &II,
+                                 vpImage<unsigned long long> &IIsq)
+{
+  integralImage(I, II);
+  IIsq.resize(I.getHeight() + 1, I.getWidth() + 1);
+  integralRows(I, IIsq, true);
+  integralColumns(IIsq);
+}
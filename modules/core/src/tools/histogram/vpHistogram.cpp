@@ -49,89 +49,107 @@
 #include <visp3/core/vpHistogram.h>
 #include <visp3/core/vpImageConvert.h>
 #include <visp3/core/vpDisplay.h>
-
+#include <visp3/core/vpMath.h>
 
 #if defined(VISP_HAVE_PTHREAD) || (defined(_WIN32) && !defined(WINRT_8_0))
 #include <visp3/core/vpThread.h>
+#endif
 
 namespace {
+  /*
+    Count the pixels by gray level in 4 interleaved banks, so that consecutive
+    pixels of the same level, as in uniform areas, increment different counters
+    and don't wait for the previous increment. The binning is done once on the
+    256 level counts by merge().
+  */
+  class vpHistogramBanks {
+  public:
+    vpHistogramBanks() {
+      memset(m_banks, 0, sizeof(m_banks));
+    }
+
+    void add(const unsigned char *ptr, const size_t n) {
+      size_t k = 0;
+      for (; k + 4 <= n; k += 4) {
+        m_banks[0][ptr[k]]++;
+        m_banks[1][ptr[k+1]]++;
+        m_banks[2][ptr[k+2]]++;
+        m_banks[3][ptr[k+3]]++;
+      }
+      for (; k < n; k++) {
+        m_banks[0][ptr[k]]++;
+      }
+    }
+
+    // Count only the pixels whose mask value is not 0
+    void add(const unsigned char *ptr, const unsigned char *mask, const size_t n) {
+      size_t k = 0;
+      for (; k + 4 <= n; k += 4) {
+        m_banks[0][ptr[k]] += (mask[k] != 0);
+        m_banks[1][ptr[k+1]] += (mask[k+1] != 0);
+        m_banks[2][ptr[k+2]] += (mask[k+2] != 0);
+        m_banks[3][ptr[k+3]] += (mask[k+3] != 0);
+      }
+      for (; k < n; k++) {
+        m_banks[0][ptr[k]] += (mask[k] != 0);
+      }
+    }
+
+    // Add the counts to the histogram of size bins, the gray level i going in the bin lut[i]
+    void merge(unsigned int *histogram, const unsigned int lut[256]) const {
+      for (unsigned int i = 0; i < 256; i++) {
+        histogram[lut[i]] += m_banks[0][i] + m_banks[1][i] + m_banks[2][i] + m_banks[3][i];
+      }
+    }
+
+  private:
+    unsigned int m_banks[4][256];
+  };
+
+  // Bin of each gray level for a histogram of size bins
+  void computeBinLut(const unsigned int size, unsigned int lut[256]) {
+    for(unsigned int i = 0; i < 256; i++) {
+      lut[i] = (unsigned int) (i * size / 256.0);
+    }
+  }
+
+  // Number of bins in ]0 ; 256]
+  unsigned int checkBins(const unsigned int nbins) {
+    if(nbins > 256 || nbins == 0) {
+      std::cerr << "nbins=" << nbins << " , nbins should be between ]0 ; 256] ; use by default nbins=256" << std::endl;
+      return 256;
+    }
+    return nbins;
+  }
+
+#if defined(VISP_HAVE_PTHREAD) || (defined(_WIN32) && !defined(WINRT_8_0))
   struct Histogram_Param_t {
     unsigned int m_start_index;
     unsigned int m_end_index;
 
-    unsigned int m_lut[256];
-    unsigned int *m_histogram;
+    vpHistogramBanks m_banks;
     const vpImage<unsigned char> *m_I;
 
-    Histogram_Param_t() : m_start_index(0), m_end_index(0), m_lut(), m_histogram(NULL), m_I(NULL) {
+    Histogram_Param_t() : m_start_index(0), m_end_index(0), m_banks(), m_I(NULL) {
     }
 
     Histogram_Param_t(const unsigned int start_index, const unsigned int end_index,
         const vpImage<unsigned char> * const I) :
-      m_start_index(start_index), m_end_index(end_index), m_lut(), m_histogram(NULL), m_I(I) {
-    }
-
-    ~Histogram_Param_t() {
-      if(m_histogram != NULL) {
-        delete []m_histogram;
-      }
+      m_start_index(start_index), m_end_index(end_index), m_banks(), m_I(I) {
     }
   };
 
   vpThread::Return computeHistogramThread(vpThread::Args args) {
     Histogram_Param_t *histogram_param = static_cast<Histogram_Param_t *>(args);
-    unsigned int start_index = histogram_param->m_start_index;
-    unsigned int end_index = histogram_param->m_end_index;
-
     const vpImage<unsigned char> *I = histogram_param->m_I;
 
-    unsigned char *ptrStart = (unsigned char*) (I->bitmap) + start_index;
-    unsigned char *ptrEnd = (unsigned char*) (I->bitmap) + end_index;
-    unsigned char *ptrCurrent = ptrStart;
-
-
-//    while(ptrCurrent != ptrEnd) {
-//      histogram_param->m_histogram[ histogram_param->m_lut[ *ptrCurrent ] ] ++;
-//      ++ptrCurrent;
-//    }
-
-    if(end_index - start_index >= 8) {
-      //Unroll loop version
-      for(; ptrCurrent <= ptrEnd - 8;) {
-        histogram_param->m_histogram[ histogram_param->m_lut[ *ptrCurrent ] ] ++;
-        ++ptrCurrent;
-
-        histogram_param->m_histogram[ histogram_param->m_lut[ *ptrCurrent ] ] ++;
-        ++ptrCurrent;
-
-        histogram_param->m_histogram[ histogram_param->m_lut[ *ptrCurrent ] ] ++;
-        ++ptrCurrent;
-
-        histogram_param->m_histogram[ histogram_param->m_lut[ *ptrCurrent ] ] ++;
-        ++ptrCurrent;
-
-        histogram_param->m_histogram[ histogram_param->m_lut[ *ptrCurrent ] ] ++;
-        ++ptrCurrent;
-
-        histogram_param->m_histogram[ histogram_param->m_lut[ *ptrCurrent ] ] ++;
-        ++ptrCurrent;
-
-        histogram_param->m_histogram[ histogram_param->m_lut[ *ptrCurrent ] ] ++;
-        ++ptrCurrent;
-
-        histogram_param->m_histogram[ histogram_param->m_lut[ *ptrCurrent ] ] ++;
-        ++ptrCurrent;
-      }
-    }
-
-    for(; ptrCurrent != ptrEnd; ++ptrCurrent) {
-      histogram_param->m_histogram[ histogram_param->m_lut[ *ptrCurrent ] ] ++;
-    }
+    histogram_param->m_banks.add(I->bitmap + histogram_param->m_start_index,
+                                 histogram_param->m_end_index - histogram_param->m_start_index);
 
     return 0;
   }
-}
 #endif
+}
 
 bool compare_vpHistogramPeak (vpHistogramPeak first, vpHistogramPeak second);
 
@@ -243,21 +261,13 @@ vpHistogram::init(unsigned size_)
 */
 void vpHistogram::calculate(const vpImage<unsigned char> &I, const unsigned int nbins, const unsigned int nbThreads)
 {
-  if(size != nbins) {
-    if (histogram != NULL) {
-      delete [] histogram;
-      histogram = NULL;
-    }
-
-    size = nbins > 256 ? 256 : (nbins > 0 ? nbins : 256);
-    if(nbins > 256 || nbins == 0) {
-      std::cerr << "nbins=" << nbins << " , nbins should be between ]0 ; 256] ; use by default nbins=256" << std::endl;
-    }
-    histogram = new unsigned int[size];
+  const unsigned int nbins_ = checkBins(nbins);
+  if(size != nbins_ || histogram == NULL) {
+    init(nbins_);
+  } else {
+    memset(histogram, 0, size * sizeof(unsigned int));
   }
 
-  memset(histogram, 0, size * sizeof(unsigned int));
-
 
   bool use_single_thread;
 #if !defined(VISP_HAVE_PTHREAD) && !defined(_WIN32)
@@ -272,22 +282,13 @@ void vpHistogram::calculate(const vpImage<unsigned char> &I, const unsigned int
 
 
   unsigned int lut[256];
-  for(unsigned int i = 0; i < 256; i++) {
-    lut[i] = (unsigned int) (i * size / 256.0);
-  }
+  computeBinLut(size, lut);
 
   if(use_single_thread) {
     //Single thread
-
-    unsigned int size_ = I.getWidth()*I.getHeight();
-    unsigned char *ptrStart = (unsigned char*) I.bitmap;
-    unsigned char *ptrEnd = ptrStart + size_;
-    unsigned char *ptrCurrent = ptrStart;
-
-    while(ptrCurrent != ptrEnd) {
-      histogram[ lut[ *ptrCurrent ] ] ++;
-      ++ptrCurrent;
-    }
+    vpHistogramBanks banks;
+    banks.add(I.bitmap, I.getSize());
+    banks.merge(histogram, lut);
   } else {
 #if defined(VISP_HAVE_PTHREAD) || (defined(_WIN32) && !defined(WINRT_8_0))
     //Multi-threads
@@ -308,10 +309,6 @@ void vpHistogram::calculate(const vpImage<unsigned char> &I, const unsigned int
       }
 
       Histogram_Param_t *histogram_param = new Histogram_Param_t(start_index, end_index, &I);
-      histogram_param->m_histogram = new unsigned int[size];
-      memset(histogram_param->m_histogram, 0, size * sizeof(unsigned int));
-      memcpy(histogram_param->m_lut, lut, 256*sizeof(unsigned int));
-
       histogramParams.push_back(histogram_param);
 
       // Start the threads
@@ -324,14 +321,8 @@ void vpHistogram::calculate(const vpImage<unsigned char> &I, const unsigned int
       threadpool[cpt]->join();
     }
 
-    for(unsigned int cpt1 = 0; cpt1 < size; cpt1++) {
-      unsigned int sum = 0;
-
-      for(size_t cpt2 = 0; cpt2 < histogramParams.size(); cpt2++) {
-        sum += histogramParams[cpt2]->m_histogram[cpt1];
-      }
-
-      histogram[cpt1] = sum;
+    for(size_t cpt = 0; cpt < histogramParams.size(); cpt++) {
+      histogramParams[cpt]->m_banks.merge(histogram, lut);
     }
 
     //Delete
@@ -346,6 +337,135 @@ void vpHistogram::calculate(const vpImage<unsigned char> &I, const unsigned int
   }
 }
 
+/*!
+
+  Calculate the histogram of a region of interest of a gray level image,
+  optionally restricted to the pixels of a mask.
+
+  \param I : Gray level image.
+  \param roi : Region of interest, clipped to the image.
+  \param mask : If not NULL, only the pixels whose mask value is not 0 are
+  counted. The mask has the size of the image.
+  \param nbins : Number of bins to compute the histogram.
+
+  \exception vpException::dimensionError : If the mask and the image sizes
+  differ.
+
+  \code
+  vpImage<unsigned char> I, mask;
+  ...
+  vpHistogram h;
+  h.calculate(I, vpRect(0, 0, I.getWidth(), I.getHeight()), &mask); // Histogram of the masked pixels
+  \endcode
+*/
+void vpHistogram::calculate(const vpImage<unsigned char> &I, const vpRect &roi, const vpImage<unsigned char> *mask,
+                            const unsigned int nbins)
+{
+  if (mask != NULL && (mask->getHeight() != I.getHeight() || mask->getWidth() != I.getWidth())) {
+    throw(vpException(vpException::dimensionError, "Mask size (%ux%u) differs from image size (%ux%u)",
+                      mask->getWidth(), mask->getHeight(), I.getWidth(), I.getHeight()));
+  }
+
+  const unsigned int nbins_ = checkBins(nbins);
+  if(size != nbins_ || histogram == NULL) {
+    init(nbins_);
+  } else {
+    memset(histogram, 0, size * sizeof(unsigned int));
+  }
+
+  //Clip the region of interest to the image
+  int left = std::max(0, vpMath::round(roi.getLeft()));
+  int top = std::max(0, vpMath::round(roi.getTop()));
+  int right = std::min((int) I.getWidth(), vpMath::round(roi.getLeft() + roi.getWidth()));
+  int bottom = std::min((int) I.getHeight(), vpMath::round(roi.getTop() + roi.getHeight()));
+  if (left >= right || top >= bottom) {
+    return;
+  }
+
+  vpHistogramBanks banks;
+  for (int i = top; i < bottom; i++) {
+    if (mask != NULL) {
+      banks.add(I[(unsigned int) i] + left, (*mask)[(unsigned int) i] + left, (size_t) (right - left));
+    } else {
+      banks.add(I[(unsigned int) i] + left, (size_t) (right - left));
+    }
+  }
+
+  unsigned int lut[256];
+  computeBinLut(size, lut);
+  banks.merge(histogram, lut);
+}
+
+/*!
+
+  Calculate the joint histogram of two gray level images of the same size,
+  where the bin (a, b) counts the pixels whose level is in the bin a in
+  \e I1 and in the bin b in \e I2.
+
+  \param I1 : First gray level image.
+  \param I2 : Second gray level image.
+  \param joint : Joint histogram of size nbins1 x nbins2, in row major order:
+  the count of the bin (a, b) is joint[a * nbins2 + b].
+  \param nbins1 : Number of bins of the levels of \e I1, in ]0 ; 256].
+  \param nbins2 : Number of bins of the levels of \e I2, in ]0 ; 256].
+  \param mask : If not NULL, only the pixels whose mask value is not 0 are
+  counted. The mask has the size of the images.
+
+  \exception vpException::dimensionError : If the image or mask sizes differ.
+*/
+void vpHistogram::calculateJoint(const vpImage<unsigned char> &I1, const vpImage<unsigned char> &I2,
+                                 std::vector<unsigned int> &joint, const unsigned int nbins1,
+                                 const unsigned int nbins2, const vpImage<unsigned char> *mask)
+{
+  if (I1.getHeight() != I2.getHeight() || I1.getWidth() != I2.getWidth()) {
+    throw(vpException(vpException::dimensionError, "Cannot compute the joint histogram of a %ux%u and a %ux%u image",
+                      I1.getWidth(), I1.getHeight(), I2.getWidth(), I2.getHeight()));
+  }
+  if (mask != NULL && (mask->getHeight() != I1.getHeight() || mask->getWidth() != I1.getWidth())) {
+    throw(vpException(vpException::dimensionError, "Mask size (%ux%u) differs from image size (%ux%u)",
+                      mask->getWidth(), mask->getHeight(), I1.getWidth(), I1.getHeight()));
+  }
+
+  const unsigned int size1 = checkBins(nbins1), size2 = checkBins(nbins2);
+  unsigned int lut1[256], lut2[256];
+  computeBinLut(size1, lut1);
+  computeBinLut(size2, lut2);
+  for (unsigned int i = 0; i < 256; i++) {
+    lut1[i] *= size2;
+  }
+
+  //Two banks: the second image is usually correlated with the first one, so
+  //that consecutive pixels often fall in the same bin
+  std::vector<unsigned int> banks(2 * size1 * size2, 0);
+  unsigned int *bank0 = &banks[0], *bank1 = bank0 + size1 * size2;
+  const unsigned char *ptr1 = I1.bitmap, *ptr2 = I2.bitmap;
+  const size_t n = I1.getSize();
+  size_t k = 0;
+  if (mask == NULL) {
+    for (; k + 2 <= n; k += 2) {
+      bank0[lut1[ptr1[k]] + lut2[ptr2[k]]]++;
+      bank1[lut1[ptr1[k+1]] + lut2[ptr2[k+1]]]++;
+    }
+    for (; k < n; k++) {
+      bank0[lut1[ptr1[k]] + lut2[ptr2[k]]]++;
+    }
+  } else {
+    const unsigned char *ptrMask = mask->bitmap;
+    for (; k + 2 <= n; k += 2) {
+      bank0[lut1[ptr1[k]] + lut2[ptr2[k]]] += (ptrMask[k] != 0);
+      bank1[lut1[ptr1[k+1]] + lut2[ptr2[k+1]]] += (ptrMask[k+1] != 0);
+    }
+    for (; k < n; k++) {
+      bank0[lut1[ptr1[k]] + lut2[ptr2[k]]] += (ptrMask[k] != 0);
+    }
+  }
+
+  joint.resize(size1 * size2);
+  for (unsigned int i = 0; i < size1 * size2; i++) {
+    joint[i] = bank0[i] + bank1[i];
+  }
+}
+
 /*!
   Display the histogram distribution in an image, the minimal image size is 36x36 px.
 
@@ -37,13 +37,40 @@
  *****************************************************************************/
 
 
+#include <algorithm>
+#include <errno.h>
+#include <limits.h>
+
 #include <visp3/core/vpNetwork.h>
 
+#if !defined(_WIN32) && (defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__))) // UNIX
+#  include <sys/uio.h>
+#endif
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+namespace
+{
+// A binary frame starts with a header made of three 32 bits words in network
+// byte order: the magic number "VPB1", the length of the request id and the
+// number of parameters. It is followed by the length of each parameter (32
+// bits words), the request id and the parameters.
+const unsigned int vpFrameMagic = 0x56504231;
+// Limits used to detect a corrupted stream
+const unsigned int vpFrameMaxIdLength = 65536;
+const unsigned int vpFrameMaxParams = 1048576;
+#if defined(IOV_MAX)
+const size_t vpFrameMaxIov = IOV_MAX;
+#else
+const size_t vpFrameMaxIov = 64;
+#endif
+}
+#endif
+
 vpNetwork::vpNetwork()
   : emitter(), receptor_list(), readFileDescriptor(), socketMax(0), request_list(),
-    max_size_message(999999), separator("[*@*]"), beginning("[*start*]"), end("[*end*]"),
-    param_sep("[*|*]"), currentMessageReceived(), tv(), tv_sec(0), tv_usec(10),
-    verboseMode(false)
+    max_size_message(999999), max_size_frame(64*1024*1024), separator("[*@*]"), beginning("[*start*]"), end("[*end*]"),
+    param_sep("[*|*]"), currentMessageReceived(), receiveBuffer(), protocol(PROTOCOL_TEXT),
+    tv(), tv_sec(0), tv_usec(10), verboseMode(false)
 {
   tv.tv_sec = tv_sec;
 #if TARGET_OS_IPHONE
@@ -201,7 +228,16 @@ int vpNetwork::sendRequestTo(vpRequest &req, const unsigned int &dest)
     return 0;
   }
 
-  std::string message = beginning + req.getId() + separator;
+  if(protocol == PROTOCOL_BINARY)
+    return _sendFrameTo(req, dest);
+
+  size_t messageSize = beginning.size() + req.getId().size() + separator.size() + end.size();
+  for(unsigned int i = 0 ; i < req.size() ; i++)
+    messageSize += param_sep.size() + req[i].size();
+
+  std::string message;
+  message.reserve(messageSize);
+  message = beginning + req.getId() + separator;
 
   if(req.size() != 0){
     message += req[0];
@@ -285,6 +321,9 @@ int vpNetwork::sendAndEncodeRequestTo(vpRequest &req, const unsigned int &dest)
 */
 std::vector<int> vpNetwork::receiveRequest()
 {
+  if(protocol == PROTOCOL_BINARY)
+    return _receiveFrames(-1);
+
   _receiveRequest();
   return _handleRequests();
 }
@@ -307,6 +346,9 @@ std::vector<int> vpNetwork::receiveRequest()
 */
 std::vector<int> vpNetwork::receiveRequestFrom(const unsigned int &receptorEmitting)
 {
+  if(protocol == PROTOCOL_BINARY)
+    return _receiveFrames((int)receptorEmitting);
+
   _receiveRequestFrom(receptorEmitting);
   return _handleRequests();
 }
@@ -331,6 +373,11 @@ std::vector<int> vpNetwork::receiveRequestFrom(const unsigned int &receptorEmitt
 */
 int vpNetwork::receiveRequestOnce()
 {
+  if(protocol == PROTOCOL_BINARY){
+    int numbytes;
+    return _receiveFrameOnce(-1, numbytes);
+  }
+
   _receiveRequestOnce();
   return _handleFirstRequest();
 }
@@ -357,6 +404,11 @@ int vpNetwork::receiveRequestOnce()
 */
 int vpNetwork::receiveRequestOnceFrom(const unsigned int &receptorEmitting)
 {
+  if(protocol == PROTOCOL_BINARY){
+    int numbytes;
+    return _receiveFrameOnce((int)receptorEmitting, numbytes);
+  }
+
   _receiveRequestOnceFrom(receptorEmitting);
   return _handleFirstRequest();
 }
@@ -692,7 +744,9 @@ int vpNetwork::_receiveRequestOnce()
   else{
     for(unsigned int i=0; i<receptor_list.size(); i++){
       if(FD_ISSET((unsigned int)receptor_list[i].socketFileDescriptorReceptor,&readFileDescriptor)){
-        char *buf = new char [max_size_message];
+        if(receiveBuffer.size() < max_size_message)
+          receiveBuffer.resize(max_size_message);
+        char *buf = &receiveBuffer[0];
 #if !defined(_WIN32) && (defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__))) // UNIX
         numbytes=(int)recv(receptor_list[i].socketFileDescriptorReceptor, buf, max_size_message, 0);
 #else
@@ -703,14 +757,11 @@ int vpNetwork::_receiveRequestOnce()
         {
           std::cout << "Disconnected : " << inet_ntoa(receptor_list[i].receptorAddress.sin_addr) << std::endl;
           receptor_list.erase(receptor_list.begin()+(int)i);
-          delete [] buf;
           return numbytes;
         }
         else {
-          std::string returnVal(buf, (unsigned int)numbytes);
-          currentMessageReceived.append(returnVal);
+          currentMessageReceived.append(buf, (size_t)numbytes);
         }
-        delete [] buf;
         break;
       }
     }
@@ -775,7 +826,9 @@ int vpNetwork::_receiveRequestOnceFrom(const unsigned int &receptorEmitting)
   }
   else{
     if(FD_ISSET((unsigned int)receptor_list[receptorEmitting].socketFileDescriptorReceptor,&readFileDescriptor)){
-      char *buf = new char [max_size_message];
+      if(receiveBuffer.size() < max_size_message)
+        receiveBuffer.resize(max_size_message);
+      char *buf = &receiveBuffer[0];
 #if !defined(_WIN32) && (defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__))) // UNIX
       numbytes=(int)recv(receptor_list[receptorEmitting].socketFileDescriptorReceptor, buf, max_size_message, 0);
 #else
@@ -785,14 +838,11 @@ int vpNetwork::_receiveRequestOnceFrom(const unsigned int &receptorEmitting)
       {
         std::cout << "Disconnected : " << inet_ntoa(receptor_list[receptorEmitting].receptorAddress.sin_addr) << std::endl;
         receptor_list.erase(receptor_list.begin()+(int)receptorEmitting);
-        delete [] buf;
         return numbytes;
       }
       else {
-        std::string returnVal(buf, (unsigned int)numbytes);
-        currentMessageReceived.append(returnVal);
+        currentMessageReceived.append(buf, (size_t)numbytes);
       }
-      delete [] buf;
     }
   }
 
@@ -801,3 +851,378 @@ int vpNetwork::_receiveRequestOnceFrom(const unsigned int &receptorEmitting)
 
 
 
+
+/*!
+  Wait until data can be read from the receptors.
+
+  \param receptorEmitting : Index of the receptor to wait for, or -1 to wait for all the receptors.
+  \param ready : Indexes of the receptors from which data can be read.
+
+  \return The number of receptors ready, 0 if the timeout expired, -1 if an error occured.
+*/
+int vpNetwork::_waitForReceptors(const int &receptorEmitting, std::vector<unsigned int> &ready)
+{
+  ready.clear();
+  if(receptor_list.size() == 0 || (receptorEmitting >= 0 && (unsigned int)receptorEmitting >= receptor_list.size()))
+  {
+    if(verboseMode)
+      vpTRACE( "No receptor at the specified index!" );
+    return -1;
+  }
+
+  tv.tv_sec = tv_sec;
+#if TARGET_OS_IPHONE
+  tv.tv_usec = (int)tv_usec;
+#else
+  tv.tv_usec = tv_usec;
+#endif
+
+  unsigned int first = (receptorEmitting >= 0) ? (unsigned int)receptorEmitting : 0;
+  unsigned int last = (receptorEmitting >= 0) ? first + 1 : (unsigned int)receptor_list.size();
+
+  FD_ZERO(&readFileDescriptor);
+  socketMax = receptor_list[first].socketFileDescriptorReceptor;
+  for(unsigned int i = first ; i < last ; i++){
+    FD_SET((unsigned int)receptor_list[i].socketFileDescriptorReceptor,&readFileDescriptor);
+    if(socketMax < receptor_list[i].socketFileDescriptorReceptor) socketMax = receptor_list[i].socketFileDescriptorReceptor;
+  }
+
+  int value = select((int)socketMax+1,&readFileDescriptor,NULL,NULL,&tv);
+  if(value == -1){
+    if(verboseMode)
+      vpERROR_TRACE( "Select error" );
+    return -1;
+  }
+
+  for(unsigned int i = first ; i < last ; i++){
+    if(FD_ISSET((unsigned int)receptor_list[i].socketFileDescriptorReceptor,&readFileDescriptor))
+      ready.push_back(i);
+  }
+
+  return value;
+}
+
+/*!
+  Receive binary frames until there is no more data to receive.
+
+  \param receptorEmitting : Index of the receptor emitting the frames, or -1 for all the receptors.
+
+  \return The list of index corresponding to the requests that have been received.
+*/
+std::vector<int> vpNetwork::_receiveFrames(const int &receptorEmitting)
+{
+  std::vector<int> resIndex;
+  int numbytes = 0;
+  do{
+    int index = _receiveFrameOnce(receptorEmitting, numbytes);
+    if(index != -1)
+      resIndex.push_back(index);
+  } while(numbytes > 0);
+
+  return resIndex;
+}
+
+/*!
+  Wait for data and read it in the binary frame of the first receptor ready.
+
+  \param receptorEmitting : Index of the receptor emitting the frame, or -1 for all the receptors.
+  \param numbytes : The number of bytes received, 0 if nothing has been received, -1 if an error occured.
+
+  \return The index of the request that has been received, -1 if no frame is complete.
+*/
+int vpNetwork::_receiveFrameOnce(const int &receptorEmitting, int &numbytes)
+{
+  std::vector<unsigned int> ready;
+  numbytes = _waitForReceptors(receptorEmitting, ready);
+  if(numbytes <= 0 || ready.empty()){
+    if(numbytes > 0)
+      numbytes = 0;
+    return -1;
+  }
+
+  return _readFrame(ready[0], numbytes);
+}
+
+/*!
+  Close the connection with a receptor that sent a corrupted frame or a frame
+  larger than the maximum size set with setMaxSizeReceivedFrame().
+
+  \param index : Index of the receptor.
+*/
+void vpNetwork::_rejectFrame(const unsigned int &index)
+{
+  std::cout << "Incorrect frame, disconnected : " << inet_ntoa(receptor_list[index].receptorAddress.sin_addr) << std::endl;
+#if !defined(_WIN32) && (defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__))) // UNIX
+  close( receptor_list[index].socketFileDescriptorReceptor );
+#else //Win32
+  closesocket( (unsigned)receptor_list[index].socketFileDescriptorReceptor );
+#endif
+  receptor_list.erase(receptor_list.begin()+(int)index);
+}
+
+/*!
+  Read, without blocking, the available data of the binary frame sent by a
+  receptor. The parameters of the request are received directly in the decoding
+  request which id corresponds to the frame.
+
+  \param index : Index of the receptor.
+  \param numbytes : The number of bytes received, 0 or -1 if the receptor has been disconnected.
+
+  \return The index of the request that has been received, -1 if the frame is not complete.
+*/
+int vpNetwork::_readFrame(const unsigned int &index, int &numbytes)
+{
+  vpFrame &f = receptor_list[index].frame;
+  numbytes = 0;
+  if(receiveBuffer.size() == 0)
+    receiveBuffer.resize(65536);
+
+#if !defined(_WIN32) && (defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__))) // UNIX
+  std::vector<struct iovec> iov;
+#endif
+
+  for(;;){
+    // Go through the completed parts of the frame
+    if(f.stage == 0 && f.offset == sizeof(f.header)){
+      unsigned int magic = ntohl(f.header[0]);
+      unsigned int idLength = ntohl(f.header[1]);
+      unsigned int nbParams = ntohl(f.header[2]);
+      if(magic != vpFrameMagic || idLength > vpFrameMaxIdLength || nbParams > vpFrameMaxParams
+         || nbParams*sizeof(unsigned int) + idLength > max_size_frame){
+        _rejectFrame(index);
+        numbytes = -1;
+        return -1;
+      }
+      f.meta.resize(nbParams*sizeof(unsigned int) + idLength);
+      f.stage = 1;
+      f.offset = 0;
+      continue;
+    }
+    if(f.stage == 1 && f.offset == f.meta.size()){
+      unsigned int nbParams = ntohl(f.header[2]);
+      f.lengths.resize(nbParams);
+      // Check the size of the frame before allocating the parameters
+      size_t frameSize = f.meta.size();
+      for(unsigned int k = 0 ; k < nbParams ; k++){
+        unsigned int length;
+        memcpy(&length, &f.meta[k*sizeof(unsigned int)], sizeof(unsigned int));
+        f.lengths[k] = ntohl(length);
+        if(f.lengths[k] > max_size_frame - frameSize){
+          _rejectFrame(index);
+          numbytes = -1;
+          return -1;
+        }
+        frameSize += f.lengths[k];
+      }
+      std::string id(f.meta.begin() + (std::ptrdiff_t)(nbParams*sizeof(unsigned int)), f.meta.end());
+
+      f.request = -1;
+      for(unsigned int i = 0 ; i < request_list.size() ; i++){
+        if(id == request_list[i]->getId()){
+          f.request = (int)i;
+          break;
+        }
+      }
+
+      if(f.request != -1){
+        // The parameters keep their memory from one frame to the next
+        std::vector<std::string> &params = request_list[(unsigned int)f.request]->listOfParams;
+        params.resize(nbParams);
+        for(unsigned int k = 0 ; k < nbParams ; k++)
+          params[k].resize(f.lengths[k]);
+      }
+      else if(verboseMode)
+        vpTRACE("No request corresponds to the received message");
+
+      f.stage = 2;
+      f.param = 0;
+      f.offset = 0;
+      continue;
+    }
+    if(f.stage == 2){
+      while(f.param < f.lengths.size() && f.offset == f.lengths[f.param]){
+        f.param++;
+        f.offset = 0;
+      }
+      if(f.param == f.lengths.size()){
+        f.stage = 0;
+        f.offset = 0;
+        return f.request;
+      }
+    }
+
+    // Read the next part of the frame
+    char *buf;
+    size_t size;
+    if(f.stage == 0){
+      buf = (char *)f.header + f.offset;
+      size = sizeof(f.header) - f.offset;
+    }
+    else if(f.stage == 1){
+      buf = &f.meta[f.offset];
+      size = f.meta.size() - f.offset;
+    }
+    else if(f.request == -1){
+      buf = &receiveBuffer[0];
+      size = std::min(receiveBuffer.size(), f.lengths[f.param] - f.offset);
+    }
+    else{
+      buf = &request_list[(unsigned int)f.request]->listOfParams[f.param][f.offset];
+      size = f.lengths[f.param] - f.offset;
+    }
+
+#if !defined(_WIN32) && (defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__))) // UNIX
+    ssize_t n;
+    if(f.stage == 2 && f.request != -1){
+      // Scatter the data over the remaining parameters
+      std::vector<std::string> &params = request_list[(unsigned int)f.request]->listOfParams;
+      iov.clear();
+      for(unsigned int k = f.param ; k < f.lengths.size() && iov.size() < vpFrameMaxIov ; k++){
+        size_t start = (k == f.param) ? f.offset : 0;
+        if(f.lengths[k] > start){
+          struct iovec v;
+          v.iov_base = &params[k][start];
+          v.iov_len = f.lengths[k] - start;
+          iov.push_back(v);
+        }
+      }
+      struct msghdr msg;
+      memset(&msg, 0, sizeof(msg));
+      msg.msg_iov = &iov[0];
+      msg.msg_iovlen = iov.size();
+      n = recvmsg(receptor_list[index].socketFileDescriptorReceptor, &msg, MSG_DONTWAIT);
+    }
+    else
+      n = recv(receptor_list[index].socketFileDescriptorReceptor, buf, size, MSG_DONTWAIT);
+
+    if(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+      return -1;
+#else
+    // The sockets are blocking: only read the data known to be available
+    if(numbytes > 0)
+      return -1;
+    int n = recv((unsigned int)receptor_list[index].socketFileDescriptorReceptor, buf, (int)size, 0);
+#endif
+
+    if(n <= 0){
+      std::cout << "Disconnected : " << inet_ntoa(receptor_list[index].receptorAddress.sin_addr) << std::endl;
+      receptor_list.erase(receptor_list.begin()+(int)index);
+      numbytes = (int)n;
+      return -1;
+    }
+    numbytes += (int)n;
+
+    if(f.stage == 2 && f.request != -1){
+      size_t m = (size_t)n;
+      while(m > 0){
+        size_t left = f.lengths[f.param] - f.offset;
+        if(m >= left){
+          m -= left;
+          f.param++;
+          f.offset = 0;
+        }
+        else{
+          f.offset += m;
+          m = 0;
+        }
+      }
+    }
+    else
+      f.offset += (size_t)n;
+  }
+}
+
+/*!
+  Send a request as a binary frame. The header, the id and the parameters of
+  the request are sent together without being copied in a single message.
+
+  \param req : Request to send.
+  \param dest : Index of the receptor receiving the request.
+
+  \return The number of bytes that have been sent, -1 if an error occured.
+*/
+int vpNetwork::_sendFrameTo(vpRequest &req, const unsigned int &dest)
+{
+  std::string id = req.getId();
+  unsigned int nbParams = req.size();
+
+  std::vector<unsigned int> header(3 + nbParams);
+  header[0] = htonl(vpFrameMagic);
+  header[1] = htonl((unsigned int)id.size());
+  header[2] = htonl(nbParams);
+  for(unsigned int k = 0 ; k < nbParams ; k++)
+    header[3 + k] = htonl((unsigned int)req[k].size());
+
+  std::vector<const char *> buffers;
+  std::vector<size_t> sizes;
+  buffers.reserve(nbParams + 2);
+  sizes.reserve(nbParams + 2);
+  buffers.push_back((const char *)&header[0]);
+  sizes.push_back(header.size()*sizeof(unsigned int));
+  if(!id.empty()){
+    buffers.push_back(id.data());
+    sizes.push_back(id.size());
+  }
+  for(unsigned int k = 0 ; k < nbParams ; k++){
+    if(!req[k].empty()){
+      buffers.push_back(req[k].data());
+      sizes.push_back(req[k].size());
+    }
+  }
+
+  size_t sent = 0;
+#if !defined(_WIN32) && (defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__))) // UNIX
+  int flags = 0;
+#if defined(__linux__)
+  flags = MSG_NOSIGNAL; // Only for Linux
+#endif
+
+  std::vector<struct iovec> iov(buffers.size());
+  for(size_t k = 0 ; k < buffers.size() ; k++){
+    iov[k].iov_base = const_cast<char *>(buffers[k]);
+    iov[k].iov_len = sizes[k];
+  }
+
+  size_t first = 0;
+  while(first < iov.size()){
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov[first];
+    msg.msg_iovlen = std::min(iov.size() - first, vpFrameMaxIov);
+    ssize_t n = sendmsg(receptor_list[dest].socketFileDescriptorReceptor, &msg, flags);
+    if(n < 0){
+      if(errno == EINTR)
+        continue;
+      return -1;
+    }
+    sent += (size_t)n;
+
+    // Skip the data that has been sent
+    size_t m = (size_t)n;
+    while(m > 0 && first < iov.size()){
+      if(m >= iov[first].iov_len){
+        m -= iov[first].iov_len;
+        first++;
+      }
+      else{
+        iov[first].iov_base = (char *)iov[first].iov_base + m;
+        iov[first].iov_len -= m;
+        m = 0;
+      }
+    }
+  }
+#else
+  for(size_t k = 0 ; k < buffers.size() ; k++){
+    size_t done = 0;
+    while(done < sizes[k]){
+      int n = send((unsigned int)receptor_list[dest].socketFileDescriptorReceptor, buffers[k] + done, (int)(sizes[k] - done), 0);
+      if(n <= 0)
+        return -1;
+      done += (size_t)n;
+    }
+    sent += done;
+  }
+#endif
+
+  return (int)sent;
+}
@@ -38,14 +38,21 @@
 
 #include <visp3/core/vpServer.h>
 
+#include <algorithm>
+#include <errno.h>
+
 #if defined(__APPLE__) && defined(__MACH__) // Apple OSX and iOS (Darwin)
 #  include <TargetConditionals.h> // To detect OSX or IOS using TARGET_OS_IPHONE or TARGET_OS_IOS macro
 #endif
 
+#if defined(__linux__)
+#  include <sys/epoll.h>
+#endif
+
 /*!
   Construct a server on the machine launching it.
 */
-vpServer::vpServer( ) : adress(), port(0), started(false), max_clients(10)
+vpServer::vpServer( ) : adress(), port(0), started(false), max_clients(10), epollFileDescriptor(-1)
 {
   int protocol = 0;
   emitter.socketFileDescriptorEmitter = socket(AF_INET, SOCK_STREAM, protocol);
@@ -70,7 +77,7 @@ vpServer::vpServer( ) : adress(), port(0), started(false), max_clients(10)
   
   \param port_serv : server's port.
 */
-vpServer::vpServer( const int &port_serv ) : adress(), port(0), started(false), max_clients(10)
+vpServer::vpServer( const int &port_serv ) : adress(), port(0), started(false), max_clients(10), epollFileDescriptor(-1)
 {
   int protocol = 0;
   emitter.socketFileDescriptorEmitter = socket(AF_INET, SOCK_STREAM, protocol);
@@ -97,7 +104,7 @@ vpServer::vpServer( const int &port_serv ) : adress(), port(0), started(false),
   \param port_serv : server's port.
 */
 vpServer::vpServer( const std::string &adress_serv,const int &port_serv )
-  : adress(), port(0), started(false), max_clients(10)
+  : adress(), port(0), started(false), max_clients(10), epollFileDescriptor(-1)
 {
   int protocol = 0;
   emitter.socketFileDescriptorEmitter = socket(AF_INET, SOCK_STREAM, protocol);
@@ -134,7 +141,11 @@ vpServer::~vpServer()
 #else //Win32
     closesocket( (unsigned)receptor_list[i].socketFileDescriptorReceptor );
 #endif
-     
+
+#if defined(__linux__)
+  if(epollFileDescriptor >= 0)
+    close( epollFileDescriptor );
+#endif
 }
 
 /*!
@@ -183,6 +194,22 @@ bool vpServer::start()
   listen( (unsigned)emitter.socketFileDescriptorEmitter, (int)max_clients );
 #endif
   
+#if defined(__linux__)
+  // Wait for the connections and the requests with epoll. If it is not
+  // available, select() is used.
+  epollFileDescriptor = epoll_create(1);
+  if(epollFileDescriptor >= 0){
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = emitter.socketFileDescriptorEmitter;
+    if(epoll_ctl(epollFileDescriptor, EPOLL_CTL_ADD, emitter.socketFileDescriptorEmitter, &event) != 0){
+      close( epollFileDescriptor );
+      epollFileDescriptor = -1;
+    }
+  }
+#endif
+
   std::cout << "Server ready" << std::endl;
   
   started = true;
@@ -201,83 +228,190 @@ bool vpServer::checkForConnections()
     if(!start()){
       return false;
     }
-  
-  tv.tv_sec = tv_sec;
+
+  bool connection = false;
+  std::vector<unsigned int> ready;
+
+#if defined(__linux__)
+  if(epollFileDescriptor >= 0){
+    if(_epollWait(connection, ready) <= 0)
+      return false;
+  }
+  else
+#endif
+  {
+    tv.tv_sec = tv_sec;
 #if TARGET_OS_IPHONE
-  tv.tv_usec = (int)tv_usec;
+    tv.tv_usec = (int)tv_usec;
 #else
-  tv.tv_usec = tv_usec;
+    tv.tv_usec = tv_usec;
 #endif
 
-  FD_ZERO(&readFileDescriptor);         
-  
-  socketMax = emitter.socketFileDescriptorEmitter;
-  FD_SET((unsigned)emitter.socketFileDescriptorEmitter,&readFileDescriptor);
+    FD_ZERO(&readFileDescriptor);
 
-  for(unsigned int i=0; i<receptor_list.size(); i++){
-    FD_SET((unsigned)receptor_list[i].socketFileDescriptorReceptor,&readFileDescriptor);
+    socketMax = emitter.socketFileDescriptorEmitter;
+    FD_SET((unsigned)emitter.socketFileDescriptorEmitter,&readFileDescriptor);
 
-    if(i == 0)
-      socketMax = receptor_list[i].socketFileDescriptorReceptor;
-   
-    if(socketMax < receptor_list[i].socketFileDescriptorReceptor) socketMax = receptor_list[i].socketFileDescriptorReceptor; 
-  }
-  
-  int value = select((int)socketMax+1,&readFileDescriptor,NULL,NULL,&tv);
-  if(value == -1){
-    //vpERROR_TRACE( "vpServer::run(), select()" );
-    return false;
-  }
-  else if(value == 0){
-    return false;
+    for(unsigned int i=0; i<receptor_list.size(); i++){
+      FD_SET((unsigned)receptor_list[i].socketFileDescriptorReceptor,&readFileDescriptor);
+
+      if(i == 0)
+        socketMax = receptor_list[i].socketFileDescriptorReceptor;
+
+      if(socketMax < receptor_list[i].socketFileDescriptorReceptor) socketMax = receptor_list[i].socketFileDescriptorReceptor;
+    }
+
+    int value = select((int)socketMax+1,&readFileDescriptor,NULL,NULL,&tv);
+    if(value == -1){
+      //vpERROR_TRACE( "vpServer::run(), select()" );
+      return false;
+    }
+    else if(value == 0){
+      return false;
+    }
+
+    connection = FD_ISSET((unsigned int)emitter.socketFileDescriptorEmitter,&readFileDescriptor) != 0;
+    for(unsigned int i=0; i<receptor_list.size(); i++){
+      if(FD_ISSET((unsigned int)receptor_list[i].socketFileDescriptorReceptor,&readFileDescriptor))
+        ready.push_back(i);
+    }
   }
-  else{
-    if(FD_ISSET((unsigned int)emitter.socketFileDescriptorEmitter,&readFileDescriptor)){
-      vpNetwork::vpReceptor client;
-      client.receptorAddressSize = sizeof(client.receptorAddress);
+
+  if(connection){
+    vpNetwork::vpReceptor client;
+    client.receptorAddressSize = sizeof(client.receptorAddress);
 #if !defined(_WIN32) && (defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__))) // UNIX
-      client.socketFileDescriptorReceptor = accept(emitter.socketFileDescriptorEmitter,(struct sockaddr*) &client.receptorAddress, &client.receptorAddressSize);
+    client.socketFileDescriptorReceptor = accept(emitter.socketFileDescriptorEmitter,(struct sockaddr*) &client.receptorAddress, &client.receptorAddressSize);
 #else //Win32
-      client.socketFileDescriptorReceptor = accept((unsigned int)emitter.socketFileDescriptorEmitter,(struct sockaddr*) &client.receptorAddress, &client.receptorAddressSize);
+    client.socketFileDescriptorReceptor = accept((unsigned int)emitter.socketFileDescriptorEmitter,(struct sockaddr*) &client.receptorAddress, &client.receptorAddressSize);
 #endif
-      
+
 #if !defined(_WIN32) && (defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__))) // UNIX
-      if((client.socketFileDescriptorReceptor) == -1)
+    if((client.socketFileDescriptorReceptor) == -1)
 #else
-      if((client.socketFileDescriptorReceptor) == INVALID_SOCKET)
+    if((client.socketFileDescriptorReceptor) == INVALID_SOCKET)
 #endif
-        vpERROR_TRACE( "vpServer::run(), accept()" );
-      
-      client.receptorIP = inet_ntoa(client.receptorAddress.sin_addr);
-      printf("New client connected : %s\n", inet_ntoa(client.receptorAddress.sin_addr));
-      receptor_list.push_back(client);
-      
-      return true;
+      vpERROR_TRACE( "vpServer::run(), accept()" );
+
+#if defined(__linux__)
+    if(epollFileDescriptor >= 0 && client.socketFileDescriptorReceptor >= 0){
+      struct epoll_event event;
+      memset(&event, 0, sizeof(event));
+      event.events = EPOLLIN;
+      event.data.fd = client.socketFileDescriptorReceptor;
+      epoll_ctl(epollFileDescriptor, EPOLL_CTL_ADD, client.socketFileDescriptorReceptor, &event);
     }
-    else{
-      for(unsigned int i=0; i<receptor_list.size(); i++){
-        if(FD_ISSET((unsigned int)receptor_list[i].socketFileDescriptorReceptor,&readFileDescriptor)){
-          char deco;
+#endif
+
+    client.receptorIP = inet_ntoa(client.receptorAddress.sin_addr);
+    printf("New client connected : %s\n", inet_ntoa(client.receptorAddress.sin_addr));
+    receptor_list.push_back(client);
+
+    return true;
+  }
+  else{
+    for(unsigned int k=0; k<ready.size(); k++){
+      unsigned int i = ready[k];
+      char deco;
 #if !defined(_WIN32) && (defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__))) // UNIX
-          ssize_t numbytes = recv(receptor_list[i].socketFileDescriptorReceptor, &deco, 1, MSG_PEEK);
+      ssize_t numbytes = recv(receptor_list[i].socketFileDescriptorReceptor, &deco, 1, MSG_PEEK);
 #else //Win32
-          int numbytes = recv((unsigned int)receptor_list[i].socketFileDescriptorReceptor, &deco, 1, MSG_PEEK);
+      int numbytes = recv((unsigned int)receptor_list[i].socketFileDescriptorReceptor, &deco, 1, MSG_PEEK);
 #endif
-          
-          if(numbytes == 0)
-          {
-            std::cout << "Disconnected : " << inet_ntoa(receptor_list[i].receptorAddress.sin_addr) << std::endl;
-            receptor_list.erase(receptor_list.begin()+(int)i);
-            return 0;
-          }
-        }
+
+      if(numbytes == 0)
+      {
+        std::cout << "Disconnected : " << inet_ntoa(receptor_list[i].receptorAddress.sin_addr) << std::endl;
+        receptor_list.erase(receptor_list.begin()+(int)i);
+        return 0;
       }
     }
   }
-  
+
   return false;
 }
 
+#if defined(__linux__)
+/*!
+  Wait with epoll for a connection or for data sent by the clients.
+
+  \param connection : True if a client is waiting to be accepted.
+  \param ready : Indexes of the clients from which data can be read.
+
+  \return The number of events, 0 if the timeout expired, -1 if an error occured.
+*/
+int vpServer::_epollWait(bool &connection, std::vector<unsigned int> &ready)
+{
+  connection = false;
+  ready.clear();
+
+  std::vector<struct epoll_event> events(receptor_list.size() + 1);
+  // epoll has a millisecond resolution. The timeout is rounded down, so that
+  // the default timeout of 10 usec doesn't become a 1 ms wait.
+  int timeout = (int)(tv_sec*1000 + tv_usec/1000);
+  int value = epoll_wait(epollFileDescriptor, &events[0], (int)events.size(), timeout);
+  if(value == -1){
+    if(errno == EINTR)
+      return 0;
+    if(verboseMode)
+      vpERROR_TRACE( "Epoll error" );
+    return -1;
+  }
+
+  for(int k = 0 ; k < value ; k++){
+    int fd = events[(unsigned int)k].data.fd;
+    if(fd == emitter.socketFileDescriptorEmitter){
+      connection = true;
+      continue;
+    }
+
+    bool found = false;
+    for(unsigned int i = 0 ; i < receptor_list.size() ; i++){
+      if(receptor_list[i].socketFileDescriptorReceptor == fd){
+        ready.push_back(i);
+        found = true;
+        break;
+      }
+    }
+    // The client has been removed from the list after a disconnection
+    if(!found)
+      epoll_ctl(epollFileDescriptor, EPOLL_CTL_DEL, fd, NULL);
+  }
+  std::sort(ready.begin(), ready.end());
+
+  return value;
+}
+#endif
+
+/*!
+  Wait until data can be read from the clients. On Linux, epoll is used when
+  waiting for all the clients.
+
+  \param receptorEmitting : Index of the client to wait for, or -1 to wait for all the clients.
+  \param ready : Indexes of the clients from which data can be read.
+
+  \return The number of clients ready, 0 if the timeout expired, -1 if an error occured.
+*/
+int vpServer::_waitForReceptors(const int &receptorEmitting, std::vector<unsigned int> &ready)
+{
+#if defined(__linux__)
+  if(epollFileDescriptor >= 0 && receptorEmitting < 0){
+    ready.clear();
+    if(receptor_list.size() == 0){
+      if(verboseMode)
+        vpTRACE( "No receptor!" );
+      return -1;
+    }
+    bool connection;
+    if(_epollWait(connection, ready) < 0)
+      return -1;
+    return (int)ready.size();
+  }
+#endif
+
+  return vpNetwork::_waitForReceptors(receptorEmitting, ready);
+}
+
 /*!
   Print the connected clients. 
 */
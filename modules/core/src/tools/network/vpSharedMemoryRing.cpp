@@ -0,0 +1,650 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2017 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * Description:
+ * Ring buffer of frames in shared memory.
+ *
+ *****************************************************************************/
+
+/*!
+  \file vpSharedMemoryRing.cpp
+  \brief Ring buffer of frames (images, depth maps, point clouds) shared between processes.
+*/
+
+#include <visp3/core/vpSharedMemoryRing.h>
+
+#if !defined(_WIN32) && (defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__))) // UNIX
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#  include <linux/futex.h>
+#  include <sys/syscall.h>
+#endif
+
+#include <visp3/core/vpTime.h>
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+namespace
+{
+// Layout of the shared memory: a header of vpRingHeaderSize bytes followed by
+// the slots. Each slot starts with a vpSlotHeaderSize bytes header, followed
+// by the frame data.
+const char vpRingMagic[8] = {'V', 'P', 'S', 'H', 'M', 'R', 'N', 'G'};
+const unsigned int vpRingVersion = 1;
+const size_t vpRingHeaderSize = 128;
+const size_t vpSlotHeaderSize = 64;
+
+struct vpRingHeader
+{
+  char magic[8];
+  unsigned int version;
+  unsigned int nbSlots;
+  unsigned long long slotSize;
+  unsigned long long slotStride;
+  volatile unsigned long long frameCount;
+  // Incremented with each frame, consumers sleep on it
+  volatile int futexWord;
+  // Number of sleeping consumers
+  volatile int waiters;
+};
+
+struct vpSlotHeader
+{
+  // Odd while the slot is written
+  volatile unsigned int sequence;
+  unsigned int type;
+  unsigned int width;
+  unsigned int height;
+  unsigned long long size;
+  unsigned long long frameIndex;
+  double timestamp;
+};
+
+size_t vpAlign(unsigned long long size) { return (size_t)((size + 63) & ~63ULL); }
+
+#if defined(__linux__)
+void vpFutexWait(volatile int *addr, int value, double timeout)
+{
+  struct timespec ts;
+  struct timespec *pts = NULL;
+  if (timeout >= 0) {
+    ts.tv_sec = (time_t)(timeout / 1000.);
+    ts.tv_nsec = (long)((timeout - 1000. * (double)ts.tv_sec) * 1e6);
+    pts = &ts;
+  }
+  syscall(SYS_futex, (int *)addr, FUTEX_WAIT, value, pts, NULL, 0);
+}
+
+void vpFutexWake(volatile int *addr) { syscall(SYS_futex, (int *)addr, FUTEX_WAKE, INT_MAX, NULL, NULL, 0); }
+#endif
+
+std::string vpShmName(const std::string &name) { return (!name.empty() && name[0] == '/') ? name : "/" + name; }
+}
+#endif
+
+/*!
+  Default constructor. The ring has to be created with create() or opened with open().
+*/
+vpSharedMemoryRing::vpSharedMemoryRing()
+  : m_name(), m_producer(false), m_map(NULL), m_mapSize(0), m_nbSlots(0), m_slotSize(0), m_slotStride(0), m_next(0),
+    m_dropped(0), m_writing(false)
+{
+}
+
+/*!
+  Destructor that calls close().
+*/
+vpSharedMemoryRing::~vpSharedMemoryRing() { close(); }
+
+/*!
+  Close the ring. If the ring was created by this object, its name is
+  removed: the consumers keep their access to the ring until they close it,
+  but the ring can no longer be opened.
+*/
+void vpSharedMemoryRing::close()
+{
+  if (m_map != NULL) {
+    munmap(m_map, m_mapSize);
+    if (m_producer)
+      shm_unlink(vpShmName(m_name).c_str());
+  }
+  m_map = NULL;
+  m_mapSize = 0;
+  m_producer = false;
+  m_nbSlots = 0;
+  m_slotSize = 0;
+  m_slotStride = 0;
+  m_next = 0;
+  m_dropped = 0;
+  m_writing = false;
+}
+
+/*!
+  Create a ring as producer. A previous ring with the same name is replaced.
+
+  \param name : Name of the ring, shared with the consumers.
+  \param nbSlots : Number of frames kept in the ring. The more slots, the
+  later a slow consumer has to skip frames.
+  \param slotSize : Maximum size in bytes of a frame, for example
+  I.getSize()*sizeof(vpRGBa) for a color image I.
+  \param mode : Access permissions of the shared memory. By default, only
+  the processes of the same user can open the ring. Use for example 0660 to
+  give access to the processes of the same group.
+
+  \exception vpException::badValue : If the number of slots is 0.
+  \exception vpException::ioError : If the shared memory cannot be created.
+*/
+void vpSharedMemoryRing::create(const std::string &name, unsigned int nbSlots, unsigned long long slotSize,
+                                unsigned int mode)
+{
+  close();
+  if (nbSlots == 0) {
+    throw(vpException(vpException::badValue, "A shared memory ring needs at least one slot"));
+  }
+
+  std::string shmName = vpShmName(name);
+  shm_unlink(shmName.c_str());
+  int fd = shm_open(shmName.c_str(), O_CREAT | O_EXCL | O_RDWR, (mode_t)mode);
+  if (fd < 0) {
+    throw(vpException(vpException::ioError, "Cannot create the shared memory %s: %s", shmName.c_str(),
+                      strerror(errno)));
+  }
+
+  size_t slotStride = vpSlotHeaderSize + vpAlign(slotSize);
+  size_t mapSize = vpRingHeaderSize + (size_t)nbSlots * slotStride;
+  void *map = MAP_FAILED;
+  if (ftruncate(fd, (off_t)mapSize) == 0)
+    map = mmap(NULL, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (map == MAP_FAILED) {
+    shm_unlink(shmName.c_str());
+    throw(vpException(vpException::ioError, "Cannot map the shared memory %s: %s", shmName.c_str(), strerror(errno)));
+  }
+
+  m_name = name;
+  m_producer = true;
+  m_map = (unsigned char *)map;
+  m_mapSize = mapSize;
+  m_nbSlots = nbSlots;
+  m_slotSize = slotSize;
+  m_slotStride = slotStride;
+  m_next = 0;
+  m_dropped = 0;
+
+  // The memory is zero filled by ftruncate(), the magic number is written last
+  vpRingHeader *header = (vpRingHeader *)m_map;
+  header->version = vpRingVersion;
+  header->nbSlots = nbSlots;
+  header->slotSize = slotSize;
+  header->slotStride = slotStride;
+  __sync_synchronize();
+  memcpy(header->magic, vpRingMagic, sizeof(vpRingMagic));
+}
+
+/*!
+  Open as consumer a ring created by a producer. Only the frames written after
+  the call to open() are read.
+
+  \param name : Name of the ring given to create().
+
+  \exception vpException::ioError : If the ring doesn't exist or is not valid.
+*/
+void vpSharedMemoryRing::open(const std::string &name)
+{
+  close();
+
+  std::string shmName = vpShmName(name);
+  int fd = shm_open(shmName.c_str(), O_RDWR, 0);
+  if (fd < 0) {
+    throw(vpException(vpException::ioError, "Cannot open the shared memory %s: %s", shmName.c_str(), strerror(errno)));
+  }
+
+  struct stat st;
+  void *map = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && (size_t)st.st_size >= vpRingHeaderSize)
+    map = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (map == MAP_FAILED) {
+    throw(vpException(vpException::ioError, "Cannot map the shared memory %s", shmName.c_str()));
+  }
+
+  const vpRingHeader *header = (const vpRingHeader *)map;
+  __sync_synchronize();
+  if (memcmp(header->magic, vpRingMagic, sizeof(vpRingMagic)) != 0 || header->version != vpRingVersion ||
+      header->nbSlots == 0 || header->slotStride < vpSlotHeaderSize + header->slotSize ||
+      vpRingHeaderSize + header->nbSlots * header->slotStride > (unsigned long long)st.st_size) {
+    munmap(map, (size_t)st.st_size);
+    throw(vpException(vpException::ioError, "%s is not a valid shared memory ring", shmName.c_str()));
+  }
+
+  m_name = name;
+  m_producer = false;
+  m_map = (unsigned char *)map;
+  m_mapSize = (size_t)st.st_size;
+  m_nbSlots = header->nbSlots;
+  m_slotSize = header->slotSize;
+  m_slotStride = (size_t)header->slotStride;
+  m_next = getFrameCount();
+  m_dropped = 0;
+}
+
+/*!
+  Return the number of frames written in the ring since its creation.
+*/
+unsigned long long vpSharedMemoryRing::getFrameCount() const
+{
+  if (m_map == NULL)
+    return 0;
+  vpRingHeader *header = (vpRingHeader *)m_map;
+  return __sync_fetch_and_add(&header->frameCount, 0);
+}
+
+/*!
+  Wait until a frame that was not yet read by this consumer is available.
+
+  \param timeout : Maximum time to wait in ms. If negative, wait without limit.
+
+  \return true if a frame is available, false if the timeout expired.
+
+  \exception vpException::notInitialized : If the ring is not opened.
+*/
+bool vpSharedMemoryRing::wait(double timeout)
+{
+  if (m_map == NULL) {
+    throw(vpException(vpException::notInitialized, "The shared memory ring is not opened"));
+  }
+
+  vpRingHeader *header = (vpRingHeader *)m_map;
+  double t0 = (timeout > 0) ? vpTime::measureTimeMs() : 0;
+  for (;;) {
+    int word = header->futexWord;
+    __sync_synchronize();
+    if (getFrameCount() > m_next)
+      return true;
+
+    double remaining = timeout;
+    if (timeout > 0)
+      remaining = timeout - (vpTime::measureTimeMs() - t0);
+    if (timeout >= 0 && remaining <= 0)
+      return false;
+
+#if defined(__linux__)
+    __sync_add_and_fetch(&header->waiters, 1);
+    vpFutexWait(&header->futexWord, word, remaining);
+    __sync_sub_and_fetch(&header->waiters, 1);
+#else
+    (void)word;
+    usleep((remaining < 0 || remaining > 0.1) ? 100 : (useconds_t)(remaining * 1000.));
+#endif
+  }
+}
+
+/*!
+  Get the next frame without copy.
+
+  The frame stays in the ring and may be overwritten by the producer while it
+  is accessed. Use isValid() after having accessed the frame to check that it
+  was not overwritten.
+
+  \param view : Next frame.
+  \param timeout : Maximum time to wait for a frame in ms. If negative, wait without limit.
+
+  \return true if a frame is given, false if the timeout expired.
+
+  \exception vpException::notInitialized : If the ring is not opened.
+*/
+bool vpSharedMemoryRing::acquire(vpFrameView &view, double timeout)
+{
+  for (;;) {
+    if (!wait(timeout))
+      return false;
+
+    // Skip the frames that are overwritten
+    unsigned long long count = getFrameCount();
+    if (count > m_nbSlots && m_next < count - m_nbSlots) {
+      m_dropped += count - m_nbSlots - m_next;
+      m_next = count - m_nbSlots;
+    }
+
+    unsigned int slot = (unsigned int)(m_next % m_nbSlots);
+    unsigned char *base = m_map + vpRingHeaderSize + (size_t)slot * m_slotStride;
+    const vpSlotHeader *slotHeader = (const vpSlotHeader *)base;
+
+    unsigned int sequence = slotHeader->sequence;
+    __sync_synchronize();
+    view.data = base + vpSlotHeaderSize;
+    view.type = (vpFrameType)slotHeader->type;
+    view.width = slotHeader->width;
+    view.height = slotHeader->height;
+    view.size = slotHeader->size;
+    view.timestamp = slotHeader->timestamp;
+    view.frameIndex = slotHeader->frameIndex;
+    view.slot = slot;
+    view.sequence = sequence;
+    bool valid = ((sequence & 1) == 0) && view.frameIndex == m_next && view.size <= m_slotSize;
+    valid = valid && isValid(view);
+
+    m_next++;
+    if (valid)
+      return true;
+    m_dropped++;
+  }
+}
+
+/*!
+  Check that a frame given by acquire() was not overwritten by the producer.
+
+  \param view : Frame given by acquire().
+
+  \return true if the frame is still in the ring.
+*/
+bool vpSharedMemoryRing::isValid(const vpFrameView &view) const
+{
+  if (m_map == NULL || view.slot >= m_nbSlots)
+    return false;
+  const vpSlotHeader *slotHeader = (const vpSlotHeader *)(m_map + vpRingHeaderSize + (size_t)view.slot * m_slotStride);
+  __sync_synchronize();
+  return slotHeader->sequence == view.sequence;
+}
+
+template <class Type>
+bool vpSharedMemoryRing::readImage(vpImage<Type> &I, double &timestamp, double timeout, vpFrameType type)
+{
+  vpFrameView view;
+  while (acquire(view, timeout)) {
+    if (view.type != type) {
+      throw(vpException(vpException::badValue, "Frame %llu of the shared memory ring has not the requested type",
+                        view.frameIndex));
+    }
+    if ((unsigned long long)view.width * view.height * sizeof(Type) > view.size) {
+      m_dropped++;
+      continue;
+    }
+    I.resize(view.height, view.width);
+    memcpy((unsigned char *)I.bitmap, view.data, (size_t)view.width * view.height * sizeof(Type));
+    if (isValid(view)) {
+      timestamp = view.timestamp;
+      return true;
+    }
+    m_dropped++;
+  }
+  return false;
+}
+
+/*!
+  Copy the next grey level image of the ring.
+
+  \param I : Next image.
+  \param timestamp : Timestamp of the image given by the producer.
+  \param timeout : Maximum time to wait for an image in ms. If negative, wait without limit.
+
+  \return true if an image is read, false if the timeout expired.
+
+  \exception vpException::badValue : If the next frame is not a grey level image.
+*/
+bool vpSharedMemoryRing::read(vpImage<unsigned char> &I, double &timestamp, double timeout)
+{
+  return readImage(I, timestamp, timeout, FRAME_GREY);
+}
+
+/*!
+  Copy the next color image of the ring.
+
+  \param I : Next image.
+  \param timestamp : Timestamp of the image given by the producer.
+  \param timeout : Maximum time to wait for an image in ms. If negative, wait without limit.
+
+  \return true if an image is read, false if the timeout expired.
+
+  \exception vpException::badValue : If the next frame is not a color image.
+*/
+bool vpSharedMemoryRing::read(vpImage<vpRGBa> &I, double &timestamp, double timeout)
+{
+  return readImage(I, timestamp, timeout, FRAME_RGBA);
+}
+
+/*!
+  Copy the next depth map of the ring.
+
+  \param I : Next depth map.
+  \param timestamp : Timestamp of the depth map given by the producer.
+  \param timeout : Maximum time to wait for a depth map in ms. If negative, wait without limit.
+
+  \return true if a depth map is read, false if the timeout expired.
+
+  \exception vpException::badValue : If the next frame is not a depth map.
+*/
+bool vpSharedMemoryRing::read(vpImage<uint16_t> &I, double &timestamp, double timeout)
+{
+  return readImage(I, timestamp, timeout, FRAME_DEPTH);
+}
+
+/*!
+  Copy the next point cloud of the ring.
+
+  \param pointcloud : Next point cloud.
+  \param timestamp : Timestamp of the point cloud given by the producer.
+  \param timeout : Maximum time to wait for a point cloud in ms. If negative, wait without limit.
+
+  \return true if a point cloud is read, false if the timeout expired.
+
+  \exception vpException::badValue : If the next frame is not a point cloud.
+*/
+bool vpSharedMemoryRing::read(std::vector<vpColVector> &pointcloud, double &timestamp, double timeout)
+{
+  vpFrameView view;
+  while (acquire(view, timeout)) {
+    if (view.type != FRAME_POINTCLOUD) {
+      throw(vpException(vpException::badValue, "Frame %llu of the shared memory ring is not a point cloud",
+                        view.frameIndex));
+    }
+    if ((unsigned long long)view.width * view.height * sizeof(float) > view.size) {
+      m_dropped++;
+      continue;
+    }
+    pointcloud.resize(view.width);
+    const float *data = (const float *)view.data;
+    for (unsigned int i = 0; i < view.width; i++) {
+      vpColVector &v = pointcloud[i];
+      v.resize(view.height, false);
+      const float *p = data + (size_t)i * view.height;
+      for (unsigned int j = 0; j < view.height; j++)
+        v[j] = p[j];
+    }
+    if (isValid(view)) {
+      timestamp = view.timestamp;
+      return true;
+    }
+    m_dropped++;
+  }
+  return false;
+}
+
+/*!
+  Start to write a frame directly in the next slot of the ring, without
+  intermediate copy. The frame is given to the consumers by endWrite().
+
+  \param type : Type of the frame.
+  \param width : Width of the frame, or number of points of a point cloud.
+  \param height : Height of the frame, or number of coordinates of the points of a point cloud.
+  \param size : Size in bytes of the frame data.
+
+  \return Address where the frame data has to be written.
+
+  \exception vpException::badValue : If the ring was not created by this object or if the frame is too large.
+*/
+void *vpSharedMemoryRing::beginWrite(vpFrameType type, unsigned int width, unsigned int height,
+                                     unsigned long long size)
+{
+  if (m_map == NULL || !m_producer) {
+    throw(vpException(vpException::badValue, "The shared memory ring is not created by this producer"));
+  }
+  if (size > m_slotSize) {
+    throw(vpException(vpException::badValue, "Frame of %llu bytes larger than the %llu bytes slots of the ring", size,
+                      m_slotSize));
+  }
+
+  unsigned int slot = (unsigned int)(m_next % m_nbSlots);
+  unsigned char *base = m_map + vpRingHeaderSize + (size_t)slot * m_slotStride;
+  vpSlotHeader *slotHeader = (vpSlotHeader *)base;
+  if (!m_writing) {
+    slotHeader->sequence = slotHeader->sequence + 1;
+    __sync_synchronize();
+  }
+  slotHeader->type = (unsigned int)type;
+  slotHeader->width = width;
+  slotHeader->height = height;
+  slotHeader->size = size;
+  slotHeader->frameIndex = m_next;
+  m_writing = true;
+
+  return base + vpSlotHeaderSize;
+}
+
+/*!
+  Give to the consumers the frame started by beginWrite().
+
+  \param timestamp : Timestamp of the frame, for example from vpTime::measureTimeMs().
+*/
+void vpSharedMemoryRing::endWrite(double timestamp)
+{
+  if (!m_writing)
+    return;
+
+  vpRingHeader *header = (vpRingHeader *)m_map;
+  vpSlotHeader *slotHeader = (vpSlotHeader *)(m_map + vpRingHeaderSize + (size_t)(m_next % m_nbSlots) * m_slotStride);
+  slotHeader->timestamp = timestamp;
+  __sync_synchronize();
+  slotHeader->sequence = slotHeader->sequence + 1;
+  m_writing = false;
+  m_next++;
+
+  __sync_fetch_and_add(&header->frameCount, 1);
+  __sync_add_and_fetch(&header->futexWord, 1);
+#if defined(__linux__)
+  if (header->waiters > 0)
+    vpFutexWake(&header->futexWord);
+#endif
+}
+
+/*!
+  Write a grey level image in the ring.
+
+  \param I : Image to write.
+  \param timestamp : Timestamp of the image, for example from vpTime::measureTimeMs().
+
+  \exception vpException::badValue : If the ring was not created by this object or if the image is too large.
+*/
+void vpSharedMemoryRing::write(const vpImage<unsigned char> &I, double timestamp)
+{
+  unsigned long long size = I.getSize();
+  void *data = beginWrite(FRAME_GREY, I.getWidth(), I.getHeight(), size);
+  if (size > 0)
+    memcpy(data, I.bitmap, (size_t)size);
+  endWrite(timestamp);
+}
+
+/*!
+  Write a color image in the ring.
+
+  \param I : Image to write.
+  \param timestamp : Timestamp of the image, for example from vpTime::measureTimeMs().
+
+  \exception vpException::badValue : If the ring was not created by this object or if the image is too large.
+*/
+void vpSharedMemoryRing::write(const vpImage<vpRGBa> &I, double timestamp)
+{
+  unsigned long long size = (unsigned long long)I.getSize() * sizeof(vpRGBa);
+  void *data = beginWrite(FRAME_RGBA, I.getWidth(), I.getHeight(), size);
+  if (size > 0)
+    memcpy(data, I.bitmap, (size_t)size);
+  endWrite(timestamp);
+}
+
+/*!
+  Write a depth map in the ring.
+
+  \param I : Depth map to write.
+  \param timestamp : Timestamp of the depth map, for example from vpTime::measureTimeMs().
+
+  \exception vpException::badValue : If the ring was not created by this object or if the depth map is too large.
+*/
+void vpSharedMemoryRing::write(const vpImage<uint16_t> &I, double timestamp)
+{
+  unsigned long long size = (unsigned long long)I.getSize() * sizeof(uint16_t);
+  void *data = beginWrite(FRAME_DEPTH, I.getWidth(), I.getHeight(), size);
+  if (size > 0)
+    memcpy(data, I.bitmap, (size_t)size);
+  endWrite(timestamp);
+}
+
+/*!
+  Write a point cloud in the ring. The coordinates are stored as floats.
+
+  \param pointcloud : Point cloud to write. All the points must have the same number of coordinates.
+  \param timestamp : Timestamp of the point cloud, for example from vpTime::measureTimeMs().
+
+  \exception vpException::badValue : If the ring was not created by this object or if the point cloud is too large.
+  \exception vpException::dimensionError : If the points don't have the same number of coordinates.
+*/
+void vpSharedMemoryRing::write(const std::vector<vpColVector> &pointcloud, double timestamp)
+{
+  unsigned int nbPoints = (unsigned int)pointcloud.size();
+  unsigned int dim = nbPoints > 0 ? pointcloud[0].getRows() : 0;
+  for (unsigned int i = 0; i < nbPoints; i++) {
+    if (pointcloud[i].getRows() != dim) {
+      throw(vpException(vpException::dimensionError, "Point %u of the point cloud has %u coordinates instead of %u",
+                        i, pointcloud[i].getRows(), dim));
+    }
+  }
+
+  float *data = (float *)beginWrite(FRAME_POINTCLOUD, nbPoints, dim,
+                                    (unsigned long long)nbPoints * dim * sizeof(float));
+  for (unsigned int i = 0; i < nbPoints; i++) {
+    const vpColVector &v = pointcloud[i];
+    float *p = data + (size_t)i * dim;
+    for (unsigned int j = 0; j < dim; j++)
+      p[j] = (float)v[j];
+  }
+  endWrite(timestamp);
+}
+
+#elif !defined(VISP_BUILD_SHARED_LIBS)
+// Work arround to avoid warning: libvisp_core.a(vpSharedMemoryRing.cpp.o) has no symbols
+void dummy_vpSharedMemoryRing() {};
+#endif
@@ -33,6 +33,7 @@
  *
  *****************************************************************************/
 
+#include <algorithm>
 #include <cstring>
 #include <sstream>
 
@@ -51,6 +52,14 @@
 
 #include <visp3/core/vpUDPClient.h>
 
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+namespace
+{
+// Maximum number of datagrams sent by a single system call
+const size_t vpUDPClientMaxBatch = 64;
+}
+#endif
+
 /*!
   Create a (IPv4) UDP client.
 
@@ -215,3 +224,75 @@ int vpUDPClient::send(const std::string &msg) {
   return sendto(m_socketFileDescriptor, msg.c_str(), (int)msg.size(), 0, (struct sockaddr *) &m_serverAddress, m_serverLength);
 #endif
 }
+
+/*!
+  Send a binary message to the server, to be received with
+  vpUDPServer::receive(vpUDPMessage &, const int).
+
+  \param msg : Message to send.
+
+  \return The size of the message sent, or -1 if there is an error.
+*/
+int vpUDPClient::send(const vpUDPMessage &msg)
+{
+  if (!msg.isValid()) {
+    std::cerr << "Invalid message!" << std::endl;
+    return -1;
+  }
+
+  return (int)sendto(m_socketFileDescriptor, msg.m_data, msg.m_length, 0, (struct sockaddr *)&m_serverAddress,
+                     m_serverLength);
+}
+
+/*!
+  Send several binary messages to the server, to be received with
+  vpUDPServer::receive(std::vector<vpUDPMessage> &, const int). On Linux, the
+  messages are sent with a single system call (sendmmsg()).
+
+  \param msgs : Messages to send, each one in its own datagram.
+
+  \return The number of messages sent, or -1 if there is an error.
+*/
+int vpUDPClient::send(const std::vector<vpUDPMessage> &msgs)
+{
+  for (size_t i = 0; i < msgs.size(); i++) {
+    if (!msgs[i].isValid()) {
+      std::cerr << "Invalid message!" << std::endl;
+      return -1;
+    }
+  }
+
+  size_t nb = 0;
+#if defined(__linux__)
+  struct mmsghdr mmsg[vpUDPClientMaxBatch];
+  struct iovec iov[vpUDPClientMaxBatch];
+  while (nb < msgs.size()) {
+    size_t n = std::min(msgs.size() - nb, vpUDPClientMaxBatch);
+    memset(mmsg, 0, n * sizeof(struct mmsghdr));
+    for (size_t i = 0; i < n; i++) {
+      iov[i].iov_base = (void *)msgs[nb + i].m_data;
+      iov[i].iov_len = msgs[nb + i].m_length;
+      mmsg[i].msg_hdr.msg_name = &m_serverAddress;
+      mmsg[i].msg_hdr.msg_namelen = (socklen_t)m_serverLength;
+      mmsg[i].msg_hdr.msg_iov = &iov[i];
+      mmsg[i].msg_hdr.msg_iovlen = 1;
+    }
+    int res = sendmmsg(m_socketFileDescriptor, mmsg, (unsigned int)n, 0);
+    if (res < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return nb > 0 ? (int)nb : -1;
+    }
+    nb += (size_t)res;
+  }
+#else
+  for (; nb < msgs.size(); nb++) {
+    if (sendto(m_socketFileDescriptor, msgs[nb].m_data, msgs[nb].m_length, 0, (struct sockaddr *)&m_serverAddress,
+               m_serverLength) < 0) {
+      return nb > 0 ? (int)nb : -1;
+    }
+  }
+#endif
+  return (int)nb;
+}
@@ -0,0 +1,285 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2017 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * Description:
+ * Fixed layout binary UDP message
+ *
+ *****************************************************************************/
+
+#include <cstring>
+
+#include <visp3/core/vpUDPMessage.h>
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+namespace
+{
+const unsigned char vpUDPMessageVersion = 1;
+
+// Little endian encoding, independent of the host byte order
+void vpPutUInt16(char *p, unsigned int v)
+{
+  p[0] = (char)(v & 0xFF);
+  p[1] = (char)((v >> 8) & 0xFF);
+}
+
+void vpPutUInt32(char *p, unsigned int v)
+{
+  for (int i = 0; i < 4; i++)
+    p[i] = (char)((v >> (8 * i)) & 0xFF);
+}
+
+void vpPutDouble(char *p, double v)
+{
+  unsigned long long u;
+  memcpy(&u, &v, sizeof(u));
+  for (int i = 0; i < 8; i++)
+    p[i] = (char)((u >> (8 * i)) & 0xFF);
+}
+
+unsigned int vpGetUInt16(const char *p) { return (unsigned int)(unsigned char)p[0] | ((unsigned int)(unsigned char)p[1] << 8); }
+
+unsigned int vpGetUInt32(const char *p)
+{
+  unsigned int v = 0;
+  for (int i = 0; i < 4; i++)
+    v |= (unsigned int)(unsigned char)p[i] << (8 * i);
+  return v;
+}
+
+double vpGetDouble(const char *p)
+{
+  unsigned long long u = 0;
+  for (int i = 0; i < 8; i++)
+    u |= (unsigned long long)(unsigned char)p[i] << (8 * i);
+  double v;
+  memcpy(&v, &u, sizeof(v));
+  return v;
+}
+}
+#endif
+
+/*!
+  Create an empty (invalid) message.
+*/
+vpUDPMessage::vpUDPMessage() : m_length(0)
+{
+  // The payload is not initialized: it is written by set() or by the reception
+  memset(m_data, 0, headerSize);
+}
+
+/*!
+  Create a message carrying a pose.
+
+  \param M : Pose.
+  \param sequence : Sequence number of the message.
+  \param timestamp : Timestamp of the message, for example from vpTime::measureTimeMs().
+  \param channel : Identifier of the data stream.
+*/
+vpUDPMessage::vpUDPMessage(const vpHomogeneousMatrix &M, const unsigned int sequence, const double timestamp,
+                           const unsigned int channel)
+  : m_length(0)
+{
+  set(M, sequence, timestamp, channel);
+}
+
+/*!
+  Create a message carrying a vector of values.
+
+  \param v : Values, at most vpUDPMessage::maxNbValues.
+  \param sequence : Sequence number of the message.
+  \param timestamp : Timestamp of the message, for example from vpTime::measureTimeMs().
+  \param channel : Identifier of the data stream.
+
+  \exception vpException::dimensionError : If the vector has too many values.
+*/
+vpUDPMessage::vpUDPMessage(const vpColVector &v, const unsigned int sequence, const double timestamp,
+                           const unsigned int channel)
+  : m_length(0)
+{
+  set(v, sequence, timestamp, channel);
+}
+
+/*!
+  Get the pose carried by the message.
+
+  \param M : Pose.
+  \return false if the message doesn't carry a pose.
+*/
+bool vpUDPMessage::get(vpHomogeneousMatrix &M) const
+{
+  if (getType() != MESSAGE_HOMOGENEOUS_MATRIX || getNbValues() != 12)
+    return false;
+
+  const char *p = m_data + headerSize;
+  for (unsigned int i = 0; i < 3; i++) {
+    for (unsigned int j = 0; j < 4; j++, p += 8)
+      M[i][j] = vpGetDouble(p);
+  }
+  M[3][0] = M[3][1] = M[3][2] = 0.;
+  M[3][3] = 1.;
+  return true;
+}
+
+/*!
+  Get the values carried by the message.
+
+  \param v : Values. The vector is resized only if its size differs from the number of values.
+  \return false if the message doesn't carry a vector of values.
+*/
+bool vpUDPMessage::get(vpColVector &v) const
+{
+  if (getType() != MESSAGE_COLVECTOR)
+    return false;
+
+  unsigned int n = getNbValues();
+  if (v.getRows() != n)
+    v.resize(n, false);
+  const char *p = m_data + headerSize;
+  for (unsigned int i = 0; i < n; i++, p += 8)
+    v[i] = vpGetDouble(p);
+  return true;
+}
+
+/*!
+  Return the identifier of the data stream of the message.
+*/
+unsigned int vpUDPMessage::getChannel() const { return vpGetUInt32(m_data + 16); }
+
+/*!
+  Return the number of values carried by the message.
+*/
+unsigned int vpUDPMessage::getNbValues() const { return vpGetUInt16(m_data + 20); }
+
+/*!
+  Return the sequence number of the message.
+*/
+unsigned int vpUDPMessage::getSequence() const { return vpGetUInt32(m_data + 4); }
+
+/*!
+  Return the timestamp of the message.
+*/
+double vpUDPMessage::getTimestamp() const { return vpGetDouble(m_data + 8); }
+
+/*!
+  Return the type of the message, vpUDPMessage::MESSAGE_UNKNOWN if the
+  message is not valid.
+*/
+vpUDPMessage::vpMessageType vpUDPMessage::getType() const
+{
+  if (!isValid())
+    return MESSAGE_UNKNOWN;
+  return (vpMessageType)(unsigned char)m_data[3];
+}
+
+/*!
+  Return a value carried by the message.
+
+  \param i : Index of the value, lower than getNbValues().
+*/
+double vpUDPMessage::getValue(const unsigned int i) const
+{
+  if (i >= getNbValues()) {
+    throw(vpException(vpException::dimensionError, "Value %u out of the %u values of the message", i, getNbValues()));
+  }
+  return vpGetDouble(m_data + headerSize + 8 * i);
+}
+
+/*!
+  Return true if the message has a valid header and size, for example after
+  its reception.
+*/
+bool vpUDPMessage::isValid() const
+{
+  if (m_length < headerSize || m_data[0] != 'V' || m_data[1] != 'P' ||
+      (unsigned char)m_data[2] != vpUDPMessageVersion) {
+    return false;
+  }
+  unsigned char type = (unsigned char)m_data[3];
+  unsigned int nbValues = vpGetUInt16(m_data + 20);
+  return (type == MESSAGE_HOMOGENEOUS_MATRIX || type == MESSAGE_COLVECTOR) && nbValues <= maxNbValues &&
+         m_length == headerSize + 8 * nbValues;
+}
+
+/*!
+  Set the message to carry a pose.
+
+  \param M : Pose.
+  \param sequence : Sequence number of the message.
+  \param timestamp : Timestamp of the message, for example from vpTime::measureTimeMs().
+  \param channel : Identifier of the data stream.
+*/
+void vpUDPMessage::set(const vpHomogeneousMatrix &M, const unsigned int sequence, const double timestamp,
+                       const unsigned int channel)
+{
+  setHeader(MESSAGE_HOMOGENEOUS_MATRIX, sequence, timestamp, channel, 12);
+  char *p = m_data + headerSize;
+  for (unsigned int i = 0; i < 3; i++) {
+    for (unsigned int j = 0; j < 4; j++, p += 8)
+      vpPutDouble(p, M[i][j]);
+  }
+}
+
+/*!
+  Set the message to carry a vector of values.
+
+  \param v : Values, at most vpUDPMessage::maxNbValues.
+  \param sequence : Sequence number of the message.
+  \param timestamp : Timestamp of the message, for example from vpTime::measureTimeMs().
+  \param channel : Identifier of the data stream.
+
+  \exception vpException::dimensionError : If the vector has too many values.
+*/
+void vpUDPMessage::set(const vpColVector &v, const unsigned int sequence, const double timestamp,
+                       const unsigned int channel)
+{
+  if (v.getRows() > maxNbValues) {
+    throw(vpException(vpException::dimensionError, "Cannot send %u values in a UDP message (maximum is %u)",
+                      v.getRows(), (unsigned int)maxNbValues));
+  }
+  setHeader(MESSAGE_COLVECTOR, sequence, timestamp, channel, v.getRows());
+  char *p = m_data + headerSize;
+  for (unsigned int i = 0; i < v.getRows(); i++, p += 8)
+    vpPutDouble(p, v[i]);
+}
+
+void vpUDPMessage::setHeader(const vpMessageType type, const unsigned int sequence, const double timestamp,
+                             const unsigned int channel, const unsigned int nbValues)
+{
+  m_data[0] = 'V';
+  m_data[1] = 'P';
+  m_data[2] = (char)vpUDPMessageVersion;
+  m_data[3] = (char)type;
+  vpPutUInt32(m_data + 4, sequence);
+  vpPutDouble(m_data + 8, timestamp);
+  vpPutUInt32(m_data + 16, channel);
+  vpPutUInt16(m_data + 20, nbValues);
+  vpPutUInt16(m_data + 22, 0);
+  m_length = headerSize + 8 * nbValues;
+}
@@ -33,6 +33,7 @@
  *
  *****************************************************************************/
 
+#include <algorithm>
 #include <cstring>
 #include <sstream>
 
@@ -50,8 +51,17 @@
 #include <Ws2tcpip.h>
 #endif
 
+#include <visp3/core/vpTime.h>
 #include <visp3/core/vpUDPServer.h>
 
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+namespace
+{
+// Maximum number of datagrams received by a single system call
+const unsigned int vpUDPServerMaxBatch = 64;
+}
+#endif
+
 /*!
   Create a (IPv4) UDP server.
 
@@ -59,7 +69,7 @@
   \note The server will listen to all the interfaces (see INADDR_ANY).
 */
 vpUDPServer::vpUDPServer(const int port)
-  : m_clientAddress(), m_clientLength(0),
+  : m_batchSize(32), m_busyPoll(false), m_clientAddress(), m_clientLength(0),
     m_serverAddress(), m_socketFileDescriptor(0)
 #if defined(_WIN32)
     , m_wsa()
@@ -75,7 +85,7 @@ vpUDPServer::vpUDPServer(const int port)
   \param port : Server port number.
 */
 vpUDPServer::vpUDPServer(const std::string &hostname, const int port)
-  : m_clientAddress(), m_clientLength(0),
+  : m_batchSize(32), m_busyPoll(false), m_clientAddress(), m_clientLength(0),
     m_serverAddress(), m_socketFileDescriptor(0)
 #if defined(_WIN32)
     , m_wsa()
@@ -256,6 +266,160 @@ int vpUDPServer::receive(std::string &msg, std::string &hostInfo, const int time
   return 0;
 }
 
+/*!
+  Receive a binary message sent by a client with vpUDPClient::send(const vpUDPMessage &).
+
+  \param msg : Received message.
+  \param timeoutMs : Timeout in millisecond (if zero, the call is blocking).
+
+  \return The size of the message, or -1 if there is an error, or 0 if there
+  is a timeout or if the datagram received is not a valid vpUDPMessage.
+*/
+int vpUDPServer::receive(vpUDPMessage &msg, const int timeoutMs)
+{
+  int nb = waitMessages(&msg, 1, timeoutMs);
+  if (nb <= 0) {
+    return nb;
+  }
+  return msg.isValid() ? (int)msg.getLength() : 0;
+}
+
+/*!
+  Receive all the binary messages waiting in the socket, up to the batch size
+  set with setBatchSize(). On Linux, the datagrams are received with a single
+  system call (recvmmsg()).
+
+  \param msgs : Received messages. The vector is resized to the number of
+  messages received and should be reused between calls to avoid any memory
+  allocation. The datagrams that are not valid vpUDPMessage are discarded.
+  \param timeoutMs : Timeout in millisecond to wait for the first message (if
+  zero, the call is blocking).
+
+  \return The number of messages received, or -1 if there is an error, or 0
+  if there is a timeout.
+*/
+int vpUDPServer::receive(std::vector<vpUDPMessage> &msgs, const int timeoutMs)
+{
+  msgs.resize(m_batchSize);
+  int nb = waitMessages(&msgs[0], m_batchSize, timeoutMs);
+  if (nb <= 0) {
+    msgs.clear();
+    return nb;
+  }
+
+  // Discard the invalid datagrams
+  size_t nbValid = 0;
+  for (size_t i = 0; i < (size_t)nb; i++) {
+    if (msgs[i].isValid()) {
+      if (nbValid != i) {
+        msgs[nbValid] = msgs[i];
+      }
+      nbValid++;
+    }
+  }
+  msgs.resize(nbValid);
+  return (int)nbValid;
+}
+
+/*!
+  Receive without waiting the datagrams available in the socket.
+
+  \return The number of datagrams received, or -1 if there is an error.
+*/
+int vpUDPServer::receiveMessages(vpUDPMessage *msgs, const unsigned int nbMsgs)
+{
+  unsigned int nb = 0;
+#if defined(__linux__)
+  struct mmsghdr mmsg[vpUDPServerMaxBatch];
+  struct iovec iov[vpUDPServerMaxBatch];
+  while (nb < nbMsgs) {
+    unsigned int n = std::min(nbMsgs - nb, vpUDPServerMaxBatch);
+    memset(mmsg, 0, n * sizeof(struct mmsghdr));
+    for (unsigned int i = 0; i < n; i++) {
+      iov[i].iov_base = msgs[nb + i].m_data;
+      iov[i].iov_len = sizeof(msgs[nb + i].m_data);
+      mmsg[i].msg_hdr.msg_iov = &iov[i];
+      mmsg[i].msg_hdr.msg_iovlen = 1;
+    }
+    int res = recvmmsg(m_socketFileDescriptor, mmsg, n, MSG_DONTWAIT, NULL);
+    if (res < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+        break;
+      }
+      return nb > 0 ? (int)nb : -1;
+    }
+    for (int i = 0; i < res; i++) {
+      msgs[nb + (unsigned int)i].m_length = mmsg[i].msg_len;
+    }
+    nb += (unsigned int)res;
+    if ((unsigned int)res < n) {
+      break;
+    }
+  }
+#else
+  fd_set s;
+  struct timeval timeout;
+  for (; nb < nbMsgs; nb++) {
+    FD_ZERO(&s);
+    FD_SET(m_socketFileDescriptor, &s);
+    timeout.tv_sec = 0;
+    timeout.tv_usec = 0;
+    int retval = select((int)m_socketFileDescriptor + 1, &s, NULL, NULL, &timeout);
+    if (retval < 0) {
+      return nb > 0 ? (int)nb : -1;
+    }
+    if (retval == 0) {
+      break;
+    }
+    int length = recvfrom(m_socketFileDescriptor, msgs[nb].m_data, sizeof(msgs[nb].m_data), 0, NULL, NULL);
+    if (length < 0) {
+      return nb > 0 ? (int)nb : -1;
+    }
+    msgs[nb].m_length = (unsigned int)length;
+  }
+#endif
+  return (int)nb;
+}
+
+/*!
+  Wait for datagrams and receive the available ones, sleeping in select() or
+  polling the socket if the busy poll mode is enabled.
+
+  \return The number of datagrams received, or -1 if there is an error, or 0
+  if there is a timeout.
+*/
+int vpUDPServer::waitMessages(vpUDPMessage *msgs, const unsigned int nbMsgs, const int timeoutMs)
+{
+  if (m_busyPoll) {
+    double t0 = vpTime::measureTimeMs();
+    int nb = 0;
+    do {
+      nb = receiveMessages(msgs, nbMsgs);
+    } while (nb == 0 && (timeoutMs <= 0 || vpTime::measureTimeMs() - t0 < timeoutMs));
+    return nb;
+  }
+
+  fd_set s;
+  FD_ZERO(&s);
+  FD_SET(m_socketFileDescriptor, &s);
+  struct timeval timeout;
+  if (timeoutMs > 0) {
+    timeout.tv_sec = timeoutMs / 1000;
+    timeout.tv_usec = (timeoutMs % 1000) * 1000;
+  }
+  int retval = select((int)m_socketFileDescriptor + 1, &s, NULL, NULL, timeoutMs > 0 ? &timeout : NULL);
+
+  if (retval == -1) {
+    std::cerr << "Error select!" << std::endl;
+    return -1;
+  }
+  if (retval == 0) {
+    // Timeout
+    return 0;
+  }
+  return receiveMessages(msgs, nbMsgs);
+}
+
 /*!
   Send data to a client.
 
@@ -308,3 +472,32 @@ int vpUDPServer::send(const std::string &msg, const std::string &hostname, const
   return sendto(m_socketFileDescriptor, msg.c_str(), (int) msg.size(), 0, (struct sockaddr *) &m_clientAddress, m_clientLength);
 #endif
 }
+
+/*!
+  Set the maximum number of messages returned by receive(std::vector<vpUDPMessage> &, const int).
+
+  \param batchSize : Maximum number of messages received by a call (32 by default).
+*/
+void vpUDPServer::setBatchSize(const unsigned int batchSize) { m_batchSize = std::max(1u, batchSize); }
+
+/*!
+  Enable or disable the busy poll mode used to receive vpUDPMessage.
+
+  In busy poll mode, the server polls the socket until a message arrives
+  instead of sleeping in the kernel, which removes the wake up latency and
+  its jitter at the cost of a fully busy processor core. On Linux, the socket
+  option SO_BUSY_POLL is also set when available, to poll the network device
+  queue.
+
+  \param busyPoll : true to enable the busy poll mode, false to disable it (default).
+*/
+void vpUDPServer::setBusyPoll(const bool busyPoll)
+{
+  m_busyPoll = busyPoll;
+#if defined(SO_BUSY_POLL)
+  // Busy poll duration in microseconds. This option may require privileges:
+  // the failure is not an error since the socket is polled anyway.
+  int usec = busyPoll ? 50 : 0;
+  setsockopt(m_socketFileDescriptor, SOL_SOCKET, SO_BUSY_POLL, (const void *)&usec, sizeof(usec));
+#endif
+}
@@ -0,0 +1,285 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2017 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * Description:
+ * Test the read-ahead of vpDiskGrabber against the synchronous reading.
+ *
+ *****************************************************************************/
+
+/*!
+  \example testDiskGrabberReadAhead.cpp
+
+  Test vpDiskGrabber read-ahead: the images are the same and in the same order
+  as with the synchronous reading, the end of the sequence is reported at the
+  same image, and a jump in the sequence restarts the read-ahead.
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <visp3/core/vpConfig.h>
+#include <visp3/core/vpIoTools.h>
+#include <visp3/io/vpDiskGrabber.h>
+#include <visp3/io/vpImageIo.h>
+#include <visp3/io/vpParseArgv.h>
+
+// List of allowed command line options
+#define GETOPTARGS "cdo:h"
+
+namespace {
+  const long firstFrame = 1;
+  const long nbFrames = 25;
+
+  // Sequence of the images acquired until the end of the sequence
+  struct vpAcquisition {
+    std::vector<long> numbers;
+    std::vector<unsigned char> values;
+    bool readAfterEnd;
+  };
+
+  unsigned char firstValue(const vpImage<unsigned char> &I) { return I.bitmap[0]; }
+
+  unsigned char firstValue(const vpImage<vpRGBa> &I) { return I.bitmap[0].R; }
+
+  /*
+    Acquire the sequence until its end with a given step, jumping back to
+    image \e jumpFrom once image \e jumpTo is reached.
+  */
+  template <class Type>
+  vpAcquisition acquireSequence(const std::string &genericName, unsigned int nbThreads, unsigned int bufferSize,
+                                long step, long jumpFrom, long jumpTo)
+  {
+    vpDiskGrabber g(genericName);
+    g.setReadAhead(nbThreads, bufferSize);
+    g.setImageNumber(firstFrame);
+    g.setStep(step);
+
+    vpAcquisition acquisition;
+    acquisition.readAfterEnd = false;
+    bool jumped = false;
+    vpImage<Type> I;
+    for (;;) {
+      try {
+        g.acquire(I);
+      }
+      catch(const vpException &) {
+        // End of the sequence
+        break;
+      }
+      acquisition.numbers.push_back(g.getImageNumber());
+      acquisition.values.push_back(firstValue(I));
+      if (! jumped && g.getImageNumber() >= jumpTo) {
+        g.setImageNumber(jumpFrom);
+        jumped = true;
+      }
+    }
+
+    // Reading after the end of the sequence fails again
+    try {
+      g.acquire(I);
+      acquisition.readAfterEnd = true;
+    }
+    catch(const vpException &) {
+    }
+    return acquisition;
+  }
+
+  template <class Type>
+  bool testReadAhead(const std::string &genericName)
+  {
+    unsigned int nbThreads[] = {1, 3, 4, 2};
+    unsigned int bufferSize[] = {0, 2, 8, 40};
+    long steps[] = {1, 2, 3};
+    for (size_t s = 0; s < sizeof(steps) / sizeof(steps[0]); s++) {
+      vpAcquisition ref = acquireSequence<Type>(genericName, 0, 0, steps[s], 5, 16);
+      if (ref.numbers.empty() || ref.numbers.back() + steps[s] <= firstFrame + nbFrames - 1) {
+        std::cerr << "The synchronous reading did not reach the end of the sequence" << std::endl;
+        return false;
+      }
+      for (size_t i = 0; i < sizeof(nbThreads) / sizeof(nbThreads[0]); i++) {
+        vpAcquisition acquisition = acquireSequence<Type>(genericName, nbThreads[i], bufferSize[i], steps[s], 5, 16);
+        if (acquisition.numbers != ref.numbers || acquisition.values != ref.values) {
+          std::cerr << "Step " << steps[s] << ", " << nbThreads[i] << " threads, buffer size " << bufferSize[i]
+                    << ": " << acquisition.numbers.size() << " images read instead of " << ref.numbers.size()
+                    << " or different images" << std::endl;
+          return false;
+        }
+        if (acquisition.readAfterEnd) {
+          std::cerr << "Step " << steps[s] << ", " << nbThreads[i] << " threads: an image was read after the end"
+                    << std::endl;
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+  /*
+    Print the program options.
+
+    \param name : Program name.
+    \param badparam : Bad parameter name.
+    \param opath : Output image path.
+    \param user : Username.
+  */
+  void usage(const char *name, const char *badparam, const std::string &opath, const std::string &user)
+  {
+    fprintf(stdout, "\n\
+Read an image sequence with vpDiskGrabber read-ahead and compare with the\n\
+synchronous reading.\n\
+\n\
+SYNOPSIS\n\
+  %s [-o <output image path>] [-h]\n", name);
+
+    fprintf(stdout, "\n\
+OPTIONS:                                               Default\n\
+  -o <output image path>                               %s\n\
+     Set image output path.\n\
+     From this directory, creates the \"%s\"\n\
+     subdirectory depending on the username, where \n\
+     the testDiskGrabberReadAhead directory with the sequence is created.\n\
+\n\
+  -h\n\
+     Print the help.\n\n",
+      opath.c_str(), user.c_str());
+
+    if (badparam)
+      fprintf(stdout, "\nERROR: Bad parameter [%s]\n", badparam);
+  }
+
+  /*
+    Set the program options.
+
+    \param argc : Command line number of parameters.
+    \param argv : Array of command line parameters.
+    \param opath : Output image path.
+    \param user : Username.
+    \return false if the program has to be stopped, true otherwise.
+  */
+  bool getOptions(int argc, const char **argv, std::string &opath, const std::string &user)
+  {
+    const char *optarg_;
+    int c;
+    while ((c = vpParseArgv::parse(argc, argv, GETOPTARGS, &optarg_)) > 1) {
+
+      switch (c) {
+      case 'o': opath = optarg_; break;
+      case 'h': usage(argv[0], NULL, opath, user); return false; break;
+
+      case 'c':
+      case 'd':
+        break;
+
+      default:
+        usage(argv[0], optarg_, opath, user); return false; break;
+      }
+    }
+
+    if ((c == 1) || (c == -1)) {
+      // standalone param or error
+      usage(argv[0], NULL, opath, user);
+      std::cerr << "ERROR: " << std::endl;
+      std::cerr << "  Bad argument " << optarg_ << std::endl << std::endl;
+      return false;
+    }
+
+    return true;
+  }
+}
+
+int main(int argc, const char **argv)
+{
+  try {
+    std::string opt_opath;
+    std::string username;
+
+    // Set the default output path
+#if defined(_WIN32)
+    opt_opath = "C:/temp";
+#else
+    opt_opath = "/tmp";
+#endif
+
+    // Get the user login name
+    vpIoTools::getUserName(username);
+
+    // Read the command line options
+    if (getOptions(argc, argv, opt_opath, username) == false)
+      return EXIT_FAILURE;
+
+    // Append to the output path string, the login name of the user and the name of the test
+    std::string opath = vpIoTools::createFilePath(opt_opath, username);
+    opath = vpIoTools::createFilePath(opath, "testDiskGrabberReadAhead");
+
+    // Test if the output path exist. If no try to create it
+    if (vpIoTools::checkDirectory(opath) == false) {
+      try {
+        vpIoTools::makeDirectory(opath);
+      }
+      catch (...) {
+        usage(argv[0], NULL, opt_opath, username);
+        std::cerr << std::endl << "ERROR:" << std::endl;
+        std::cerr << "  Cannot create " << opath << std::endl;
+        std::cerr << "  Check your -o " << opt_opath << " option " << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+
+    std::string genericName = vpIoTools::createFilePath(opath, "image%04d.pgm");
+    std::vector<std::string> files;
+    for (long k = firstFrame; k < firstFrame + nbFrames; k++) {
+      vpImage<unsigned char> I(10, 12, (unsigned char) (3*k));
+      char name[FILENAME_MAX];
+      sprintf(name, genericName.c_str(), k);
+      vpImageIo::write(I, name);
+      files.push_back(name);
+    }
+    // Remove the image following the sequence left by a previous run
+    char name[FILENAME_MAX];
+    sprintf(name, genericName.c_str(), firstFrame + nbFrames);
+    if (vpIoTools::checkFilename(name))
+      vpIoTools::remove(name);
+
+    bool success = testReadAhead<unsigned char>(genericName) && testReadAhead<vpRGBa>(genericName);
+
+    for (size_t i = 0; i < files.size(); i++)
+      vpIoTools::remove(files[i]);
+    if (! success)
+      return EXIT_FAILURE;
+  }
+  catch(const vpException &e) {
+    std::cerr << "Catch an exception: " << e.getStringMessage() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "testDiskGrabberReadAhead is ok." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,345 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2017 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * Description:
+ * Test the batch reading and writing of images.
+ *
+ *****************************************************************************/
+
+/*!
+  \example testImageBatch.cpp
+
+  Test vpImageIo::readBatch(), vpImageIo::writeBatch() and vpImageBatchReader:
+  images are delivered in the order of the file list, an unreadable file is
+  reported without stopping the other ones, and the iteration is the same
+  whatever the batch size.
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <visp3/core/vpConfig.h>
+#include <visp3/core/vpImageConvert.h>
+#include <visp3/core/vpIoTools.h>
+#include <visp3/io/vpImageBatchReader.h>
+#include <visp3/io/vpImageIo.h>
+#include <visp3/io/vpParseArgv.h>
+
+// List of allowed command line options
+#define GETOPTARGS "cdo:h"
+
+namespace {
+  const unsigned int nbImages = 11;
+  // Index of the file removed from the list of images to read
+  const unsigned int missingIndex = 4;
+
+  // Image whose content depends on its index, so that any permutation is detected
+  template <class Type>
+  void createImage(unsigned int index, vpImage<Type> &I) {
+    I.resize(16 + index, 24);
+    for (unsigned int i = 0; i < I.getSize(); i++)
+      I.bitmap[i] = (Type) (index * 20 + i % 7);
+  }
+
+  void createImage(unsigned int index, vpImage<vpRGBa> &I) {
+    vpImage<unsigned char> I_grey;
+    createImage(index, I_grey);
+    vpImageConvert::convert(I_grey, I);
+  }
+
+  // Write the images, then read them back with readBatch(), one file of the list being removed
+  template <class Type>
+  bool checkBatch(const std::vector<std::string> &filenames, const std::string &name) {
+    std::vector<vpImage<Type> > I(nbImages), I_read;
+    for (unsigned int i = 0; i < nbImages; i++)
+      createImage(i, I[i]);
+
+    std::vector<std::string> errors;
+    if (vpImageIo::writeBatch(I, filenames, errors) != nbImages || errors.size() != nbImages) {
+      std::cerr << name << ": not all the images are written" << std::endl;
+      return false;
+    }
+    vpIoTools::remove(filenames[missingIndex]);
+
+    if (vpImageIo::readBatch(I_read, filenames, errors) != nbImages - 1 || I_read.size() != nbImages ||
+        errors.size() != nbImages) {
+      std::cerr << name << ": wrong number of images read" << std::endl;
+      return false;
+    }
+    for (unsigned int i = 0; i < nbImages; i++) {
+      if (i == missingIndex) {
+        if (errors[i].empty()) {
+          std::cerr << name << ": the missing file is not reported" << std::endl;
+          return false;
+        }
+      }
+      else if (! errors[i].empty() || I[i] != I_read[i]) {
+        std::cerr << name << ": image " << i << " is not read back at its place: " << errors[i] << std::endl;
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Iterate over the list with vpImageBatchReader, the file missingIndex being missing
+  template <class Type>
+  bool checkBatchReader(vpImageBatchReader &reader, const std::vector<std::string> &filenames, const std::string &name) {
+    vpImage<Type> I, I_ref;
+    for (unsigned int pass = 0; pass < 2; pass++) {
+      unsigned int i = 0;
+      for (; reader.next(I); i++) {
+        if (i >= nbImages || reader.getIndex() != i || reader.getFilename() != filenames[i]) {
+          std::cerr << name << ": wrong index or file name at image " << i << std::endl;
+          return false;
+        }
+        if (i == missingIndex) {
+          if (reader.getError().empty()) {
+            std::cerr << name << ": the missing file is not reported" << std::endl;
+            return false;
+          }
+          continue;
+        }
+        createImage(i, I_ref);
+        if (! reader.getError().empty() || I != I_ref) {
+          std::cerr << name << ": wrong image " << i << ": " << reader.getError() << std::endl;
+          return false;
+        }
+      }
+      if (i != nbImages || reader.next(I)) {
+        std::cerr << name << ": " << i << " images delivered instead of " << nbImages << std::endl;
+        return false;
+      }
+      reader.rewind();
+    }
+    return true;
+  }
+  /*
+    Print the program options.
+
+    \param name : Program name.
+    \param badparam : Bad parameter name.
+    \param opath : Output image path.
+    \param user : Username.
+  */
+  void usage(const char *name, const char *badparam, const std::string &opath, const std::string &user)
+  {
+    fprintf(stdout, "\n\
+Write images in batches and read them back with vpImageIo::readBatch()\n\
+and vpImageBatchReader.\n\
+\n\
+SYNOPSIS\n\
+  %s [-o <output image path>] [-h]\n", name);
+
+    fprintf(stdout, "\n\
+OPTIONS:                                               Default\n\
+  -o <output image path>                               %s\n\
+     Set image output path.\n\
+     From this directory, creates the \"%s\"\n\
+     subdirectory depending on the username, where \n\
+     the testImageBatch directory with the test images is created.\n\
+\n\
+  -h\n\
+     Print the help.\n\n",
+      opath.c_str(), user.c_str());
+
+    if (badparam)
+      fprintf(stdout, "\nERROR: Bad parameter [%s]\n", badparam);
+  }
+
+  /*
+    Set the program options.
+
+    \param argc : Command line number of parameters.
+    \param argv : Array of command line parameters.
+    \param opath : Output image path.
+    \param user : Username.
+    \return false if the program has to be stopped, true otherwise.
+  */
+  bool getOptions(int argc, const char **argv, std::string &opath, const std::string &user)
+  {
+    const char *optarg_;
+    int c;
+    while ((c = vpParseArgv::parse(argc, argv, GETOPTARGS, &optarg_)) > 1) {
+
+      switch (c) {
+      case 'o': opath = optarg_; break;
+      case 'h': usage(argv[0], NULL, opath, user); return false; break;
+
+      case 'c':
+      case 'd':
+        break;
+
+      default:
+        usage(argv[0], optarg_, opath, user); return false; break;
+      }
+    }
+
+    if ((c == 1) || (c == -1)) {
+      // standalone param or error
+      usage(argv[0], NULL, opath, user);
+      std::cerr << "ERROR: " << std::endl;
+      std::cerr << "  Bad argument " << optarg_ << std::endl << std::endl;
+      return false;
+    }
+
+    return true;
+  }
+}
+
+int main(int argc, const char **argv)
+{
+  try {
+    std::string opt_opath;
+    std::string username;
+
+    // Set the default output path
+#if defined(_WIN32)
+    opt_opath = "C:/temp";
+#else
+    opt_opath = "/tmp";
+#endif
+
+    // Get the user login name
+    vpIoTools::getUserName(username);
+
+    // Read the command line options
+    if (getOptions(argc, argv, opt_opath, username) == false)
+      return EXIT_FAILURE;
+
+    // Append to the output path string, the login name of the user and the name of the test
+    std::string opath = vpIoTools::createFilePath(opt_opath, username);
+    opath = vpIoTools::createFilePath(opath, "testImageBatch");
+
+    // Test if the output path exist. If no try to create it
+    if (vpIoTools::checkDirectory(opath) == false) {
+      try {
+        vpIoTools::makeDirectory(opath);
+      }
+      catch (...) {
+        usage(argv[0], NULL, opt_opath, username);
+        std::cerr << std::endl << "ERROR:" << std::endl;
+        std::cerr << "  Cannot create " << opath << std::endl;
+        std::cerr << "  Check your -o " << opt_opath << " option " << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+
+    std::vector<std::string> greyFilenames, colorFilenames, depthFilenames;
+    for (unsigned int i = 0; i < nbImages; i++) {
+      char name[FILENAME_MAX];
+      // The names are not in the alphabetical order of the list
+      sprintf(name, "grey-%u.pgm", (i * 7) % nbImages);
+      greyFilenames.push_back(vpIoTools::createFilePath(opath, name));
+      sprintf(name, "color-%u.ppm", (i * 7) % nbImages);
+      colorFilenames.push_back(vpIoTools::createFilePath(opath, name));
+      sprintf(name, "depth-%u.pgm", (i * 7) % nbImages);
+      depthFilenames.push_back(vpIoTools::createFilePath(opath, name));
+    }
+
+    if (! checkBatch<unsigned char>(greyFilenames, "Grey") || ! checkBatch<vpRGBa>(colorFilenames, "Color") ||
+        ! checkBatch<uint16_t>(depthFilenames, "Depth"))
+      return EXIT_FAILURE;
+
+    // Batch sizes smaller than, dividing, not dividing and larger than the number of files
+    unsigned int batchSizes[5] = { 1, 3, 4, nbImages, 100 };
+    for (unsigned int b = 0; b < 5; b++) {
+      vpImageBatchReader reader(greyFilenames, batchSizes[b]);
+      if (! checkBatchReader<unsigned char>(reader, greyFilenames, "Grey reader"))
+        return EXIT_FAILURE;
+      reader.setFileNames(colorFilenames);
+      if (! checkBatchReader<vpRGBa>(reader, colorFilenames, "Color reader"))
+        return EXIT_FAILURE;
+      reader.setFileNames(depthFilenames);
+      if (! checkBatchReader<uint16_t>(reader, depthFilenames, "Depth reader"))
+        return EXIT_FAILURE;
+    }
+
+    // Changing the image type in the middle of a batch decodes the files again
+    vpImageBatchReader reader(colorFilenames, 4);
+    vpImage<vpRGBa> I_color, I_color_ref;
+    vpImage<unsigned char> I_grey, I_grey_ref;
+    createImage(0, I_color_ref);
+    vpImageIo::read(I_grey_ref, colorFilenames[1]);
+    if (! reader.next(I_color) || I_color != I_color_ref || ! reader.next(I_grey) || reader.getIndex() != 1 ||
+        ! reader.getError().empty() || I_grey != I_grey_ref) {
+      std::cerr << "Wrong image after a change of type" << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    // An image that cannot be written is reported, the other ones are written
+    std::vector<vpImage<unsigned char> > I(3);
+    std::vector<std::string> filenames, errors;
+    for (unsigned int i = 0; i < 3; i++) {
+      createImage(i, I[i]);
+      char name[FILENAME_MAX];
+      sprintf(name, i == 1 ? "directory-that-does-not-exist/grey-write-%u.pgm" : "grey-write-%u.pgm", i);
+      filenames.push_back(vpIoTools::createFilePath(opath, name));
+    }
+    if (vpImageIo::writeBatch(I, filenames, errors) != 2 || errors[1].empty() || ! errors[0].empty() ||
+        ! errors[2].empty()) {
+      std::cerr << "The image that cannot be written is not reported" << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    for (unsigned int i = 0; i < nbImages; i++) {
+      if (i != missingIndex) {
+        vpIoTools::remove(greyFilenames[i]);
+        vpIoTools::remove(colorFilenames[i]);
+        vpIoTools::remove(depthFilenames[i]);
+      }
+    }
+    vpIoTools::remove(filenames[0]);
+    vpIoTools::remove(filenames[2]);
+
+    // The number of images and file names must be the same
+    bool refused = false;
+    filenames.pop_back();
+    try {
+      vpImageIo::writeBatch(I, filenames, errors);
+    }
+    catch(const vpException &) {
+      refused = true;
+    }
+    if (! refused) {
+      std::cerr << "A number of file names different from the number of images is accepted" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  catch(const vpException &e) {
+    std::cerr << "Catch an exception: " << e.getStringMessage() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "testImageBatch is ok." << std::endl;
+  return EXIT_SUCCESS;
+}
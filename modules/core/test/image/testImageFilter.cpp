@@ -41,6 +41,7 @@
 #include <iostream>
 #include <visp3/core/vpImageFilter.h>
 #include <visp3/core/vpImageConvert.h>
+#include <visp3/core/vpImageTools.h>
 #include <visp3/core/vpIoTools.h>
 #include <visp3/io/vpParseArgv.h>
 #include <visp3/io/vpImageIo.h>
@@ -459,6 +460,51 @@ int main(int argc, const char *argv[]) {
       return EXIT_FAILURE;
     }
 #endif
+
+
+    //Test integral image and box filter
+    vpImage<unsigned int> II;
+    vpImage<unsigned long long> IIsq;
+    t = vpTime::measureTimeMs();
+    vpImageTools::integralImage(I, II, IIsq);
+    t = vpTime::measureTimeMs() - t;
+    std::cout << "\nTime to compute the integral images: " << t << " ms" << std::endl;
+
+    unsigned long long sum = 0, sumSq = 0;
+    for (unsigned int i = 10; i < 10 + I.getHeight() / 2; i++) {
+      for (unsigned int j = 20; j < 20 + I.getWidth() / 3; j++) {
+        sum += I[i][j];
+        sumSq += I[i][j] * I[i][j];
+      }
+    }
+    if (vpImageTools::boxSum(II, 10, 20, I.getHeight() / 2, I.getWidth() / 3) != sum ||
+        vpImageTools::boxSum(IIsq, 10, 20, I.getHeight() / 2, I.getWidth() / 3) != sumSq) {
+      std::cerr << "Failed integral image!" << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    const unsigned int box_size = 5;
+    vpImage<double> I_box;
+    t = vpTime::measureTimeMs();
+    vpImageFilter::boxFilter(I, I_box, box_size);
+    t = vpTime::measureTimeMs() - t;
+    std::cout << "Time to do boxFilter: " << t << " ms" << std::endl;
+
+    for (int i = 0; i < (int)I.getHeight(); i++) {
+      for (int j = 0; j < (int)I.getWidth(); j++) {
+        double box_sum = 0;
+        int count = 0;
+        for (int u = std::max(0, i - 2); u <= std::min((int)I.getHeight() - 1, i + 2); u++) {
+          for (int v = std::max(0, j - 2); v <= std::min((int)I.getWidth() - 1, j + 2); v++, count++) {
+            box_sum += I[(unsigned int)u][(unsigned int)v];
+          }
+        }
+        if (!vpMath::equal(I_box[(unsigned int)i][(unsigned int)j], box_sum / count, 1e-9)) {
+          std::cerr << "Failed box filter at (" << i << ", " << j << ")!" << std::endl;
+          return EXIT_FAILURE;
+        }
+      }
+    }
   }
   catch(vpException &e) {
     std::cerr << "Catch an exception: " << e.what() << std::endl;
@@ -259,6 +259,25 @@ void generalDilatation(vpImage<unsigned char> &I, vpImageMorphology::vpConnexity
   }
 }
 
+// Erosion or dilatation with a rectangular structuring element computed window by window
+void generalRectangle(vpImage<unsigned char> &I, unsigned int width, unsigned int height, bool erosion) {
+  vpImage<unsigned char> J = I;
+  int x0 = -(int)(width / 2), y0 = -(int)(height / 2);
+  for (int i = 0; i < (int)I.getHeight(); i++) {
+    for (int j = 0; j < (int)I.getWidth(); j++) {
+      unsigned char value = erosion ? 255 : 0;
+      for (int y = i + y0; y < i + y0 + (int)height; y++) {
+        for (int x = j + x0; x < j + x0 + (int)width; x++) {
+          if (y >= 0 && y < (int)I.getHeight() && x >= 0 && x < (int)I.getWidth()) {
+            value = erosion ? (std::min)(value, J[y][x]) : (std::max)(value, J[y][x]);
+          }
+        }
+      }
+      I[i][j] = value;
+    }
+  }
+}
+
 //Generate a magic square matrix to get a consistent grayscale image
 void magicSquare(vpImage<unsigned char> &magic_square, const int N) {
   magic_square.resize((unsigned int) N, (unsigned int) N, 0);
@@ -649,6 +668,46 @@ int main(int argc, const char ** argv) {
 
 
 
+    //Rectangular structuring elements
+    vpImage<unsigned char> I_random(37, 53);
+    for (unsigned int i = 0; i < I_random.getSize(); i++) {
+      I_random.bitmap[i] = (unsigned char) ((i * 7919 + (i / 13) * 104729) % 256);
+    }
+
+    unsigned int rectangle_sizes[][2] = {{1, 1}, {3, 3}, {2, 5}, {6, 1}, {1, 9}, {15, 15}, {8, 21}, {60, 40}};
+    for (size_t cpt = 0; cpt < sizeof(rectangle_sizes) / sizeof(rectangle_sizes[0]); cpt++) {
+      unsigned int width = rectangle_sizes[cpt][0], height = rectangle_sizes[cpt][1];
+      vpImage<unsigned char> I_rect_erosion = I_random, I_rect_erosion_ref = I_random;
+      vpImage<unsigned char> I_rect_dilatation = I_random, I_rect_dilatation_ref = I_random;
+
+      vpImageMorphology::erosion(I_rect_erosion, width, height);
+      generalRectangle(I_rect_erosion_ref, width, height, true);
+      vpImageMorphology::dilatation(I_rect_dilatation, width, height);
+      generalRectangle(I_rect_dilatation_ref, width, height, false);
+
+      if (I_rect_erosion != I_rect_erosion_ref) {
+        throw vpException(vpException::fatalError, "Bad erosion with a %ux%u rectangle", width, height);
+      }
+      if (I_rect_dilatation != I_rect_dilatation_ref) {
+        throw vpException(vpException::fatalError, "Bad dilatation with a %ux%u rectangle", width, height);
+      }
+    }
+
+    vpImage<unsigned char> I_magic_square_rect = I_magic_square;
+    vpImageMorphology::dilatation(I_magic_square_rect, 3, 3);
+    if (I_magic_square_rect != I2_check_dilated2) {
+      throw vpException(vpException::fatalError, "(I_magic_square_rect != I2_check_dilated2)");
+    }
+
+    vpImage<unsigned char> I_opening = I_random, I_top_hat = I_random;
+    vpImageMorphology::opening(I_opening, 15, 15);
+    vpImageMorphology::topHat(I_top_hat, 15, 15);
+    for (unsigned int i = 0; i < I_random.getSize(); i++) {
+      if (I_opening.bitmap[i] > I_random.bitmap[i] || I_top_hat.bitmap[i] != I_random.bitmap[i] - I_opening.bitmap[i]) {
+        throw vpException(vpException::fatalError, "Bad opening or top-hat");
+      }
+    }
+
     std::cout << std::endl;
     vpImage<unsigned char> I_Klimt;
     filename = vpIoTools::createFilePath(ipath, "Klimt/Klimt.pgm");
@@ -842,6 +901,37 @@ int main(int argc, const char ** argv) {
               << " ; speed-up=" << (t/t_sse) << "X" << std::endl;
 
 
+    //15x15 opening: repeated 3x3 operations compared with the rectangular structuring element
+    vpImage<unsigned char> I_Klimt_opening = I_Klimt;
+    vpImage<unsigned char> I_Klimt_opening_rect = I_Klimt;
+
+    t = vpTime::measureTimeMs();
+    for (int cpt = 0; cpt < nbIterations; cpt++) {
+      for (int k = 0; k < 7; k++) {
+        vpImageMorphology::erosion(I_Klimt_opening, vpImageMorphology::CONNEXITY_8);
+      }
+      for (int k = 0; k < 7; k++) {
+        vpImageMorphology::dilatation(I_Klimt_opening, vpImageMorphology::CONNEXITY_8);
+      }
+    }
+    t = vpTime::measureTimeMs() - t;
+
+    double t_rect = vpTime::measureTimeMs();
+    for (int cpt = 0; cpt < nbIterations; cpt++) {
+      vpImageMorphology::opening(I_Klimt_opening_rect, 15, 15);
+    }
+    t_rect = vpTime::measureTimeMs() - t_rect;
+
+    std::cout << "(I_Klimt_opening == I_Klimt_opening_rect)? "
+              << (I_Klimt_opening == I_Klimt_opening_rect)
+              << " ; t=" << t << " ms ; t_rect="  << t_rect << " ms"
+              << " ; speed-up=" << (t/t_rect) << "X" << std::endl;
+
+    if (I_Klimt_opening != I_Klimt_opening_rect) {
+      throw vpException(vpException::fatalError, "(I_Klimt_opening != I_Klimt_opening_rect)");
+    }
+
+
     //Compare with OpenCV
 #if (VISP_HAVE_OPENCV_VERSION >= 0x030000)
     std::cout << std::endl;
@@ -0,0 +1,327 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2017 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * Description:
+ * Write and read back QOI images and 16 bits PGM depth maps.
+ *
+ *****************************************************************************/
+
+/*!
+  \example testIoQOI.cpp
+
+  Write and read back QOI images (gray level, color with alpha and depth maps)
+  and 16 bits PGM depth maps, and check that the images are unchanged. A color
+  QOI image read as a gray level image is converted as by vpImageConvert.
+  Check also that the PNG compression settings are applied.
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+#include <visp3/core/vpConfig.h>
+#include <visp3/core/vpImageConvert.h>
+#include <visp3/core/vpImageException.h>
+#include <visp3/core/vpIoTools.h>
+#include <visp3/io/vpImageIo.h>
+#include <visp3/io/vpParseArgv.h>
+
+// List of allowed command line options
+#define GETOPTARGS "cdo:h"
+
+namespace {
+  // Images with runs, small and large differences between neighbor pixels, to go through all the QOI operations
+  void createImage(vpImage<unsigned char> &I) {
+    I.resize(37, 53);
+    for (unsigned int i = 0; i < I.getHeight(); i++) {
+      for (unsigned int j = 0; j < I.getWidth(); j++) {
+        if (i % 5 == 0)
+          I[i][j] = 128;
+        else if (i % 5 == 1)
+          I[i][j] = (unsigned char) (i + j);
+        else
+          I[i][j] = (unsigned char) ((i * 131 + j * 71 + i * j * 17) % 256);
+      }
+    }
+  }
+
+  void createImage(vpImage<vpRGBa> &I) {
+    vpImage<unsigned char> G;
+    createImage(G);
+    I.resize(G.getHeight(), G.getWidth());
+    for (unsigned int i = 0; i < G.getSize(); i++) {
+      unsigned char v = G.bitmap[i];
+      I.bitmap[i] = vpRGBa(v, (unsigned char) (v + 1), (unsigned char) (v ^ 0x5a), (unsigned char) (i % 3 == 0 ? 255 : v));
+    }
+  }
+
+  void createImage(vpImage<uint16_t> &I) {
+    I.resize(37, 53);
+    for (unsigned int i = 0; i < I.getHeight(); i++) {
+      for (unsigned int j = 0; j < I.getWidth(); j++) {
+        if (i % 4 == 0)
+          I[i][j] = 0;
+        else if (i % 4 == 1)
+          I[i][j] = (uint16_t) (1000 + i + j);
+        else
+          I[i][j] = (uint16_t) ((i * 40503u + j * 7919u) % 65536u);
+      }
+    }
+  }
+
+  // Write the image, read it back in an image of the same type and compare
+  template <class Type>
+  bool checkRoundTrip(const std::string &filename) {
+    vpImage<Type> I, I_read;
+    createImage(I);
+    vpImageIo::write(I, filename);
+    vpImageIo::read(I_read, filename);
+    bool same = (I == I_read);
+    if (! same)
+      std::cerr << filename << " is not read back unchanged" << std::endl;
+    vpIoTools::remove(filename);
+    return same;
+  }
+  /*
+    Write a QOI file whose header gives the image size \e width x \e height
+    while the payload only encodes a few pixels, and check that reading it is
+    rejected before the image is allocated.
+  */
+  bool checkForgedHeader(const std::string &filename, unsigned int width, unsigned int height) {
+    unsigned char header[14] = { 'q', 'o', 'i', 'f', 0, 0, 0, 0, 0, 0, 0, 0, 4, 0 };
+    for (unsigned int i = 0; i < 4; i++) {
+      header[4 + i] = (unsigned char) (width >> (24 - 8 * i));
+      header[8 + i] = (unsigned char) (height >> (24 - 8 * i));
+    }
+    // Four runs of 62 pixels, then the end marker
+    const unsigned char data[12] = { 0xfd, 0xfd, 0xfd, 0xfd, 0, 0, 0, 0, 0, 0, 0, 1 };
+    std::ofstream f(filename.c_str(), std::ios::binary);
+    f.write((const char *) header, sizeof(header));
+    f.write((const char *) data, sizeof(data));
+    f.close();
+
+    bool rejected = false;
+    vpImage<vpRGBa> I;
+    try {
+      vpImageIo::read(I, filename);
+    }
+    catch(vpException &e) {
+      rejected = (e.getCode() == vpImageException::ioError);
+    }
+    vpIoTools::remove(filename);
+    if (! rejected)
+      std::cerr << "A QOI file of " << width << "x" << height << " with a payload of 248 pixels is not rejected" << std::endl;
+    return rejected;
+  }
+
+  /*
+    Print the program options.
+
+    \param name : Program name.
+    \param badparam : Bad parameter name.
+    \param opath : Output image path.
+    \param user : Username.
+  */
+  void usage(const char *name, const char *badparam, const std::string &opath, const std::string &user)
+  {
+    fprintf(stdout, "\n\
+Write and read back QOI images and 16 bits PGM depth maps.\n\
+\n\
+SYNOPSIS\n\
+  %s [-o <output image path>] [-h]\n", name);
+
+    fprintf(stdout, "\n\
+OPTIONS:                                               Default\n\
+  -o <output image path>                               %s\n\
+     Set image output path.\n\
+     From this directory, creates the \"%s\"\n\
+     subdirectory depending on the username, where \n\
+     the testIoQOI directory with the test images is created.\n\
+\n\
+  -h\n\
+     Print the help.\n\n",
+      opath.c_str(), user.c_str());
+
+    if (badparam)
+      fprintf(stdout, "\nERROR: Bad parameter [%s]\n", badparam);
+  }
+
+  /*
+    Set the program options.
+
+    \param argc : Command line number of parameters.
+    \param argv : Array of command line parameters.
+    \param opath : Output image path.
+    \param user : Username.
+    \return false if the program has to be stopped, true otherwise.
+  */
+  bool getOptions(int argc, const char **argv, std::string &opath, const std::string &user)
+  {
+    const char *optarg_;
+    int c;
+    while ((c = vpParseArgv::parse(argc, argv, GETOPTARGS, &optarg_)) > 1) {
+
+      switch (c) {
+      case 'o': opath = optarg_; break;
+      case 'h': usage(argv[0], NULL, opath, user); return false; break;
+
+      case 'c':
+      case 'd':
+        break;
+
+      default:
+        usage(argv[0], optarg_, opath, user); return false; break;
+      }
+    }
+
+    if ((c == 1) || (c == -1)) {
+      // standalone param or error
+      usage(argv[0], NULL, opath, user);
+      std::cerr << "ERROR: " << std::endl;
+      std::cerr << "  Bad argument " << optarg_ << std::endl << std::endl;
+      return false;
+    }
+
+    return true;
+  }
+}
+
+int main(int argc, const char **argv)
+{
+  try {
+    std::string opt_opath;
+    std::string username;
+
+    // Set the default output path
+#if defined(_WIN32)
+    opt_opath = "C:/temp";
+#else
+    opt_opath = "/tmp";
+#endif
+
+    // Get the user login name
+    vpIoTools::getUserName(username);
+
+    // Read the command line options
+    if (getOptions(argc, argv, opt_opath, username) == false)
+      return EXIT_FAILURE;
+
+    // Append to the output path string, the login name of the user and the name of the test
+    std::string opath = vpIoTools::createFilePath(opt_opath, username);
+    opath = vpIoTools::createFilePath(opath, "testIoQOI");
+
+    // Test if the output path exist. If no try to create it
+    if (vpIoTools::checkDirectory(opath) == false) {
+      try {
+        vpIoTools::makeDirectory(opath);
+      }
+      catch (...) {
+        usage(argv[0], NULL, opt_opath, username);
+        std::cerr << std::endl << "ERROR:" << std::endl;
+        std::cerr << "  Cannot create " << opath << std::endl;
+        std::cerr << "  Check your -o " << opt_opath << " option " << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+
+    if (! checkRoundTrip<unsigned char>(vpIoTools::createFilePath(opath, "grey.qoi")) ||
+        ! checkRoundTrip<vpRGBa>(vpIoTools::createFilePath(opath, "color.qoi")) ||
+        ! checkRoundTrip<uint16_t>(vpIoTools::createFilePath(opath, "depth.qoi")) ||
+        ! checkRoundTrip<uint16_t>(vpIoTools::createFilePath(opath, "depth.pgm")))
+      return EXIT_FAILURE;
+
+    // A color image read as a gray level image is converted as the other formats do
+    std::string filename = vpIoTools::createFilePath(opath, "color.qoi");
+    vpImage<vpRGBa> I_color;
+    createImage(I_color);
+    vpImageIo::write(I_color, filename);
+    vpImage<unsigned char> I_grey, I_grey_ref;
+    vpImageIo::read(I_grey, filename);
+    vpImageConvert::convert(I_color, I_grey_ref);
+    vpIoTools::remove(filename);
+    if (I_grey != I_grey_ref) {
+      std::cerr << "The gray level image read from a color QOI file differs from vpImageConvert::convert()" << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    // A header asking for more pixels than the payload can encode is rejected
+    filename = vpIoTools::createFilePath(opath, "forged.qoi");
+    if (! checkForgedHeader(filename, 100000, 100000) || ! checkForgedHeader(filename, 16, 16))
+      return EXIT_FAILURE;
+
+#if defined(VISP_HAVE_PNG)
+    // The PNG compression settings change the file size, not the image
+    filename = vpIoTools::createFilePath(opath, "grey.png");
+    vpImage<unsigned char> I_png, I_png_read;
+    createImage(I_png);
+    vpImageIo::setPNGCompression(0, false);
+    vpImageIo::write(I_png, filename);
+    vpImageIo::read(I_png_read, filename);
+    std::ifstream f_raw(filename.c_str(), std::ios::binary | std::ios::ate);
+    std::streamoff rawSize = f_raw.tellg();
+    f_raw.close();
+    vpImageIo::setPNGCompression(9, true);
+    vpImageIo::write(I_png, filename);
+    std::ifstream f_best(filename.c_str(), std::ios::binary | std::ios::ate);
+    std::streamoff bestSize = f_best.tellg();
+    f_best.close();
+    vpImageIo::setPNGCompression(-1);
+    vpIoTools::remove(filename);
+    if (I_png_read != I_png || bestSize >= rawSize) {
+      std::cerr << "Wrong PNG compression: " << rawSize << " bytes without compression, " << bestSize
+                << " bytes at level 9" << std::endl;
+      return EXIT_FAILURE;
+    }
+#endif
+
+    // An 8 bits PGM file is read as a depth map with the same values
+    filename = vpIoTools::createFilePath(opath, "grey.pgm");
+    vpImage<unsigned char> I;
+    createImage(I);
+    vpImageIo::write(I, filename);
+    vpImage<uint16_t> I_depth;
+    vpImageIo::read(I_depth, filename);
+    vpIoTools::remove(filename);
+    for (unsigned int i = 0; i < I.getSize(); i++) {
+      if (I_depth.getSize() != I.getSize() || I_depth.bitmap[i] != I.bitmap[i]) {
+        std::cerr << "The 8 bits PGM file is not read back as a depth map with the same values" << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+  catch(const vpException &e) {
+    std::cerr << "Catch an exception: " << e.getStringMessage() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "testIoQOI is ok." << std::endl;
+  return EXIT_SUCCESS;
+}
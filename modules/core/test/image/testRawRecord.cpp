@@ -0,0 +1,319 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2017 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * Description:
+ * Write and read back a raw recording.
+ *
+ *****************************************************************************/
+
+/*!
+  \example testRawRecord.cpp
+
+  Write images, depth maps and point clouds in a vpRawRecord, read them back
+  with and without memory mapping and check that they are unchanged. Check
+  also that a frame whose payload size does not match its dimensions is
+  rejected.
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+#include <visp3/core/vpConfig.h>
+#include <visp3/core/vpImageConvert.h>
+#include <visp3/core/vpIoTools.h>
+#include <visp3/io/vpRawRecord.h>
+#include <visp3/io/vpParseArgv.h>
+
+// List of allowed command line options
+#define GETOPTARGS "cdo:h"
+
+namespace {
+  void createImages(vpImage<unsigned char> &I_grey, vpImage<vpRGBa> &I_color, vpImage<uint16_t> &I_depth,
+                    vpImage<float> &I_float, std::vector<vpColVector> &pointcloud) {
+    I_grey.resize(7, 11);
+    I_color.resize(5, 9);
+    I_depth.resize(6, 4);
+    I_float.resize(3, 8);
+    for (unsigned int i = 0; i < I_grey.getSize(); i++)
+      I_grey.bitmap[i] = (unsigned char) (i * 37);
+    for (unsigned int i = 0; i < I_color.getSize(); i++)
+      I_color.bitmap[i] = vpRGBa((unsigned char) i, (unsigned char) (2 * i), (unsigned char) (255 - i), (unsigned char) (i * 13));
+    for (unsigned int i = 0; i < I_depth.getSize(); i++)
+      I_depth.bitmap[i] = (uint16_t) (i * 2731);
+    for (unsigned int i = 0; i < I_float.getSize(); i++)
+      I_float.bitmap[i] = 0.25f * i - 3.f;
+
+    pointcloud.resize(10);
+    for (unsigned int i = 0; i < pointcloud.size(); i++) {
+      pointcloud[i].resize(4);
+      pointcloud[i][0] = 0.5 * i;
+      pointcloud[i][1] = -0.25 * i;
+      pointcloud[i][2] = 1.0 + i;
+      pointcloud[i][3] = 1.0;
+    }
+  }
+
+  bool checkRecording(const std::string &filename, bool useMemoryMapping) {
+    vpImage<unsigned char> I_grey, I_grey_read;
+    vpImage<vpRGBa> I_color, I_color_read;
+    vpImage<uint16_t> I_depth, I_depth_read;
+    vpImage<float> I_float, I_float_read;
+    std::vector<vpColVector> pointcloud, pointcloud_read;
+    createImages(I_grey, I_color, I_depth, I_float, pointcloud);
+
+    vpRawRecord record;
+    record.open(filename, useMemoryMapping);
+    if (record.getNbFrames() != 5) {
+      std::cerr << "The recording has " << record.getNbFrames() << " frames instead of 5" << std::endl;
+      return false;
+    }
+    const vpRawRecord::vpFrameType types[5] = { vpRawRecord::FRAME_GREY, vpRawRecord::FRAME_RGBA, vpRawRecord::FRAME_DEPTH,
+                                                vpRawRecord::FRAME_FLOAT, vpRawRecord::FRAME_POINTCLOUD };
+    for (unsigned int i = 0; i < 5; i++) {
+      if (record.getFrameType(i) != types[i] || record.getTimestamp(i) != 10.5 * i || record.getStream(i) != i % 2) {
+        std::cerr << "Wrong type, timestamp or stream of frame " << i << std::endl;
+        return false;
+      }
+    }
+
+    record.read(0, I_grey_read);
+    record.read(1, I_color_read);
+    record.read(2, I_depth_read);
+    record.read(3, I_float_read);
+    record.read(4, pointcloud_read);
+    if (I_grey != I_grey_read || I_color != I_color_read || I_depth != I_depth_read ||
+        I_float != I_float_read) {
+      std::cerr << "An image is not read back unchanged" << std::endl;
+      return false;
+    }
+    if (pointcloud_read.size() != pointcloud.size()) {
+      std::cerr << "The point cloud has " << pointcloud_read.size() << " points instead of " << pointcloud.size() << std::endl;
+      return false;
+    }
+    for (size_t i = 0; i < pointcloud.size(); i++) {
+      if (pointcloud_read[i].getRows() != pointcloud[i].getRows() || (pointcloud_read[i] - pointcloud[i]).euclideanNorm() > 0) {
+        std::cerr << "Point " << i << " of the point cloud is not read back unchanged" << std::endl;
+        return false;
+      }
+    }
+
+    // Images of the other color format are converted
+    vpImage<unsigned char> I_grey_ref;
+    vpImage<vpRGBa> I_color_ref;
+    vpImageConvert::convert(I_color, I_grey_ref);
+    vpImageConvert::convert(I_grey, I_color_ref);
+    record.read(1, I_grey_read);
+    record.read(0, I_color_read);
+    if (I_grey_ref != I_grey_read || I_color_ref != I_color_read) {
+      std::cerr << "An image is not converted as by vpImageConvert" << std::endl;
+      return false;
+    }
+
+    record.close();
+    return true;
+  }
+
+  // Change the payload size of the first frame in the index of the recording
+  void setFirstFrameSize(const std::string &filename, unsigned long long size) {
+    std::fstream f(filename.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+    f.seekg(-24, std::ios::end);
+    unsigned long long indexPos = 0;
+    f.read((char *)&indexPos, sizeof(indexPos));
+    f.seekp((std::streamoff)(indexPos + 32), std::ios::beg);
+    f.write((const char *)&size, sizeof(size));
+    if (f.fail())
+      throw(vpException(vpException::ioError, "Cannot modify the recording \"%s\"", filename.c_str()));
+  }
+
+  bool checkWrongSize(const std::string &filename, bool useMemoryMapping) {
+    vpRawRecord record;
+    record.open(filename, useMemoryMapping);
+    vpImage<unsigned char> I;
+    try {
+      record.read(0, I);
+    }
+    catch(vpException &e) {
+      if (e.getCode() == vpException::ioError)
+        return true;
+    }
+    std::cerr << "A frame with a wrong size is not rejected" << std::endl;
+    return false;
+  }
+  /*
+    Print the program options.
+
+    \param name : Program name.
+    \param badparam : Bad parameter name.
+    \param opath : Output image path.
+    \param user : Username.
+  */
+  void usage(const char *name, const char *badparam, const std::string &opath, const std::string &user)
+  {
+    fprintf(stdout, "\n\
+Write images, depth maps and point clouds in a vpRawRecord and read them back.\n\
+\n\
+SYNOPSIS\n\
+  %s [-o <output image path>] [-h]\n", name);
+
+    fprintf(stdout, "\n\
+OPTIONS:                                               Default\n\
+  -o <output image path>                               %s\n\
+     Set image output path.\n\
+     From this directory, creates the \"%s\"\n\
+     subdirectory depending on the username, where \n\
+     the testRawRecord directory with the recording is created.\n\
+\n\
+  -h\n\
+     Print the help.\n\n",
+      opath.c_str(), user.c_str());
+
+    if (badparam)
+      fprintf(stdout, "\nERROR: Bad parameter [%s]\n", badparam);
+  }
+
+  /*
+    Set the program options.
+
+    \param argc : Command line number of parameters.
+    \param argv : Array of command line parameters.
+    \param opath : Output image path.
+    \param user : Username.
+    \return false if the program has to be stopped, true otherwise.
+  */
+  bool getOptions(int argc, const char **argv, std::string &opath, const std::string &user)
+  {
+    const char *optarg_;
+    int c;
+    while ((c = vpParseArgv::parse(argc, argv, GETOPTARGS, &optarg_)) > 1) {
+
+      switch (c) {
+      case 'o': opath = optarg_; break;
+      case 'h': usage(argv[0], NULL, opath, user); return false; break;
+
+      case 'c':
+      case 'd':
+        break;
+
+      default:
+        usage(argv[0], optarg_, opath, user); return false; break;
+      }
+    }
+
+    if ((c == 1) || (c == -1)) {
+      // standalone param or error
+      usage(argv[0], NULL, opath, user);
+      std::cerr << "ERROR: " << std::endl;
+      std::cerr << "  Bad argument " << optarg_ << std::endl << std::endl;
+      return false;
+    }
+
+    return true;
+  }
+}
+
+int main(int argc, const char **argv)
+{
+  try {
+    std::string opt_opath;
+    std::string username;
+
+    // Set the default output path
+#if defined(_WIN32)
+    opt_opath = "C:/temp";
+#else
+    opt_opath = "/tmp";
+#endif
+
+    // Get the user login name
+    vpIoTools::getUserName(username);
+
+    // Read the command line options
+    if (getOptions(argc, argv, opt_opath, username) == false)
+      return EXIT_FAILURE;
+
+    // Append to the output path string, the login name of the user and the name of the test
+    std::string opath = vpIoTools::createFilePath(opt_opath, username);
+    opath = vpIoTools::createFilePath(opath, "testRawRecord");
+
+    // Test if the output path exist. If no try to create it
+    if (vpIoTools::checkDirectory(opath) == false) {
+      try {
+        vpIoTools::makeDirectory(opath);
+      }
+      catch (...) {
+        usage(argv[0], NULL, opt_opath, username);
+        std::cerr << std::endl << "ERROR:" << std::endl;
+        std::cerr << "  Cannot create " << opath << std::endl;
+        std::cerr << "  Check your -o " << opt_opath << " option " << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+    std::string filename = vpIoTools::createFilePath(opath, "record.vpraw");
+
+    vpImage<unsigned char> I_grey;
+    vpImage<vpRGBa> I_color;
+    vpImage<uint16_t> I_depth;
+    vpImage<float> I_float;
+    std::vector<vpColVector> pointcloud;
+    createImages(I_grey, I_color, I_depth, I_float, pointcloud);
+
+    vpRawRecord record;
+    record.create(filename);
+    record.write(I_grey, 0.0, 0);
+    record.write(I_color, 10.5, 1);
+    record.write(I_depth, 21.0, 0);
+    record.write(I_float, 31.5, 1);
+    record.write(pointcloud, 42.0, 0);
+    record.close();
+
+    if (! checkRecording(filename, false) || ! checkRecording(filename, true))
+      return EXIT_FAILURE;
+
+    // A payload shorter or longer than the image is rejected
+    unsigned long long size = I_grey.getSize();
+    setFirstFrameSize(filename, size - 1);
+    if (! checkWrongSize(filename, false) || ! checkWrongSize(filename, true))
+      return EXIT_FAILURE;
+    setFirstFrameSize(filename, size + 1);
+    if (! checkWrongSize(filename, false) || ! checkWrongSize(filename, true))
+      return EXIT_FAILURE;
+
+    vpIoTools::remove(filename);
+  }
+  catch(const vpException &e) {
+    std::cerr << "Catch an exception: " << e.getStringMessage() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "testRawRecord is ok." << std::endl;
+  return EXIT_SUCCESS;
+}
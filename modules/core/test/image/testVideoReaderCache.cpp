@@ -0,0 +1,328 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2017 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * Description:
+ * Test the cache of the frames read by vpVideoReader::getFrame().
+ *
+ *****************************************************************************/
+
+/*!
+  \example testVideoReaderCache.cpp
+
+  Test the cache of vpVideoReader::getFrame(): the least recently used frames
+  are released first, a cached frame places the reader as if it was read, and
+  a frame past the end of a video is not cached.
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+#include <visp3/core/vpConfig.h>
+#include <visp3/core/vpIoTools.h>
+#include <visp3/io/vpImageIo.h>
+#include <visp3/io/vpVideoReader.h>
+#include <visp3/io/vpVideoWriter.h>
+#include <visp3/io/vpParseArgv.h>
+
+// List of allowed command line options
+#define GETOPTARGS "cdo:h"
+
+namespace {
+  // Gray level of the center of the image
+  int centerValue(const vpImage<unsigned char> &I) {
+    return I[I.getHeight() / 2][I.getWidth() / 2];
+  }
+
+  // Check that getFrame() succeeds or fails as expected, and gives the expected gray level
+  bool checkGetFrame(vpVideoReader &reader, long index, bool expected, int value, int tolerance, const std::string &name) {
+    vpImage<unsigned char> I;
+    bool success = reader.getFrame(I, index);
+    if (success != expected) {
+      std::cerr << name << ": getFrame(" << index << ") " << (success ? "succeeded" : "failed") << std::endl;
+      return false;
+    }
+    if (success && (std::abs(centerValue(I) - value) > tolerance || reader.getFrameIndex() < index)) {
+      std::cerr << name << ": getFrame(" << index << ") gives gray level " << centerValue(I) << " instead of "
+                << value << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+  std::string imageName(const std::string &genericName, long index) {
+    char name[FILENAME_MAX];
+    sprintf(name, genericName.c_str(), index);
+    return name;
+  }
+
+  bool testImageSequence(const std::string &opath) {
+    const std::string genericName = vpIoTools::createFilePath(opath, "image%04d.pgm");
+    const long nbFrames = 10;
+    for (long k = 0; k < nbFrames; k++) {
+      vpImage<unsigned char> I(8, 10, (unsigned char) (20*k));
+      vpImageIo::write(I, imageName(genericName, k));
+    }
+
+    vpVideoReader reader;
+    reader.setFileName(genericName);
+    reader.setFrameCacheSize(2);
+    vpImage<unsigned char> I;
+    reader.open(I);
+
+    // Cache: 7, 5 (3 released)
+    if (! checkGetFrame(reader, 3, true, 60, 0, "sequence") ||
+        ! checkGetFrame(reader, 5, true, 100, 0, "sequence") ||
+        ! checkGetFrame(reader, 7, true, 140, 0, "sequence"))
+      return false;
+
+    // Without the files, only the cached frames can be read
+    for (long k = 0; k < nbFrames; k++)
+      vpIoTools::rename(imageName(genericName, k), imageName(genericName, k) + ".bak");
+    // Cache: 5, 7
+    if (! checkGetFrame(reader, 3, false, 0, 0, "sequence") ||
+        ! checkGetFrame(reader, 7, true, 140, 0, "sequence") ||
+        ! checkGetFrame(reader, 5, true, 100, 0, "sequence"))
+      return false;
+
+    // Reading frame 3 releases frame 7, the least recently used one
+    vpIoTools::rename(imageName(genericName, 3) + ".bak", imageName(genericName, 3));
+    if (! checkGetFrame(reader, 3, true, 60, 0, "sequence"))
+      return false;
+    vpIoTools::rename(imageName(genericName, 3), imageName(genericName, 3) + ".bak");
+    if (! checkGetFrame(reader, 7, false, 0, 0, "sequence") ||
+        ! checkGetFrame(reader, 5, true, 100, 0, "sequence") ||
+        ! checkGetFrame(reader, 3, true, 60, 0, "sequence"))
+      return false;
+
+    for (long k = 0; k < nbFrames; k++)
+      vpIoTools::rename(imageName(genericName, k) + ".bak", imageName(genericName, k));
+
+    // acquire() after a cached frame gives the same images as after a frame read from the disk
+    vpVideoReader reference;
+    reference.setFileName(genericName);
+    reference.open(I);
+    vpImage<unsigned char> J;
+    reference.getFrame(J, 5);
+    reader.getFrame(I, 5);
+    for (int k = 0; k < 3; k++) {
+      reference.acquire(J);
+      reader.acquire(I);
+      if (centerValue(I) != centerValue(J) || reader.getFrameIndex() != reference.getFrameIndex()) {
+        std::cerr << "sequence: acquire() after a cached frame gives frame " << reader.getFrameIndex()
+                  << " instead of " << reference.getFrameIndex() << std::endl;
+        return false;
+      }
+    }
+
+    for (long k = 0; k < nbFrames; k++)
+      vpIoTools::remove(imageName(genericName, k));
+    return true;
+  }
+
+#if VISP_HAVE_OPENCV_VERSION >= 0x030000
+  bool testVideo(const std::string &opath) {
+    const std::string filename = vpIoTools::createFilePath(opath, "video.avi");
+    const long nbFrames = 20;
+    // Tolerance on the gray levels for the lossy encoding
+    const int tolerance = 4;
+    {
+      vpVideoWriter writer;
+      writer.setCodec(cv::VideoWriter::fourcc('M', 'J', 'P', 'G'));
+      writer.setFramerate(25.0);
+      writer.setFileName(filename);
+      vpImage<unsigned char> I(64, 64, 0);
+      writer.open(I);
+      for (long k = 0; k < nbFrames; k++) {
+        I = (unsigned char) (10*k);
+        writer.saveFrame(I);
+      }
+      writer.close();
+    }
+
+    vpVideoReader reader;
+    reader.setFileName(filename);
+    reader.setFrameCacheSize(4);
+    vpImage<unsigned char> I;
+    reader.open(I);
+
+    // A frame past the end of the video is not cached: it fails each time
+    if (! checkGetFrame(reader, 12, true, 120, tolerance, "video") ||
+        ! checkGetFrame(reader, nbFrames + 5, false, 0, tolerance, "video") ||
+        ! checkGetFrame(reader, nbFrames + 5, false, 0, tolerance, "video") ||
+        ! checkGetFrame(reader, 12, true, 120, tolerance, "video"))
+      return false;
+
+    // acquire() after a cached frame moves the video to the next frame, as after a decoded one
+    vpVideoReader reference;
+    reference.setFileName(filename);
+    reference.open(I);
+    vpImage<unsigned char> J;
+    reference.getFrame(J, 12);
+    reader.getFrame(I, 12);
+    for (int k = 0; k < 3; k++) {
+      reference.acquire(J);
+      reader.acquire(I);
+      if (std::abs(centerValue(I) - centerValue(J)) > tolerance || reader.getFrameIndex() != reference.getFrameIndex()) {
+        std::cerr << "video: acquire() after a cached frame gives gray level " << centerValue(I)
+                  << " instead of " << centerValue(J) << std::endl;
+        return false;
+      }
+    }
+
+    vpIoTools::remove(filename);
+    return true;
+  }
+#endif
+  /*
+    Print the program options.
+
+    \param name : Program name.
+    \param badparam : Bad parameter name.
+    \param opath : Output image path.
+    \param user : Username.
+  */
+  void usage(const char *name, const char *badparam, const std::string &opath, const std::string &user)
+  {
+    fprintf(stdout, "\n\
+Test the frame cache of vpVideoReader::getFrame().\n\
+\n\
+SYNOPSIS\n\
+  %s [-o <output image path>] [-h]\n", name);
+
+    fprintf(stdout, "\n\
+OPTIONS:                                               Default\n\
+  -o <output image path>                               %s\n\
+     Set image output path.\n\
+     From this directory, creates the \"%s\"\n\
+     subdirectory depending on the username, where \n\
+     the testVideoReaderCache directory with the sequence is created.\n\
+\n\
+  -h\n\
+     Print the help.\n\n",
+      opath.c_str(), user.c_str());
+
+    if (badparam)
+      fprintf(stdout, "\nERROR: Bad parameter [%s]\n", badparam);
+  }
+
+  /*
+    Set the program options.
+
+    \param argc : Command line number of parameters.
+    \param argv : Array of command line parameters.
+    \param opath : Output image path.
+    \param user : Username.
+    \return false if the program has to be stopped, true otherwise.
+  */
+  bool getOptions(int argc, const char **argv, std::string &opath, const std::string &user)
+  {
+    const char *optarg_;
+    int c;
+    while ((c = vpParseArgv::parse(argc, argv, GETOPTARGS, &optarg_)) > 1) {
+
+      switch (c) {
+      case 'o': opath = optarg_; break;
+      case 'h': usage(argv[0], NULL, opath, user); return false; break;
+
+      case 'c':
+      case 'd':
+        break;
+
+      default:
+        usage(argv[0], optarg_, opath, user); return false; break;
+      }
+    }
+
+    if ((c == 1) || (c == -1)) {
+      // standalone param or error
+      usage(argv[0], NULL, opath, user);
+      std::cerr << "ERROR: " << std::endl;
+      std::cerr << "  Bad argument " << optarg_ << std::endl << std::endl;
+      return false;
+    }
+
+    return true;
+  }
+}
+
+int main(int argc, const char **argv)
+{
+  try {
+    std::string opt_opath;
+    std::string username;
+
+    // Set the default output path
+#if defined(_WIN32)
+    opt_opath = "C:/temp";
+#else
+    opt_opath = "/tmp";
+#endif
+
+    // Get the user login name
+    vpIoTools::getUserName(username);
+
+    // Read the command line options
+    if (getOptions(argc, argv, opt_opath, username) == false)
+      return EXIT_FAILURE;
+
+    // Append to the output path string, the login name of the user and the name of the test
+    std::string opath = vpIoTools::createFilePath(opt_opath, username);
+    opath = vpIoTools::createFilePath(opath, "testVideoReaderCache");
+
+    // Test if the output path exist. If no try to create it
+    if (vpIoTools::checkDirectory(opath) == false) {
+      try {
+        vpIoTools::makeDirectory(opath);
+      }
+      catch (...) {
+        usage(argv[0], NULL, opt_opath, username);
+        std::cerr << std::endl << "ERROR:" << std::endl;
+        std::cerr << "  Cannot create " << opath << std::endl;
+        std::cerr << "  Check your -o " << opt_opath << " option " << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+
+    if (! testImageSequence(opath))
+      return EXIT_FAILURE;
+#if VISP_HAVE_OPENCV_VERSION >= 0x030000
+    if (! testVideo(opath))
+      return EXIT_FAILURE;
+#endif
+  }
+  catch(const vpException &e) {
+    std::cerr << "Catch an exception: " << e.getStringMessage() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "testVideoReaderCache is ok." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,252 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2017 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * Description:
+ * Test the asynchronous writing of image sequences.
+ *
+ *****************************************************************************/
+
+/*!
+  \example testVideoWriterAsync.cpp
+
+  Test vpVideoWriter in asynchronous mode: each file of the sequence contains
+  the image saved with the corresponding index, and all the images are written
+  when close() returns.
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+#include <visp3/core/vpConfig.h>
+#include <visp3/core/vpImageConvert.h>
+#include <visp3/core/vpIoTools.h>
+#include <visp3/io/vpImageIo.h>
+#include <visp3/io/vpVideoWriter.h>
+#include <visp3/io/vpParseArgv.h>
+
+// List of allowed command line options
+#define GETOPTARGS "cdo:h"
+
+namespace {
+  const unsigned int nbFrames = 50;
+  const unsigned int firstFrame = 3;
+
+  // Image whose content depends on its index
+  void createImage(unsigned int index, vpImage<unsigned char> &I) {
+    I.resize(12, 16);
+    for (unsigned int i = 0; i < I.getSize(); i++) {
+      I.bitmap[i] = (unsigned char) (index*7 + i);
+    }
+  }
+
+  void createImage(unsigned int index, vpImage<vpRGBa> &I) {
+    vpImage<unsigned char> I_grey;
+    createImage(index, I_grey);
+    vpImageConvert::convert(I_grey, I);
+  }
+
+  // Write the sequence with the given number of threads and queue size, then read it back
+  template <class Type>
+  bool testSequence(const std::string &filename, unsigned int nbThreads, unsigned int queueSize) {
+    vpVideoWriter writer;
+    writer.setAsyncWriting(nbThreads, queueSize);
+    writer.setFileName(filename);
+    writer.setFirstFrameIndex(firstFrame);
+
+    vpImage<Type> I;
+    createImage(0, I);
+    writer.open(I);
+    for (unsigned int k = 0; k < nbFrames; k++) {
+      createImage(k, I);
+      writer.saveFrame(I);
+    }
+    // The images have to be on the disk when close() returns
+    writer.close();
+
+    if (writer.getNbDroppedFrames() != 0) {
+      std::cerr << filename << ": " << writer.getNbDroppedFrames() << " dropped frames" << std::endl;
+      return false;
+    }
+    if (writer.getQueueDepth() != 0) {
+      std::cerr << filename << ": " << writer.getQueueDepth() << " frames still queued after close()" << std::endl;
+      return false;
+    }
+
+    for (unsigned int k = 0; k < nbFrames; k++) {
+      char name[FILENAME_MAX];
+      sprintf(name, filename.c_str(), firstFrame + k);
+      vpImage<Type> I_read, I_ref;
+      try {
+        vpImageIo::read(I_read, name);
+      }
+      catch(const vpException &e) {
+        std::cerr << "Cannot read " << name << ": " << e.getStringMessage() << std::endl;
+        return false;
+      }
+      createImage(k, I_ref);
+      if (I_read != I_ref) {
+        std::cerr << name << " does not contain image " << k << std::endl;
+        return false;
+      }
+      vpIoTools::remove(name);
+    }
+    return true;
+  }
+  /*
+    Print the program options.
+
+    \param name : Program name.
+    \param badparam : Bad parameter name.
+    \param opath : Output image path.
+    \param user : Username.
+  */
+  void usage(const char *name, const char *badparam, const std::string &opath, const std::string &user)
+  {
+    fprintf(stdout, "\n\
+Write image sequences with vpVideoWriter in asynchronous mode and read them back.\n\
+\n\
+SYNOPSIS\n\
+  %s [-o <output image path>] [-h]\n", name);
+
+    fprintf(stdout, "\n\
+OPTIONS:                                               Default\n\
+  -o <output image path>                               %s\n\
+     Set image output path.\n\
+     From this directory, creates the \"%s\"\n\
+     subdirectory depending on the username, where \n\
+     the testVideoWriterAsync directory with the sequences is created.\n\
+\n\
+  -h\n\
+     Print the help.\n\n",
+      opath.c_str(), user.c_str());
+
+    if (badparam)
+      fprintf(stdout, "\nERROR: Bad parameter [%s]\n", badparam);
+  }
+
+  /*
+    Set the program options.
+
+    \param argc : Command line number of parameters.
+    \param argv : Array of command line parameters.
+    \param opath : Output image path.
+    \param user : Username.
+    \return false if the program has to be stopped, true otherwise.
+  */
+  bool getOptions(int argc, const char **argv, std::string &opath, const std::string &user)
+  {
+    const char *optarg_;
+    int c;
+    while ((c = vpParseArgv::parse(argc, argv, GETOPTARGS, &optarg_)) > 1) {
+
+      switch (c) {
+      case 'o': opath = optarg_; break;
+      case 'h': usage(argv[0], NULL, opath, user); return false; break;
+
+      case 'c':
+      case 'd':
+        break;
+
+      default:
+        usage(argv[0], optarg_, opath, user); return false; break;
+      }
+    }
+
+    if ((c == 1) || (c == -1)) {
+      // standalone param or error
+      usage(argv[0], NULL, opath, user);
+      std::cerr << "ERROR: " << std::endl;
+      std::cerr << "  Bad argument " << optarg_ << std::endl << std::endl;
+      return false;
+    }
+
+    return true;
+  }
+}
+
+int main(int argc, const char **argv)
+{
+  try {
+    std::string opt_opath;
+    std::string username;
+
+    // Set the default output path
+#if defined(_WIN32)
+    opt_opath = "C:/temp";
+#else
+    opt_opath = "/tmp";
+#endif
+
+    // Get the user login name
+    vpIoTools::getUserName(username);
+
+    // Read the command line options
+    if (getOptions(argc, argv, opt_opath, username) == false)
+      return EXIT_FAILURE;
+
+    // Append to the output path string, the login name of the user and the name of the test
+    std::string opath = vpIoTools::createFilePath(opt_opath, username);
+    opath = vpIoTools::createFilePath(opath, "testVideoWriterAsync");
+
+    // Test if the output path exist. If no try to create it
+    if (vpIoTools::checkDirectory(opath) == false) {
+      try {
+        vpIoTools::makeDirectory(opath);
+      }
+      catch (...) {
+        usage(argv[0], NULL, opt_opath, username);
+        std::cerr << std::endl << "ERROR:" << std::endl;
+        std::cerr << "  Cannot create " << opath << std::endl;
+        std::cerr << "  Check your -o " << opt_opath << " option " << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+
+    // Synchronous mode as a reference, then one thread, several threads and a
+    // queue smaller than the sequence so that saveFrame() has to block
+    unsigned int nbThreads[] = {0, 1, 4, 2};
+    unsigned int queueSize[] = {0, 0, 0, 1};
+    for (size_t i = 0; i < sizeof(nbThreads) / sizeof(nbThreads[0]); i++) {
+      std::cout << "Test with " << nbThreads[i] << " threads, queue size " << queueSize[i] << std::endl;
+      if (! testSequence<unsigned char>(vpIoTools::createFilePath(opath, "image%04d.pgm"), nbThreads[i], queueSize[i]))
+        return EXIT_FAILURE;
+      if (! testSequence<vpRGBa>(vpIoTools::createFilePath(opath, "image%04d.ppm"), nbThreads[i], queueSize[i]))
+        return EXIT_FAILURE;
+    }
+  }
+  catch(const vpException &e) {
+    std::cerr << "Catch an exception: " << e.getStringMessage() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "testVideoWriterAsync is ok." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,237 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2017 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * Description:
+ * Test the binary framed protocol of vpNetwork over the loopback interface.
+ *
+ *****************************************************************************/
+
+/*!
+  \example testNetworkFrame.cpp
+
+  Test the binary framed protocol of vpNetwork with a client and a server in
+  the same process: header parsing, partial reads, multiple parameters and
+  rejection of oversized frames.
+*/
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <visp3/core/vpClient.h>
+#include <visp3/core/vpServer.h>
+
+#if !defined(_WIN32) && (defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__))) // UNIX
+
+namespace {
+  class vpRequestTest : public vpRequest
+  {
+  public:
+    std::vector<std::string> params;
+
+    vpRequestTest() : params() { request_id = "test"; }
+
+    virtual void encode() {
+      clear();
+      for (size_t i = 0; i < params.size(); i++) {
+        addParameter(params[i]);
+      }
+    }
+
+    virtual void decode() { params = listOfParams; }
+  };
+
+  // Build by hand the frame sent by vpNetwork::sendRequest()
+  std::string buildFrame(const std::string &id, const std::vector<std::string> &params) {
+    std::vector<unsigned int> words;
+    words.push_back(htonl(0x56504231));
+    words.push_back(htonl((unsigned int) id.size()));
+    words.push_back(htonl((unsigned int) params.size()));
+    for (size_t i = 0; i < params.size(); i++) {
+      words.push_back(htonl((unsigned int) params[i].size()));
+    }
+
+    std::string frame((const char *) &words[0], words.size()*sizeof(unsigned int));
+    frame += id;
+    for (size_t i = 0; i < params.size(); i++) {
+      frame += params[i];
+    }
+
+    return frame;
+  }
+
+  // Receive requests until one is complete or the number of attempts is reached
+  int waitForRequest(vpServer &serv, unsigned int nbAttempts=50) {
+    for (unsigned int i = 0; i < nbAttempts; i++) {
+      int index = serv.receiveAndDecodeRequestOnce();
+      if (index != -1) {
+        return index;
+      }
+    }
+    return -1;
+  }
+
+  bool checkParams(const vpRequestTest &received, const std::vector<std::string> &params, const std::string &name) {
+    if (received.params != params) {
+      std::cerr << name << ": the received parameters differ from the sent ones!" << std::endl;
+      return false;
+    }
+    return true;
+  }
+}
+
+int main()
+{
+  try {
+    //Find a free port
+    int port = 35100;
+    vpServer *server = NULL;
+    for (; port < 35200; port++) {
+      server = new vpServer(port);
+      if (server->start()) {
+        break;
+      }
+      delete server;
+      server = NULL;
+    }
+    if (server == NULL) {
+      std::cerr << "Cannot start the server" << std::endl;
+      return EXIT_FAILURE;
+    }
+    vpServer &serv = *server;
+    serv.setProtocol(vpNetwork::PROTOCOL_BINARY);
+    serv.setTimeoutSec(0);
+    serv.setTimeoutUSec(100000);
+
+    vpClient client;
+    client.setProtocol(vpNetwork::PROTOCOL_BINARY);
+    client.setNumberOfAttempts(1);
+    if (!client.connectToIP("127.0.0.1", (unsigned int) port)) {
+      std::cerr << "Cannot connect to the server" << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    for (unsigned int i = 0; i < 50 && serv.getNumberOfClients() == 0; i++) {
+      serv.checkForConnections();
+    }
+    if (serv.getNumberOfClients() != 1) {
+      std::cerr << "The client is not connected" << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    vpRequestTest received;
+    serv.addDecodingRequest(&received);
+
+    //Multiple parameters, including an empty one and a large one
+    vpRequestTest sent;
+    sent.params.push_back("first");
+    sent.params.push_back("");
+    sent.params.push_back(std::string(3*1024*1024, 'x'));
+    for (size_t i = 0; i < sent.params.back().size(); i += 4093) {
+      sent.params.back()[i] = (char) i;
+    }
+    sent.params.push_back(std::string(1, '\0'));
+    client.sendAndEncodeRequest(sent);
+
+    if (waitForRequest(serv) != 0 || !checkParams(received, sent.params, "Multiple parameters")) {
+      return EXIT_FAILURE;
+    }
+
+    //Partial reads: the frame is sent byte by byte for the header and the
+    //parameter lengths, then in two parts
+    std::vector<std::string> params;
+    params.push_back("abc");
+    params.push_back("defghij");
+    std::string frame = buildFrame("test", params);
+    std::vector<size_t> cuts;
+    for (size_t i = 1; i <= 20; i++) {
+      cuts.push_back(i);
+    }
+    cuts.push_back(frame.size() - 3);
+    cuts.push_back(frame.size());
+    for (size_t i = 0, begin = 0; i < cuts.size(); begin = cuts[i], i++) {
+      client.send(&frame[begin], (unsigned int) (cuts[i] - begin));
+      if (cuts[i] < frame.size() && serv.receiveAndDecodeRequestOnce() != -1) {
+        std::cerr << "Partial reads: a request is received before the end of the frame" << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+    if (waitForRequest(serv) != 0 || !checkParams(received, params, "Partial reads")) {
+      return EXIT_FAILURE;
+    }
+
+    //Two frames sent at once
+    std::vector<std::string> params2(1, "second frame");
+    std::string frames = buildFrame("test", params) + buildFrame("test", params2);
+    client.send(&frames[0], (unsigned int) frames.size());
+    if (waitForRequest(serv) != 0 || !checkParams(received, params, "Two frames (first)")) {
+      return EXIT_FAILURE;
+    }
+    if (waitForRequest(serv) != 0 || !checkParams(received, params2, "Two frames (second)")) {
+      return EXIT_FAILURE;
+    }
+
+    //A frame with an unknown id is skipped
+    frames = buildFrame("unknown", params2) + buildFrame("test", params);
+    client.send(&frames[0], (unsigned int) frames.size());
+    if (waitForRequest(serv) != 0 || !checkParams(received, params, "Unknown id")) {
+      return EXIT_FAILURE;
+    }
+
+    //A frame larger than the maximum size disconnects the client before
+    //receiving its parameters
+    serv.setMaxSizeReceivedFrame(1024);
+    std::vector<std::string> large(2, std::string(1000, 'y'));
+    frame = buildFrame("test", large);
+    client.send(&frame[0], 12 + 2*sizeof(unsigned int) + 4);
+    waitForRequest(serv, 5);
+    if (serv.getNumberOfClients() != 0) {
+      std::cerr << "Oversized frame: the client is still connected" << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    delete server;
+    std::cout << "testNetworkFrame is ok!" << std::endl;
+    return EXIT_SUCCESS;
+  }
+  catch(vpException &e) {
+    std::cout << "Catch an exception: " << e << std::endl;
+    return EXIT_FAILURE;
+  }
+}
+
+#else
+int main()
+{
+  std::cout << "This test needs UNIX sockets." << std::endl;
+  return EXIT_SUCCESS;
+}
+#endif
@@ -0,0 +1,202 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2017 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * Description:
+ * Test the shared memory ring with a producer and a consumer in the same process.
+ *
+ *****************************************************************************/
+
+/*!
+  \example testSharedMemoryRing.cpp
+
+  Test vpSharedMemoryRing with a producer and a consumer in the same process:
+  order of the frames, frames skipped when overwritten or being written, and
+  blocking wait for the next frame.
+*/
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+#include <visp3/core/vpConfig.h>
+
+#if !defined(_WIN32) && (defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__))) && defined(VISP_HAVE_PTHREAD)
+
+#include <unistd.h>
+
+#include <visp3/core/vpSharedMemoryRing.h>
+#include <visp3/core/vpThread.h>
+#include <visp3/core/vpTime.h>
+
+namespace {
+  vpImage<unsigned char> createImage(unsigned char value) {
+    vpImage<unsigned char> I(4, 6);
+    for (unsigned int i = 0; i < I.getSize(); i++) {
+      I.bitmap[i] = (unsigned char) (value + i);
+    }
+    return I;
+  }
+
+  bool checkImage(const vpImage<unsigned char> &I, unsigned char value, const std::string &name) {
+    vpImage<unsigned char> I_ref = createImage(value);
+    if (I.getHeight() != I_ref.getHeight() || I.getWidth() != I_ref.getWidth() ||
+        memcmp(I.bitmap, I_ref.bitmap, I.getSize()) != 0) {
+      std::cerr << name << ": the read image is not image " << (int) value << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+  // Write frame 100 after 100 ms
+  vpThread::Return delayedWrite(vpThread::Args args) {
+    vpSharedMemoryRing *producer = (vpSharedMemoryRing *) args;
+    vpTime::wait(100);
+    producer->write(createImage(100), 100.0);
+    return 0;
+  }
+}
+
+int main()
+{
+  try {
+    std::stringstream ss;
+    ss << "visp_testSharedMemoryRing_" << getpid();
+    const std::string name = ss.str();
+
+    vpSharedMemoryRing producer;
+    producer.create(name, 3, 4*6);
+
+    vpSharedMemoryRing consumer;
+    consumer.open(name);
+
+    vpImage<unsigned char> I;
+    double timestamp = 0;
+
+    //No frame: the timeout expires
+    double t = vpTime::measureTimeMs();
+    if (consumer.read(I, timestamp, 50)) {
+      std::cerr << "A frame is read from an empty ring" << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (vpTime::measureTimeMs() - t < 40) {
+      std::cerr << "The timeout of read() is not respected" << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    //Frames read in order
+    for (unsigned char k = 0; k < 2; k++) {
+      producer.write(createImage(k), (double) k);
+    }
+    for (unsigned char k = 0; k < 2; k++) {
+      if (!consumer.read(I, timestamp, 0) || !checkImage(I, k, "In order") || timestamp != (double) k) {
+        return EXIT_FAILURE;
+      }
+    }
+
+    //Frames overwritten before being read are skipped
+    for (unsigned char k = 10; k < 15; k++) {
+      producer.write(createImage(k), (double) k);
+    }
+    for (unsigned char k = 12; k < 15; k++) {
+      if (!consumer.read(I, timestamp, 0) || !checkImage(I, k, "Overwritten")) {
+        return EXIT_FAILURE;
+      }
+    }
+    if (consumer.getNbDroppedFrames() != 2) {
+      std::cerr << "Overwritten: " << consumer.getNbDroppedFrames() << " dropped frames instead of 2" << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    //A frame acquired without copy is no longer valid once its slot is rewritten
+    producer.write(createImage(20), 20.0);
+    vpSharedMemoryRing::vpFrameView view;
+    if (!consumer.acquire(view, 0) || !consumer.isValid(view) || view.timestamp != 20.0) {
+      std::cerr << "Acquire: frame 20 is not acquired" << std::endl;
+      return EXIT_FAILURE;
+    }
+    for (unsigned char k = 21; k < 24; k++) {
+      producer.write(createImage(k), (double) k);
+    }
+    if (consumer.isValid(view)) {
+      std::cerr << "Acquire: an overwritten frame is still valid" << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    //The sequence counter of the slot being written by the producer is odd:
+    //the consumer skips frame 21, which is in this slot, and retries with the
+    //next frame
+    unsigned long long dropped = consumer.getNbDroppedFrames();
+    unsigned char *data = (unsigned char *) producer.beginWrite(vpSharedMemoryRing::FRAME_GREY, 6, 4, 4*6);
+    vpImage<unsigned char> I_partial = createImage(30);
+    memcpy(data, I_partial.bitmap, 4*6/2);
+    if (!consumer.read(I, timestamp, 0) || !checkImage(I, 22, "Being written")) {
+      return EXIT_FAILURE;
+    }
+    if (consumer.getNbDroppedFrames() != dropped + 1) {
+      std::cerr << "Being written: the frame in the slot being written is not dropped" << std::endl;
+      return EXIT_FAILURE;
+    }
+    memcpy(data, I_partial.bitmap, 4*6);
+    producer.endWrite(30.0);
+    if (!consumer.read(I, timestamp, 0) || !checkImage(I, 23, "Being written") ||
+        !consumer.read(I, timestamp, 0) || !checkImage(I, 30, "Being written") || timestamp != 30.0) {
+      return EXIT_FAILURE;
+    }
+
+    //Blocking wait: the consumer sleeps until the producer writes a frame
+    vpThread writer((vpThread::Fn) delayedWrite, (vpThread::Args) &producer);
+    t = vpTime::measureTimeMs();
+    if (!consumer.read(I, timestamp, 5000) || !checkImage(I, 100, "Blocking wait")) {
+      return EXIT_FAILURE;
+    }
+    t = vpTime::measureTimeMs() - t;
+    writer.join();
+    if (t < 50 || t > 4000) {
+      std::cerr << "Blocking wait: the frame is read after " << t << " ms" << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    std::cout << "testSharedMemoryRing is ok!" << std::endl;
+    return EXIT_SUCCESS;
+  }
+  catch(vpException &e) {
+    std::cout << "Catch an exception: " << e << std::endl;
+    return EXIT_FAILURE;
+  }
+}
+
+#else
+int main()
+{
+  std::cout << "This test needs POSIX shared memory and threads." << std::endl;
+  return EXIT_SUCCESS;
+}
+#endif
@@ -0,0 +1,286 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2017 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * Description:
+ * Test the encoding and decoding of vpUDPMessage.
+ *
+ *****************************************************************************/
+
+/*!
+  \example testUDPMessage.cpp
+
+  Test the layout of the header of vpUDPMessage, and the decoding by
+  vpUDPServer of valid, truncated and oversized datagrams sent over the
+  loopback interface.
+*/
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <visp3/core/vpUDPClient.h>
+#include <visp3/core/vpUDPMessage.h>
+#include <visp3/core/vpUDPServer.h>
+
+#if !defined(_WIN32) && (defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__))) // UNIX
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+  bool isSame(const vpArray2D<double> &A, const vpArray2D<double> &B) {
+    if (A.getRows() != B.getRows() || A.getCols() != B.getCols())
+      return false;
+    for (unsigned int i = 0; i < A.size(); i++) {
+      if (A.data[i] != B.data[i])
+        return false;
+    }
+    return true;
+  }
+
+  unsigned int getUInt(const char *p, unsigned int nbBytes) {
+    unsigned int v = 0;
+    for (unsigned int i = 0; i < nbBytes; i++)
+      v |= (unsigned int) (unsigned char) p[i] << (8 * i);
+    return v;
+  }
+
+  bool checkHeader(const vpUDPMessage &msg, unsigned int type, unsigned int sequence, double timestamp,
+                   unsigned int channel, unsigned int nbValues, const std::string &name) {
+    const char *p = msg.getData();
+    double t;
+    unsigned long long u = 0;
+    for (int i = 0; i < 8; i++)
+      u |= (unsigned long long) (unsigned char) p[8 + i] << (8 * i);
+    memcpy(&t, &u, sizeof(t));
+
+    if (p[0] != 'V' || p[1] != 'P' || (unsigned char) p[2] != 1 || (unsigned char) p[3] != type ||
+        getUInt(p + 4, 4) != sequence || t != timestamp || getUInt(p + 16, 4) != channel ||
+        getUInt(p + 20, 2) != nbValues || getUInt(p + 22, 2) != 0) {
+      std::cerr << name << ": wrong encoded header" << std::endl;
+      return false;
+    }
+    if (msg.getLength() != vpUDPMessage::headerSize + 8 * nbValues || ! msg.isValid() ||
+        msg.getType() != (vpUDPMessage::vpMessageType) type || msg.getSequence() != sequence ||
+        msg.getTimestamp() != timestamp || msg.getChannel() != channel || msg.getNbValues() != nbValues) {
+      std::cerr << name << ": wrong decoded header" << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+  bool checkEncoding() {
+    vpHomogeneousMatrix M(0.1, -0.2, 0.3, 0.4, -0.5, 0.6), M_read;
+    vpUDPMessage msg(M, 0xDEADBEEF, 1234.5, 70000);
+    if (! checkHeader(msg, vpUDPMessage::MESSAGE_HOMOGENEOUS_MATRIX, 0xDEADBEEF, 1234.5, 70000, 12, "pose"))
+      return false;
+    vpColVector v;
+    if (! msg.get(M_read) || ! isSame(M_read, M) || msg.get(v) || msg.getValue(3) != M[0][3]) {
+      std::cerr << "pose: wrong values" << std::endl;
+      return false;
+    }
+
+    v.resize(vpUDPMessage::maxNbValues);
+    for (unsigned int i = 0; i < v.getRows(); i++)
+      v[i] = 0.5 * i - 7.;
+    vpColVector v_read;
+    msg.set(v, 3, -1.25);
+    if (! checkHeader(msg, vpUDPMessage::MESSAGE_COLVECTOR, 3, -1.25, 0, vpUDPMessage::maxNbValues, "vector"))
+      return false;
+    if (! msg.get(v_read) || ! isSame(v_read, v) || msg.get(M_read)) {
+      std::cerr << "vector: wrong values" << std::endl;
+      return false;
+    }
+
+    msg.set(vpColVector(), 4, 0.);
+    if (! checkHeader(msg, vpUDPMessage::MESSAGE_COLVECTOR, 4, 0., 0, 0, "empty vector") || ! msg.get(v_read) ||
+        v_read.getRows() != 0) {
+      return false;
+    }
+
+    // The values that do not fit in a datagram are refused
+    bool refused = false;
+    try {
+      msg.set(vpColVector(vpUDPMessage::maxNbValues + 1), 5, 0.);
+    }
+    catch(vpException &e) {
+      refused = e.getCode() == vpException::dimensionError;
+    }
+    if (! refused) {
+      std::cerr << "A vector of " << vpUDPMessage::maxNbValues + 1 << " values is not refused" << std::endl;
+      return false;
+    }
+
+    refused = false;
+    try {
+      vpUDPMessage(M, 0, 0.).getValue(12);
+    }
+    catch(vpException &e) {
+      refused = e.getCode() == vpException::dimensionError;
+    }
+    if (! refused) {
+      std::cerr << "A value out of the message is returned" << std::endl;
+      return false;
+    }
+    return ! vpUDPMessage().isValid();
+  }
+
+  // Send a datagram of any size, beyond what vpUDPClient accepts
+  bool sendDatagram(int port, const std::string &data) {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons((unsigned short) port);
+    bool sent = fd >= 0 && sendto(fd, data.c_str(), data.size(), 0, (struct sockaddr *) &address, sizeof(address)) ==
+                           (ssize_t) data.size();
+    if (fd >= 0)
+      close(fd);
+    return sent;
+  }
+
+  bool checkDecoding(vpUDPServer &server, int port) {
+    vpUDPClient client("127.0.0.1", port);
+    vpColVector v(6);
+    for (unsigned int i = 0; i < v.getRows(); i++)
+      v[i] = i + 0.5;
+    vpUDPMessage msg(v, 42, 10.5, 2), msg_read;
+    const std::string valid(msg.getData(), msg.getLength());
+
+    if (client.send(msg) != (int) msg.getLength() || server.receive(msg_read, 1000) != (int) msg.getLength() ||
+        ! checkHeader(msg_read, vpUDPMessage::MESSAGE_COLVECTOR, 42, 10.5, 2, 6, "received vector")) {
+      return false;
+    }
+
+    // Datagrams that are not valid messages
+    std::vector<std::string> invalids;
+    invalids.push_back(valid.substr(0, valid.size() - 1));            // truncated payload
+    invalids.push_back(valid.substr(0, vpUDPMessage::headerSize - 1)); // truncated header
+    invalids.push_back(valid + std::string(8, '\0'));                  // longer than its header
+    invalids.push_back(std::string("XP") + valid.substr(2));           // wrong magic number
+    std::string s = valid;
+    s[2] = 2;                                                          // unknown version
+    invalids.push_back(s);
+    s = valid;
+    s[3] = 3;                                                          // unknown type
+    invalids.push_back(s);
+    s = valid;
+    s[20] = (char) (vpUDPMessage::maxNbValues + 1);                    // too many values
+    invalids.push_back(s);
+    s = valid.substr(0, vpUDPMessage::headerSize);
+    s[20] = (char) vpUDPMessage::maxNbValues;
+    s += std::string(8 * vpUDPMessage::maxNbValues + 100, '\0');       // larger than the reception buffer
+    invalids.push_back(s);
+
+    for (size_t i = 0; i < invalids.size(); i++) {
+      if (! sendDatagram(port, invalids[i])) {
+        std::cerr << "Cannot send the datagram " << i << std::endl;
+        return false;
+      }
+      if (server.receive(msg_read, 1000) != 0 || msg_read.isValid() ||
+          msg_read.getType() != vpUDPMessage::MESSAGE_UNKNOWN) {
+        std::cerr << "The invalid datagram " << i << " of " << invalids[i].size() << " bytes is accepted" << std::endl;
+        return false;
+      }
+    }
+
+    // The invalid datagrams received in a batch are discarded, the order of the valid ones is kept
+    for (size_t i = 0; i < invalids.size(); i++) {
+      msg.set(v, (unsigned int) i, 0.);
+      if (client.send(msg) != (int) msg.getLength() || ! sendDatagram(port, invalids[i])) {
+        std::cerr << "Cannot send the batch" << std::endl;
+        return false;
+      }
+    }
+    std::vector<vpUDPMessage> msgs;
+    size_t nb = 0;
+    while (nb < invalids.size()) {
+      if (server.receive(msgs, 1000) <= 0) {
+        std::cerr << "Only " << nb << " messages of the batch are received" << std::endl;
+        return false;
+      }
+      for (size_t i = 0; i < msgs.size(); i++, nb++) {
+        if (! msgs[i].isValid() || msgs[i].getSequence() != nb) {
+          std::cerr << "Wrong message " << nb << " in the batch" << std::endl;
+          return false;
+        }
+      }
+    }
+    return nb == invalids.size();
+  }
+}
+
+int main()
+{
+  try {
+    if (! checkEncoding())
+      return EXIT_FAILURE;
+
+    // Find a free port
+    int port = 35300;
+    vpUDPServer *server = NULL;
+    for (; port < 35400 && server == NULL; port++) {
+      try {
+        server = new vpUDPServer("127.0.0.1", port);
+      }
+      catch(const vpException &) {
+      }
+    }
+    if (server == NULL) {
+      std::cerr << "Cannot start the server" << std::endl;
+      return EXIT_FAILURE;
+    }
+    port--;
+
+    bool ok = checkDecoding(*server, port);
+    delete server;
+    if (! ok)
+      return EXIT_FAILURE;
+  }
+  catch(const vpException &e) {
+    std::cerr << "Catch an exception: " << e.getStringMessage() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "testUDPMessage is ok." << std::endl;
+  return EXIT_SUCCESS;
+}
+
+#else
+int main()
+{
+  std::cout << "This test needs UNIX sockets." << std::endl;
+  return EXIT_SUCCESS;
+}
+#endif
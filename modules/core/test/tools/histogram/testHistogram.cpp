@@ -356,6 +356,47 @@ main(int argc, const char ** argv)
     }
 
 
+    //Test histogram computation on a region of interest with a mask
+    vpImage<unsigned char> mask(I.getHeight(), I.getWidth());
+    for (unsigned int cpt = 0; cpt < mask.getSize(); cpt++) {
+      mask.bitmap[cpt] = (cpt % 3 == 0) ? 255 : 0;
+    }
+    vpRect roi(10, 20, I.getWidth() / 2, I.getHeight() / 3);
+    histogram.calculate(I, roi, &mask, 64);
+    std::vector<unsigned int> expected(64, 0);
+    for (unsigned int i = 20; i < 20 + I.getHeight() / 3; i++) {
+      for (unsigned int j = 10; j < 10 + I.getWidth() / 2; j++) {
+        if (mask[i][j]) {
+          expected[(unsigned int) (I[i][j] * 64 / 256.0)]++;
+        }
+      }
+    }
+    for (unsigned int cpt = 0; cpt < 64; cpt++) {
+      if (histogram[(unsigned char) cpt] != expected[cpt]) {
+        std::cerr << "Problem with masked histogram computation: histogram[" << cpt << "]=" << histogram[(unsigned char) cpt]
+                  << " but should be: " << expected[cpt] << std::endl;
+        return -1;
+      }
+    }
+
+
+    //Test joint histogram computation
+    vpImage<unsigned char> I_shifted(I.getHeight(), I.getWidth());
+    for (unsigned int cpt = 0; cpt < I.getSize(); cpt++) {
+      I_shifted.bitmap[cpt] = I.bitmap[(cpt + 1) % I.getSize()];
+    }
+    std::vector<unsigned int> joint;
+    vpHistogram::calculateJoint(I, I_shifted, joint, 32, 16);
+    expected.assign(32 * 16, 0);
+    for (unsigned int cpt = 0; cpt < I.getSize(); cpt++) {
+      expected[(unsigned int) (I.bitmap[cpt] * 32 / 256.0) * 16 + (unsigned int) (I_shifted.bitmap[cpt] * 16 / 256.0)]++;
+    }
+    if (joint != expected) {
+      std::cerr << "Problem with joint histogram computation!" << std::endl;
+      return -1;
+    }
+
+
     std::cout << "testHistogram is OK!" << std::endl;
     return 0;
   }
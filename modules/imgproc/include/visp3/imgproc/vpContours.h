@@ -218,11 +218,74 @@ namespace vp
   };
 
 
+  /*!
+    \ingroup group_imgproc_contours
+
+    Contour of a vpContourChains: its type, its place in the hierarchy and the
+    location of its points.
+  */
+  struct vpContourNode {
+    vpContourType m_contourType; //!< Outer or hole contour.
+    int m_parent;                //!< Index of the parent contour, -1 for a contour without parent.
+    int m_firstChild;            //!< Index of the first child contour, -1 if none.
+    int m_nextSibling;           //!< Index of the next contour with the same parent, -1 if none.
+    int m_i;                     //!< Row of the first point.
+    int m_j;                     //!< Column of the first point.
+    unsigned int m_offset;       //!< Index of the first chain code, or of the first vertex for an approximated contour.
+    unsigned int m_length;       //!< Number of chain codes, or of vertices for an approximated contour.
+
+    vpContourNode() :
+      m_contourType(vp::CONTOUR_OUTER), m_parent(-1), m_firstChild(-1), m_nextSibling(-1), m_i(0), m_j(0),
+      m_offset(0), m_length(0) {
+    }
+  };
+
+  /*!
+    \ingroup group_imgproc_contours
+
+    Compact storage of the contours extracted by findContours(const vpImage<unsigned char> &, vpContourChains &, const vpContourRetrievalType &, const double).
+
+    The contours are stored in a flat array, the hierarchy being given by the
+    indexes of the parent, first child and next sibling of each contour.
+    A contour is stored as its first point followed by the Freeman chain code
+    of the moves to the next points, two codes per byte. The code k in [0, 7]
+    is a move by (vpContourChains::m_di[k], vpContourChains::m_dj[k]), that is
+    north for 0 and then clockwise by steps of 45 degrees.
+    An approximated contour is instead stored as the (i, j) coordinates of its
+    vertices.
+  */
+  struct VISP_EXPORT vpContourChains {
+    std::vector<vpContourNode> m_contours; //!< Contours, in the order they are found by the raster scan.
+    std::vector<unsigned char> m_codes;    //!< Chain codes of all the contours, two codes per byte.
+    std::vector<int> m_vertices;           //!< Interleaved (i, j) vertices of all the approximated contours.
+    bool m_approximated;                   //!< Whether the contours are stored as polygon vertices.
+
+    static const int m_di[8]; //!< Row move of each chain code.
+    static const int m_dj[8]; //!< Column move of each chain code.
+
+    vpContourChains() : m_contours(), m_codes(), m_vertices(), m_approximated(false) {
+    }
+
+    void clear();
+    unsigned char getCode(const unsigned int index) const;
+    void getPoints(const unsigned int index, std::vector<vpImagePoint> &points) const;
+    /*!
+      Return the number of contours.
+    */
+    inline unsigned int size() const {
+      return (unsigned int) m_contours.size();
+    }
+  };
+
+
   VISP_EXPORT void drawContours(vpImage<unsigned char> &I, const std::vector<std::vector<vpImagePoint> > &contours, unsigned char grayValue=255);
   VISP_EXPORT void drawContours(vpImage<vpRGBa> &I, const std::vector<std::vector<vpImagePoint> > &contours, const vpColor &color);
 
   VISP_EXPORT void findContours(const vpImage<unsigned char> &I_original, vpContour &contours, std::vector<std::vector<vpImagePoint> > &contourPts,
                                 const vpContourRetrievalType& retrievalMode=vp::CONTOUR_RETR_TREE);
+  VISP_EXPORT void findContours(const vpImage<unsigned char> &I, vpContourChains &contours,
+                                const vpContourRetrievalType& retrievalMode=vp::CONTOUR_RETR_TREE,
+                                const double epsilon=0.0);
 }
 
 #endif
@@ -47,7 +47,9 @@
 
 #include <visp3/core/vpImage.h>
 #include <visp3/core/vpImageMorphology.h>
+#include <visp3/core/vpRect.h>
 #include <visp3/imgproc/vpContours.h>
+#include <visp3/imgproc/vpPixelPipeline.h>
 
 #define USE_OLD_FILL_HOLE 0
 
@@ -67,6 +69,23 @@ namespace vp
     AUTO_THRESHOLD_TRIANGLE     /*!< Zack GW, Rogers WE, Latt SA (1977), "Automatic measurement of sister chromatid exchange frequency", J. Histochem. Cytochem. 25 (7): 741–53, PMID 70454 \cite doi:10.1177/25.7.70454 */
   } vpAutoThresholdMethod;
 
+  /*!
+    \ingroup group_imgproc_connected_components
+
+    Area, bounding box and centroid of a connected component, computed by
+    connectedComponents().
+  */
+  struct vpConnectedComponentStats {
+    unsigned int area;     //!< Number of pixels of the component.
+    vpRect bbox;           //!< Bounding box of the component.
+    vpImagePoint centroid; //!< Center of gravity of the pixels of the component.
+
+    vpConnectedComponentStats() : area(0), bbox(), centroid() {}
+  };
+
+  VISP_EXPORT void adaptiveThreshold(vpImage<unsigned char> &I, const unsigned int blockSize, const double offset=0.0,
+                                     const unsigned char backgroundValue=0, const unsigned char foregroundValue=255);
+
   VISP_EXPORT void adjust(vpImage<unsigned char> &I, const double alpha, const double beta);
   VISP_EXPORT void adjust(const vpImage<unsigned char> &I1, vpImage<unsigned char> &I2, const double alpha, const double beta);
   VISP_EXPORT void adjust(vpImage<vpRGBa> &I, const double alpha, const double beta);
@@ -109,6 +128,9 @@ namespace vp
 
   VISP_EXPORT void connectedComponents(const vpImage<unsigned char> &I, vpImage<int> &labels, int &nbComponents,
                                        const vpImageMorphology::vpConnexityType &connexity=vpImageMorphology::CONNEXITY_4);
+  VISP_EXPORT void connectedComponents(const vpImage<unsigned char> &I, vpImage<int> &labels,
+                                       std::vector<vpConnectedComponentStats> &stats,
+                                       const vpImageMorphology::vpConnexityType &connexity=vpImageMorphology::CONNEXITY_4);
 
   VISP_EXPORT void fillHoles(vpImage<unsigned char> &I
 #if USE_OLD_FILL_HOLE
@@ -0,0 +1,149 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2017 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * Description:
+ * Chain of point operations applied in a single pass.
+ *
+ *****************************************************************************/
+
+/*!
+  \file vpPixelPipeline.h
+  \brief Chain of point operations applied in a single pass.
+*/
+
+#ifndef __vpPixelPipeline_h__
+#define __vpPixelPipeline_h__
+
+#include <vector>
+
+#include <visp3/core/vpImage.h>
+#include <visp3/core/vpRGBa.h>
+
+
+namespace vp
+{
+  /*!
+    \class vpPixelPipeline
+    \ingroup group_imgproc_brightness
+
+    \brief Chain of point operations (brightness adjustment, gamma correction,
+    contrast stretching, histogram equalization, ...) applied to an image in a
+    single pass.
+
+    Each point operation maps an intensity to a new intensity, so that a chain
+    of operations is composed into one look-up table by channel before being
+    applied. The operations that depend on the image content, like
+    stretchContrast() or equalizeHistogram(), get the histogram of their input
+    image by mapping the histogram of the original image through the look-up
+    table of the previous operations. The image is thus read once to compute its
+    histogram, only when the chain contains such an operation, and once to apply
+    the look-up tables. The result is the same as calling the corresponding vp
+    functions one after the other, each operation processing the channels of a
+    color image as the vp function does.
+
+    The HSV operations, stretchContrastHSV() and equalizeHistogram(true), are
+    computed pixel by pixel on the output of the look-up tables, without
+    splitting the image into hue, saturation and value planes. Such an operation
+    must be the last one of the chain.
+
+    The passes over the image are parallelized with OpenMP when available.
+
+    \code
+#include <visp3/imgproc/vpImgproc.h>
+
+int main()
+{
+  vpImage<vpRGBa> I(480, 640);
+
+  vp::vpPixelPipeline pipeline;
+  pipeline.adjust(1.2, -10.0);
+  pipeline.gammaCorrection(1.8);
+  pipeline.stretchContrast();
+  pipeline.stretchContrastHSV();
+
+  // Here the code to acquire I
+  pipeline.apply(I);
+}
+    \endcode
+  */
+  class VISP_EXPORT vpPixelPipeline {
+  public:
+    vpPixelPipeline();
+
+    void adjust(const double alpha, const double beta);
+
+    void apply(vpImage<unsigned char> &I) const;
+    void apply(const vpImage<unsigned char> &I1, vpImage<unsigned char> &I2) const;
+    void apply(vpImage<vpRGBa> &I) const;
+    void apply(const vpImage<vpRGBa> &I1, vpImage<vpRGBa> &I2) const;
+
+    void changeLUT(const unsigned char A, const unsigned char newA, const unsigned char B, const unsigned char newB);
+    void clear();
+
+    void equalizeHistogram(const bool useHSV=false);
+
+    void gammaCorrection(const double gamma);
+
+    /*!
+      Return the number of operations of the chain.
+    */
+    inline unsigned int getNbOperations() const {
+      return (unsigned int) m_operations.size();
+    }
+
+    void lut(const unsigned char (&lut)[256]);
+
+    void stretchContrast();
+    void stretchContrastHSV();
+
+  private:
+    typedef enum {
+      OPERATION_LUT,                   //!< Fixed look-up table applied to all the channels.
+      OPERATION_STRETCH_CONTRAST,      //!< Contrast stretching of all the channels.
+      OPERATION_EQUALIZE_HISTOGRAM,    //!< Histogram equalization of the RGB channels.
+      OPERATION_STRETCH_CONTRAST_HSV,  //!< Saturation and value stretching.
+      OPERATION_EQUALIZE_HISTOGRAM_HSV //!< Histogram equalization of the value channel.
+    } vpOperationType;
+
+    struct vpOperation {
+      vpOperationType m_type;
+      unsigned char m_lut[256];
+    };
+
+    std::vector<vpOperation> m_operations;
+
+    void addOperation(const vpOperationType type, const unsigned char *lut=NULL);
+    void computeLut(const unsigned int (*histograms)[256], const unsigned int nbChannels,
+                    unsigned char (*luts)[256]) const;
+    bool needHistogram() const;
+  };
+}
+
+#endif
@@ -81,9 +81,17 @@
   \brief Contrast Limited Adaptive Histogram Equalization (CLAHE).
 */
 
+#include <cstring>
+
 #include <visp3/imgproc/vpImgproc.h>
+#include <visp3/core/vpCPUFeatures.h>
 #include <visp3/core/vpImageConvert.h>
 
+#if defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+#  include <emmintrin.h>
+#  define VISP_HAVE_SSE2 1
+#endif
+
 namespace {
   int fastRound(const float value) {
     return (int) (value + 0.5f);
@@ -120,8 +128,8 @@ namespace {
     } while (clippedEntries != clippedEntriesBefore);
   }
 
-  void createHistogram(const int blockRadius, const int bins, const int blockXCenter,
-                       const int blockYCenter, const vpImage<unsigned char> &I,
+  void createHistogram(const int blockRadius, const int blockXCenter,
+                       const int blockYCenter, const std::vector<int> &binLut, const vpImage<unsigned char> &I,
                        std::vector<int> &hist) {
     std::fill(hist.begin(), hist.end(), 0);
 
@@ -131,8 +139,9 @@ namespace {
     int yMax = std::min( (int) I.getHeight(), blockYCenter + blockRadius + 1 );
 
     for (int y = yMin; y < yMax; ++y) {
+      const unsigned char *src = I[y];
       for (int x = xMin; x < xMax; ++x) {
-        ++hist[fastRound(I[y][x] / 255.0f * bins)];
+        ++hist[(size_t) binLut[src[x]]];
       }
     }
   }
@@ -212,6 +221,9 @@ namespace {
    \param fast : Use the fast but less accurate version of the filter. The fast version does not evaluate the intensity
    transfer function for each pixel independently but for a grid of adjacent boxes of the given block size only
    and interpolates for locations in between.
+
+   \note When ViSP is built with OpenMP, the transfer functions of the blocks and the rows of the image are
+   processed in parallel.
 */
 void vp::clahe(const vpImage<unsigned char> &I1, vpImage<unsigned char> &I2, const int blockRadius,
                const int bins, const float slope, const bool fast) {
@@ -297,57 +309,112 @@ void vp::clahe(const vpImage<unsigned char> &I1, vpImage<unsigned char> &I2, con
       rs[nr + 1] = I1.getHeight() - blockRadius - 1;
     }
 
-    std::vector<int> hist((size_t) (bins+1));
-    std::vector<int> cdfs((size_t) (bins+1));
-    std::vector<float> tl;
-    std::vector<float> tr;
-    std::vector<float> br;
-    std::vector<float> bl;
+    // Bin of each intensity
+    std::vector<int> binLut(256);
+    for (int v = 0; v < 256; v++) {
+      binLut[(size_t) v] = fastRound(v / 255.0f * bins);
+    }
+
+    // Transfer function of each block, indexed by the intensity
+    int nbBlocks = (int) (rs.size() * cs.size());
+    std::vector<float> transfers((size_t) nbBlocks * 256);
+
+#ifdef VISP_HAVE_OPENMP
+#pragma omp parallel
+#endif
+    {
+      std::vector<int> hist((size_t) (bins+1));
+      std::vector<int> cdfs((size_t) (bins+1));
+
+#ifdef VISP_HAVE_OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+      for (int b = 0; b < nbBlocks; b++) {
+        int r = b / (int) cs.size(), c = b % (int) cs.size();
+        createHistogram(blockRadius, cs[(size_t) c], rs[(size_t) r], binLut, I1, hist);
+        std::vector<float> transfer = createTransfer(hist, limit, cdfs);
+        float *lut = &transfers[(size_t) b * 256];
+        for (int v = 0; v < 256; v++) {
+          lut[v] = transfer[(size_t) binLut[(size_t) v]];
+        }
+      }
+    }
+
+    // Weight of the left block for each column
+    std::vector<float> wxs(I1.getWidth());
+    for (int c = 0; c <= (int) cs.size(); ++c) {
+      int c0 = std::max(0, c - 1);
+      int c1 = std::min((int) cs.size() - 1, c);
+      int dc = cs[c1] - cs[c0];
+      int xMin = (c == 0 ? 0 : cs[c0]);
+      int xMax = (c < (int) cs.size() ? cs[c1] : I1.getWidth());
+      for (int x = xMin; x < xMax; ++x) {
+        wxs[(size_t) x] = (c0 == c1) ? 1.0f : (float) (cs[c1] - x) / dc;
+      }
+    }
 
+#if VISP_HAVE_SSE2
+    bool checkSSE2 = vpCPUFeatures::checkSSE2();
+#endif
+
+    // Interpolate the transfer functions of the four surrounding blocks, rows of blocks in parallel
+#ifdef VISP_HAVE_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
     for (int r = 0; r <= (int) rs.size(); ++r) {
       int r0 = std::max(0, r - 1);
       int r1 = std::min((int) rs.size() - 1, r);
       int dr = rs[r1] - rs[r0];
 
-      createHistogram(blockRadius, bins, cs[0], rs[r0], I1, hist);
-      tr = createTransfer(hist, limit, cdfs);
-      if (r0 == r1) {
-        br = tr;
-      } else {
-        createHistogram(blockRadius, bins, cs[0], rs[r1], I1, hist);
-        br = createTransfer(hist, limit, cdfs);
-      }
-
       int yMin = (r == 0 ? 0 : rs[r0]);
       int yMax = (r < (int) rs.size() ? rs[r1] : I1.getHeight());
 
       for (int c = 0; c <= (int) cs.size(); ++c) {
         int c0 = std::max(0, c - 1);
         int c1 = std::min((int) cs.size() - 1, c);
-        int dc = cs[c1] - cs[c0];
-
-        tl = tr;
-        bl = br;
-
-        if (c0 != c1) {
-          createHistogram(blockRadius, bins, cs[c1], rs[r0], I1, hist);
-          tr = createTransfer(hist, limit, cdfs);
-          if (r0 == r1) {
-            br = tr;
-          } else {
-            createHistogram(blockRadius, bins, cs[c1], rs[r1], I1, hist);
-            br = createTransfer(hist, limit, cdfs);
-          }
-        }
+
+        const float *tl = &transfers[(size_t) (r0 * (int) cs.size() + c0) * 256];
+        const float *tr = &transfers[(size_t) (r0 * (int) cs.size() + c1) * 256];
+        const float *bl = &transfers[(size_t) (r1 * (int) cs.size() + c0) * 256];
+        const float *br = &transfers[(size_t) (r1 * (int) cs.size() + c1) * 256];
 
         int xMin = (c == 0 ? 0 : cs[c0]);
         int xMax = (c < (int) cs.size() ? cs[c1] : I1.getWidth());
         for (int y = yMin; y < yMax; ++y) {
           float wy = (float) (rs[r1] - y) / dr;
+          const unsigned char *src = I1[y];
+          unsigned char *dst = I2[y];
+          int x = xMin;
+
+#if VISP_HAVE_SSE2
+          if (checkSSE2 && c0 != c1 && r0 != r1) {
+            const __m128 one = _mm_set1_ps(1.0f), half = _mm_set1_ps(0.5f), scale = _mm_set1_ps(255.0f);
+            const __m128 wy_ = _mm_set1_ps(wy), wy1_ = _mm_set1_ps(1.0f - wy);
+            for (; x + 4 <= xMax; x += 4) {
+              __m128 t00 = _mm_set_ps(tl[src[x + 3]], tl[src[x + 2]], tl[src[x + 1]], tl[src[x]]);
+              __m128 t01 = _mm_set_ps(tr[src[x + 3]], tr[src[x + 2]], tr[src[x + 1]], tr[src[x]]);
+              __m128 t10 = _mm_set_ps(bl[src[x + 3]], bl[src[x + 2]], bl[src[x + 1]], bl[src[x]]);
+              __m128 t11 = _mm_set_ps(br[src[x + 3]], br[src[x + 2]], br[src[x + 1]], br[src[x]]);
+              __m128 wx = _mm_loadu_ps(&wxs[(size_t) x]);
+              __m128 wx1 = _mm_sub_ps(one, wx);
+
+              __m128 t0 = _mm_add_ps(_mm_mul_ps(wx, t00), _mm_mul_ps(wx1, t01));
+              __m128 t1 = _mm_add_ps(_mm_mul_ps(wx, t10), _mm_mul_ps(wx1, t11));
+              __m128 t = _mm_add_ps(_mm_mul_ps(wy_, t0), _mm_mul_ps(wy1_, t1));
+
+              // Same rounding as fastRound(), then saturation to [0, 255]
+              __m128i v = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(t, scale), half));
+              v = _mm_packs_epi32(v, v);
+              v = _mm_packus_epi16(v, v);
+              int packed = _mm_cvtsi128_si32(v);
+              memcpy(dst + x, &packed, sizeof(packed));
+            }
+          }
+#endif
 
-          for (int x = xMin; x < xMax; ++x) {
-            float wx = (float) (cs[c1] - x) / dc;
-            int v = fastRound(I1[y][x] / 255.0f * bins);
+          for (; x < xMax; ++x) {
+            float wx = wxs[(size_t) x];
+            int v = src[x];
             float t00 = tl[v];
             float t01 = tr[v];
             float t10 = bl[v];
@@ -363,88 +430,95 @@ void vp::clahe(const vpImage<unsigned char> &I1, vpImage<unsigned char> &I2, con
             }
 
             float t = (r0 == r1) ? t0 : wy * t0 + (1.0f - wy) * t1;
-            I2[y][x] = std::max( 0, std::min(255, fastRound(t * 255.0f)) );
+            dst[x] = (unsigned char) std::max( 0, std::min(255, fastRound(t * 255.0f)) );
           }
         }
       }
     }
   } else {
-    std::vector<int> hist(bins+1), prev_hist(bins+1);
-    std::vector<int> clippedHist(bins+1);
-
-    bool first = true;
-    int xMin0 = 0;
-    int xMax0 = std::min((int) I1.getWidth(), blockRadius);
-
-    for (int y = 0; y < (int) I1.getHeight(); y++) {
-      int yMin = std::max(0, y - (int) blockRadius);
-      int yMax = std::min((int) I1.getHeight(), y + blockRadius + 1);
-      int h = yMax - yMin;
-
-#if 0
-      std::fill(hist.begin(), hist.end(), 0);
-      // Compute histogram for the current block
-      for (int yi = yMin; yi < yMax; yi++) {
-        for (int xi = xMin0; xi < xMax0; xi++) {
-          ++hist[fastRound(I1[yi][xi] / 255.0f * bins)];
-        }
-      }
-#else
-      if (first) {
-        first = false;
-        // Compute histogram for the block at (0,0)
-        for (int yi = yMin; yi < yMax; yi++) {
-          for (int xi = xMin0; xi < xMax0; xi++) {
-            ++hist[fastRound(I1[yi][xi] / 255.0f * bins)];
-          }
-        }
-      } else {
-        hist = prev_hist;
-
-        if (yMin > 0) {
-          int yMin1 = yMin - 1;
-          // Sliding histogram, remove top
-          for (int xi = xMin0; xi < xMax0; xi++) {
-            --hist[fastRound(I1[yMin1][xi] / 255.0f * bins)];
-          }
-        }
+    // Bin of each intensity
+    std::vector<int> binLut(256);
+    for (int v = 0; v < 256; v++) {
+      binLut[(size_t) v] = fastRound(v / 255.0f * bins);
+    }
 
-        if (y + blockRadius < (int) I1.getHeight()) {
-          int yMax1 = yMax - 1;
-          // Sliding histogram, add bottom
-          for (int xi = xMin0; xi < xMax0; xi++) {
-            ++hist[fastRound(I1[yMax1][xi] / 255.0f * bins)];
-          }
-        }
-      }
-      prev_hist = hist;
+    // Rows in parallel, the histogram of the block at the beginning of a row
+    // sliding from the previous row processed by the same thread
+#ifdef VISP_HAVE_OPENMP
+#pragma omp parallel
 #endif
+    {
+      std::vector<int> hist(bins+1), prev_hist(bins+1);
+      std::vector<int> clippedHist(bins+1);
 
-      for (int x = 0; x < (int) I1.getWidth(); x++) {
-        int xMin = std::max(0, x - (int) blockRadius);
-        int xMax = x + blockRadius + 1;
+      int prev_y = -2;
+      int xMin0 = 0;
+      int xMax0 = std::min((int) I1.getWidth(), blockRadius);
 
-        if (xMin > 0) {
-          int xMin1 = xMin - 1;
-          // Sliding histogram, remove left
+#ifdef VISP_HAVE_OPENMP
+#pragma omp for schedule(static)
+#endif
+      for (int y = 0; y < (int) I1.getHeight(); y++) {
+        int yMin = std::max(0, y - (int) blockRadius);
+        int yMax = std::min((int) I1.getHeight(), y + blockRadius + 1);
+        int h = yMax - yMin;
+
+        if (y != prev_y + 1) {
+          std::fill(hist.begin(), hist.end(), 0);
+          // Compute histogram for the block at (0,y)
           for (int yi = yMin; yi < yMax; yi++) {
-            --hist[fastRound(I1[yi][xMin1] / 255.0f * bins)];
+            for (int xi = xMin0; xi < xMax0; xi++) {
+              ++hist[(size_t) binLut[I1[yi][xi]]];
+            }
+          }
+        } else {
+          hist = prev_hist;
+
+          if (yMin > 0) {
+            int yMin1 = yMin - 1;
+            // Sliding histogram, remove top
+            for (int xi = xMin0; xi < xMax0; xi++) {
+              --hist[(size_t) binLut[I1[yMin1][xi]]];
+            }
           }
-        }
 
-        if (xMax <= (int) I1.getWidth()) {
-          int xMax1 = xMax - 1;
-          // Sliding histogram, add right
-          for (int yi = yMin; yi < yMax; yi++) {
-            ++hist[fastRound(I1[yi][xMax1] / 255.0f * bins)];
+          if (y + blockRadius < (int) I1.getHeight()) {
+            int yMax1 = yMax - 1;
+            // Sliding histogram, add bottom
+            for (int xi = xMin0; xi < xMax0; xi++) {
+              ++hist[(size_t) binLut[I1[yMax1][xi]]];
+            }
           }
         }
+        prev_hist = hist;
+        prev_y = y;
+
+        for (int x = 0; x < (int) I1.getWidth(); x++) {
+          int xMin = std::max(0, x - (int) blockRadius);
+          int xMax = x + blockRadius + 1;
+
+          if (xMin > 0) {
+            int xMin1 = xMin - 1;
+            // Sliding histogram, remove left
+            for (int yi = yMin; yi < yMax; yi++) {
+              --hist[(size_t) binLut[I1[yi][xMin1]]];
+            }
+          }
+
+          if (xMax <= (int) I1.getWidth()) {
+            int xMax1 = xMax - 1;
+            // Sliding histogram, add right
+            for (int yi = yMin; yi < yMax; yi++) {
+              ++hist[(size_t) binLut[I1[yi][xMax1]]];
+            }
+          }
 
-        int v = fastRound(I1[y][x] / 255.0f * bins);
-        int w = std::min((int) I1.getWidth(), xMax) - xMin;
-        int n = h*w;
-        int limit = (int) (slope * n / bins + 0.5f);
-        I2[y][x] = fastRound(transferValue(v, hist, clippedHist, limit) * 255.0f);
+          int v = binLut[I1[y][x]];
+          int w = std::min((int) I1.getWidth(), xMax) - xMin;
+          int n = h*w;
+          int limit = (int) (slope * n / bins + 0.5f);
+          I2[y][x] = (unsigned char) fastRound(transferValue(v, hist, clippedHist, limit) * 255.0f);
+        }
       }
     }
   }
@@ -38,67 +38,264 @@
 
 /*!
   \file vpConnectedComponents.cpp
-  \brief Basic connected components.
+  \brief Connected components labelling.
 */
 
-#include <queue>
+#include <algorithm>
 #include <visp3/imgproc/vpImgproc.h>
 
+#if defined(VISP_HAVE_OPENMP)
+#include <omp.h>
+#endif
+
 namespace {
-void getNeighbors(const vpImage<unsigned char> &I, std::queue<vpImagePoint> &listOfNeighbors,
-                  const unsigned int i, const unsigned int j,
-                  const vpImageMorphology::vpConnexityType &connexity) {
-  unsigned char currValue = I[i][j];
-
-  if (connexity == vpImageMorphology::CONNEXITY_4) {
-    //Top
-    if (I[i-1][j] == currValue) {
-      listOfNeighbors.push(vpImagePoint(i-1, j));
+// Statistics accumulated for a provisional label
+struct vpLabelStats {
+  unsigned int area;
+  unsigned int top, left, bottom, right;
+  double sum_i, sum_j;
+};
+
+// The root of a set is its smallest label: provisional labels are created in
+// raster order, so the final labels are ordered like the first pixel of each
+// component.
+inline int findRoot(std::vector<int> &parent, int x) {
+  while (parent[(size_t) x] != x) {
+    parent[(size_t) x] = parent[(size_t) parent[(size_t) x]];
+    x = parent[(size_t) x];
+  }
+  return x;
+}
+
+inline void unite(std::vector<int> &parent, int a, int b) {
+  a = findRoot(parent, a);
+  b = findRoot(parent, b);
+  if (a < b) {
+    parent[(size_t) b] = a;
+  } else if (b < a) {
+    parent[(size_t) a] = b;
+  }
+}
+
+/*
+  First pass over the rows [row_begin, row_end[: set a provisional label to
+  each pixel from its already labelled neighbors with the same value, and
+  record the equivalences between labels.
+*/
+void labelStrip(const vpImage<unsigned char> &I, vpImage<int> &labels, const unsigned int row_begin,
+                const unsigned int row_end, const bool connexity8, std::vector<int> &parent,
+                std::vector<vpLabelStats> *stats) {
+  const unsigned int width = I.getWidth();
+  parent.assign(1, 0);
+  if (stats) {
+    stats->resize(1);
+  }
+
+  for (unsigned int i = row_begin; i < row_end; i++) {
+    const unsigned char *row = I[i];
+    const unsigned char *prev = (i > row_begin) ? I[i-1] : NULL;
+    int *lab = labels[i];
+    const int *prev_lab = (i > row_begin) ? labels[i-1] : NULL;
+
+    for (unsigned int j = 0; j < width; j++) {
+      const unsigned char v = row[j];
+      if (v == 0) {
+        lab[j] = 0;
+        continue;
+      }
+
+      int l = 0;
+      if (connexity8) {
+        if (prev && prev[j] == v) {
+          l = prev_lab[j];
+        } else {
+          const bool up_left = prev && j > 0 && prev[j-1] == v;
+          const bool up_right = prev && j+1 < width && prev[j+1] == v;
+          const bool left = j > 0 && row[j-1] == v;
+          if (up_right) {
+            l = prev_lab[j+1];
+            // The left and up-left pixels are already connected
+            if (up_left) {
+              unite(parent, l, prev_lab[j-1]);
+            } else if (left) {
+              unite(parent, l, lab[j-1]);
+            }
+          } else if (up_left) {
+            l = prev_lab[j-1];
+          } else if (left) {
+            l = lab[j-1];
+          }
+        }
+      } else {
+        const bool up = prev && prev[j] == v;
+        const bool left = j > 0 && row[j-1] == v;
+        if (up) {
+          l = prev_lab[j];
+          if (left && lab[j-1] != l) {
+            unite(parent, l, lab[j-1]);
+          }
+        } else if (left) {
+          l = lab[j-1];
+        }
+      }
+
+      if (l == 0) {
+        l = (int) parent.size();
+        parent.push_back(l);
+        if (stats) {
+          vpLabelStats s;
+          s.area = 0;
+          s.top = s.bottom = i;
+          s.left = s.right = j;
+          s.sum_i = s.sum_j = 0.0;
+          stats->push_back(s);
+        }
+      }
+      lab[j] = l;
+
+      if (stats) {
+        vpLabelStats &s = (*stats)[(size_t) l];
+        s.area++;
+        s.bottom = i;
+        if (j < s.left) s.left = j;
+        if (j > s.right) s.right = j;
+        s.sum_i += i;
+        s.sum_j += j;
+      }
     }
+  }
+}
 
-    //Left
-    if (I[i][j-1] == currValue) {
-      listOfNeighbors.push(vpImagePoint(i, j-1));
+void connectedComponentsImpl(const vpImage<unsigned char> &I, vpImage<int> &labels, int &nbComponents,
+                             std::vector<vp::vpConnectedComponentStats> *componentStats,
+                             const vpImageMorphology::vpConnexityType &connexity) {
+  const unsigned int height = I.getHeight(), width = I.getWidth();
+  labels.resize(height, width);
+  const bool connexity8 = (connexity == vpImageMorphology::CONNEXITY_8);
+
+  // Horizontal strips labelled independently, then merged
+  int nbStrips = 1;
+#if defined(VISP_HAVE_OPENMP)
+  nbStrips = std::max(1, std::min(omp_get_max_threads(), (int) (height / 32)));
+#endif
+  std::vector<unsigned int> rowBegin((size_t) nbStrips + 1);
+  for (int k = 0; k <= nbStrips; k++) {
+    rowBegin[(size_t) k] = (unsigned int) (((unsigned long long) height * (unsigned int) k) / (unsigned int) nbStrips);
+  }
+
+  std::vector<std::vector<int> > stripParent((size_t) nbStrips);
+  std::vector<std::vector<vpLabelStats> > stripStats(componentStats ? (size_t) nbStrips : 0);
+
+#if defined(VISP_HAVE_OPENMP)
+#pragma omp parallel for schedule(static, 1)
+#endif
+  for (int k = 0; k < nbStrips; k++) {
+    labelStrip(I, labels, rowBegin[(size_t) k], rowBegin[(size_t) k+1], connexity8, stripParent[(size_t) k],
+               componentStats ? &stripStats[(size_t) k] : NULL);
+  }
+
+  // Global equivalence table, the labels of a strip being shifted by an offset
+  std::vector<int> offset((size_t) nbStrips + 1, 0);
+  for (int k = 0; k < nbStrips; k++) {
+    offset[(size_t) k+1] = offset[(size_t) k] + (int) stripParent[(size_t) k].size() - 1;
+  }
+  std::vector<int> parent((size_t) offset[(size_t) nbStrips] + 1);
+  parent[0] = 0;
+  for (int k = 0; k < nbStrips; k++) {
+    const std::vector<int> &p = stripParent[(size_t) k];
+    for (size_t x = 1; x < p.size(); x++) {
+      parent[(size_t) offset[(size_t) k] + x] = offset[(size_t) k] + p[x];
     }
+    std::vector<int>().swap(stripParent[(size_t) k]);
+  }
 
-    //Right
-    if (I[i][j+1] == currValue) {
-      listOfNeighbors.push(vpImagePoint(i, j+1));
+  // Merge the components across the strip boundaries
+  for (int k = 1; k < nbStrips; k++) {
+    const unsigned int i = rowBegin[(size_t) k];
+    if (i == rowBegin[(size_t) k-1]) {
+      continue;
     }
+    const unsigned char *row = I[i], *prev = I[i-1];
+    const int *lab = labels[i], *prev_lab = labels[i-1];
+    const int off = offset[(size_t) k], prev_off = offset[(size_t) k-1];
+    for (unsigned int j = 0; j < width; j++) {
+      const unsigned char v = row[j];
+      if (v == 0) {
+        continue;
+      }
+      if (prev[j] == v) {
+        unite(parent, off + lab[j], prev_off + prev_lab[j]);
+      }
+      if (connexity8) {
+        if (j > 0 && prev[j-1] == v) {
+          unite(parent, off + lab[j], prev_off + prev_lab[j-1]);
+        }
+        if (j+1 < width && prev[j+1] == v) {
+          unite(parent, off + lab[j], prev_off + prev_lab[j+1]);
+        }
+      }
+    }
+  }
 
-    //Bottom
-    if (I[i+1][j] == currValue) {
-      listOfNeighbors.push(vpImagePoint(i+1, j));
+  // Consecutive final labels, in increasing order of the roots
+  std::vector<int> &finalLabel = parent;
+  int current_label = 0;
+  for (size_t x = 1; x < parent.size(); x++) {
+    if (parent[x] == (int) x) {
+      finalLabel[x] = ++current_label;
+    } else {
+      // parent[x] < x: its final label is already known
+      finalLabel[x] = finalLabel[(size_t) parent[x]];
     }
-  } else {
-    for (int cpt1 = -1; cpt1 <= 1; cpt1++) {
-      for (int cpt2 = -1; cpt2 <= 1; cpt2++) {
-        //Everything except the current position
-        if (cpt1 != 0 || cpt2 != 0) {
-          if ( I[(int) i + cpt1][(int) j + cpt2] == currValue ) {
-            listOfNeighbors.push(vpImagePoint( (int) i + cpt1, (int) j + cpt2));
-          }
+  }
+  nbComponents = current_label;
+
+  if (componentStats) {
+    std::vector<vpLabelStats> stats((size_t) nbComponents);
+    std::vector<bool> initialized((size_t) nbComponents, false);
+    for (int k = 0; k < nbStrips; k++) {
+      const std::vector<vpLabelStats> &s = stripStats[(size_t) k];
+      for (size_t x = 1; x < s.size(); x++) {
+        size_t c = (size_t) finalLabel[(size_t) offset[(size_t) k] + x] - 1;
+        if (!initialized[c]) {
+          stats[c] = s[x];
+          initialized[c] = true;
+        } else {
+          vpLabelStats &d = stats[c];
+          d.area += s[x].area;
+          d.top = std::min(d.top, s[x].top);
+          d.bottom = std::max(d.bottom, s[x].bottom);
+          d.left = std::min(d.left, s[x].left);
+          d.right = std::max(d.right, s[x].right);
+          d.sum_i += s[x].sum_i;
+          d.sum_j += s[x].sum_j;
         }
       }
     }
+
+    componentStats->resize((size_t) nbComponents);
+    for (size_t c = 0; c < stats.size(); c++) {
+      vp::vpConnectedComponentStats &cs = (*componentStats)[c];
+      cs.area = stats[c].area;
+      cs.bbox = vpRect(stats[c].left, stats[c].top, stats[c].right - stats[c].left + 1,
+                       stats[c].bottom - stats[c].top + 1);
+      cs.centroid.set_ij(stats[c].sum_i / stats[c].area, stats[c].sum_j / stats[c].area);
+    }
   }
-}
 
-void visitNeighbors(vpImage<unsigned char> &I_copy, std::queue<vpImagePoint> &listOfNeighbors, vpImage<int> &labels,
-                    const int current_label, const vpImageMorphology::vpConnexityType &connexity) {
-  //Visit the neighbors
-  while (!listOfNeighbors.empty()) {
-    vpImagePoint imPt = listOfNeighbors.front();
-    unsigned int i = (unsigned int) imPt.get_i();
-    unsigned int j = (unsigned int) imPt.get_j();
-    listOfNeighbors.pop();
-
-    if (I_copy[i][j]) {
-      getNeighbors(I_copy, listOfNeighbors, i, j, connexity);
-
-      //Reset current position and set label
-      I_copy[i][j] = 0;
-      labels[i][j] = current_label;
+  // Second pass: set the final labels
+#if defined(VISP_HAVE_OPENMP)
+#pragma omp parallel for schedule(static, 1)
+#endif
+  for (int k = 0; k < nbStrips; k++) {
+    const int off = offset[(size_t) k];
+    for (unsigned int i = rowBegin[(size_t) k]; i < rowBegin[(size_t) k+1]; i++) {
+      int *lab = labels[i];
+      for (unsigned int j = 0; j < width; j++) {
+        if (lab[j]) {
+          lab[j] = finalLabel[(size_t) (off + lab[j])];
+        }
+      }
     }
   }
 }
@@ -107,7 +304,13 @@ void visitNeighbors(vpImage<unsigned char> &I_copy, std::queue<vpImagePoint> &li
 /*!
   \ingroup group_imgproc_connected_components
 
-  Perform connected components detection.
+  Perform connected components detection. A connected component is a set of
+  connected pixels with the same value.
+
+  The labelling is done in two passes over the image with a union-find
+  structure. With OpenMP, the image is split in horizontal strips labelled in
+  parallel and merged afterward. The labels are numbered from 1 in the order
+  of the first pixel of each component in the image.
 
   \param I : Input image (0 means background).
   \param labels : Label image that contain for each position the component label.
@@ -120,50 +323,29 @@ void vp::connectedComponents(const vpImage<unsigned char> &I, vpImage<int> &labe
     return;
   }
 
-  labels.resize(I.getHeight(), I.getWidth());
-
-  vpImage<unsigned char> I_copy(I.getHeight()+2, I.getWidth()+2);
-  // Copy and add border
-  for (unsigned int i = 0; i < I_copy.getHeight(); i++) {
-    if (i == 0 || i == I_copy.getHeight() - 1) {
-      memset(I_copy[i], 0, sizeof(unsigned char)*I_copy.getWidth());
-    } else {
-      I_copy[i][0] = 0;
-      memcpy(I_copy[i]+1, I[i-1], sizeof(unsigned char)*I.getWidth());
-      I_copy[i][I_copy.getWidth() - 1] = 0;
-    }
-  }
-
-  vpImage<int> labels_copy(I.getHeight()+2, I.getWidth()+2, 0);
-
-  int current_label = 1;
-  std::queue<vpImagePoint> listOfNeighbors;
-
-  for (unsigned int cpt1 = 0; cpt1 < I.getHeight(); cpt1++) {
-    unsigned int i = cpt1+1;
-
-    for (unsigned int cpt2 = 0; cpt2 < I.getWidth(); cpt2++) {
-      unsigned int j = cpt2+1;
-
-      if (I_copy[i][j] && labels_copy[i][j] == 0) {
-        //Get all the neighbors relative to the current position
-        getNeighbors(I_copy, listOfNeighbors, i, j, connexity);
-
-        //Reset current position and set label
-        I_copy[i][j] = 0;
-        labels_copy[i][j] = current_label;
+  connectedComponentsImpl(I, labels, nbComponents, NULL, connexity);
+}
 
-        visitNeighbors(I_copy, listOfNeighbors, labels_copy, current_label, connexity);
+/*!
+  \ingroup group_imgproc_connected_components
 
-        //Increment label
-        current_label++;
-      }
-    }
-  }
+  Perform connected components detection and compute the area, the bounding
+  box and the centroid of each component during the labelling.
 
-  for (unsigned int i = 0; i < labels.getHeight(); i++) {
-    memcpy(labels[i], labels_copy[i+1]+1, sizeof(int)*labels.getWidth());
+  \param I : Input image (0 means background).
+  \param labels : Label image that contain for each position the component label.
+  \param stats : Statistics of each component, stats[k] corresponds to the label k+1.
+  The number of connected components is the size of this vector.
+  \param connexity : Type of connexity.
+*/
+void vp::connectedComponents(const vpImage<unsigned char> &I, vpImage<int> &labels,
+                             std::vector<vpConnectedComponentStats> &stats,
+                             const vpImageMorphology::vpConnexityType &connexity) {
+  stats.clear();
+  if (I.getSize() == 0) {
+    return;
   }
 
-  nbComponents = current_label - 1;
+  int nbComponents = 0;
+  connectedComponentsImpl(I, labels, nbComponents, &stats, connexity);
 }
@@ -229,8 +229,210 @@ void getContoursList(const vp::vpContour &root, const int level, vp::vpContour &
     getContoursList(**it, level+1, contour_list);
   }
 }
+
+/*
+  Follow the border starting at the pixel pos of the padded image I, whose
+  0-neighbour is in the direction from, in the same way as followBorder().
+  The Freeman chain code of the moves to the next border points is stored in
+  chain, the moves being given by the pointer offsets of each direction.
+*/
+void followChain(int *I, const std::ptrdiff_t pos, const int from, const int nbd, const std::ptrdiff_t offsets[8],
+                 std::vector<unsigned char> &chain) {
+  chain.clear();
+
+  //Find i1j1 (3.1)
+  int dir = -1;
+  for (int k = 1; k < 8; k++) {
+    int d = (from + k) & 7;
+    if (I[pos + offsets[d]] != 0) {
+      dir = d;
+      break;
+    }
+  }
+
+  if (dir < 0) {
+    //(3.1) ; single pixel contour
+    I[pos] = -nbd;
+    return;
+  }
+
+  const std::ptrdiff_t i1j1 = pos + offsets[dir];
+  std::ptrdiff_t i3j3 = pos; //(3.2)
+  int back = dir; //direction from i3j3 to i2j2
+
+  while (true) {
+    //(3.3) ; i2j2 is a non-zero pixel so the search ends
+    bool eastChecked = false;
+    int d = back;
+    std::ptrdiff_t i4j4;
+    while (true) {
+      d = (d + 7) & 7;
+      i4j4 = i3j3 + offsets[d];
+      if (I[i4j4] != 0) {
+        break;
+      }
+      if (d == EAST) {
+        eastChecked = true;
+      }
+    }
+
+    //(3.4)
+    if (eastChecked) {
+      I[i3j3] = -nbd;
+    } else if (I[i3j3] == 1) {
+      I[i3j3] = nbd;
+    }
+
+    //(3.5)
+    if (i4j4 == pos && i3j3 == i1j1) {
+      break;
+    }
+
+    chain.push_back((unsigned char) d);
+    back = (d + 4) & 7;
+    i3j3 = i4j4;
+  }
+}
+
+/*
+  Douglas-Peucker approximation of a closed contour given by its interleaved
+  (i, j) points. The kept vertices are appended to vertices.
+*/
+void approximateContour(const std::vector<int> &points, const double epsilon, std::vector<int> &vertices,
+                        std::vector<unsigned char> &keep, std::vector<std::pair<unsigned int, unsigned int> > &ranges) {
+  const unsigned int n = (unsigned int) points.size() / 2;
+  if (n <= 2) {
+    vertices.insert(vertices.end(), points.begin(), points.end());
+    return;
+  }
+
+  //Split the contour at its farthest point from the first one
+  unsigned int farthest = 0;
+  double maxDist = -1.0;
+  for (unsigned int k = 1; k < n; k++) {
+    double di = points[2*k] - points[0], dj = points[2*k+1] - points[1];
+    double dist = di*di + dj*dj;
+    if (dist > maxDist) {
+      maxDist = dist;
+      farthest = k;
+    }
+  }
+
+  keep.assign(n, 0);
+  keep[0] = keep[farthest] = 1;
+  ranges.clear();
+  ranges.push_back(std::make_pair(0u, farthest));
+  ranges.push_back(std::make_pair(farthest, n));
+
+  const double epsilon2 = epsilon * epsilon;
+  while (!ranges.empty()) {
+    unsigned int a = ranges.back().first, b = ranges.back().second;
+    ranges.pop_back();
+
+    //The index n is the first point, closing the contour
+    const unsigned int bb = b % n;
+    double ai = points[2*a], aj = points[2*a+1];
+    double si = points[2*bb] - ai, sj = points[2*bb+1] - aj;
+    double len2 = si*si + sj*sj;
+
+    unsigned int split = a;
+    double maxDist2 = 0.0;
+    for (unsigned int k = a + 1; k < b; k++) {
+      //Distance to the segment, not to its line, so that every point ends within epsilon of the polygon
+      double di = points[2*k] - ai, dj = points[2*k+1] - aj;
+      double dot = si*di + sj*dj;
+      double dist2;
+      if (len2 > 0.0 && dot > 0.0) {
+        if (dot < len2) {
+          double cross = si*dj - sj*di;
+          dist2 = cross*cross / len2;
+        } else {
+          dist2 = (di - si)*(di - si) + (dj - sj)*(dj - sj);
+        }
+      } else {
+        dist2 = di*di + dj*dj;
+      }
+
+      if (dist2 > maxDist2) {
+        maxDist2 = dist2;
+        split = k;
+      }
+    }
+
+    if (maxDist2 > epsilon2) {
+      keep[split] = 1;
+      ranges.push_back(std::make_pair(split, b));
+      ranges.push_back(std::make_pair(a, split));
+    }
+  }
+
+  for (unsigned int k = 0; k < n; k++) {
+    if (keep[k]) {
+      vertices.push_back(points[2*k]);
+      vertices.push_back(points[2*k+1]);
+    }
+  }
+}
 } //namespace
 
+const int vp::vpContourChains::m_di[8] = { -1, -1, 0, 1, 1, 1, 0, -1 };
+const int vp::vpContourChains::m_dj[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+
+/*!
+  Remove all the contours.
+*/
+void vp::vpContourChains::clear() {
+  m_contours.clear();
+  m_codes.clear();
+  m_vertices.clear();
+  m_approximated = false;
+}
+
+/*!
+  Return a chain code.
+
+  \param index : Index of the chain code in the codes of all the contours,
+  from vpContourNode::m_offset to vpContourNode::m_offset + vpContourNode::m_length - 1
+  for a given contour.
+  \return Chain code in [0, 7].
+*/
+unsigned char vp::vpContourChains::getCode(const unsigned int index) const {
+  return (unsigned char) ((m_codes[index >> 1] >> ((index & 1) << 2)) & 7);
+}
+
+/*!
+  Decode the points of a contour.
+
+  \param index : Index of the contour.
+  \param points : Points of the contour, or vertices of the polygon for an
+  approximated contour.
+*/
+void vp::vpContourChains::getPoints(const unsigned int index, std::vector<vpImagePoint> &points) const {
+  if (index >= m_contours.size()) {
+    throw vpException(vpException::dimensionError, "Contour %u out of the %u contours", index, size());
+  }
+
+  const vpContourNode &contour = m_contours[index];
+  points.clear();
+
+  if (m_approximated) {
+    points.reserve(contour.m_length);
+    for (unsigned int k = contour.m_offset; k < contour.m_offset + contour.m_length; k++) {
+      points.push_back(vpImagePoint(m_vertices[2*k], m_vertices[2*k+1]));
+    }
+  } else {
+    points.reserve(contour.m_length + 1);
+    int i = contour.m_i, j = contour.m_j;
+    points.push_back(vpImagePoint(i, j));
+    for (unsigned int k = contour.m_offset; k < contour.m_offset + contour.m_length; k++) {
+      unsigned char code = getCode(k);
+      i += m_di[code];
+      j += m_dj[code];
+      points.push_back(vpImagePoint(i, j));
+    }
+  }
+}
+
 /*!
   \ingroup group_imgproc_contours
 
@@ -454,3 +656,157 @@ void vp::findContours(const vpImage<unsigned char> &I_original, vpContour &conto
   delete root;
   root = NULL;
 }
+
+/*!
+  \ingroup group_imgproc_contours
+
+  Extract contours from a binary image, in a compact form.
+
+  The border following is the same as in
+  findContours(const vpImage<unsigned char> &, vpContour &, std::vector<std::vector<vpImagePoint> > &, const vpContourRetrievalType &),
+  but each contour is stored as its first point and the chain code of its
+  other points, in a flat array of contours. A chain code takes half a byte
+  instead of the 16 bytes of a vpImagePoint.
+
+  \param I : Input binary image (0 means background, other values mean foreground).
+  \param contours : Detected contours. With vp::CONTOUR_RETR_TREE, the
+  contours are linked to their parent, first child and next sibling. With the
+  other modes, all the contours have no parent and are siblings.
+  \param retrievalMode : Contour retrieval mode.
+  \param epsilon : If positive, each contour is approximated during the
+  extraction by a polygon whose distance to the contour points is at most
+  epsilon pixels (Douglas-Peucker algorithm), and only the polygon vertices are
+  stored.
+*/
+void vp::findContours(const vpImage<unsigned char> &I, vpContourChains &contours,
+                      const vpContourRetrievalType& retrievalMode, const double epsilon) {
+  contours.clear();
+  contours.m_approximated = epsilon > 0.0;
+  if (I.getSize() == 0) {
+    return;
+  }
+
+  //Copy I into a binary int image with a 1-pixel padding
+  const unsigned int height = I.getHeight(), width = I.getWidth();
+  const std::ptrdiff_t step = (std::ptrdiff_t) width + 2;
+  std::vector<int> padded((size_t) step * (height + 2), 0);
+  for (unsigned int i = 0; i < height; i++) {
+    const unsigned char *src = I[i];
+    int *dst = &padded[(size_t) step * (i + 1) + 1];
+    for (unsigned int j = 0; j < width; j++) {
+      dst[j] = src[j] != 0;
+    }
+  }
+
+  std::ptrdiff_t offsets[8];
+  for (int k = 0; k < 8; k++) {
+    offsets[k] = vpContourChains::m_di[k] * step + vpContourChains::m_dj[k];
+  }
+
+  //Type and parent of every border, indexed by NBD - 2, the background frame being NBD = 1
+  std::vector<unsigned char> borderOuter;
+  std::vector<int> borderParent;
+  //Index of the last child of each contour, and of the last contour without parent
+  std::vector<int> lastChild;
+  int lastRoot = -1;
+
+  std::vector<unsigned char> chain;
+  std::vector<int> points, &vertices = contours.m_vertices;
+  std::vector<unsigned char> keep;
+  std::vector<std::pair<unsigned int, unsigned int> > ranges;
+  unsigned int nbCodes = 0;
+
+  int *data = &padded[0];
+  int nbd = 1;
+  for (unsigned int i = 1; i <= height; i++) {
+    int lnbd = 1; //Reset LNBD at the beginning of each scan row
+    const std::ptrdiff_t rowStart = (std::ptrdiff_t) i * step;
+
+    for (std::ptrdiff_t pos = rowStart + 1; pos <= rowStart + (std::ptrdiff_t) width; pos++) {
+      const int fji = data[pos];
+      if (fji == 0) {
+        continue;
+      }
+
+      const bool isOuter = fji == 1 && data[pos - 1] == 0;
+      const bool isHole = !isOuter && fji >= 1 && data[pos + 1] == 0;
+
+      if (isOuter || isHole) {
+        nbd++;
+        if (isHole && fji > 1) {
+          lnbd = fji;
+        }
+
+        //Table 1: the parent is the border B' of LNBD if it is of the other type, else the parent of B'
+        const bool primeOuter = lnbd > 1 && borderOuter[(size_t) lnbd - 2];
+        int parent = lnbd - 2;
+        if (primeOuter == isOuter) {
+          parent = lnbd > 1 ? borderParent[(size_t) lnbd - 2] : -1;
+        }
+        borderOuter.push_back(isOuter);
+        borderParent.push_back(parent);
+
+        followChain(data, pos, isOuter ? WEST : EAST, nbd, offsets, chain);
+
+        if (retrievalMode != CONTOUR_RETR_EXTERNAL || (isOuter && parent < 0)) {
+          vpContourNode node;
+          node.m_contourType = isOuter ? vp::CONTOUR_OUTER : vp::CONTOUR_HOLE;
+          node.m_i = (int) i - 1; //remove 1-pixel padding
+          node.m_j = (int) (pos - rowStart) - 1;
+
+          if (contours.m_approximated) {
+            //Decode the points to approximate the contour before the next one
+            points.resize(2 * (chain.size() + 1));
+            points[0] = node.m_i;
+            points[1] = node.m_j;
+            for (size_t k = 0; k < chain.size(); k++) {
+              points[2*k+2] = points[2*k] + vpContourChains::m_di[chain[k]];
+              points[2*k+3] = points[2*k+1] + vpContourChains::m_dj[chain[k]];
+            }
+
+            node.m_offset = (unsigned int) vertices.size() / 2;
+            approximateContour(points, epsilon, vertices, keep, ranges);
+            node.m_length = (unsigned int) vertices.size() / 2 - node.m_offset;
+          } else {
+            //Pack two chain codes per byte
+            node.m_offset = nbCodes;
+            node.m_length = (unsigned int) chain.size();
+            for (size_t k = 0; k < chain.size(); k++, nbCodes++) {
+              if (nbCodes & 1) {
+                contours.m_codes.back() |= (unsigned char) (chain[k] << 4);
+              } else {
+                contours.m_codes.push_back(chain[k]);
+              }
+            }
+          }
+
+          //In tree mode every border is kept, so that the border indexes are the contour indexes
+          const int index = (int) contours.m_contours.size();
+          node.m_parent = retrievalMode == CONTOUR_RETR_TREE ? parent : -1;
+          if (node.m_parent < 0) {
+            if (lastRoot >= 0) {
+              contours.m_contours[(size_t) lastRoot].m_nextSibling = index;
+            }
+            lastRoot = index;
+          } else {
+            vpContourNode &parentNode = contours.m_contours[(size_t) node.m_parent];
+            if (parentNode.m_firstChild < 0) {
+              parentNode.m_firstChild = index;
+            } else {
+              contours.m_contours[(size_t) lastChild[(size_t) node.m_parent]].m_nextSibling = index;
+            }
+            lastChild[(size_t) node.m_parent] = index;
+          }
+
+          contours.m_contours.push_back(node);
+          lastChild.push_back(-1);
+        }
+      }
+
+      //(4)
+      if (data[pos] != 1) {
+        lnbd = std::abs(data[pos]);
+      }
+    }
+  }
+}
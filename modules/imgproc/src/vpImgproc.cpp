@@ -61,12 +61,252 @@
   \brief Basic image processing functions.
 */
 
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
 #include <visp3/imgproc/vpImgproc.h>
-#include <visp3/core/vpMath.h>
-#include <visp3/core/vpHistogram.h>
+#include <visp3/core/vpCPUFeatures.h>
 #include <visp3/core/vpImageConvert.h>
+#include <visp3/core/vpMath.h>
 #include <visp3/core/vpImageFilter.h>
 
+#if defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+#  include <emmintrin.h>
+#  define VISP_HAVE_SSE2 1
+#endif
+
+#if defined(VISP_HAVE_OPENMP)
+#include <omp.h>
+#endif
+
+namespace {
+  /*
+    Fixed-point unsharp mask. The Gaussian blur b of the image, in 1/256 gray levels,
+    is computed with 16 bits weights: the horizontal pass maps the gray levels to b,
+    the vertical pass maps b to b. The result is (a I - c b) with a = 1 / (1 - weight)
+    and c = weight / (1 - weight), in fixed point with shift bits.
+
+    The rounding error of b grows with the radius of the kernel and is amplified by c,
+    see unsharpMaskUseFixedPoint().
+  */
+  struct vpUnsharpMaskCoefficients {
+    int radius;
+    unsigned int center;             // Q16 weight of the center pixel
+    std::vector<unsigned int> sides; // Q17 weight of the pixels at distance k, stored at k-1
+    int a, c;
+    int shift;
+
+    vpUnsharpMaskCoefficients(const unsigned int size, const double weight) :
+      radius((int) (size - 1) / 2), center(65535), sides(), a(0), c(0), shift(0) {
+      if (size != 1) {
+        std::vector<double> filter((size + 1) / 2);
+        vpImageFilter::getGaussianKernel(&filter[0], size);
+
+        //Normalized so that the weights of a flat image sum to 1
+        unsigned int sum = 0;
+        for (int k = 1; k <= radius; k++) {
+          sides.push_back((unsigned int) std::min(65535, vpMath::round(filter[(size_t) k] * 131072.0)));
+          sum += sides.back();
+        }
+        center = std::min(65535u, sum < 65536 ? 65536 - sum : 0);
+      }
+
+      double alpha = 1.0 / (1.0 - weight), gamma = weight / (1.0 - weight);
+      while (shift < 14 && alpha * (1 << (shift + 1)) <= 32767.0) {
+        shift++;
+      }
+      a = vpMath::round(alpha * (1 << shift));
+      c = vpMath::round(gamma * (1 << shift));
+    }
+  };
+
+  /*
+    The fixed-point result stays within one gray level of the floating-point formula
+    while c (radius + 1) <= 64, which also keeps a and c in the range of the 16 bits
+    multiplications. Larger weights are processed in floating point. Without blur
+    (size 1), the image is copied.
+  */
+  inline bool unsharpMaskUseFixedPoint(const unsigned int size, const double weight) {
+    return size <= 1 || weight / (1.0 - weight) * ((size + 1) / 2) <= 64.0;
+  }
+
+  // Reflection of the borders done by vpImageFilter::filterX() and vpImageFilter::filterY()
+  inline int reflectIndex(int p, const int n) {
+    if (p < 0) {
+      p = -p;
+    }
+    if (p >= n) {
+      p = 2 * n - p - 1;
+    }
+    return std::max(0, std::min(n - 1, p));
+  }
+
+  // Horizontal blur of a row padded with radius pixels on each side
+  void unsharpMaskRowX(const unsigned char *padded, unsigned short *h, const int n, const int cn,
+                       const vpUnsharpMaskCoefficients &coeffs, const bool useSSE2) {
+    const int r = coeffs.radius;
+    const unsigned char *row = padded + r * cn;
+    int x = 0;
+
+#if VISP_HAVE_SSE2
+    if (useSSE2) {
+      const __m128i zero = _mm_setzero_si128();
+      const __m128i wc = _mm_set1_epi16((short) coeffs.center);
+      for (; x + 8 <= n; x += 8) {
+        const unsigned char *ptr = row + x;
+        __m128i val = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *) ptr), zero);
+        __m128i sum = _mm_mulhi_epu16(_mm_slli_epi16(val, 8), wc);
+        for (int k = 1; k <= r; k++) {
+          __m128i left = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *) (ptr - k * cn)), zero);
+          __m128i right = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *) (ptr + k * cn)), zero);
+          __m128i ws = _mm_set1_epi16((short) coeffs.sides[(size_t) k - 1]);
+          sum = _mm_add_epi16(sum, _mm_mulhi_epu16(_mm_slli_epi16(_mm_add_epi16(left, right), 7), ws));
+        }
+        _mm_storeu_si128((__m128i *) (h + x), sum);
+      }
+    }
+#else
+    (void) useSSE2;
+#endif
+
+    for (; x < n; x++) {
+      const unsigned char *ptr = row + x;
+      unsigned int sum = ((unsigned int) ptr[0] << 8) * coeffs.center >> 16;
+      for (int k = 1; k <= r; k++) {
+        sum += (((unsigned int) ptr[-k * cn] + ptr[k * cn]) << 7) * coeffs.sides[(size_t) k - 1] >> 16;
+      }
+      h[x] = (unsigned short) sum;
+    }
+  }
+
+  inline unsigned char unsharpMaskPixel(const unsigned int I, const unsigned int b,
+                                        const vpUnsharpMaskCoefficients &coeffs) {
+    int v = coeffs.a * (int) (I << 7) - coeffs.c * (int) (b >> 1) + (1 << (6 + coeffs.shift));
+    return v < 0 ? 0 : (unsigned char) std::min(255, v >> (7 + coeffs.shift));
+  }
+
+  // Vertical blur of the horizontally blurred rows and sharpening of the row src
+  void unsharpMaskRowY(const unsigned short * const *rows, const unsigned char *src, unsigned char *dst,
+                       const int n, const int cn, const vpUnsharpMaskCoefficients &coeffs, const bool useSSE2) {
+    const int r = coeffs.radius;
+    int x = 0;
+
+#if VISP_HAVE_SSE2
+    if (useSSE2) {
+      const __m128i zero = _mm_setzero_si128();
+      const __m128i wc = _mm_set1_epi16((short) coeffs.center);
+      const __m128i coef = _mm_set_epi16((short) -coeffs.c, (short) coeffs.a, (short) -coeffs.c, (short) coeffs.a,
+                                         (short) -coeffs.c, (short) coeffs.a, (short) -coeffs.c, (short) coeffs.a);
+      const __m128i round = _mm_set1_epi32(1 << (6 + coeffs.shift));
+      const __m128i shift = _mm_cvtsi32_si128(7 + coeffs.shift);
+      //The alpha channel of a color image is copied
+      const __m128i alpha = cn == 4 ? _mm_set1_epi32((int) 0xFF000000) : zero;
+      for (; x + 8 <= n; x += 8) {
+        __m128i b = _mm_mulhi_epu16(_mm_loadu_si128((const __m128i *) (rows[r] + x)), wc);
+        for (int k = 1; k <= r; k++) {
+          __m128i mean = _mm_avg_epu16(_mm_loadu_si128((const __m128i *) (rows[r - k] + x)),
+                                       _mm_loadu_si128((const __m128i *) (rows[r + k] + x)));
+          b = _mm_add_epi16(b, _mm_mulhi_epu16(mean, _mm_set1_epi16((short) coeffs.sides[(size_t) k - 1])));
+        }
+
+        __m128i bytes = _mm_loadl_epi64((const __m128i *) (src + x));
+        __m128i val = _mm_slli_epi16(_mm_unpacklo_epi8(bytes, zero), 7);
+        b = _mm_srli_epi16(b, 1);
+        __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi16(val, b), coef);
+        __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi16(val, b), coef);
+        lo = _mm_sra_epi32(_mm_add_epi32(lo, round), shift);
+        hi = _mm_sra_epi32(_mm_add_epi32(hi, round), shift);
+        __m128i res = _mm_packus_epi16(_mm_packs_epi32(lo, hi), zero);
+        res = _mm_or_si128(_mm_andnot_si128(alpha, res), _mm_and_si128(alpha, bytes));
+        _mm_storel_epi64((__m128i *) (dst + x), res);
+      }
+    }
+#else
+    (void) useSSE2;
+#endif
+
+    for (; x < n; x++) {
+      unsigned int b = (unsigned int) rows[r][x] * coeffs.center >> 16;
+      for (int k = 1; k <= r; k++) {
+        b += (((unsigned int) rows[r - k][x] + rows[r + k][x] + 1) >> 1) * coeffs.sides[(size_t) k - 1] >> 16;
+      }
+      dst[x] = (cn == 4 && x % 4 == 3) ? src[x] : unsharpMaskPixel(src[x], b, coeffs);
+    }
+  }
+
+  /*
+    Unsharp mask of the rows [top, bottom[ in one pass: each row is blurred horizontally
+    when it enters a ring buffer of 2 radius + 1 rows, then the ring buffer is blurred
+    vertically and combined with the source row.
+  */
+  void unsharpMaskBand(const unsigned char *src, unsigned char *dst, const int height, const int width,
+                       const int cn, const int top, const int bottom, const vpUnsharpMaskCoefficients &coeffs,
+                       const bool useSSE2) {
+    const int r = coeffs.radius, n = width * cn, ringSize = 2 * r + 1;
+    std::vector<unsigned char> padded((size_t) ((width + 2 * r) * cn));
+    std::vector<unsigned short> ring((size_t) (ringSize * n));
+    std::vector<const unsigned short *> rows((size_t) ringSize);
+
+    for (int p = top - r; p < bottom + r; p++) {
+      //Horizontal blur of the row p, with the borders reflected
+      const unsigned char *row = src + (size_t) reflectIndex(p, height) * (size_t) n;
+      memcpy(&padded[(size_t) (r * cn)], row, (size_t) n);
+      for (int k = 1; k <= r; k++) {
+        memcpy(&padded[(size_t) ((r - k) * cn)], row + reflectIndex(-k, width) * cn, (size_t) cn);
+        memcpy(&padded[(size_t) ((r + width - 1 + k) * cn)], row + reflectIndex(width - 1 + k, width) * cn,
+               (size_t) cn);
+      }
+      unsharpMaskRowX(&padded[0], &ring[(size_t) (((p - top + r) % ringSize) * n)], n, cn, coeffs, useSSE2);
+
+      //Output row once its 2 radius + 1 rows are blurred
+      const int i = p - r;
+      if (i >= top) {
+        for (int k = 0; k < ringSize; k++) {
+          rows[(size_t) k] = &ring[(size_t) (((i - top + k) % ringSize) * n)];
+        }
+        unsharpMaskRowY(&rows[0], src + (size_t) i * (size_t) n, dst + (size_t) i * (size_t) n, n, cn, coeffs,
+                        useSSE2);
+      }
+    }
+  }
+
+  void unsharpMaskFixedPoint(const unsigned char *src, unsigned char *dst, const unsigned int height,
+                             const unsigned int width, const int cn, const unsigned int size, const double weight) {
+    if (height == 0 || width == 0) {
+      return;
+    }
+    if (size <= 1) {
+      //No blur: the image is unchanged
+      if (dst != src) {
+        memcpy(dst, src, (size_t) height * (size_t) width * (size_t) cn);
+      }
+      return;
+    }
+    const vpUnsharpMaskCoefficients coeffs(size, weight);
+
+    bool useSSE2 = false;
+#if VISP_HAVE_SSE2
+    useSSE2 = vpCPUFeatures::checkSSE2();
+#endif
+
+    //Horizontal bands processed independently
+    int nbBands = 1;
+#if defined(VISP_HAVE_OPENMP)
+    nbBands = std::max(1, std::min(omp_get_max_threads(), (int) (height / 32)));
+#endif
+
+#if defined(VISP_HAVE_OPENMP)
+#pragma omp parallel for schedule(static, 1)
+#endif
+    for (int k = 0; k < nbBands; k++) {
+      int top = (int) (((unsigned long long) height * (unsigned int) k) / (unsigned int) nbBands);
+      int bottom = (int) (((unsigned long long) height * (unsigned int) (k + 1)) / (unsigned int) nbBands);
+      unsharpMaskBand(src, dst, (int) height, (int) width, cn, top, bottom, coeffs, useSSE2);
+    }
+  }
+}
+
 
 /*!
   \ingroup group_imgproc_brightness
@@ -78,14 +318,9 @@
   \param beta : Constant value added to the old intensity.
 */
 void vp::adjust(vpImage<unsigned char> &I, const double alpha, const double beta) {
-  //Construct the look-up table
-  unsigned char lut[256];
-  for(unsigned int i = 0; i < 256; i++) {
-    lut[i] = vpMath::saturate<unsigned char>(alpha * i + beta);
-  }
-
-  //Apply the transformation using a LUT
-  I.performLut(lut);
+  vp::vpPixelPipeline pipeline;
+  pipeline.adjust(alpha, beta);
+  pipeline.apply(I);
 }
 
 /*!
@@ -99,10 +334,9 @@ void vp::adjust(vpImage<unsigned char> &I, const double alpha, const double beta
   \param beta : Constant value added to the old intensity.
 */
 void vp::adjust(const vpImage<unsigned char> &I1, vpImage<unsigned char> &I2, const double alpha, const double beta) {
-  //Copy I1 to I2
-  I2 = I1;
-
-  vp::adjust(I2, alpha, beta);
+  vp::vpPixelPipeline pipeline;
+  pipeline.adjust(alpha, beta);
+  pipeline.apply(I1, I2);
 }
 
 /*!
@@ -115,17 +349,9 @@ void vp::adjust(const vpImage<unsigned char> &I1, vpImage<unsigned char> &I2, co
   \param beta : Constant value added to the old intensity.
 */
 void vp::adjust(vpImage<vpRGBa> &I, const double alpha, const double beta) {
-  //Construct the look-up table
-  vpRGBa lut[256];
-  for(unsigned int i = 0; i < 256; i++) {
-    lut[i].R = vpMath::saturate<unsigned char>(alpha * i + beta);
-    lut[i].G = vpMath::saturate<unsigned char>(alpha * i + beta);
-    lut[i].B = vpMath::saturate<unsigned char>(alpha * i + beta);
-    lut[i].A = vpMath::saturate<unsigned char>(alpha * i + beta);
-  }
-
-  //Apply the transformation using a LUT
-  I.performLut(lut);
+  vp::vpPixelPipeline pipeline;
+  pipeline.adjust(alpha, beta);
+  pipeline.apply(I);
 }
 
 /*!
@@ -139,10 +365,9 @@ void vp::adjust(vpImage<vpRGBa> &I, const double alpha, const double beta) {
   \param beta : Constant value added to the old intensity.
 */
 void vp::adjust(const vpImage<vpRGBa> &I1, vpImage<vpRGBa> &I2, const double alpha, const double beta) {
-  //Copy I1 to I2
-  I2 = I1;
-
-  vp::adjust(I2, alpha, beta);
+  vp::vpPixelPipeline pipeline;
+  pipeline.adjust(alpha, beta);
+  pipeline.apply(I1, I2);
 }
 
 /*!
@@ -155,52 +380,9 @@ void vp::adjust(const vpImage<vpRGBa> &I1, vpImage<vpRGBa> &I2, const double alp
   \param I : The grayscale image to apply histogram equalization.
 */
 void vp::equalizeHistogram(vpImage<unsigned char> &I) {
-  if(I.getWidth()*I.getHeight() == 0) {
-    return;
-  }
-
-  //Calculate the histogram
-  vpHistogram hist;
-  hist.calculate(I);
-
-  //Calculate the cumulative distribution function
-  unsigned int cdf[256];
-  unsigned int cdfMin = /*std::numeric_limits<unsigned int>::max()*/ UINT_MAX, cdfMax = 0;
-  unsigned int minValue = /*std::numeric_limits<unsigned int>::max()*/ UINT_MAX, maxValue = 0;
-  cdf[0] = hist[0];
-
-  if(cdf[0] < cdfMin && cdf[0] > 0) {
-    cdfMin = cdf[0];
-    minValue = 0;
-  }
-
-  for(unsigned int i = 1; i < 256; i++) {
-    cdf[i] = cdf[i-1] + hist[i];
-
-    if(cdf[i] < cdfMin && cdf[i] > 0) {
-      cdfMin = cdf[i];
-      minValue = i;
-    }
-
-    if(cdf[i] > cdfMax) {
-      cdfMax = cdf[i];
-      maxValue = i;
-    }
-  }
-
-  unsigned int nbPixels = I.getWidth()*I.getHeight();
-  if(nbPixels == cdfMin) {
-    //Only one brightness value in the image
-    return;
-  }
-
-  //Construct the look-up table
-  unsigned char lut[256];
-  for(unsigned int x = minValue; x <= maxValue; x++) {
-    lut[x] = vpMath::round( (cdf[x]-cdfMin) / (double) (nbPixels-cdfMin) * 255.0 );
-  }
-
-  I.performLut(lut);
+  vp::vpPixelPipeline pipeline;
+  pipeline.equalizeHistogram();
+  pipeline.apply(I);
 }
 
 /*!
@@ -214,8 +396,9 @@ void vp::equalizeHistogram(vpImage<unsigned char> &I) {
   \param I2 : The second grayscale image after histogram equalization.
 */
 void vp::equalizeHistogram(const vpImage<unsigned char> &I1, vpImage<unsigned char> &I2) {
-  I2 = I1;
-  vp::equalizeHistogram(I2);
+  vp::vpPixelPipeline pipeline;
+  pipeline.equalizeHistogram();
+  pipeline.apply(I1, I2);
 }
 
 /*!
@@ -230,63 +413,9 @@ void vp::equalizeHistogram(const vpImage<unsigned char> &I1, vpImage<unsigned ch
   the histogram equalization is performed independently on the RGB channels.
 */
 void vp::equalizeHistogram(vpImage<vpRGBa> &I, const bool useHSV) {
-  if(I.getWidth()*I.getHeight() == 0) {
-    return;
-  }
-
-  if(!useHSV) {
-    //Split the RGBa image into 4 images
-    vpImage<unsigned char> pR(I.getHeight(), I.getWidth());
-    vpImage<unsigned char> pG(I.getHeight(), I.getWidth());
-    vpImage<unsigned char> pB(I.getHeight(), I.getWidth());
-    vpImage<unsigned char> pa(I.getHeight(), I.getWidth());
-
-    vpImageConvert::split(I, &pR, &pG, &pB, &pa);
-
-    //Apply histogram equalization for each channel
-    vp::equalizeHistogram(pR);
-    vp::equalizeHistogram(pG);
-    vp::equalizeHistogram(pB);
-
-    //Merge the result in I
-    unsigned int size = I.getWidth()*I.getHeight();
-    unsigned char *ptrStart = (unsigned char*) I.bitmap;
-    unsigned char *ptrEnd = ptrStart + size*4;
-    unsigned char *ptrCurrent = ptrStart;
-
-    unsigned int cpt = 0;
-    while(ptrCurrent != ptrEnd) {
-      *ptrCurrent = pR.bitmap[cpt];
-      ++ptrCurrent;
-
-      *ptrCurrent = pG.bitmap[cpt];
-      ++ptrCurrent;
-
-      *ptrCurrent = pB.bitmap[cpt];
-      ++ptrCurrent;
-
-      *ptrCurrent = pa.bitmap[cpt];
-      ++ptrCurrent;
-
-      cpt++;
-    }
-  } else {
-    vpImage<unsigned char> hue(I.getHeight(), I.getWidth());
-    vpImage<unsigned char> saturation(I.getHeight(), I.getWidth());
-    vpImage<unsigned char> value(I.getHeight(), I.getWidth());
-
-    unsigned int size = I.getWidth()*I.getHeight();
-    //Convert from RGBa to HSV
-    vpImageConvert::RGBaToHSV((unsigned char *) I.bitmap, (unsigned char *) hue.bitmap,
-        (unsigned char *) saturation.bitmap, (unsigned char *) value.bitmap, size);
-
-    //Histogram equalization on the value plane
-    vp::equalizeHistogram(value);
-
-    //Convert from HSV to RGBa
-    vpImageConvert::HSVToRGBa((unsigned char*) hue.bitmap, (unsigned char*) saturation.bitmap,
-        (unsigned char*) value.bitmap, (unsigned char*) I.bitmap, size);
-  }
+  vp::vpPixelPipeline pipeline;
+  pipeline.equalizeHistogram(useHSV);
+  pipeline.apply(I);
 }
 
 /*!
@@ -302,8 +431,9 @@ void vp::equalizeHistogram(vpImage<vpRGBa> &I, const bool useHSV) {
   the histogram equalization is performed independently on the RGB channels.
 */
 void vp::equalizeHistogram(const vpImage<vpRGBa> &I1, vpImage<vpRGBa> &I2, const bool useHSV) {
-  I2 = I1;
-  vp::equalizeHistogram(I2, useHSV);
+  vp::vpPixelPipeline pipeline;
+  pipeline.equalizeHistogram(useHSV);
+  pipeline.apply(I1, I2);
 }
 
 /*!
@@ -315,20 +445,9 @@ void vp::equalizeHistogram(const vpImage<vpRGBa> &I1, vpImage<vpRGBa> &I2, const
   \param gamma : Gamma value.
 */
 void vp::gammaCorrection(vpImage<unsigned char> &I, const double gamma) {
-  double inverse_gamma = 1.0;
-  if(gamma > 0) {
-    inverse_gamma = 1.0 / gamma;
-  } else {
-    throw vpException(vpException::badValue, "The gamma value must be positive !");
-  }
-
-  //Construct the look-up table
-  unsigned char lut[256];
-  for(unsigned int i = 0; i < 256; i++) {
-    lut[i] = vpMath::saturate<unsigned char>( pow( (double) i / 255.0, inverse_gamma ) * 255.0 );
-  }
-
-  I.performLut(lut);
+  vp::vpPixelPipeline pipeline;
+  pipeline.gammaCorrection(gamma);
+  pipeline.apply(I);
 }
 
 /*!
@@ -341,8 +460,9 @@ void vp::gammaCorrection(vpImage<unsigned char> &I, const double gamma) {
   \param gamma : Gamma value.
 */
 void vp::gammaCorrection(const vpImage<unsigned char> &I1, vpImage<unsigned char> &I2, const double gamma) {
-  I2 = I1;
-  vp::gammaCorrection(I2, gamma);
+  vp::vpPixelPipeline pipeline;
+  pipeline.gammaCorrection(gamma);
+  pipeline.apply(I1, I2);
 }
 
 /*!
@@ -354,23 +474,9 @@ void vp::gammaCorrection(const vpImage<unsigned char> &I1, vpImage<unsigned char
   \param gamma : Gamma value.
 */
 void vp::gammaCorrection(vpImage<vpRGBa> &I, const double gamma) {
-  double inverse_gamma = 1.0;
-  if(gamma > 0) {
-    inverse_gamma = 1.0 / gamma;
-  } else {
-    throw vpException(vpException::badValue, "The gamma value must be positive !");
-  }
-
-  //Construct the look-up table
-  vpRGBa lut[256];
-  for(unsigned int i = 0; i < 256; i++) {
-    lut[i].R = vpMath::saturate<unsigned char>( pow( (double) i / 255.0, inverse_gamma ) * 255.0 );
-    lut[i].G = vpMath::saturate<unsigned char>( pow( (double) i / 255.0, inverse_gamma ) * 255.0 );
-    lut[i].B = vpMath::saturate<unsigned char>( pow( (double) i / 255.0, inverse_gamma ) * 255.0 );
-    lut[i].A = vpMath::saturate<unsigned char>( pow( (double) i / 255.0, inverse_gamma ) * 255.0 );
-  }
-
-  I.performLut(lut);
+  vp::vpPixelPipeline pipeline;
+  pipeline.gammaCorrection(gamma);
+  pipeline.apply(I);
 }
 
 /*!
@@ -383,8 +489,9 @@ void vp::gammaCorrection(vpImage<vpRGBa> &I, const double gamma) {
   \param gamma : Gamma value.
 */
 void vp::gammaCorrection(const vpImage<vpRGBa> &I1, vpImage<vpRGBa> &I2, const double gamma) {
-  I2 = I1;
-  vp::gammaCorrection(I2, gamma);
+  vp::vpPixelPipeline pipeline;
+  pipeline.gammaCorrection(gamma);
+  pipeline.apply(I1, I2);
 }
 
 /*!
@@ -395,23 +502,9 @@ void vp::gammaCorrection(const vpImage<vpRGBa> &I1, vpImage<vpRGBa> &I2, const d
   \param I : The grayscale image to stretch the contrast.
 */
 void vp::stretchContrast(vpImage<unsigned char> &I) {
-  //Find min and max intensity values
-  unsigned char min = 255, max = 0;
-  I.getMinMaxValue(min, max);
-
-  unsigned char range = max - min;
-
-  //Construct the look-up table
-  unsigned char lut[256];
-  if(range > 0) {
-    for(unsigned int x = min; x <= max; x++) {
-      lut[x] = 255 * (x - min) / range;
-    }
-  } else {
-    lut[min] = min;
-  }
-
-  I.performLut(lut);
+  vp::vpPixelPipeline pipeline;
+  pipeline.stretchContrast();
+  pipeline.apply(I);
 }
 
 /*!
@@ -423,9 +516,9 @@ void vp::stretchContrast(vpImage<unsigned char> &I) {
   \param I2 : The second output grayscale image.
 */
 void vp::stretchContrast(const vpImage<unsigned char> &I1, vpImage<unsigned char> &I2) {
-  //Copy I1 to I2
-  I2 = I1;
-  vp::stretchContrast(I2);
+  vp::vpPixelPipeline pipeline;
+  pipeline.stretchContrast();
+  pipeline.apply(I1, I2);
 }
 
 /*!
@@ -436,74 +529,9 @@ void vp::stretchContrast(const vpImage<unsigned char> &I1, vpImage<unsigned char
   \param I : The color image to stretch the contrast.
 */
 void vp::stretchContrast(vpImage<vpRGBa> &I) {
-  //Find min and max intensity values
-  vpRGBa min = 255, max = 0;
-
-  //Split the RGBa image into 4 images
-  vpImage<unsigned char> pR(I.getHeight(), I.getWidth());
-  vpImage<unsigned char> pG(I.getHeight(), I.getWidth());
-  vpImage<unsigned char> pB(I.getHeight(), I.getWidth());
-  vpImage<unsigned char> pa(I.getHeight(), I.getWidth());
-
-  vpImageConvert::split(I, &pR, &pG, &pB, &pa);
-  //Min max values calculated for each channel
-  unsigned char minChannel, maxChannel;
-  pR.getMinMaxValue(minChannel, maxChannel);
-  min.R = minChannel;
-  max.R = maxChannel;
-
-  pG.getMinMaxValue(minChannel, maxChannel);
-  min.G = minChannel;
-  max.G = maxChannel;
-
-  pB.getMinMaxValue(minChannel, maxChannel);
-  min.B = minChannel;
-  max.B = maxChannel;
-
-  pa.getMinMaxValue(minChannel, maxChannel);
-  min.A = minChannel;
-  max.A = maxChannel;
-
-
-  //Construct the look-up table
-  vpRGBa lut[256];
-  unsigned char rangeR = max.R - min.R;
-  if(rangeR > 0) {
-    for(unsigned int x = min.R; x <= max.R; x++) {
-      lut[x].R = 255 * (x - min.R) / rangeR;
-    }
-  } else {
-    lut[min.R].R = min.R;
-  }
-
-  unsigned char rangeG = max.G - min.G;
-  if(rangeG > 0) {
-    for(unsigned int x = min.G; x <= max.G; x++) {
-      lut[x].G = 255 * (x - min.G) / rangeG;
-    }
-  } else {
-    lut[min.G].G = min.G;
-  }
-
-  unsigned char rangeB = max.B - min.B;
-  if(rangeB > 0) {
-    for(unsigned int x = min.B; x <= max.B; x++) {
-      lut[x].B = 255 * (x - min.B) / rangeB;
-    }
-  } else {
-    lut[min.B].B = min.B;
-  }
-
-  unsigned char rangeA = max.A - min.A;
-  if(rangeA > 0) {
-    for(unsigned int x = min.A; x <= max.A; x++) {
-      lut[x].A = 255 * (x - min.A) / rangeA;
-    }
-  } else {
-    lut[min.A].A = min.A;
-  }
-
-  I.performLut(lut);
+  vp::vpPixelPipeline pipeline;
+  pipeline.stretchContrast();
+  pipeline.apply(I);
 }
 
 /*!
@@ -515,9 +543,9 @@ void vp::stretchContrast(vpImage<vpRGBa> &I) {
   \param I2 : The second output color image.
 */
 void vp::stretchContrast(const vpImage<vpRGBa> &I1, vpImage<vpRGBa> &I2) {
-  //Copy I1 to I2
-  I2 = I1;
-  vp::stretchContrast(I2);
+  vp::vpPixelPipeline pipeline;
+  pipeline.stretchContrast();
+  pipeline.apply(I1, I2);
 }
 
 /*!
@@ -529,45 +557,9 @@ void vp::stretchContrast(const vpImage<vpRGBa> &I1, vpImage<vpRGBa> &I2) {
   \param I : The color image to stetch the contrast in the HSV color space.
 */
 void vp::stretchContrastHSV(vpImage<vpRGBa> &I) {
-  unsigned int size = I.getWidth()*I.getHeight();
-
-  //Convert RGB to HSV
-  vpImage<double> hueImage(I.getHeight(), I.getWidth()), saturationImage(I.getHeight(), I.getWidth()),
-      valueImage(I.getHeight(), I.getWidth());
-  vpImageConvert::RGBaToHSV((unsigned char *) I.bitmap, hueImage.bitmap, saturationImage.bitmap,
-      valueImage.bitmap, size);
-
-  //Find min and max Saturation and Value
-  double minSaturation, maxSaturation, minValue, maxValue;
-  saturationImage.getMinMaxValue(minSaturation, maxSaturation);
-  valueImage.getMinMaxValue(minValue, maxValue);
-
-  double *ptrStart = saturationImage.bitmap;
-  double *ptrEnd = saturationImage.bitmap + size;
-  double *ptrCurrent = ptrStart;
-
-  //Stretch Saturation
-  if(maxSaturation - minSaturation > 0.0) {
-    while(ptrCurrent != ptrEnd) {
-      *ptrCurrent = (*ptrCurrent - minSaturation) / (maxSaturation - minSaturation);
-      ++ptrCurrent;
-    }
-  }
-
-  //Stretch Value
-  if(maxValue - minValue > 0.0) {
-    ptrStart = valueImage.bitmap;
-    ptrEnd = valueImage.bitmap + size;
-    ptrCurrent = ptrStart;
-
-    while(ptrCurrent != ptrEnd) {
-      *ptrCurrent = (*ptrCurrent - minValue) / (maxValue - minValue);
-      ++ptrCurrent;
-    }
-  }
-
-  //Convert HSV to RGBa
-  vpImageConvert::HSVToRGBa(hueImage.bitmap, saturationImage.bitmap, valueImage.bitmap, (unsigned char *) I.bitmap, size);
+  vp::vpPixelPipeline pipeline;
+  pipeline.stretchContrastHSV();
+  pipeline.apply(I);
 }
 
 /*!
@@ -580,9 +572,9 @@ void vp::stretchContrastHSV(vpImage<vpRGBa> &I) {
   \param I2 : The second output color image.
 */
 void vp::stretchContrastHSV(const vpImage<vpRGBa> &I1, vpImage<vpRGBa> &I2) {
-  //Copy I1 to I2
-  I2 = I1;
-  vp::stretchContrastHSV(I2);
+  vp::vpPixelPipeline pipeline;
+  pipeline.stretchContrastHSV();
+  pipeline.apply(I1, I2);
 }
 
 /*!
@@ -590,20 +582,32 @@ void vp::stretchContrastHSV(const vpImage<vpRGBa> &I1, vpImage<vpRGBa> &I2) {
 
   Sharpen a grayscale image using the unsharp mask technique.
 
+  When weight / (1 - weight) x (size + 1) / 2 <= 64 (for instance weight <= 0.94 with
+  a kernel of size 7), the Gaussian blur and the sharpening are computed in fixed point
+  in a single pass over horizontal bands of the image, so that the result may differ by
+  one gray level from a computation in floating point. Larger weights amplify the
+  rounding error of the blur, so they are processed in floating point.
+
   \param I : The grayscale image to sharpen.
   \param size : Size (must be odd) of the Gaussian blur kernel.
   \param weight : Weight (between [0 - 1[) for the sharpening process.
  */
 void vp::unsharpMask(vpImage<unsigned char> &I, const unsigned int size, const double weight) {
   if(weight < 1.0 && weight >= 0.0) {
-    //Gaussian blurred image
-    vpImage<double> I_blurred;
-    vpImageFilter::gaussianBlur(I, I_blurred, size);
-
-    //Unsharp mask
-    for(unsigned int cpt = 0; cpt < I.getSize(); cpt++) {
-      double val = (I.bitmap[cpt] - weight*I_blurred.bitmap[cpt]) / (1 - weight);
-      I.bitmap[cpt] = vpMath::saturate<unsigned char>(val); //val > 255 ? 255 : (val < 0 ? 0 : val);
+    if (unsharpMaskUseFixedPoint(size, weight)) {
+      //The blur needs the original rows around each sharpened row
+      vpImage<unsigned char> I_original = I;
+      unsharpMaskFixedPoint(I_original.bitmap, I.bitmap, I.getHeight(), I.getWidth(), 1, size, weight);
+    } else {
+      //Gaussian blurred image
+      vpImage<double> I_blurred;
+      vpImageFilter::gaussianBlur(I, I_blurred, size);
+
+      //Unsharp mask
+      for(unsigned int cpt = 0; cpt < I.getSize(); cpt++) {
+        double val = (I.bitmap[cpt] - weight*I_blurred.bitmap[cpt]) / (1 - weight);
+        I.bitmap[cpt] = vpMath::saturate<unsigned char>(val); //val > 255 ? 255 : (val < 0 ? 0 : val);
+      }
     }
   }
 }
@@ -619,9 +623,14 @@ void vp::unsharpMask(vpImage<unsigned char> &I, const unsigned int size, const d
   \param weight : Weight (between [0 - 1[) for the sharpening process.
 */
 void vp::unsharpMask(const vpImage<unsigned char> &I1, vpImage<unsigned char> &I2, const unsigned int size, const double weight) {
-  //Copy I1 to I2
-  I2 = I1;
-  vp::unsharpMask(I2, size, weight);
+  if(weight < 1.0 && weight >= 0.0 && &I1 != &I2 && unsharpMaskUseFixedPoint(size, weight)) {
+    I2.resize(I1.getHeight(), I1.getWidth());
+    unsharpMaskFixedPoint(I1.bitmap, I2.bitmap, I1.getHeight(), I1.getWidth(), 1, size, weight);
+  } else {
+    //Copy I1 to I2
+    I2 = I1;
+    vp::unsharpMask(I2, size, weight);
+  }
 }
 
 /*!
@@ -629,30 +638,44 @@ void vp::unsharpMask(const vpImage<unsigned char> &I1, vpImage<unsigned char> &I
 
   Sharpen a color image using the unsharp mask technique.
 
+  When weight / (1 - weight) x (size + 1) / 2 <= 64 (for instance weight <= 0.94 with
+  a kernel of size 7), the Gaussian blur and the sharpening are computed in fixed point
+  in a single pass over horizontal bands of the image, the RGB channels being processed
+  together, so that the result may differ by one level from a computation in floating
+  point. Larger weights amplify the rounding error of the blur, so they are processed in
+  floating point. The alpha channel is unchanged.
+
   \param I : The color image to sharpen.
   \param size : Size (must be odd) of the Gaussian blur kernel.
   \param weight : Weight (between [0 - 1[) for the sharpening process.
  */
 void vp::unsharpMask(vpImage<vpRGBa> &I, const unsigned int size, const double weight) {
   if(weight < 1.0 && weight >= 0.0) {
-    //Gaussian blurred image
-    vpImage<double> I_blurred_R,  I_blurred_G,  I_blurred_B;
-    vpImage<unsigned char> I_R, I_G, I_B;
-
-    vpImageConvert::split(I, &I_R, &I_G, &I_B);
-    vpImageFilter::gaussianBlur(I_R, I_blurred_R, size);
-    vpImageFilter::gaussianBlur(I_G, I_blurred_G, size);
-    vpImageFilter::gaussianBlur(I_B, I_blurred_B, size);
-
-    //Unsharp mask
-    for(unsigned int cpt = 0; cpt < I.getSize(); cpt++) {
-      double val_R = (I.bitmap[cpt].R - weight*I_blurred_R.bitmap[cpt]) / (1 - weight);
-      double val_G = (I.bitmap[cpt].G - weight*I_blurred_G.bitmap[cpt]) / (1 - weight);
-      double val_B = (I.bitmap[cpt].B - weight*I_blurred_B.bitmap[cpt]) / (1 - weight);
-
-      I.bitmap[cpt].R = vpMath::saturate<unsigned char>(val_R);
-      I.bitmap[cpt].G = vpMath::saturate<unsigned char>(val_G);
-      I.bitmap[cpt].B = vpMath::saturate<unsigned char>(val_B);
+    if (unsharpMaskUseFixedPoint(size, weight)) {
+      //The blur needs the original rows around each sharpened row
+      vpImage<vpRGBa> I_original = I;
+      unsharpMaskFixedPoint((unsigned char *) I_original.bitmap, (unsigned char *) I.bitmap, I.getHeight(), I.getWidth(),
+                            4, size, weight);
+    } else {
+      //Gaussian blurred image
+      vpImage<double> I_blurred_R,  I_blurred_G,  I_blurred_B;
+      vpImage<unsigned char> I_R, I_G, I_B;
+
+      vpImageConvert::split(I, &I_R, &I_G, &I_B);
+      vpImageFilter::gaussianBlur(I_R, I_blurred_R, size);
+      vpImageFilter::gaussianBlur(I_G, I_blurred_G, size);
+      vpImageFilter::gaussianBlur(I_B, I_blurred_B, size);
+
+      //Unsharp mask
+      for(unsigned int cpt = 0; cpt < I.getSize(); cpt++) {
+        double val_R = (I.bitmap[cpt].R - weight*I_blurred_R.bitmap[cpt]) / (1 - weight);
+        double val_G = (I.bitmap[cpt].G - weight*I_blurred_G.bitmap[cpt]) / (1 - weight);
+        double val_B = (I.bitmap[cpt].B - weight*I_blurred_B.bitmap[cpt]) / (1 - weight);
+
+        I.bitmap[cpt].R = vpMath::saturate<unsigned char>(val_R);
+        I.bitmap[cpt].G = vpMath::saturate<unsigned char>(val_G);
+        I.bitmap[cpt].B = vpMath::saturate<unsigned char>(val_B);
+      }
     }
   }
 }
@@ -668,7 +691,13 @@ void vp::unsharpMask(vpImage<vpRGBa> &I, const unsigned int size, const double w
   \param weight : Weight (between [0 - 1[) for the sharpening process.
 */
 void vp::unsharpMask(const vpImage<vpRGBa> &I1, vpImage<vpRGBa> &I2, const unsigned int size, const double weight) {
-  //Copy I1 to I2
-  I2 = I1;
-  vp::unsharpMask(I2, size, weight);
+  if(weight < 1.0 && weight >= 0.0 && &I1 != &I2 && unsharpMaskUseFixedPoint(size, weight)) {
+    I2.resize(I1.getHeight(), I1.getWidth());
+    unsharpMaskFixedPoint((unsigned char *) I1.bitmap, (unsigned char *) I2.bitmap, I1.getHeight(), I1.getWidth(),
+                          4, size, weight);
+  } else {
+    //Copy I1 to I2
+    I2 = I1;
+    vp::unsharpMask(I2, size, weight);
+  }
 }
@@ -41,8 +41,48 @@
   \brief Additional image morphology functions.
 */
 
+#include <queue>
 #include <visp3/imgproc/vpImgproc.h>
-#include <visp3/core/vpImageTools.h>
+#include <visp3/core/vpCPUFeatures.h>
+
+#if defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+#  include <emmintrin.h>
+#  define VISP_HAVE_SSE2 1
+#endif
+
+namespace {
+/*
+  Maximum of a row of J and of the adjacent pixels in the row J_adj (above for
+  the raster scan, below for the anti-raster scan): the part of the scan that
+  does not depend on the pixels of the same row.
+*/
+void maxWithAdjacentRow(const unsigned char *J, const unsigned char *J_adj, unsigned char *v, const unsigned int width,
+                        const bool connexity8, const bool checkSSE2) {
+  unsigned int j = 1;
+#if VISP_HAVE_SSE2
+  if (checkSSE2 && width >= 16) {
+    for (; j + 16 <= width + 1; j += 16) {
+      __m128i m = _mm_max_epu8(_mm_loadu_si128((const __m128i *) (J + j)), _mm_loadu_si128((const __m128i *) (J_adj + j)));
+      if (connexity8) {
+        m = _mm_max_epu8(m, _mm_loadu_si128((const __m128i *) (J_adj + j - 1)));
+        m = _mm_max_epu8(m, _mm_loadu_si128((const __m128i *) (J_adj + j + 1)));
+      }
+      _mm_storeu_si128((__m128i *) (v + j), m);
+    }
+  }
+#else
+  (void)checkSSE2;
+#endif
+
+  for (; j <= width; j++) {
+    unsigned char m = (std::max)(J[j], J_adj[j]);
+    if (connexity8) {
+      m = (std::max)(m, (std::max)(J_adj[j-1], J_adj[j+1]));
+    }
+    v[j] = m;
+  }
+}
+} //namespace
 
 /*!
   \ingroup group_imgproc_morph
@@ -108,16 +148,15 @@ void vp::fillHoles(vpImage<unsigned char> &I
   //Perform flood fill
   vp::floodFill(flood_fill_mask, vpImagePoint(0,0), 0, 255);
 
-  //Get current mask
-  vpImage<unsigned char> mask(I.getHeight(), I.getWidth());
-  for (unsigned int i = 0; i < mask.getHeight(); i++) {
-    memcpy(mask[i], flood_fill_mask[i+1]+1, sizeof(unsigned char)*mask.getWidth());
+  //Everything except the background connected to the border is set to 255,
+  //as I + (255 - mask) with saturation
+  for (unsigned int i = 0; i < I.getHeight(); i++) {
+    unsigned char *ptr_I = I[i];
+    const unsigned char *ptr_mask = flood_fill_mask[i+1]+1;
+    for (unsigned int j = 0; j < I.getWidth(); j++) {
+      ptr_I[j] = (ptr_I[j] == 0 && ptr_mask[j] == 255) ? 0 : 255;
+    }
   }
-
-  //Get image with holes filled
-  vpImage<unsigned char> I_white(I.getHeight(), I.getWidth(), 255), I_holes;
-  vpImageTools::imageSubtract(I_white, mask, I_holes);
-  vpImageTools::imageAdd(I, I_holes, I, true);
 #endif
 }
 
@@ -150,24 +189,93 @@ void vp::reconstruct(const vpImage<unsigned char> &marker, const vpImage<unsigne
     return;
   }
 
-  vpImage<unsigned char> h_k = marker;
-  h_kp1 = h_k;
+  // Luc Vincent, "Morphological grayscale reconstruction in image analysis:
+  // applications and efficient algorithms", IEEE Transactions on Image
+  // Processing, 2(2):176-201, 1993. Hybrid algorithm: a raster and an
+  // anti-raster scan followed by a FIFO propagation of the remaining changes.
+  const unsigned int height = marker.getHeight(), width = marker.getWidth();
+  const bool connexity8 = (connexity == vpImageMorphology::CONNEXITY_8);
+#if VISP_HAVE_SSE2
+  const bool checkSSE2 = vpCPUFeatures::checkSSE2();
+#else
+  const bool checkSSE2 = false;
+#endif
+
+  // First geodesic dilation, as the marker may be above the mask
+  vpImage<unsigned char> h_1 = marker;
+  vpImageMorphology::dilatation(h_1, connexity);
+
+  // Work on images with a 1-pixel border set to 0 in both the mask and the
+  // reconstruction: a border pixel is never propagated
+  const unsigned int stride = width + 2;
+  vpImage<unsigned char> J(height + 2, stride, 0), G(height + 2, stride, 0);
+  for (unsigned int i = 0; i < height; i++) {
+    memcpy(G[i+1] + 1, mask[i], width);
+    unsigned char *ptr_J = J[i+1] + 1;
+    const unsigned char *ptr_h = h_1[i], *ptr_G = mask[i];
+    for (unsigned int j = 0; j < width; j++) {
+      ptr_J[j] = (std::min)(ptr_h[j], ptr_G[j]);
+    }
+  }
+
+  std::vector<unsigned char> v(stride, 0);
 
-  do {
-    //Dilatation
-    vpImageMorphology::dilatation(h_kp1, connexity);
+  // Raster scan
+  for (unsigned int i = 1; i <= height; i++) {
+    unsigned char *ptr_J = J[i];
+    const unsigned char *ptr_G = G[i];
+    maxWithAdjacentRow(ptr_J, J[i-1], &v[0], width, connexity8, checkSSE2);
+    for (unsigned int j = 1; j <= width; j++) {
+      ptr_J[j] = (std::min)((std::max)(v[j], ptr_J[j-1]), ptr_G[j]);
+    }
+  }
 
-    //Keep min
-    for (unsigned int i = 0; i < h_kp1.getHeight(); i++) {
-      for (unsigned int j = 0; j < h_kp1.getWidth(); j++) {
-        h_kp1[i][j] = std::min(h_kp1[i][j], mask[i][j]);
+  // Anti-raster scan, queuing the pixels that can still be propagated
+  std::queue<unsigned int> fifo;
+  for (unsigned int i = height; i >= 1; i--) {
+    unsigned char *ptr_J = J[i];
+    const unsigned char *ptr_G = G[i];
+    const unsigned char *ptr_J_below = J[i+1], *ptr_G_below = G[i+1];
+    maxWithAdjacentRow(ptr_J, ptr_J_below, &v[0], width, connexity8, checkSSE2);
+    for (unsigned int j = width; j >= 1; j--) {
+      const unsigned char p = (std::min)((std::max)(v[j], ptr_J[j+1]), ptr_G[j]);
+      ptr_J[j] = p;
+
+      bool propagate = (ptr_J[j+1] < p && ptr_J[j+1] < ptr_G[j+1]) ||
+          (ptr_J_below[j] < p && ptr_J_below[j] < ptr_G_below[j]);
+      if (connexity8 && !propagate) {
+        propagate = (ptr_J_below[j-1] < p && ptr_J_below[j-1] < ptr_G_below[j-1]) ||
+            (ptr_J_below[j+1] < p && ptr_J_below[j+1] < ptr_G_below[j+1]);
+      }
+      if (propagate) {
+        fifo.push(i*stride + j);
       }
     }
+  }
 
-    if (h_kp1 == h_k) {
-      break;
+  // Propagation
+  const int offset4[4] = {-(int) stride, -1, 1, (int) stride};
+  const int offset8[8] = {-(int) stride - 1, -(int) stride, -(int) stride + 1, -1, 1,
+                          (int) stride - 1, (int) stride, (int) stride + 1};
+  const int *offset = connexity8 ? offset8 : offset4;
+  const int nbOffsets = connexity8 ? 8 : 4;
+  unsigned char *ptr_J = J.bitmap;
+  const unsigned char *ptr_G = G.bitmap;
+  while (!fifo.empty()) {
+    const unsigned int p = fifo.front();
+    fifo.pop();
+    const unsigned char value = ptr_J[p];
+    for (int k = 0; k < nbOffsets; k++) {
+      const unsigned int q = (unsigned int) ((int) p + offset[k]);
+      if (ptr_J[q] < value && ptr_G[q] != ptr_J[q]) {
+        ptr_J[q] = (std::min)(value, ptr_G[q]);
+        fifo.push(q);
+      }
     }
+  }
 
-    h_k = h_kp1;
-  } while (true);
+  h_kp1.resize(height, width);
+  for (unsigned int i = 0; i < height; i++) {
+    memcpy(h_kp1[i], J[i+1] + 1, width);
+  }
 }
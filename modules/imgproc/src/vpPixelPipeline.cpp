@@ -0,0 +1,605 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2017 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * Description:
+ * Chain of point operations applied in a single pass.
+ *
+ *****************************************************************************/
+
+/*!
+  \file vpPixelPipeline.cpp
+  \brief Chain of point operations applied in a single pass.
+*/
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include <visp3/core/vpException.h>
+#include <visp3/core/vpHistogram.h>
+#include <visp3/core/vpImageConvert.h>
+#include <visp3/core/vpMath.h>
+#include <visp3/imgproc/vpPixelPipeline.h>
+
+
+namespace {
+  void setIdentity(unsigned char (&lut)[256]) {
+    for (unsigned int i = 0; i < 256; i++) {
+      lut[i] = (unsigned char) i;
+    }
+  }
+
+  //Same look-up table as vp::equalizeHistogram(), identity for an image with a single intensity
+  void computeEqualizationLut(const unsigned int (&histogram)[256], unsigned char (&lut)[256]) {
+    setIdentity(lut);
+
+    unsigned int cdf[256];
+    unsigned int cdfMin = UINT_MAX, cdfMax = 0;
+    unsigned int minValue = UINT_MAX, maxValue = 0;
+    cdf[0] = histogram[0];
+
+    if (cdf[0] < cdfMin && cdf[0] > 0) {
+      cdfMin = cdf[0];
+      minValue = 0;
+    }
+
+    for (unsigned int i = 1; i < 256; i++) {
+      cdf[i] = cdf[i-1] + histogram[i];
+
+      if (cdf[i] < cdfMin && cdf[i] > 0) {
+        cdfMin = cdf[i];
+        minValue = i;
+      }
+
+      if (cdf[i] > cdfMax) {
+        cdfMax = cdf[i];
+        maxValue = i;
+      }
+    }
+
+    unsigned int nbPixels = cdf[255];
+    if (nbPixels == 0 || nbPixels == cdfMin) {
+      return;
+    }
+
+    for (unsigned int x = minValue; x <= maxValue; x++) {
+      lut[x] = (unsigned char) vpMath::round( (cdf[x]-cdfMin) / (double) (nbPixels-cdfMin) * 255.0 );
+    }
+  }
+
+  //Same look-up table as vp::stretchContrast()
+  void computeStretchingLut(const unsigned char min, const unsigned char max, unsigned char (&lut)[256]) {
+    setIdentity(lut);
+
+    unsigned char range = max - min;
+    if (range > 0) {
+      for (unsigned int x = min; x <= max; x++) {
+        lut[x] = (unsigned char) (255 * (x - min) / range);
+      }
+    }
+  }
+
+  void computeHistograms(const vpImage<vpRGBa> &I, unsigned int (*histograms)[256]) {
+    memset(histograms, 0, 4*256*sizeof(unsigned int));
+    const int height = (int) I.getHeight();
+
+#ifdef VISP_HAVE_OPENMP
+#pragma omp parallel
+#endif
+    {
+      unsigned int local[4][256];
+      memset(local, 0, sizeof(local));
+
+#ifdef VISP_HAVE_OPENMP
+#pragma omp for schedule(static)
+#endif
+      for (int i = 0; i < height; i++) {
+        const unsigned char *ptr = (const unsigned char *) I[(unsigned int) i];
+        const unsigned char *ptrEnd = ptr + 4*I.getWidth();
+        for (; ptr != ptrEnd; ptr += 4) {
+          local[0][ptr[0]]++;
+          local[1][ptr[1]]++;
+          local[2][ptr[2]]++;
+          local[3][ptr[3]]++;
+        }
+      }
+
+#ifdef VISP_HAVE_OPENMP
+#pragma omp critical
+#endif
+      {
+        for (unsigned int c = 0; c < 4; c++) {
+          for (unsigned int x = 0; x < 256; x++) {
+            histograms[c][x] += local[c][x];
+          }
+        }
+      }
+    }
+  }
+
+  void applyLut(const vpImage<unsigned char> &I1, vpImage<unsigned char> &I2, const unsigned char (&lut)[256]) {
+    const int height = (int) I1.getHeight();
+
+#ifdef VISP_HAVE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (int i = 0; i < height; i++) {
+      //The table is read through a local pointer: the unsigned char writes to dst may alias
+      //the reference to lut shared by the OpenMP threads, which would be reloaded for each pixel
+      const unsigned char *src = I1[(unsigned int) i], *table = lut;
+      unsigned char *dst = I2[(unsigned int) i];
+      const unsigned int width = I1.getWidth();
+      for (unsigned int j = 0; j < width; j++) {
+        dst[j] = table[src[j]];
+      }
+    }
+  }
+
+  void applyLut(const vpImage<vpRGBa> &I1, vpImage<vpRGBa> &I2, const unsigned char (*luts)[256]) {
+    const int height = (int) I1.getHeight();
+
+#ifdef VISP_HAVE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (int i = 0; i < height; i++) {
+      const unsigned char *src = (const unsigned char *) I1[(unsigned int) i];
+      unsigned char *dst = (unsigned char *) I2[(unsigned int) i];
+      const unsigned char *lutR = luts[0], *lutG = luts[1], *lutB = luts[2], *lutA = luts[3];
+      const unsigned int width = I1.getWidth();
+      for (unsigned int j = 0; j < 4*width; j += 4) {
+        dst[j] = lutR[src[j]];
+        dst[j+1] = lutG[src[j+1]];
+        dst[j+2] = lutB[src[j+2]];
+        dst[j+3] = lutA[src[j+3]];
+      }
+    }
+  }
+
+  //Same as vp::stretchContrastHSV() on the image mapped through the look-up tables
+  void applyStretchContrastHSV(const vpImage<vpRGBa> &I1, vpImage<vpRGBa> &I2, const unsigned char (*luts)[256]) {
+    const int height = (int) I1.getHeight();
+
+    //Minimum and maximum saturation and value, computed as vpImageConvert::RGBaToHSV()
+    double minSaturation = std::numeric_limits<double>::max(), maxSaturation = -minSaturation;
+    double minValue = minSaturation, maxValue = maxSaturation;
+
+#ifdef VISP_HAVE_OPENMP
+#pragma omp parallel
+#endif
+    {
+      double localMinSaturation = std::numeric_limits<double>::max(), localMaxSaturation = -localMinSaturation;
+      double localMinValue = localMinSaturation, localMaxValue = localMaxSaturation;
+
+#ifdef VISP_HAVE_OPENMP
+#pragma omp for schedule(static)
+#endif
+      for (int i = 0; i < height; i++) {
+        const unsigned char *src = (const unsigned char *) I1[(unsigned int) i];
+        const unsigned int width = I1.getWidth();
+        for (unsigned int j = 0; j < 4*width; j += 4) {
+          unsigned char red = luts[0][src[j]], green = luts[1][src[j+1]], blue = luts[2][src[j+2]];
+          double max = std::max(red, std::max(green, blue)) / 255.0;
+          double min = std::min(red, std::min(green, blue)) / 255.0;
+          double saturation = max > 0.0 ? (max - min) / max : 0.0;
+
+          localMinSaturation = std::min(localMinSaturation, saturation);
+          localMaxSaturation = std::max(localMaxSaturation, saturation);
+          localMinValue = std::min(localMinValue, max);
+          localMaxValue = std::max(localMaxValue, max);
+        }
+      }
+
+#ifdef VISP_HAVE_OPENMP
+#pragma omp critical
+#endif
+      {
+        minSaturation = std::min(minSaturation, localMinSaturation);
+        maxSaturation = std::max(maxSaturation, localMaxSaturation);
+        minValue = std::min(minValue, localMinValue);
+        maxValue = std::max(maxValue, localMaxValue);
+      }
+    }
+
+    const double rangeSaturation = maxSaturation - minSaturation, rangeValue = maxValue - minValue;
+
+#ifdef VISP_HAVE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (int i = 0; i < height; i++) {
+      const unsigned char *src = (const unsigned char *) I1[(unsigned int) i];
+      unsigned char *dst = (unsigned char *) I2[(unsigned int) i];
+      const unsigned int width = I1.getWidth();
+      for (unsigned int j = 0; j < 4*width; j += 4) {
+        unsigned char rgba[4] = { luts[0][src[j]], luts[1][src[j+1]], luts[2][src[j+2]], luts[3][src[j+3]] };
+        double h, s, v;
+        vpImageConvert::RGBaToHSV(rgba, &h, &s, &v, 1);
+
+        if (rangeSaturation > 0.0) {
+          s = (s - minSaturation) / rangeSaturation;
+        }
+        if (rangeValue > 0.0) {
+          v = (v - minValue) / rangeValue;
+        }
+
+        vpImageConvert::HSVToRGBa(&h, &s, &v, dst + j, 1);
+      }
+    }
+  }
+
+  //Same as vp::equalizeHistogram(I, true) on the image mapped through the look-up tables
+  void applyEqualizeHistogramHSV(const vpImage<vpRGBa> &I1, vpImage<vpRGBa> &I2, const unsigned char (*luts)[256]) {
+    const int height = (int) I1.getHeight();
+
+    //Value channel as computed by vpImageConvert::RGBaToHSV(const unsigned char *, unsigned char *, ...)
+    unsigned char valueLut[256];
+    for (unsigned int i = 0; i < 256; i++) {
+      valueLut[i] = (unsigned char) (255.0 * (i / 255.0));
+    }
+
+    unsigned int histogram[256];
+    memset(histogram, 0, sizeof(histogram));
+
+#ifdef VISP_HAVE_OPENMP
+#pragma omp parallel
+#endif
+    {
+      unsigned int local[256];
+      memset(local, 0, sizeof(local));
+
+#ifdef VISP_HAVE_OPENMP
+#pragma omp for schedule(static)
+#endif
+      for (int i = 0; i < height; i++) {
+        const unsigned char *src = (const unsigned char *) I1[(unsigned int) i];
+        const unsigned int width = I1.getWidth();
+        for (unsigned int j = 0; j < 4*width; j += 4) {
+          unsigned char red = luts[0][src[j]], green = luts[1][src[j+1]], blue = luts[2][src[j+2]];
+          local[valueLut[std::max(red, std::max(green, blue))]]++;
+        }
+      }
+
+#ifdef VISP_HAVE_OPENMP
+#pragma omp critical
+#endif
+      {
+        for (unsigned int x = 0; x < 256; x++) {
+          histogram[x] += local[x];
+        }
+      }
+    }
+
+    unsigned char equalizationLut[256];
+    computeEqualizationLut(histogram, equalizationLut);
+
+#ifdef VISP_HAVE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (int i = 0; i < height; i++) {
+      const unsigned char *src = (const unsigned char *) I1[(unsigned int) i];
+      unsigned char *dst = (unsigned char *) I2[(unsigned int) i];
+      const unsigned int width = I1.getWidth();
+      for (unsigned int j = 0; j < 4*width; j += 4) {
+        unsigned char rgba[4] = { luts[0][src[j]], luts[1][src[j+1]], luts[2][src[j+2]], luts[3][src[j+3]] };
+        unsigned char h, s, v;
+        vpImageConvert::RGBaToHSV(rgba, &h, &s, &v, 1);
+        v = equalizationLut[v];
+        vpImageConvert::HSVToRGBa(&h, &s, &v, dst + j, 1);
+      }
+    }
+  }
+}
+
+/*!
+  Create an empty chain of operations, which leaves the images unchanged.
+*/
+vp::vpPixelPipeline::vpPixelPipeline() : m_operations() {
+}
+
+/*!
+  Append a brightness adjustment such as the new intensity is alpha x old_intensity + beta, as done
+  by vp::adjust(). All the channels of a color image are adjusted.
+
+  \param alpha : Multiplication coefficient.
+  \param beta : Constant value added to the old intensity.
+*/
+void vp::vpPixelPipeline::adjust(const double alpha, const double beta) {
+  unsigned char lut[256];
+  for (unsigned int i = 0; i < 256; i++) {
+    lut[i] = vpMath::saturate<unsigned char>(alpha * i + beta);
+  }
+
+  addOperation(OPERATION_LUT, lut);
+}
+
+/*!
+  Apply the chain of operations to a grayscale image.
+
+  \param I : The grayscale image to process.
+
+  \exception vpException::badValue : If the chain contains an HSV operation.
+*/
+void vp::vpPixelPipeline::apply(vpImage<unsigned char> &I) const {
+  apply(I, I);
+}
+
+/*!
+  Apply the chain of operations to a grayscale image.
+
+  \param I1 : The input grayscale image.
+  \param I2 : The output grayscale image, which can be I1.
+
+  \exception vpException::badValue : If the chain contains an HSV operation.
+*/
+void vp::vpPixelPipeline::apply(const vpImage<unsigned char> &I1, vpImage<unsigned char> &I2) const {
+  if (!m_operations.empty() && m_operations.back().m_type >= OPERATION_STRETCH_CONTRAST_HSV) {
+    throw vpException(vpException::badValue, "Cannot apply an HSV operation to a grayscale image");
+  }
+
+  if (&I1 != &I2) {
+    I2.resize(I1.getHeight(), I1.getWidth());
+  }
+
+  if (I1.getSize() == 0) {
+    return;
+  }
+
+  unsigned int histogram[1][256];
+  if (needHistogram()) {
+    vpHistogram hist;
+    hist.calculate(I1);
+    for (unsigned int x = 0; x < 256; x++) {
+      histogram[0][x] = hist[x];
+    }
+  }
+
+  unsigned char lut[1][256];
+  computeLut(histogram, 1, lut);
+
+  applyLut(I1, I2, lut[0]);
+}
+
+/*!
+  Apply the chain of operations to a color image.
+
+  \param I : The color image to process.
+*/
+void vp::vpPixelPipeline::apply(vpImage<vpRGBa> &I) const {
+  apply(I, I);
+}
+
+/*!
+  Apply the chain of operations to a color image.
+
+  \param I1 : The input color image.
+  \param I2 : The output color image, which can be I1.
+*/
+void vp::vpPixelPipeline::apply(const vpImage<vpRGBa> &I1, vpImage<vpRGBa> &I2) const {
+  if (&I1 != &I2) {
+    I2.resize(I1.getHeight(), I1.getWidth());
+  }
+
+  if (I1.getSize() == 0) {
+    return;
+  }
+
+  unsigned int histograms[4][256];
+  if (needHistogram()) {
+    computeHistograms(I1, histograms);
+  }
+
+  unsigned char luts[4][256];
+  computeLut(histograms, 4, luts);
+
+  vpOperationType lastType = m_operations.empty() ? OPERATION_LUT : m_operations.back().m_type;
+  if (lastType == OPERATION_STRETCH_CONTRAST_HSV) {
+    applyStretchContrastHSV(I1, I2, luts);
+  } else if (lastType == OPERATION_EQUALIZE_HISTOGRAM_HSV) {
+    applyEqualizeHistogramHSV(I1, I2, luts);
+  } else {
+    applyLut(I1, I2, luts);
+  }
+}
+
+/*!
+  Append a linear stretching of the gray levels between A and B, as done by vpImageTools::changeLUT(): the
+  intensities lower than A are set to newA, the ones greater than B to newB, and the ones in between are
+  linearly mapped to [newA, newB]. All the channels of a color image are processed.
+
+  \param A : Low gray level to be changed to newA.
+  \param newA : New gray level value for A.
+  \param B : High gray level to be changed to newB.
+  \param newB : New gray level value for B.
+
+  \exception vpException::badValue : If B is not greater than A.
+*/
+void vp::vpPixelPipeline::changeLUT(const unsigned char A, const unsigned char newA, const unsigned char B,
+                                    const unsigned char newB) {
+  if (B <= A) {
+    throw vpException(vpException::badValue, "Bad gray levels");
+  }
+
+  double factor = (double) (newB - newA) / (double) (B - A);
+  unsigned char lut[256];
+  for (unsigned int v = 0; v < 256; v++) {
+    if (v <= A) {
+      lut[v] = newA;
+    } else if (v >= B) {
+      lut[v] = newB;
+    } else {
+      lut[v] = (unsigned char) (newA + factor*(v-A));
+    }
+  }
+
+  addOperation(OPERATION_LUT, lut);
+}
+
+/*!
+  Remove all the operations.
+*/
+void vp::vpPixelPipeline::clear() {
+  m_operations.clear();
+}
+
+/*!
+  Append an histogram equalization, as done by vp::equalizeHistogram(). The alpha channel of a color image
+  is unchanged.
+
+  \param useHSV : If true, the histogram equalization of a color image is performed on the value channel (in
+  HSV space) and must be the last operation of the chain, otherwise the histogram equalization is performed
+  independently on the RGB channels.
+*/
+void vp::vpPixelPipeline::equalizeHistogram(const bool useHSV) {
+  addOperation(useHSV ? OPERATION_EQUALIZE_HISTOGRAM_HSV : OPERATION_EQUALIZE_HISTOGRAM);
+}
+
+/*!
+  Append a gamma correction, as done by vp::gammaCorrection(). All the channels of a color image are
+  corrected.
+
+  \param gamma : Gamma value.
+
+  \exception vpException::badValue : If gamma is not positive.
+*/
+void vp::vpPixelPipeline::gammaCorrection(const double gamma) {
+  if (gamma <= 0) {
+    throw vpException(vpException::badValue, "The gamma value must be positive !");
+  }
+
+  double inverse_gamma = 1.0 / gamma;
+  unsigned char lut[256];
+  for (unsigned int i = 0; i < 256; i++) {
+    lut[i] = vpMath::saturate<unsigned char>( pow( (double) i / 255.0, inverse_gamma ) * 255.0 );
+  }
+
+  addOperation(OPERATION_LUT, lut);
+}
+
+/*!
+  Append a look-up table applied to all the channels.
+
+  \param lut : Look-up table which maps each intensity to its new value.
+*/
+void vp::vpPixelPipeline::lut(const unsigned char (&lut)[256]) {
+  addOperation(OPERATION_LUT, lut);
+}
+
+/*!
+  Append a contrast stretching, as done by vp::stretchContrast(). All the channels of a color image are
+  stretched.
+*/
+void vp::vpPixelPipeline::stretchContrast() {
+  addOperation(OPERATION_STRETCH_CONTRAST);
+}
+
+/*!
+  Append a contrast stretching of a color image in the HSV color space, as done by vp::stretchContrastHSV().
+  It must be the last operation of the chain.
+*/
+void vp::vpPixelPipeline::stretchContrastHSV() {
+  addOperation(OPERATION_STRETCH_CONTRAST_HSV);
+}
+
+void vp::vpPixelPipeline::addOperation(const vpOperationType type, const unsigned char *lut) {
+  if (!m_operations.empty() && m_operations.back().m_type >= OPERATION_STRETCH_CONTRAST_HSV) {
+    throw vpException(vpException::badValue, "An HSV operation must be the last operation of the pipeline");
+  }
+
+  vpOperation operation;
+  operation.m_type = type;
+  if (lut != NULL) {
+    memcpy(operation.m_lut, lut, sizeof(operation.m_lut));
+  }
+
+  m_operations.push_back(operation);
+}
+
+/*
+  Compose the look-up tables of the operations, except the HSV one. The histogram of the
+  input of each operation is the histogram of the image mapped through the previous tables.
+*/
+void vp::vpPixelPipeline::computeLut(const unsigned int (*histograms)[256], const unsigned int nbChannels,
+                                     unsigned char (*luts)[256]) const {
+  for (unsigned int c = 0; c < nbChannels; c++) {
+    setIdentity(luts[c]);
+  }
+
+  for (std::vector<vpOperation>::const_iterator it = m_operations.begin(); it != m_operations.end(); ++it) {
+    if (it->m_type == OPERATION_LUT) {
+      for (unsigned int c = 0; c < nbChannels; c++) {
+        for (unsigned int x = 0; x < 256; x++) {
+          luts[c][x] = it->m_lut[luts[c][x]];
+        }
+      }
+    } else if (it->m_type == OPERATION_STRETCH_CONTRAST) {
+      for (unsigned int c = 0; c < nbChannels; c++) {
+        unsigned char min = 255, max = 0;
+        for (unsigned int x = 0; x < 256; x++) {
+          if (histograms[c][x] > 0) {
+            min = std::min(min, luts[c][x]);
+            max = std::max(max, luts[c][x]);
+          }
+        }
+
+        unsigned char lut[256];
+        computeStretchingLut(min, max, lut);
+        for (unsigned int x = 0; x < 256; x++) {
+          luts[c][x] = lut[luts[c][x]];
+        }
+      }
+    } else if (it->m_type == OPERATION_EQUALIZE_HISTOGRAM) {
+      //The alpha channel is not equalized
+      for (unsigned int c = 0; c < std::min(nbChannels, 3u); c++) {
+        unsigned int histogram[256];
+        memset(histogram, 0, sizeof(histogram));
+        for (unsigned int x = 0; x < 256; x++) {
+          histogram[luts[c][x]] += histograms[c][x];
+        }
+
+        unsigned char lut[256];
+        computeEqualizationLut(histogram, lut);
+        for (unsigned int x = 0; x < 256; x++) {
+          luts[c][x] = lut[luts[c][x]];
+        }
+      }
+    }
+  }
+}
+
+bool vp::vpPixelPipeline::needHistogram() const {
+  for (std::vector<vpOperation>::const_iterator it = m_operations.begin(); it != m_operations.end(); ++it) {
+    if (it->m_type == OPERATION_STRETCH_CONTRAST || it->m_type == OPERATION_EQUALIZE_HISTOGRAM) {
+      return true;
+    }
+  }
+
+  return false;
+}
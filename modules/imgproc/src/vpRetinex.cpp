@@ -88,11 +88,264 @@
 #include <functional>
 
 #include <visp3/imgproc/vpImgproc.h>
+#include <visp3/core/vpCPUFeatures.h>
 #include <visp3/core/vpMath.h>
 #include <visp3/core/vpImageFilter.h>
 
+#if defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+#  include <emmintrin.h>
+#  define VISP_HAVE_SSE2 1
+#endif
+
 #define MAX_RETINEX_SCALES 8
 
+namespace {
+  /*
+    Recursive approximation of the Gaussian filter from I. T. Young and L. J. van Vliet,
+    "Recursive implementation of the Gaussian filter", Signal Processing, 1995.
+    The third order filter is factored in a first order section for its real pole
+    followed by a second order section for its complex poles, which stays accurate
+    in single precision for the large scales used by the retinex. The cost doesn't
+    depend on sigma.
+  */
+  struct vpRecursiveGaussian {
+    float g1, p;      // First order section: s[n] = g1 x[n] + p s[n-1]
+    float g2, c1, c2; // Second order section: y[n] = g2 s[n] + c1 y[n-1] + c2 y[n-2]
+    // Initial anti-causal states from the final causal states for a replicated border
+    float M[3][3];
+
+    explicit vpRecursiveGaussian(double sigma) : g1(0), p(0), g2(0), c1(0), c2(0) {
+      sigma = std::max(sigma, 0.5);
+      double q = sigma >= 2.5 ? 0.98711 * sigma - 0.96330 : 3.97156 - 4.14554 * std::sqrt(1.0 - 0.26891 * sigma);
+      const double m0 = 1.16680, m1 = 1.10783, m2 = 1.40586;
+
+      double p_ = q / (m0 + q);
+      double den = (m1 + q) * (m1 + q) + m2 * m2;
+      double c1_ = 2.0 * q * (m1 + q) / den, c2_ = -q * q / den;
+      p = (float) p_;
+      g1 = (float) (1.0 - p_);
+      c1 = (float) c1_;
+      c2 = (float) c2_;
+      g2 = (float) (1.0 - c1_ - c2_);
+
+      // The border is extended with its last value: simulate the causal filter
+      // on the extension from each unit state deviation, then the anti-causal
+      // filter back to the border, until the response vanishes
+      double slowest = std::max(p_, std::sqrt(-c2_));
+      int length = (int) (std::log(1e-8) / std::log(slowest)) + 3;
+      std::vector<double> extension((size_t) length);
+      for (int j = 0; j < 3; j++) {
+        double s = (j == 0), y1 = (j == 1), y2 = (j == 2);
+        for (int k = 0; k < length; k++) {
+          s = p_ * s;
+          double y = (1.0 - c1_ - c2_) * s + c1_ * y1 + c2_ * y2;
+          y2 = y1;
+          y1 = y;
+          extension[(size_t) k] = y;
+        }
+
+        double t = 0, z1 = 0, z2 = 0;
+        for (int k = length - 1; k >= 0; k--) {
+          t = (1.0 - p_) * extension[(size_t) k] + p_ * t;
+          double z = (1.0 - c1_ - c2_) * t + c1_ * z1 + c2_ * z2;
+          z2 = z1;
+          z1 = z;
+        }
+        M[0][j] = (float) t;
+        M[1][j] = (float) z1;
+        M[2][j] = (float) z2;
+      }
+    }
+  };
+
+  // Operations on a pixel of 4 interleaved float channels
+  struct vpPixel4f {
+    struct Type {
+      float v[4];
+    };
+    static inline Type load(const float *ptr) {
+      Type a;
+      for (int c = 0; c < 4; c++) a.v[c] = ptr[c];
+      return a;
+    }
+    static inline void store(float *ptr, const Type &a) {
+      for (int c = 0; c < 4; c++) ptr[c] = a.v[c];
+    }
+    static inline Type set1(float value) {
+      Type a;
+      for (int c = 0; c < 4; c++) a.v[c] = value;
+      return a;
+    }
+    static inline Type add(const Type &a, const Type &b) {
+      Type r;
+      for (int c = 0; c < 4; c++) r.v[c] = a.v[c] + b.v[c];
+      return r;
+    }
+    static inline Type mul(const Type &a, const Type &b) {
+      Type r;
+      for (int c = 0; c < 4; c++) r.v[c] = a.v[c] * b.v[c];
+      return r;
+    }
+    static inline Type sub(const Type &a, const Type &b) {
+      Type r;
+      for (int c = 0; c < 4; c++) r.v[c] = a.v[c] - b.v[c];
+      return r;
+    }
+  };
+
+#if VISP_HAVE_SSE2
+  struct vpPixel4fSSE {
+    typedef __m128 Type;
+    static inline Type load(const float *ptr) { return _mm_loadu_ps(ptr); }
+    static inline void store(float *ptr, const Type &a) { _mm_storeu_ps(ptr, a); }
+    static inline Type set1(float value) { return _mm_set1_ps(value); }
+    static inline Type add(const Type &a, const Type &b) { return _mm_add_ps(a, b); }
+    static inline Type mul(const Type &a, const Type &b) { return _mm_mul_ps(a, b); }
+    static inline Type sub(const Type &a, const Type &b) { return _mm_sub_ps(a, b); }
+  };
+#endif
+
+  // Anti-causal initial states from the causal final states s, y1, y2 and the border value u
+  template <class P>
+  inline void antiCausalStates(const typename P::Type &s, const typename P::Type &y1, const typename P::Type &y2,
+                               const typename P::Type &u, const vpRecursiveGaussian &g, typename P::Type &t,
+                               typename P::Type &z1, typename P::Type &z2) {
+    typedef typename P::Type T;
+    T d[3] = {s, y1, y2};
+    T r[3];
+    for (int i = 0; i < 3; i++) {
+      d[i] = P::sub(d[i], u);
+    }
+    for (int i = 0; i < 3; i++) {
+      r[i] = P::add(u, P::add(P::add(P::mul(P::set1(g.M[i][0]), d[0]), P::mul(P::set1(g.M[i][1]), d[1])),
+                               P::mul(P::set1(g.M[i][2]), d[2])));
+    }
+    t = r[0];
+    z1 = r[1];
+    z2 = r[2];
+  }
+
+  // Filter each row in place, the pixels having 4 interleaved channels
+  template <class P>
+  void recursiveGaussianRows(float *data, int width, int height, const vpRecursiveGaussian &g) {
+    typedef typename P::Type T;
+
+#ifdef VISP_HAVE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (int i = 0; i < height; i++) {
+      const T g1 = P::set1(g.g1), p = P::set1(g.p), g2 = P::set1(g.g2), c1 = P::set1(g.c1), c2 = P::set1(g.c2);
+      float *row = data + (size_t) i * (size_t) width * 4;
+
+      // Causal pass, starting from the steady state of the first pixel
+      T u = P::load(row + (size_t) (width - 1) * 4);
+      T s = P::load(row), y1 = s, y2 = s;
+      for (int j = 0; j < width; j++) {
+        s = P::add(P::mul(g1, P::load(row + 4 * j)), P::mul(p, s));
+        T y = P::add(P::add(P::mul(g2, s), P::mul(c1, y1)), P::mul(c2, y2));
+        y2 = y1;
+        y1 = y;
+        P::store(row + 4 * j, y);
+      }
+
+      // Anti-causal pass
+      T t, z1, z2;
+      antiCausalStates<P>(s, y1, y2, u, g, t, z1, z2);
+      for (int j = width - 1; j >= 0; j--) {
+        t = P::add(P::mul(g1, P::load(row + 4 * j)), P::mul(p, t));
+        T z = P::add(P::add(P::mul(g2, t), P::mul(c1, z1)), P::mul(c2, z2));
+        z2 = z1;
+        z1 = z;
+        P::store(row + 4 * j, z);
+      }
+    }
+  }
+
+  // Filter each column in place, whole rows at a time, chunks of columns in parallel
+  template <class P>
+  void recursiveGaussianColumns(float *data, int width, int height, const vpRecursiveGaussian &g) {
+    typedef typename P::Type T;
+    const int chunkSize = 64;
+    const int nbChunks = (width + chunkSize - 1) / chunkSize;
+    const size_t rowSize = (size_t) width * 4;
+
+#ifdef VISP_HAVE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (int chunk = 0; chunk < nbChunks; chunk++) {
+      const T g1 = P::set1(g.g1), p = P::set1(g.p), g2 = P::set1(g.g2), c1 = P::set1(g.c1), c2 = P::set1(g.c2);
+      const int j0 = chunk * chunkSize, j1 = std::min(width, j0 + chunkSize);
+      // States of the filter of each column, and value of its last pixel
+      std::vector<float> states((size_t) (j1 - j0) * 16);
+      float *ptr_s = &states[0], *ptr_y1 = ptr_s + (j1 - j0) * 4, *ptr_y2 = ptr_y1 + (j1 - j0) * 4;
+      float *ptr_u = ptr_y2 + (j1 - j0) * 4;
+
+      // Start from the steady state of the first pixel
+      for (int j = j0; j < j1; j++) {
+        const int k = 4 * (j - j0);
+        T first = P::load(data + 4 * j);
+        P::store(ptr_s + k, first);
+        P::store(ptr_y1 + k, first);
+        P::store(ptr_y2 + k, first);
+        P::store(ptr_u + k, P::load(data + (size_t) (height - 1) * rowSize + 4 * j));
+      }
+
+      // Causal pass
+      for (int i = 0; i < height; i++) {
+        float *row = data + (size_t) i * rowSize;
+        for (int j = j0; j < j1; j++) {
+          const int k = 4 * (j - j0);
+          T s = P::add(P::mul(g1, P::load(row + 4 * j)), P::mul(p, P::load(ptr_s + k)));
+          T y1 = P::load(ptr_y1 + k);
+          T y = P::add(P::add(P::mul(g2, s), P::mul(c1, y1)), P::mul(c2, P::load(ptr_y2 + k)));
+          P::store(ptr_s + k, s);
+          P::store(ptr_y2 + k, y1);
+          P::store(ptr_y1 + k, y);
+          P::store(row + 4 * j, y);
+        }
+      }
+
+      // Anti-causal pass, the states s, y1, y2 becoming t, z1, z2
+      for (int j = j0; j < j1; j++) {
+        const int k = 4 * (j - j0);
+        T t, z1, z2;
+        antiCausalStates<P>(P::load(ptr_s + k), P::load(ptr_y1 + k), P::load(ptr_y2 + k), P::load(ptr_u + k), g, t, z1,
+                            z2);
+        P::store(ptr_s + k, t);
+        P::store(ptr_y1 + k, z1);
+        P::store(ptr_y2 + k, z2);
+      }
+
+      for (int i = height - 1; i >= 0; i--) {
+        float *row = data + (size_t) i * rowSize;
+        for (int j = j0; j < j1; j++) {
+          const int k = 4 * (j - j0);
+          T t = P::add(P::mul(g1, P::load(row + 4 * j)), P::mul(p, P::load(ptr_s + k)));
+          T z1 = P::load(ptr_y1 + k);
+          T z = P::add(P::add(P::mul(g2, t), P::mul(c1, z1)), P::mul(c2, P::load(ptr_y2 + k)));
+          P::store(ptr_s + k, t);
+          P::store(ptr_y2 + k, z1);
+          P::store(ptr_y1 + k, z);
+          P::store(row + 4 * j, z);
+        }
+      }
+    }
+  }
+
+  // Gaussian blur of an image of 4 interleaved float channels, in place
+  void recursiveGaussianBlur(std::vector<float> &data, int width, int height, double sigma) {
+    vpRecursiveGaussian g(sigma);
+#if VISP_HAVE_SSE2
+    if (vpCPUFeatures::checkSSE2()) {
+      recursiveGaussianRows<vpPixel4fSSE>(&data[0], width, height, g);
+      recursiveGaussianColumns<vpPixel4fSSE>(&data[0], width, height, g);
+      return;
+    }
+#endif
+    recursiveGaussianRows<vpPixel4f>(&data[0], width, height, g);
+    recursiveGaussianColumns<vpPixel4f>(&data[0], width, height, g);
+  }
+}
 
 std::vector<double> retinexScalesDistribution(const int scaleDiv, const int level, const int scale) {
   std::vector<double> scales(MAX_RETINEX_SCALES);
@@ -149,13 +402,6 @@ void MSRCR(vpImage<vpRGBa> &I, const int _scale, const int scaleDiv,
   std::vector<vpImage<double> > doubleResRGB(3);
   unsigned int size = I.getSize();
 
-  int kernelSize = _kernelSize;
-  if(kernelSize == -1) {
-    //Compute the kernel size from the input image size
-    kernelSize = (int) (std::min(I.getWidth(), I.getHeight()) / 2.0);
-    kernelSize = (kernelSize - kernelSize%2) + 1;
-  }
-
   for(int channel = 0; channel < 3; channel++) {
     doubleRGB[(size_t) channel] = vpImage<double>(I.getHeight(), I.getWidth());
     doubleResRGB[(size_t) channel] = vpImage<double>(I.getHeight(), I.getWidth());
@@ -179,17 +425,50 @@ void MSRCR(vpImage<vpRGBa> &I, const int _scale, const int scaleDiv,
         break;
       }
     }
+  }
+
+  if(_kernelSize == -1) {
+    //Recursive Gaussian blur of the three interleaved channels at once
+    std::vector<float> rgb(size*4), blurImage(size*4), blurProduct(size*4, 1.0f);
+    for(unsigned int cpt = 0; cpt < size; cpt++) {
+      rgb[cpt*4] = I.bitmap[cpt].R + 1.0f;
+      rgb[cpt*4 + 1] = I.bitmap[cpt].G + 1.0f;
+      rgb[cpt*4 + 2] = I.bitmap[cpt].B + 1.0f;
+      rgb[cpt*4 + 3] = 1.0f;
+    }
 
     for (int sc = 0; sc < scaleDiv; sc++) {
-      vpImage<double> blurImage;
-      double sigma = retinexScales[(size_t) sc];
-      vpImageFilter::gaussianBlur(doubleRGB[(size_t) channel], blurImage, (unsigned int) kernelSize, sigma);
-
-      for(unsigned int cpt = 0; cpt < size; cpt++) {
-        //Summarize the filtered values.
-        //In fact one calculates a ratio between the original values and the filtered values.
-        doubleResRGB[(size_t) channel].bitmap[cpt] += weight * (std::log(doubleRGB[(size_t) channel].bitmap[cpt])
-          - std::log(blurImage.bitmap[cpt]));
+      blurImage = rgb;
+      recursiveGaussianBlur(blurImage, (int) I.getWidth(), (int) I.getHeight(), retinexScales[(size_t) sc]);
+      for(size_t cpt = 0; cpt < blurImage.size(); cpt++) {
+        blurProduct[cpt] *= blurImage[cpt];
+      }
+    }
+
+    //As the weights are equal, the sum over the scales of weight * (log(I) - log(blur))
+    //is log(I) - weight * log(product of the blurs)
+#ifdef VISP_HAVE_OPENMP
+#pragma omp parallel for
+#endif
+    for(int cpt = 0; cpt < (int) size; cpt++) {
+      for(int channel = 0; channel < 3; channel++) {
+        doubleResRGB[(size_t) channel].bitmap[cpt] = std::log(doubleRGB[(size_t) channel].bitmap[cpt])
+          - weight * std::log((double) blurProduct[(size_t) cpt*4 + (size_t) channel]);
+      }
+    }
+  } else {
+    for(int channel = 0; channel < 3; channel++) {
+      for (int sc = 0; sc < scaleDiv; sc++) {
+        vpImage<double> blurImage;
+        double sigma = retinexScales[(size_t) sc];
+        vpImageFilter::gaussianBlur(doubleRGB[(size_t) channel], blurImage, (unsigned int) _kernelSize, sigma);
+
+        for(unsigned int cpt = 0; cpt < size; cpt++) {
+          //Summarize the filtered values.
+          //In fact one calculates a ratio between the original values and the filtered values.
+          doubleResRGB[(size_t) channel].bitmap[cpt] += weight * (std::log(doubleRGB[(size_t) channel].bitmap[cpt])
+            - std::log(blurImage.bitmap[cpt]));
+        }
       }
     }
   }
@@ -242,7 +521,12 @@ void MSRCR(vpImage<vpRGBa> &I, const int _scale, const int scaleDiv,
     - 1, enhances dark regions of the image,
     - 2, enhances the bright regions of the image.
   \param dynamic : Adjusts the color of the result. Large values produce less saturated images.
-  \param kernelSize : Kernel size for the gaussian blur operation. If -1, the kernel size is calculated from the image size.
+  \param kernelSize : Kernel size for the gaussian blur operation. If -1, a recursive gaussian filter is used
+  instead of the convolution, whose cost does not depend on the scale. It is not truncated, contrary to the
+  kernel of size min(width, height)/2 used by default before: with the default scale the largest Gaussians were cut
+  well below their standard deviation and the output differs by about 10 gray levels. Pass this kernel size to get
+  the previous output. When the kernel covers the Gaussians, the outputs differ by about one gray level, and more
+  near the image borders, which are replicated instead of mirrored.
 */
 void vp::retinex(vpImage<vpRGBa> &I, const int scale, const int scaleDiv,
     const int level, const double dynamic, const int kernelSize) {
@@ -280,7 +564,12 @@ void vp::retinex(vpImage<vpRGBa> &I, const int scale, const int scaleDiv,
     - 1, enhances dark regions of the image,
     - 2, enhances the bright regions of the image.
   \param dynamic : Adjusts the color of the result. Large values produce less saturated images.
-  \param kernelSize : Kernel size for the gaussian blur operation. If -1, the kernel size is calculated from the image size.
+  \param kernelSize : Kernel size for the gaussian blur operation. If -1, a recursive gaussian filter is used
+  instead of the convolution, whose cost does not depend on the scale. It is not truncated, contrary to the
+  kernel of size min(width, height)/2 used by default before: with the default scale the largest Gaussians were cut
+  well below their standard deviation and the output differs by about 10 gray levels. Pass this kernel size to get
+  the previous output. When the kernel covers the Gaussians, the outputs differ by about one gray level, and more
+  near the image borders, which are replicated instead of mirrored.
 */
 void vp::retinex(const vpImage<vpRGBa> &I1, vpImage<vpRGBa> &I2, const int scale, const int scaleDiv,
     const int level, const double dynamic, const int kernelSize) {
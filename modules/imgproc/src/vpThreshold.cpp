@@ -43,6 +43,7 @@
 
 #include <visp3/imgproc/vpImgproc.h>
 #include <visp3/core/vpHistogram.h>
+#include <visp3/core/vpImageFilter.h>
 #include <visp3/core/vpImageTools.h>
 
 namespace {
@@ -404,3 +405,43 @@ unsigned char vp::autoThreshold(vpImage<unsigned char> &I, const vpAutoThreshold
 
   return threshold;
 }
+
+/*!
+  \ingroup group_imgproc_threshold
+
+  Adaptive thresholding: each pixel is compared to the mean of the
+  blockSize x blockSize neighbourhood around it minus an offset, which copes
+  with uneven illuminations. The means are computed with
+  vpImageFilter::boxFilter(), in constant time by pixel whatever the block size.
+  Near the borders, the mean is computed over the part of the neighbourhood
+  inside the image.
+
+  \param I : Input grayscale image.
+  \param blockSize : Size of the neighbourhood. This value should be odd.
+  \param offset : Offset subtracted from the mean.
+  \param backgroundValue : Value to set to the pixels lower than or equal to the mean minus the offset.
+  \param foregroundValue : Value to set to the pixels greater than the mean minus the offset.
+
+  \exception vpException::badValue : If the block size is not odd.
+
+  \sa vpImageFilter::boxFilter()
+*/
+void vp::adaptiveThreshold(vpImage<unsigned char> &I, const unsigned int blockSize, const double offset,
+                           const unsigned char backgroundValue, const unsigned char foregroundValue) {
+  if (blockSize == 0 || blockSize % 2 == 0) {
+    throw vpException(vpException::badValue, "Block size (%u) should be odd", blockSize);
+  }
+
+  if (I.getSize() == 0) {
+    return;
+  }
+
+  vpImage<double> I_mean;
+  vpImageFilter::boxFilter(I, I_mean, blockSize);
+
+  unsigned char *bitmap = I.bitmap;
+  const double *mean = I_mean.bitmap;
+  for (unsigned int i = 0; i < I.getSize(); i++) {
+    bitmap[i] = bitmap[i] > mean[i] - offset ? foregroundValue : backgroundValue;
+  }
+}
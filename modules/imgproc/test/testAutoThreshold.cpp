@@ -307,6 +307,37 @@ main(int argc, const char ** argv)
     std::cout << "Write: " << filename << std::endl;
 
 
+    //Adaptive
+    I_thresh = I;
+    const unsigned int block_size = 7;
+    const double offset = 5.0;
+    t = vpTime::measureTimeMs();
+    vp::adaptiveThreshold(I_thresh, block_size, offset);
+    t = vpTime::measureTimeMs() - t;
+    std::cout << "\nAdaptive thresholding: t=" << t << " ms" << std::endl;
+
+    for (int i = 0; i < (int) I.getHeight(); i++) {
+      for (int j = 0; j < (int) I.getWidth(); j++) {
+        double sum = 0;
+        int count = 0;
+        for (int u = std::max(0, i - 3); u <= std::min((int) I.getHeight() - 1, i + 3); u++) {
+          for (int v = std::max(0, j - 3); v <= std::min((int) I.getWidth() - 1, j + 3); v++, count++) {
+            sum += I[(unsigned int) u][(unsigned int) v];
+          }
+        }
+        unsigned char expected = I[(unsigned int) i][(unsigned int) j] > sum / count - offset ? 255 : 0;
+        if (I_thresh[(unsigned int) i][(unsigned int) j] != expected) {
+          std::cerr << "Wrong adaptive threshold at (" << i << ", " << j << ")" << std::endl;
+          return EXIT_FAILURE;
+        }
+      }
+    }
+
+    filename = vpIoTools::createFilePath(opath, "grid36-03_adaptive_thresh.pgm");
+    vpImageIo::write(I_thresh, filename);
+    std::cout << "Write: " << filename << std::endl;
+
+
     return EXIT_SUCCESS;
   }
   catch(vpException &e) {
@@ -0,0 +1,348 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2017 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * Description:
+ * Test CLAHE against a scalar reference implementation.
+ *
+ *****************************************************************************/
+
+/*!
+  \example testCLAHE.cpp
+
+  Compare vp::clahe() in fast and exact modes with a scalar reference on
+  synthetic images, for odd widths, block radii up to the image size, several
+  numbers of bins and slopes. The output must be the same to the gray level.
+*/
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <visp3/core/vpImageConvert.h>
+#include <visp3/core/vpUniRand.h>
+#include <visp3/imgproc/vpImgproc.h>
+
+#ifdef VISP_HAVE_OPENMP
+#  include <omp.h>
+#endif
+
+namespace {
+  /*
+    Scalar reference: the ImageJ transcription of vp::clahe() as it was before
+    the lookup tables, the SSE2 blending and the OpenMP split, with the sliding
+    histogram of the exact mode replaced by the histogram of each window.
+  */
+  int fastRound(const float value) {
+    return (int) (value + 0.5f);
+  }
+
+  void clipHistogram(const std::vector<int> &hist, std::vector<int> &clippedHist, const int limit) {
+    clippedHist = hist;
+    int clippedEntries = 0, clippedEntriesBefore = 0;
+    int histlength = (int) hist.size();
+
+    do {
+      clippedEntriesBefore = clippedEntries;
+      clippedEntries = 0;
+      for (int i = 0; i < histlength; i++) {
+        int d = clippedHist[i] - limit;
+        if (d > 0) {
+          clippedEntries += d;
+          clippedHist[i] = limit;
+        }
+      }
+
+      int d = clippedEntries / histlength;
+      int m = clippedEntries % histlength;
+      for (int i = 0; i < histlength; i++) {
+        clippedHist[i] += d;
+      }
+
+      if (m != 0) {
+        int s = (histlength - 1) / m;
+        for (int i = s / 2; i < histlength; i += s) {
+          ++(clippedHist[i]);
+        }
+      }
+    } while (clippedEntries != clippedEntriesBefore);
+  }
+
+  void createHistogram(const vpImage<unsigned char> &I, const int bins, const int xMin, const int xMax,
+                       const int yMin, const int yMax, std::vector<int> &hist) {
+    hist.assign((size_t) (bins + 1), 0);
+    for (int y = yMin; y < yMax; ++y) {
+      for (int x = xMin; x < xMax; ++x) {
+        ++hist[fastRound(I[y][x] / 255.0f * bins)];
+      }
+    }
+  }
+
+  void createBlockHistogram(const vpImage<unsigned char> &I, const int blockRadius, const int bins,
+                            const int xCenter, const int yCenter, std::vector<int> &hist) {
+    createHistogram(I, bins, std::max(0, xCenter - blockRadius), std::min((int) I.getWidth(), xCenter + blockRadius + 1),
+                    std::max(0, yCenter - blockRadius), std::min((int) I.getHeight(), yCenter + blockRadius + 1), hist);
+  }
+
+  std::vector<float> createTransfer(const std::vector<int> &hist, const int limit) {
+    std::vector<int> cdfs;
+    clipHistogram(hist, cdfs, limit);
+    int hMin = (int) hist.size() - 1;
+    for (int i = 0; i < hMin; ++i) {
+      if (cdfs[i] != 0) {
+        hMin = i;
+      }
+    }
+    int cdf = 0;
+    for (int i = hMin; i < (int) hist.size(); ++i) {
+      cdf += cdfs[i];
+      cdfs[i] = cdf;
+    }
+
+    int cdfMin = cdfs[hMin];
+    int cdfMax = cdfs[hist.size() - 1];
+    std::vector<float> transfer(hist.size());
+    for (int i = 0; i < (int) transfer.size(); ++i) {
+      transfer[i] = (cdfs[i] - cdfMin) / (float) (cdfMax - cdfMin);
+    }
+    return transfer;
+  }
+
+  float transferValue(const int v, const std::vector<int> &hist, const int limit) {
+    std::vector<int> clippedHist;
+    clipHistogram(hist, clippedHist, limit);
+    int clippedHistLength = (int) clippedHist.size();
+    int hMin = clippedHistLength - 1;
+    for (int i = 0; i < hMin; i++) {
+      if (clippedHist[i] != 0) {
+        hMin = i;
+      }
+    }
+
+    int cdf = 0;
+    for (int i = hMin; i <= v; i++) {
+      cdf += clippedHist[i];
+    }
+    int cdfMax = cdf;
+    for (int i = v + 1; i < clippedHistLength; ++i) {
+      cdfMax += clippedHist[i];
+    }
+
+    int cdfMin = clippedHist[hMin];
+    return (cdf - cdfMin) / (float) (cdfMax - cdfMin);
+  }
+
+  // Centers of the blocks along one direction of the image
+  std::vector<int> blockCenters(const int size, const int blockRadius) {
+    const int blockSize = 2 * blockRadius + 1;
+    const int n = size / blockSize, m = size - n * blockSize;
+    std::vector<int> centers;
+    if (m > 1) {
+      centers.push_back(blockRadius + 1);
+    }
+    for (int i = 0; i < n; ++i) {
+      centers.push_back(i * blockSize + blockRadius + 1 + (m > 1 ? m / 2 : 0));
+    }
+    if (m > 0) {
+      centers.push_back(size - blockRadius - 1);
+    }
+    return centers;
+  }
+
+  void claheFastReference(const vpImage<unsigned char> &I1, vpImage<unsigned char> &I2, const int blockRadius,
+                          const int bins, const float slope) {
+    const int blockSize = 2 * blockRadius + 1;
+    const int limit = (int) (slope * blockSize * blockSize / bins + 0.5);
+    const std::vector<int> cs = blockCenters((int) I1.getWidth(), blockRadius);
+    const std::vector<int> rs = blockCenters((int) I1.getHeight(), blockRadius);
+    I2.resize(I1.getHeight(), I1.getWidth());
+
+    std::vector<int> hist;
+    for (int r = 0; r <= (int) rs.size(); ++r) {
+      int r0 = std::max(0, r - 1);
+      int r1 = std::min((int) rs.size() - 1, r);
+      int dr = rs[r1] - rs[r0];
+      int yMin = (r == 0 ? 0 : rs[r0]);
+      int yMax = (r < (int) rs.size() ? rs[r1] : (int) I1.getHeight());
+
+      for (int c = 0; c <= (int) cs.size(); ++c) {
+        int c0 = std::max(0, c - 1);
+        int c1 = std::min((int) cs.size() - 1, c);
+        int dc = cs[c1] - cs[c0];
+
+        createBlockHistogram(I1, blockRadius, bins, cs[c0], rs[r0], hist);
+        std::vector<float> tl = createTransfer(hist, limit);
+        createBlockHistogram(I1, blockRadius, bins, cs[c1], rs[r0], hist);
+        std::vector<float> tr = createTransfer(hist, limit);
+        createBlockHistogram(I1, blockRadius, bins, cs[c0], rs[r1], hist);
+        std::vector<float> bl = createTransfer(hist, limit);
+        createBlockHistogram(I1, blockRadius, bins, cs[c1], rs[r1], hist);
+        std::vector<float> br = createTransfer(hist, limit);
+
+        int xMin = (c == 0 ? 0 : cs[c0]);
+        int xMax = (c < (int) cs.size() ? cs[c1] : (int) I1.getWidth());
+        for (int y = yMin; y < yMax; ++y) {
+          float wy = (float) (rs[r1] - y) / dr;
+          for (int x = xMin; x < xMax; ++x) {
+            float wx = (float) (cs[c1] - x) / dc;
+            int v = fastRound(I1[y][x] / 255.0f * bins);
+            float t0 = 0.0f, t1 = 0.0f;
+            if (c0 == c1) {
+              t0 = tl[v];
+              t1 = bl[v];
+            } else {
+              t0 = wx * tl[v] + (1.0f - wx) * tr[v];
+              t1 = wx * bl[v] + (1.0f - wx) * br[v];
+            }
+            float t = (r0 == r1) ? t0 : wy * t0 + (1.0f - wy) * t1;
+            I2[y][x] = (unsigned char) std::max(0, std::min(255, fastRound(t * 255.0f)));
+          }
+        }
+      }
+    }
+  }
+
+  void claheExactReference(const vpImage<unsigned char> &I1, vpImage<unsigned char> &I2, const int blockRadius,
+                           const int bins, const float slope) {
+    I2.resize(I1.getHeight(), I1.getWidth());
+    std::vector<int> hist;
+    for (int y = 0; y < (int) I1.getHeight(); y++) {
+      int yMin = std::max(0, y - blockRadius);
+      int yMax = std::min((int) I1.getHeight(), y + blockRadius + 1);
+      for (int x = 0; x < (int) I1.getWidth(); x++) {
+        int xMin = std::max(0, x - blockRadius);
+        int xMax = std::min((int) I1.getWidth(), x + blockRadius + 1);
+        createHistogram(I1, bins, xMin, xMax, yMin, yMax, hist);
+        int limit = (int) (slope * (yMax - yMin) * (xMax - xMin) / bins + 0.5f);
+        int v = fastRound(I1[y][x] / 255.0f * bins);
+        I2[y][x] = (unsigned char) fastRound(transferValue(v, hist, limit) * 255.0f);
+      }
+    }
+  }
+
+  /*
+    Noise over a gradient. Each 2x2 block holds a 0 and a 255 so that every
+    window has the two extreme bins: the transfer functions are then always
+    defined.
+  */
+  void createImage(vpUniRand &rng, unsigned int height, unsigned int width, vpImage<unsigned char> &I) {
+    I.resize(height, width);
+    for (unsigned int i = 0; i < height; i++) {
+      for (unsigned int j = 0; j < width; j++) {
+        if (i % 2 == 0 && j % 2 == 0) {
+          I[i][j] = 0;
+        } else if (i % 2 == 1 && j % 2 == 1) {
+          I[i][j] = 255;
+        } else {
+          I[i][j] = (unsigned char) std::min(255.0, (i * 3 + j * 2) % 160 + 96 * rng());
+        }
+      }
+    }
+  }
+}
+
+int main()
+{
+#ifdef VISP_HAVE_OPENMP
+  // Several threads even on a single core, to go through the split of the rows
+  omp_set_num_threads(4);
+#endif
+
+  vpUniRand rng(1234);
+  // Odd widths, and sizes that are or are not multiples of the block sizes
+  const unsigned int widths[] = {17, 33, 45};
+  const unsigned int heights[] = {16, 21, 31};
+  const int bins[] = {4, 32, 256};
+  const float slopes[] = {1.0f, 2.5f, 1000.0f};
+  unsigned int nbChecks = 0;
+
+  for (size_t s = 0; s < sizeof(widths) / sizeof(widths[0]); s++) {
+    vpImage<unsigned char> I;
+    createImage(rng, heights[s], widths[s], I);
+    const int maxRadius = ((int) std::min(widths[s], heights[s]) - 1) / 2;
+    // Small radii and radii close to the image size
+    const int radii[] = {1, 2, 5, maxRadius - 1, maxRadius};
+
+    for (size_t r = 0; r < sizeof(radii) / sizeof(radii[0]); r++) {
+      for (size_t b = 0; b < sizeof(bins) / sizeof(bins[0]); b++) {
+        for (size_t k = 0; k < sizeof(slopes) / sizeof(slopes[0]); k++) {
+          // The clip limit of the smallest window must keep at least one entry per bin
+          if (slopes[k] * (radii[r] + 1) * (radii[r] + 1) < 1.5f * bins[b]) {
+            continue;
+          }
+          for (int fast = 0; fast < 2; fast++, nbChecks++) {
+            vpImage<unsigned char> I_clahe, I_ref;
+            vp::clahe(I, I_clahe, radii[r], bins[b], slopes[k], fast == 1);
+            if (fast == 1) {
+              claheFastReference(I, I_ref, radii[r], bins[b], slopes[k]);
+            } else {
+              claheExactReference(I, I_ref, radii[r], bins[b], slopes[k]);
+            }
+            if (I_clahe != I_ref) {
+              std::cerr << "CLAHE on a " << I.getWidth() << "x" << I.getHeight() << " image, radius " << radii[r]
+                        << ", " << bins[b] << " bins, slope " << slopes[k] << ", " << (fast ? "fast" : "exact")
+                        << " mode: the output differs from the scalar reference" << std::endl;
+              return EXIT_FAILURE;
+            }
+          }
+        }
+      }
+    }
+  }
+
+  // The color version processes the three channels independently and keeps the alpha channel
+  vpImage<unsigned char> R, G, B;
+  createImage(rng, 21, 33, R);
+  createImage(rng, 21, 33, G);
+  createImage(rng, 21, 33, B);
+  vpImage<vpRGBa> I_color(21, 33), I_color_clahe;
+  for (unsigned int i = 0; i < I_color.getSize(); i++) {
+    I_color.bitmap[i] = vpRGBa(R.bitmap[i], G.bitmap[i], B.bitmap[i], (unsigned char) i);
+  }
+  for (int fast = 0; fast < 2; fast++, nbChecks++) {
+    vp::clahe(I_color, I_color_clahe, 4, 64, 3.0f, fast == 1);
+    vpImage<unsigned char> R_ref, G_ref, B_ref;
+    vp::clahe(R, R_ref, 4, 64, 3.0f, fast == 1);
+    vp::clahe(G, G_ref, 4, 64, 3.0f, fast == 1);
+    vp::clahe(B, B_ref, 4, 64, 3.0f, fast == 1);
+    vpImage<vpRGBa> I_color_ref;
+    vpImageConvert::merge(&R_ref, &G_ref, &B_ref, NULL, I_color_ref);
+    for (unsigned int i = 0; i < I_color_ref.getSize(); i++) {
+      I_color_ref.bitmap[i].A = I_color.bitmap[i].A;
+    }
+    if (I_color_clahe != I_color_ref) {
+      std::cerr << "CLAHE on a color image differs from CLAHE on each channel" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::cout << "testCLAHE is ok (" << nbChecks << " configurations)." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -56,6 +56,7 @@
 void usage(const char *name, const char *badparam, std::string ipath, std::string opath, std::string user);
 bool getOptions(int argc, const char **argv, std::string &ipath, std::string &opath, std::string user);
 bool checkLabels(const vpImage<int> &label1, const vpImage<int> &label2);
+bool checkStats(const vpImage<int> &labels, const std::vector<vp::vpConnectedComponentStats> &stats);
 
 /*
   Print the program options.
@@ -186,6 +187,46 @@ bool checkLabels(const vpImage<int> &label1, const vpImage<int> &label2) {
   return true;
 }
 
+bool checkStats(const vpImage<int> &labels, const std::vector<vp::vpConnectedComponentStats> &stats) {
+  std::vector<unsigned int> area(stats.size(), 0);
+  std::vector<double> top(stats.size()), left(stats.size()), bottom(stats.size()), right(stats.size());
+  std::vector<double> sum_i(stats.size(), 0.0), sum_j(stats.size(), 0.0);
+  for (unsigned int i = 0; i < labels.getHeight(); i++) {
+    for (unsigned int j = 0; j < labels.getWidth(); j++) {
+      if (labels[i][j] == 0)
+        continue;
+      if (labels[i][j] > (int) stats.size()) {
+        std::cerr << "labels[i][j] > stats.size()" << std::endl;
+        return false;
+      }
+
+      size_t k = (size_t) labels[i][j] - 1;
+      if (area[k] == 0) {
+        top[k] = bottom[k] = i;
+        left[k] = right[k] = j;
+      }
+      top[k] = std::min(top[k], (double) i);
+      bottom[k] = std::max(bottom[k], (double) i);
+      left[k] = std::min(left[k], (double) j);
+      right[k] = std::max(right[k], (double) j);
+      area[k]++;
+      sum_i[k] += i;
+      sum_j[k] += j;
+    }
+  }
+
+  for (size_t k = 0; k < stats.size(); k++) {
+    if (stats[k].area != area[k] || stats[k].bbox != vpRect(vpImagePoint(top[k], left[k]), vpImagePoint(bottom[k], right[k])) ||
+        std::fabs(stats[k].centroid.get_i() - sum_i[k] / area[k]) > 1e-6 ||
+        std::fabs(stats[k].centroid.get_j() - sum_j[k] / area[k]) > 1e-6) {
+      std::cerr << "Wrong statistics for the component " << k+1 << std::endl;
+      return false;
+    }
+  }
+
+  return true;
+}
+
 int
 main(int argc, const char ** argv)
 {
@@ -299,6 +340,17 @@ main(int argc, const char ** argv)
     std::cout << "Time: " << t << " ms" << std::endl;
     std::cout << "nbComponents=" << nbComponents << std::endl;
 
+    vpImage<int> labels_stats;
+    std::vector<vp::vpConnectedComponentStats> stats;
+    t = vpTime::measureTimeMs();
+    vp::connectedComponents(I, labels_stats, stats, vpImageMorphology::CONNEXITY_8);
+    t = vpTime::measureTimeMs() - t;
+    std::cout << "\n8-connexity connected components with statistics:" << std::endl;
+    std::cout << "Time: " << t << " ms" << std::endl;
+    if (!(labels_stats == labels_connex8) || (int) stats.size() != nbComponents || !checkStats(labels_stats, stats)) {
+      throw vpException(vpException::fatalError, "Wrong connected components statistics");
+    }
+
 
     //Save results
     vpImage<vpRGBa> labels_connex4_color(labels_connex4.getHeight(), labels_connex4.getWidth(), vpRGBa(0,0,0,0));
@@ -0,0 +1,250 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2017 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * Description:
+ * Test the hierarchy of the chain code contours.
+ *
+ *****************************************************************************/
+
+/*!
+  \example testContourHierarchy.cpp
+
+  Compare the parent, first child and next sibling indexes of the contours
+  extracted in a vp::vpContourChains with the vp::vpContour tree given by the
+  other vp::findContours() overload, on synthetic binary images: nested rings,
+  several islands in the same hole, shapes touching the image border and
+  random noise.
+*/
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include <visp3/core/vpUniRand.h>
+#include <visp3/imgproc/vpImgproc.h>
+
+namespace {
+  std::string toString(int index) {
+    std::ostringstream oss;
+    oss << index;
+    return oss.str();
+  }
+
+  void drawSquare(vpImage<unsigned char> &I, unsigned int top, unsigned int left, unsigned int size,
+                  unsigned char value) {
+    for (unsigned int i = top; i < top + size && i < I.getHeight(); i++) {
+      for (unsigned int j = left; j < left + size && j < I.getWidth(); j++) {
+        I[i][j] = value;
+      }
+    }
+  }
+
+  // Rings nested in each other, the innermost hole holding a row of islands
+  void createNested(unsigned int depth, unsigned int nbIslands, vpImage<unsigned char> &I) {
+    const unsigned int inner = 4 * nbIslands + 1;
+    const unsigned int size = inner + 4 * depth + 2;
+    I.resize(size, size, 0);
+    for (unsigned int k = 0; k <= depth; k++) {
+      drawSquare(I, 1 + 2 * k, 1 + 2 * k, size - 2 - 4 * k, k % 2 == 0 ? 1 : 0);
+    }
+    if (depth % 2 == 0) {
+      // The innermost square is foreground: dig a hole for the islands
+      drawSquare(I, 2 * depth + 2, 2 * depth + 2, size - 4 - 4 * depth, 0);
+    }
+    const unsigned int top = size / 2 - 1;
+    for (unsigned int n = 0; n < nbIslands; n++) {
+      drawSquare(I, top, 2 * depth + 3 + 4 * n, n % 2 == 0 ? 1 : 2, 1);
+    }
+  }
+
+  // Shapes touching the border, linked by diagonals, with holes of one pixel
+  void createBorder(vpImage<unsigned char> &I) {
+    const unsigned char data[9*11] = {
+      1, 1, 1, 0, 0, 0, 0, 0, 1, 1, 1,
+      1, 0, 1, 0, 1, 1, 1, 0, 1, 0, 1,
+      1, 1, 1, 0, 1, 0, 1, 0, 1, 1, 1,
+      0, 0, 0, 1, 1, 1, 1, 0, 0, 0, 0,
+      0, 1, 0, 0, 0, 0, 0, 1, 0, 1, 0,
+      1, 0, 1, 0, 1, 1, 0, 0, 1, 0, 1,
+      0, 1, 0, 0, 1, 1, 0, 0, 0, 1, 0,
+      1, 1, 1, 1, 0, 0, 1, 1, 1, 1, 1,
+      1, 0, 0, 1, 1, 1, 1, 0, 1, 0, 1
+    };
+    I.resize(9, 11);
+    for (unsigned int k = 0; k < I.getSize(); k++) {
+      I.bitmap[k] = data[k];
+    }
+  }
+
+  void createNoise(vpUniRand &rng, unsigned int height, unsigned int width, double density,
+                   vpImage<unsigned char> &I) {
+    I.resize(height, width);
+    for (unsigned int k = 0; k < I.getSize(); k++) {
+      I.bitmap[k] = rng() < density ? 1 : 0;
+    }
+  }
+
+  /*
+    Walk the siblings starting at first along the children of the same
+    vp::vpContour, and recursively their own children.
+  */
+  bool checkSiblings(const vp::vpContourChains &chains, const std::vector<vp::vpContour *> &children, int first,
+                     int parent, std::vector<bool> &visited, std::string &error) {
+    std::ostringstream oss;
+    std::vector<vpImagePoint> points;
+    int index = first;
+    for (size_t k = 0; k < children.size(); k++) {
+      if (index < 0 || index >= (int) chains.size()) {
+        oss << (parent < 0 ? std::string("the background") : "contour " + toString(parent)) << " has " << k
+            << " children instead of " << children.size();
+        error = oss.str();
+        return false;
+      }
+      if (visited[(size_t) index]) {
+        oss << "contour " << index << " is reached twice";
+        error = oss.str();
+        return false;
+      }
+      visited[(size_t) index] = true;
+
+      const vp::vpContourNode &node = chains.m_contours[(size_t) index];
+      const vp::vpContour &contour = *children[k];
+      if (node.m_parent != parent) {
+        oss << "contour " << index << " has the parent " << node.m_parent << " instead of " << parent;
+        error = oss.str();
+        return false;
+      }
+      if (node.m_contourType != contour.m_contourType) {
+        oss << "contour " << index << " has a wrong type";
+        error = oss.str();
+        return false;
+      }
+      chains.getPoints((unsigned int) index, points);
+      if (points != contour.m_points || contour.m_points.empty() ||
+          contour.m_points.front() != vpImagePoint(node.m_i, node.m_j)) {
+        oss << "contour " << index << " has wrong points";
+        error = oss.str();
+        return false;
+      }
+
+      if (!checkSiblings(chains, contour.m_children, node.m_firstChild, index, visited, error)) {
+        return false;
+      }
+      index = node.m_nextSibling;
+    }
+
+    if (index >= 0) {
+      oss << (parent < 0 ? std::string("the background") : "contour " + toString(parent)) << " has more than "
+          << children.size() << " children";
+      error = oss.str();
+      return false;
+    }
+    return true;
+  }
+
+  bool checkHierarchy(const vpImage<unsigned char> &I, const std::string &name) {
+    vp::vpContour tree;
+    std::vector<std::vector<vpImagePoint> > contourPts;
+    vp::findContours(I, tree, contourPts, vp::CONTOUR_RETR_TREE);
+
+    vp::vpContourChains chains;
+    vp::findContours(I, chains, vp::CONTOUR_RETR_TREE);
+
+    std::string error;
+    std::vector<bool> visited(chains.size(), false);
+    bool ok = chains.size() == contourPts.size();
+    if (!ok) {
+      std::ostringstream oss;
+      oss << chains.size() << " contours instead of " << contourPts.size();
+      error = oss.str();
+    } else {
+      // The contours without parent are the children of the background
+      ok = checkSiblings(chains, tree.m_children, chains.size() > 0 ? 0 : -1, -1, visited, error);
+    }
+    for (size_t k = 0; ok && k < visited.size(); k++) {
+      if (!visited[k]) {
+        std::ostringstream oss;
+        oss << "contour " << k << " is not reached from the roots";
+        error = oss.str();
+        ok = false;
+      }
+    }
+
+    if (!ok) {
+      std::cerr << name << " " << I.getHeight() << "x" << I.getWidth() << ": " << error << std::endl;
+    }
+    return ok;
+  }
+}
+
+int main()
+{
+  try {
+    unsigned int nbChecks = 0;
+    vpImage<unsigned char> I;
+
+    for (unsigned int depth = 0; depth < 5; depth++) {
+      for (unsigned int nbIslands = 0; nbIslands < 4; nbIslands++, nbChecks++) {
+        createNested(depth, nbIslands, I);
+        if (!checkHierarchy(I, "Nested")) {
+          return EXIT_FAILURE;
+        }
+      }
+    }
+
+    createBorder(I);
+    nbChecks++;
+    if (!checkHierarchy(I, "Border")) {
+      return EXIT_FAILURE;
+    }
+
+    vpUniRand rng(4242);
+    const unsigned int sizes[][2] = {{1, 1}, {1, 13}, {13, 1}, {2, 2}, {7, 9}, {16, 16}, {31, 47}, {64, 67}};
+    const double densities[] = {0.2, 0.5, 0.8};
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+      for (size_t d = 0; d < sizeof(densities) / sizeof(densities[0]); d++) {
+        for (unsigned int k = 0; k < 4; k++, nbChecks++) {
+          createNoise(rng, sizes[s][0], sizes[s][1], densities[d], I);
+          if (!checkHierarchy(I, "Noise")) {
+            return EXIT_FAILURE;
+          }
+        }
+      }
+    }
+
+    std::cout << "testContourHierarchy is ok (" << nbChecks << " images)." << std::endl;
+    return EXIT_SUCCESS;
+  }
+  catch(vpException &e) {
+    std::cerr << "Catch an exception: " << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+}
@@ -36,6 +36,8 @@
  *
  *****************************************************************************/
 
+#include <algorithm>
+#include <cmath>
 #include <iomanip>
 
 #include <visp3/core/vpIoTools.h>
@@ -56,6 +58,8 @@
 
 void usage(const char *name, const char *badparam, std::string ipath, std::string opath, std::string user);
 bool getOptions(int argc, const char **argv, std::string &ipath, std::string &opath, std::string user);
+bool checkApproximatedContour(const std::vector<vpImagePoint> &contour, const std::vector<vpImagePoint> &vertices,
+                              const double epsilon);
 
 /*
   Print the program options.
@@ -162,6 +166,46 @@ void printImage(const vpImage<unsigned char> &I, const std::string &name) {
   }
 }
 
+/*
+  Check a contour approximated with findContours(const vpImage<unsigned char> &, vp::vpContourChains &, const vpContourRetrievalType &, const double):
+  its vertices are contour points in the same order, starting with the first
+  point of the contour, and every contour point lies within epsilon of the
+  closed polygon.
+*/
+bool checkApproximatedContour(const std::vector<vpImagePoint> &contour, const std::vector<vpImagePoint> &vertices,
+                              const double epsilon) {
+  if (vertices.empty() || vertices.size() > contour.size() || vertices.front() != contour.front()) {
+    return false;
+  }
+
+  size_t pos = 0;
+  for (size_t v = 0; v < vertices.size(); v++, pos++) {
+    while (pos < contour.size() && contour[pos] != vertices[v]) {
+      pos++;
+    }
+    if (pos == contour.size()) {
+      return false;
+    }
+  }
+
+  for (size_t k = 0; k < contour.size(); k++) {
+    double minDist = vpImagePoint::distance(contour[k], vertices.front());
+    for (size_t v = 0; v < vertices.size(); v++) {
+      const vpImagePoint &a = vertices[v], &b = vertices[(v + 1) % vertices.size()];
+      double si = b.get_i() - a.get_i(), sj = b.get_j() - a.get_j();
+      double di = contour[k].get_i() - a.get_i(), dj = contour[k].get_j() - a.get_j();
+      double len2 = si*si + sj*sj;
+      double t = len2 > 0.0 ? std::max(0.0, std::min(1.0, (si*di + sj*dj) / len2)) : 0.0;
+      minDist = std::min(minDist, std::sqrt((di - t*si)*(di - t*si) + (dj - t*sj)*(dj - t*sj)));
+    }
+    if (minDist > epsilon + 1e-9) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
 void displayContourInfo(const vp::vpContour &contour, const int level) {
   std::cout << "\nContour:" << std::endl;
   std::cout << "\tlevel: " << level << std::endl;
@@ -367,6 +411,51 @@ main(int argc, const char ** argv)
     vpImageIo::write(I_draw_contours_external, filename);
 
 
+    //Test chain code contours
+    vp::vpContourRetrievalType retrievalModes[3] = { vp::CONTOUR_RETR_TREE, vp::CONTOUR_RETR_LIST, vp::CONTOUR_RETR_EXTERNAL };
+    for (int mode = 0; mode < 3; mode++) {
+      vp::findContours(I, vp_contours, contours, retrievalModes[mode]);
+
+      vp::vpContourChains chains;
+      t = vpTime::measureTimeMs();
+      vp::findContours(I, chains, retrievalModes[mode]);
+      t = vpTime::measureTimeMs() - t;
+      std::cout << "\nChain codes (mode " << mode << "): nb contours=" << chains.size() << " ; t=" << t << " ms" << std::endl;
+
+      if (chains.size() != contours.size()) {
+        std::cerr << "Wrong number of chain code contours: " << chains.size() << " instead of " << contours.size() << std::endl;
+        return EXIT_FAILURE;
+      }
+
+      std::vector<vpImagePoint> points;
+      for (unsigned int i = 0; i < chains.size(); i++) {
+        chains.getPoints(i, points);
+        if (points != contours[i]) {
+          std::cerr << "Wrong points for the chain code contour " << i << std::endl;
+          return EXIT_FAILURE;
+        }
+      }
+
+      //The approximated contours keep a subset of the contour points, close to all the other ones
+      const double epsilons[4] = { 0.5, 1.0, 2.0, 5.0 };
+      for (int e = 0; e < 4; e++) {
+        vp::vpContourChains polygons;
+        vp::findContours(I, polygons, retrievalModes[mode], epsilons[e]);
+        if (polygons.size() != contours.size()) {
+          std::cerr << "Wrong number of approximated contours: " << polygons.size() << " instead of " << contours.size() << std::endl;
+          return EXIT_FAILURE;
+        }
+        for (unsigned int i = 0; i < polygons.size(); i++) {
+          polygons.getPoints(i, points);
+          if (!checkApproximatedContour(contours[i], points, epsilons[e])) {
+            std::cerr << "Wrong vertices for the approximated contour " << i << " (epsilon " << epsilons[e] << ")" << std::endl;
+            return EXIT_FAILURE;
+          }
+        }
+      }
+    }
+
+
     //Test fillHoles
     vpImage<unsigned char> I_holes = I_draw_contours_external;
     vpImageTools::binarise(I_holes, (unsigned char) 127, (unsigned char) 255, (unsigned char) 0, (unsigned char) 255, (unsigned char) 255);
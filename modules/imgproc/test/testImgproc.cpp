@@ -39,9 +39,12 @@
 #include <visp3/core/vpImage.h>
 #include <visp3/io/vpImageIo.h>
 #include <visp3/io/vpParseArgv.h>
+#include <visp3/core/vpImageFilter.h>
+#include <visp3/core/vpImageTools.h>
 #include <visp3/core/vpIoTools.h>
 #include <visp3/core/vpMath.h>
 #include <visp3/imgproc/vpImgproc.h>
+#include <algorithm>
 #include <cstdlib>
 #include <cstdio>
 
@@ -56,6 +59,17 @@
 
 void usage(const char *name, const char *badparam, std::string ipath, std::string opath, std::string user);
 bool getOptions(int argc, const char **argv, std::string &ipath, std::string &opath, std::string user);
+bool checkUnsharpMask(const vpImage<unsigned char> &I);
+bool checkUnsharpMask(const vpImage<vpRGBa> &I);
+bool checkRetinex(const vpImage<vpRGBa> &I);
+void referenceAdjust(vpImage<unsigned char> &I, const double alpha, const double beta);
+void referenceChangeLUT(vpImage<unsigned char> &I, const unsigned char A, const unsigned char A_star,
+                        const unsigned char B, const unsigned char B_star);
+void referenceEqualizeHistogram(vpImage<unsigned char> &I);
+void referenceGammaCorrection(vpImage<unsigned char> &I, const double gamma);
+void referenceStretchContrast(vpImage<unsigned char> &I);
+void referenceStretchContrastHSV(vpImage<vpRGBa> &I);
+bool checkPipelineKnownValues();
 
 /*
   Print the program options.
@@ -141,6 +155,272 @@ bool getOptions(int argc, const char **argv, std::string &ipath, std::string &op
   return true;
 }
 
+/*
+  Compare the unsharp mask with a computation in floating point, for weights
+  processed in fixed point and in floating point.
+
+  \param I : Input image.
+  \return false if a pixel differs by more than one gray level.
+*/
+bool checkUnsharpMask(const vpImage<unsigned char> &I)
+{
+  const unsigned int sizes[] = {3, 7, 21};
+  const double weights[] = {0.6, 0.9, 0.99, 0.999, 0.99999};
+  for (unsigned int i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    vpImage<double> I_blurred;
+    vpImageFilter::gaussianBlur(I, I_blurred, sizes[i]);
+
+    for (unsigned int j = 0; j < sizeof(weights) / sizeof(weights[0]); j++) {
+      const double weight = weights[j];
+      vpImage<unsigned char> I_unsharp_mask;
+      vp::unsharpMask(I, I_unsharp_mask, sizes[i], weight);
+
+      for (unsigned int cpt = 0; cpt < I.getSize(); cpt++) {
+        double val = (I.bitmap[cpt] - weight*I_blurred.bitmap[cpt]) / (1 - weight);
+        if (std::abs((int) vpMath::saturate<unsigned char>(val) - (int) I_unsharp_mask.bitmap[cpt]) > 1) {
+          std::cerr << "Unsharp mask (size " << sizes[i] << ", weight " << weight
+                    << ") differs from the floating-point computation!" << std::endl;
+          return false;
+        }
+      }
+    }
+  }
+
+  return true;
+}
+
+/*
+  Compare the color unsharp mask with a computation in floating point on each
+  channel, for weights processed in fixed point and in floating point.
+
+  \param I : Input image.
+  \return false if a channel differs by more than one level or if the alpha
+  channel is modified.
+*/
+bool checkUnsharpMask(const vpImage<vpRGBa> &I)
+{
+  vpImage<unsigned char> I_R, I_G, I_B, I_A;
+  vpImageConvert::split(I, &I_R, &I_G, &I_B, &I_A);
+
+  const unsigned int sizes[] = {3, 7, 21};
+  const double weights[] = {0.6, 0.9, 0.99, 0.999, 0.99999};
+  for (unsigned int i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    vpImage<double> I_blurred_R, I_blurred_G, I_blurred_B;
+    vpImageFilter::gaussianBlur(I_R, I_blurred_R, sizes[i]);
+    vpImageFilter::gaussianBlur(I_G, I_blurred_G, sizes[i]);
+    vpImageFilter::gaussianBlur(I_B, I_blurred_B, sizes[i]);
+
+    for (unsigned int j = 0; j < sizeof(weights) / sizeof(weights[0]); j++) {
+      const double weight = weights[j];
+      vpImage<vpRGBa> I_unsharp_mask;
+      vp::unsharpMask(I, I_unsharp_mask, sizes[i], weight);
+
+      for (unsigned int cpt = 0; cpt < I.getSize(); cpt++) {
+        double val_R = (I.bitmap[cpt].R - weight*I_blurred_R.bitmap[cpt]) / (1 - weight);
+        double val_G = (I.bitmap[cpt].G - weight*I_blurred_G.bitmap[cpt]) / (1 - weight);
+        double val_B = (I.bitmap[cpt].B - weight*I_blurred_B.bitmap[cpt]) / (1 - weight);
+        if (std::abs((int) vpMath::saturate<unsigned char>(val_R) - (int) I_unsharp_mask.bitmap[cpt].R) > 1 ||
+            std::abs((int) vpMath::saturate<unsigned char>(val_G) - (int) I_unsharp_mask.bitmap[cpt].G) > 1 ||
+            std::abs((int) vpMath::saturate<unsigned char>(val_B) - (int) I_unsharp_mask.bitmap[cpt].B) > 1 ||
+            I_unsharp_mask.bitmap[cpt].A != I.bitmap[cpt].A) {
+          std::cerr << "Color unsharp mask (size " << sizes[i] << ", weight " << weight
+                    << ") differs from the floating-point computation!" << std::endl;
+          return false;
+        }
+      }
+    }
+  }
+
+  return true;
+}
+
+/*
+  Compare the retinex computed with the recursive Gaussian filter (default
+  kernel size) with the retinex computed by convolution with the kernel of
+  size min(width, height)/2 used by default before. The scale is chosen so that
+  this kernel covers the Gaussians up to four standard deviations; with the
+  default scale it truncates them.
+
+  \param I : Input image.
+  \return false if the outputs differ by more than about one gray level.
+*/
+bool checkRetinex(const vpImage<vpRGBa> &I)
+{
+  const int scale = 40;
+  int kernelSize = (int) (std::min(I.getWidth(), I.getHeight()) / 2.0);
+  kernelSize = (kernelSize - kernelSize%2) + 1;
+
+  vpImage<vpRGBa> I_recursive, I_convolution;
+  vp::retinex(I, I_recursive, scale);
+  vp::retinex(I, I_convolution, scale, 3, vp::RETINEX_UNIFORM, 1.2, kernelSize);
+
+  //The borders are replicated by the recursive filter and mirrored by the convolution
+  const unsigned int border = 20;
+  double sum = 0.0, sum_inside = 0.0;
+  unsigned int nb_inside = 0, nb_large_inside = 0;
+  for (unsigned int i = 0; i < I.getHeight(); i++) {
+    for (unsigned int j = 0; j < I.getWidth(); j++) {
+      int diff[3] = { std::abs((int) I_recursive[i][j].R - (int) I_convolution[i][j].R),
+                      std::abs((int) I_recursive[i][j].G - (int) I_convolution[i][j].G),
+                      std::abs((int) I_recursive[i][j].B - (int) I_convolution[i][j].B) };
+      bool inside = i >= border && i < I.getHeight() - border && j >= border && j < I.getWidth() - border;
+      for (unsigned int c = 0; c < 3; c++) {
+        sum += diff[c];
+        if (inside) {
+          sum_inside += diff[c];
+          nb_inside++;
+          if (diff[c] > 3) {
+            nb_large_inside++;
+          }
+        }
+      }
+    }
+  }
+
+  double mean = sum / (3.0 * I.getSize()), mean_inside = sum_inside / nb_inside;
+  double ratio_large_inside = (double) nb_large_inside / nb_inside;
+  std::cout << "Retinex recursive / convolution: mean difference " << mean << " (" << mean_inside
+            << " inside), " << 100.0 * ratio_large_inside << "% of the values inside differ by more than 3"
+            << std::endl;
+  if (mean > 2.5 || mean_inside > 1.5 || ratio_large_inside > 0.06) {
+    std::cerr << "The retinex with the recursive Gaussian filter differs from the convolution!" << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+/*
+  The reference functions below apply one point operation on a grayscale image
+  (or a channel) pixel by pixel, with the formulas of the functions replaced by
+  vp::vpPixelPipeline, so that the pipeline is not only compared to itself.
+*/
+void referenceAdjust(vpImage<unsigned char> &I, const double alpha, const double beta)
+{
+  for (unsigned int cpt = 0; cpt < I.getSize(); cpt++) {
+    I.bitmap[cpt] = vpMath::saturate<unsigned char>(alpha * I.bitmap[cpt] + beta);
+  }
+}
+
+void referenceChangeLUT(vpImage<unsigned char> &I, const unsigned char A, const unsigned char A_star,
+                        const unsigned char B, const unsigned char B_star)
+{
+  double factor = (double) (B_star - A_star) / (double) (B - A);
+  for (unsigned int cpt = 0; cpt < I.getSize(); cpt++) {
+    unsigned char v = I.bitmap[cpt];
+    if (v <= A)
+      I.bitmap[cpt] = A_star;
+    else if (v >= B)
+      I.bitmap[cpt] = B_star;
+    else
+      I.bitmap[cpt] = (unsigned char) (A_star + factor * (v - A));
+  }
+}
+
+void referenceEqualizeHistogram(vpImage<unsigned char> &I)
+{
+  unsigned int cdf[256] = {0};
+  for (unsigned int cpt = 0; cpt < I.getSize(); cpt++) {
+    cdf[I.bitmap[cpt]]++;
+  }
+  for (unsigned int x = 1; x < 256; x++) {
+    cdf[x] += cdf[x-1];
+  }
+
+  unsigned int cdfMin = 0;
+  for (unsigned int x = 0; x < 256 && cdfMin == 0; x++) {
+    cdfMin = cdf[x];
+  }
+  if (cdfMin == I.getSize()) {
+    //Only one brightness value in the image
+    return;
+  }
+
+  for (unsigned int cpt = 0; cpt < I.getSize(); cpt++) {
+    I.bitmap[cpt] = (unsigned char) vpMath::round((cdf[I.bitmap[cpt]] - cdfMin) / (double) (I.getSize() - cdfMin) * 255.0);
+  }
+}
+
+void referenceGammaCorrection(vpImage<unsigned char> &I, const double gamma)
+{
+  for (unsigned int cpt = 0; cpt < I.getSize(); cpt++) {
+    I.bitmap[cpt] = vpMath::saturate<unsigned char>(pow(I.bitmap[cpt] / 255.0, 1.0 / gamma) * 255.0);
+  }
+}
+
+void referenceStretchContrast(vpImage<unsigned char> &I)
+{
+  unsigned char min = 255, max = 0;
+  I.getMinMaxValue(min, max);
+  if (max > min) {
+    for (unsigned int cpt = 0; cpt < I.getSize(); cpt++) {
+      I.bitmap[cpt] = (unsigned char) (255 * (I.bitmap[cpt] - min) / (max - min));
+    }
+  }
+}
+
+void referenceStretchContrastHSV(vpImage<vpRGBa> &I)
+{
+  vpImage<double> H(I.getHeight(), I.getWidth()), S(I.getHeight(), I.getWidth()), V(I.getHeight(), I.getWidth());
+  vpImageConvert::RGBaToHSV((unsigned char *) I.bitmap, H.bitmap, S.bitmap, V.bitmap, I.getSize());
+
+  double minSaturation, maxSaturation, minValue, maxValue;
+  S.getMinMaxValue(minSaturation, maxSaturation);
+  V.getMinMaxValue(minValue, maxValue);
+  for (unsigned int cpt = 0; cpt < I.getSize(); cpt++) {
+    if (maxSaturation > minSaturation)
+      S.bitmap[cpt] = (S.bitmap[cpt] - minSaturation) / (maxSaturation - minSaturation);
+    if (maxValue > minValue)
+      V.bitmap[cpt] = (V.bitmap[cpt] - minValue) / (maxValue - minValue);
+  }
+
+  vpImageConvert::HSVToRGBa(H.bitmap, S.bitmap, V.bitmap, (unsigned char *) I.bitmap, I.getSize());
+}
+
+/*
+  Check the pixel pipeline on a small image whose result is computed by hand.
+
+  \return false if a pixel differs from the expected value.
+*/
+bool checkPipelineKnownValues()
+{
+  // 10, 20, 30, 40 -> adjust: 10, 30, 50, 70 -> stretch: 0, 85, 170, 255 -> gamma 2: 0, 147, 208, 255
+  vpImage<unsigned char> I(2, 2);
+  I.bitmap[0] = 10; I.bitmap[1] = 20; I.bitmap[2] = 30; I.bitmap[3] = 40;
+
+  vp::vpPixelPipeline pipeline;
+  pipeline.adjust(2.0, -10.0);
+  pipeline.stretchContrast();
+  pipeline.gammaCorrection(2.0);
+  vpImage<unsigned char> I_pipeline;
+  pipeline.apply(I, I_pipeline);
+
+  const unsigned char expected[] = {0, 147, 208, 255};
+  for (unsigned int cpt = 0; cpt < 4; cpt++) {
+    if (I_pipeline.bitmap[cpt] != expected[cpt]) {
+      std::cerr << "Pixel pipeline: pixel " << cpt << " is " << (int) I_pipeline.bitmap[cpt]
+                << " instead of " << (int) expected[cpt] << std::endl;
+      return false;
+    }
+  }
+
+  // Equalization of four distinct levels gives evenly spaced levels
+  pipeline.clear();
+  pipeline.equalizeHistogram();
+  I.bitmap[0] = 3; I.bitmap[1] = 200; I.bitmap[2] = 17; I.bitmap[3] = 90;
+  pipeline.apply(I);
+  const unsigned char expected_equalized[] = {0, 255, 85, 170};
+  for (unsigned int cpt = 0; cpt < 4; cpt++) {
+    if (I.bitmap[cpt] != expected_equalized[cpt]) {
+      std::cerr << "Pixel pipeline equalization: pixel " << cpt << " is " << (int) I.bitmap[cpt]
+                << " instead of " << (int) expected_equalized[cpt] << std::endl;
+      return false;
+    }
+  }
+
+  return true;
+}
+
 int
 main(int argc, const char ** argv)
 {
@@ -290,6 +570,11 @@ main(int argc, const char ** argv)
     filename = vpIoTools::createFilePath(opath, "Klimt_retinex.ppm");
     vpImageIo::write(I_color_retinex, filename);
 
+    //Compare the recursive Gaussian filter of the retinex with the convolution
+    if (!checkRetinex(I_color)) {
+      return EXIT_FAILURE;
+    }
+
 
     //Stretch contrast
     vpImage<vpRGBa> I_color_stretch_contrast;
@@ -326,6 +611,11 @@ main(int argc, const char ** argv)
     filename = vpIoTools::createFilePath(opath, "Klimt_unsharp_mask.ppm");
     vpImageIo::write(I_color_unsharp_mask, filename);
 
+    //Compare the color unsharp mask with a computation in floating point
+    if (!checkUnsharpMask(I_color)) {
+      return EXIT_FAILURE;
+    }
+
 
     //CLAHE
     vpImage<vpRGBa> I_color_clahe;
@@ -339,6 +629,57 @@ main(int argc, const char ** argv)
     vpImageIo::write(I_color_clahe, filename);
 
 
+    //Pixel pipeline
+    vpImage<vpRGBa> I_color_pipeline;
+    vp::vpPixelPipeline pipeline_color;
+    pipeline_color.adjust(alpha, beta);
+    pipeline_color.gammaCorrection(gamma);
+    pipeline_color.stretchContrast();
+    pipeline_color.equalizeHistogram();
+    pipeline_color.stretchContrastHSV();
+    t = vpTime::measureTimeMs();
+    pipeline_color.apply(I_color, I_color_pipeline);
+    t = vpTime::measureTimeMs() - t;
+    std::cout << "Time to do color pixel pipeline: " << t << " ms" << std::endl;
+
+    //Same operations one after the other
+    vpImage<vpRGBa> I_color_sequence;
+    vp::adjust(I_color, I_color_sequence, alpha, beta);
+    vp::gammaCorrection(I_color_sequence, gamma);
+    vp::stretchContrast(I_color_sequence);
+    vp::equalizeHistogram(I_color_sequence);
+    vp::stretchContrastHSV(I_color_sequence);
+    if (I_color_pipeline != I_color_sequence) {
+      std::cerr << "Color pixel pipeline differs from the sequence of operations!" << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    //Same operations with the reference formulas, channel by channel
+    vpImage<unsigned char> I_R, I_G, I_B, I_A;
+    vpImageConvert::split(I_color, &I_R, &I_G, &I_B, &I_A);
+    vpImage<unsigned char> *channels[] = {&I_R, &I_G, &I_B, &I_A};
+    for (unsigned int c = 0; c < 4; c++) {
+      referenceAdjust(*channels[c], alpha, beta);
+      referenceGammaCorrection(*channels[c], gamma);
+      referenceStretchContrast(*channels[c]);
+      //The alpha channel is not equalized
+      if (c < 3) {
+        referenceEqualizeHistogram(*channels[c]);
+      }
+    }
+    vpImage<vpRGBa> I_color_reference;
+    vpImageConvert::merge(&I_R, &I_G, &I_B, &I_A, I_color_reference);
+    referenceStretchContrastHSV(I_color_reference);
+    if (I_color_pipeline != I_color_reference) {
+      std::cerr << "Color pixel pipeline differs from the reference operations!" << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    //Save pipeline
+    filename = vpIoTools::createFilePath(opath, "Klimt_pipeline.ppm");
+    vpImageIo::write(I_color_pipeline, filename);
+
+
 
     //
     //Test grayscale function using image0000.pgm
@@ -413,6 +754,11 @@ main(int argc, const char ** argv)
     filename = vpIoTools::createFilePath(opath, "image0000_unsharp_mask.pgm");
     vpImageIo::write(I_unsharp_mask, filename);
 
+    //Compare the unsharp mask with a computation in floating point
+    if (!checkUnsharpMask(I)) {
+      return EXIT_FAILURE;
+    }
+
 
     //CLAHE
     vpImage<unsigned char> I_clahe;
@@ -426,6 +772,52 @@ main(int argc, const char ** argv)
     vpImageIo::write(I_clahe, filename);
 
 
+    //Pixel pipeline
+    vpImage<unsigned char> I_pipeline;
+    vp::vpPixelPipeline pipeline;
+    pipeline.adjust(alpha, beta);
+    pipeline.changeLUT(40, 20, 200, 230);
+    pipeline.gammaCorrection(gamma);
+    pipeline.stretchContrast();
+    pipeline.equalizeHistogram();
+    t = vpTime::measureTimeMs();
+    pipeline.apply(I, I_pipeline);
+    t = vpTime::measureTimeMs() - t;
+    std::cout << "Time to do grayscale pixel pipeline: " << t << " ms" << std::endl;
+
+    //Same operations one after the other
+    vpImage<unsigned char> I_sequence;
+    vp::adjust(I, I_sequence, alpha, beta);
+    vpImageTools::changeLUT(I_sequence, 40, 20, 200, 230);
+    vp::gammaCorrection(I_sequence, gamma);
+    vp::stretchContrast(I_sequence);
+    vp::equalizeHistogram(I_sequence);
+    if (I_pipeline != I_sequence) {
+      std::cerr << "Grayscale pixel pipeline differs from the sequence of operations!" << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    //Same operations with the reference formulas
+    vpImage<unsigned char> I_reference = I;
+    referenceAdjust(I_reference, alpha, beta);
+    referenceChangeLUT(I_reference, 40, 20, 200, 230);
+    referenceGammaCorrection(I_reference, gamma);
+    referenceStretchContrast(I_reference);
+    referenceEqualizeHistogram(I_reference);
+    if (I_pipeline != I_reference) {
+      std::cerr << "Grayscale pixel pipeline differs from the reference operations!" << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    if (! checkPipelineKnownValues()) {
+      return EXIT_FAILURE;
+    }
+
+    //Save pipeline
+    filename = vpIoTools::createFilePath(opath, "image0000_pipeline.pgm");
+    vpImageIo::write(I_pipeline, filename);
+
+
     return EXIT_SUCCESS;
   } catch(const vpException &e) {
     std::cerr << "Catch an exception: " << e.what() << std::endl;
@@ -0,0 +1,179 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2017 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * Description:
+ * Test morphological reconstruction against iterated geodesic dilations.
+ *
+ *****************************************************************************/
+
+/*!
+  \example testReconstruct.cpp
+
+  Compare vp::reconstruct() with the geodesic dilation of the marker under the
+  mask repeated until stability, on synthetic images: random plateaus, a
+  corridor that needs many propagation steps and markers above the mask, with
+  widths that are not multiples of 16 and both connexities.
+*/
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include <visp3/core/vpImageMorphology.h>
+#include <visp3/core/vpUniRand.h>
+#include <visp3/imgproc/vpImgproc.h>
+
+namespace {
+  // Reconstruction by dilation as it was computed before the hybrid algorithm
+  void reconstructReference(const vpImage<unsigned char> &marker, const vpImage<unsigned char> &mask,
+                            vpImage<unsigned char> &h_kp1, const vpImageMorphology::vpConnexityType &connexity) {
+    vpImage<unsigned char> h_k = marker;
+    h_kp1 = h_k;
+    do {
+      vpImageMorphology::dilatation(h_kp1, connexity);
+      for (unsigned int i = 0; i < h_kp1.getSize(); i++) {
+        h_kp1.bitmap[i] = (std::min)(h_kp1.bitmap[i], mask.bitmap[i]);
+      }
+      if (h_kp1 == h_k) {
+        break;
+      }
+      h_k = h_kp1;
+    } while (true);
+  }
+
+  // Mask made of random plateaus of a few gray levels, marker made of a few random seeds
+  void createPlateaus(vpUniRand &rng, unsigned int height, unsigned int width, vpImage<unsigned char> &marker,
+                      vpImage<unsigned char> &mask) {
+    const unsigned char levels[4] = {0, 60, 200, 255};
+    const unsigned int block = 1 + (unsigned int) (4 * rng());
+    mask.resize(height, width);
+    marker.resize(height, width, 0);
+    for (unsigned int i = 0; i < height; i++) {
+      for (unsigned int j = 0; j < width; j++) {
+        // Same level in each block, with some noise so that plateaus leak into each other
+        unsigned int seed = ((i / block) * 7919 + (j / block) * 104729) % 4;
+        mask[i][j] = rng() < 0.1 ? levels[(unsigned int) (4 * rng())] : levels[seed];
+      }
+    }
+    const unsigned int nbSeeds = 1 + (unsigned int) (4 * rng());
+    for (unsigned int k = 0; k < nbSeeds; k++) {
+      unsigned int i = (unsigned int) (height * rng()), j = (unsigned int) (width * rng());
+      marker[i][j] = (unsigned char) (256 * rng());
+    }
+  }
+
+  // Random marker and mask: the marker is above the mask at about half of the pixels
+  void createNoise(vpUniRand &rng, unsigned int height, unsigned int width, vpImage<unsigned char> &marker,
+                   vpImage<unsigned char> &mask) {
+    mask.resize(height, width);
+    marker.resize(height, width);
+    for (unsigned int i = 0; i < mask.getSize(); i++) {
+      mask.bitmap[i] = (unsigned char) (256 * rng());
+      marker.bitmap[i] = (unsigned char) (256 * rng());
+    }
+  }
+
+  /*
+    Serpentine corridor: the marker at the end of the corridor has to go back
+    and forth along the rows, which needs the queue propagation after the two
+    scans. The value of the corridor decreases along the path.
+  */
+  void createCorridor(unsigned int height, unsigned int width, bool markerAboveMask, vpImage<unsigned char> &marker,
+                      vpImage<unsigned char> &mask) {
+    mask.resize(height, width, 0);
+    marker.resize(height, width, 0);
+    unsigned int length = 0;
+    for (unsigned int i = 0; i < height; i += 2) {
+      for (unsigned int j = 0; j < width; j++) {
+        mask[i][j] = (unsigned char) (255 - (length++ % 200));
+      }
+      if (i + 1 < height) {
+        // Link to the next row alternatively on the right and on the left
+        mask[i+1][(i / 2) % 2 == 0 ? width - 1 : 0] = 100;
+      }
+    }
+    unsigned int last = height - 1 - (height - 1) % 2;
+    unsigned int j_last = ((last / 2) % 2 == 0) ? width - 1 : 0;
+    marker[last][j_last] = markerAboveMask ? 255 : mask[last][j_last];
+  }
+
+  bool checkReconstruct(const vpImage<unsigned char> &marker, const vpImage<unsigned char> &mask,
+                        const std::string &name) {
+    const vpImageMorphology::vpConnexityType connexities[2] = {vpImageMorphology::CONNEXITY_4,
+                                                               vpImageMorphology::CONNEXITY_8};
+    for (unsigned int c = 0; c < 2; c++) {
+      vpImage<unsigned char> I, I_ref;
+      vp::reconstruct(marker, mask, I, connexities[c]);
+      reconstructReference(marker, mask, I_ref, connexities[c]);
+      if (I != I_ref) {
+        std::cerr << name << " " << mask.getHeight() << "x" << mask.getWidth() << ", "
+                  << (c == 0 ? "4" : "8") << "-connexity: the reconstruction differs from the iterated dilations"
+                  << std::endl;
+        return false;
+      }
+    }
+    return true;
+  }
+}
+
+int main()
+{
+  vpUniRand rng(4242);
+  // Widths below, equal to and around multiples of 16 for the SSE2 part of the scans
+  const unsigned int widths[] = {1, 2, 7, 15, 16, 17, 31, 33, 47, 64, 67};
+  const unsigned int heights[] = {1, 2, 9, 24};
+  unsigned int nbChecks = 0;
+
+  for (size_t w = 0; w < sizeof(widths) / sizeof(widths[0]); w++) {
+    for (size_t h = 0; h < sizeof(heights) / sizeof(heights[0]); h++) {
+      vpImage<unsigned char> marker, mask;
+      for (unsigned int k = 0; k < 4; k++, nbChecks += 2) {
+        createPlateaus(rng, heights[h], widths[w], marker, mask);
+        if (! checkReconstruct(marker, mask, "Plateaus")) {
+          return EXIT_FAILURE;
+        }
+        createNoise(rng, heights[h], widths[w], marker, mask);
+        if (! checkReconstruct(marker, mask, "Noise")) {
+          return EXIT_FAILURE;
+        }
+      }
+      for (unsigned int above = 0; above < 2; above++, nbChecks++) {
+        createCorridor(heights[h], widths[w], above == 1, marker, mask);
+        if (! checkReconstruct(marker, mask, above == 1 ? "Corridor with marker above the mask" : "Corridor")) {
+          return EXIT_FAILURE;
+        }
+      }
+    }
+  }
+
+  std::cout << "testReconstruct is ok (" << nbChecks << " marker/mask pairs)." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -121,14 +121,26 @@ private:
   bool m_use_generic_name;
   std::string m_generic_name;
 
+  bool m_frame_dropping; //!< Skip the already decoded images when the consumer lags
+  unsigned int m_read_ahead_buffer_size; //!< Number of images in the read-ahead ring
+  unsigned int m_read_ahead_threads; //!< Number of decoding threads, 0 to disable read-ahead
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+  class vpReadAhead;
+  vpReadAhead *m_read_ahead; //!< Read-ahead decoding threads and ring, created on first acquisition
+#endif
+
 public:
   vpDiskGrabber();
   explicit vpDiskGrabber(const std::string &genericName);
   explicit vpDiskGrabber(const std::string &dir, const std::string &basename,
                          long number, int step, unsigned int noz,
                          const std::string &ext) ;
+  vpDiskGrabber(const vpDiskGrabber &grabber);
   virtual ~vpDiskGrabber() ;
 
+  vpDiskGrabber &operator=(const vpDiskGrabber &grabber);
+
   void acquire(vpImage<unsigned char> &I);
   void acquire(vpImage<vpRGBa> &I);
   void acquire(vpImage<float> &I) ;
@@ -143,6 +155,8 @@ public:
   */
   long getImageNumber() { return m_image_number; };
 
+  unsigned int getNbDroppedFrames() const;
+
   void open(vpImage<unsigned char> &I) ;
   void open(vpImage<vpRGBa> &I) ;
   void open(vpImage<float> &I) ;
@@ -150,10 +164,16 @@ public:
   void setBaseName(const std::string &name);
   void setDirectory(const std::string &dir);
   void setExtension(const std::string &ext);
+  void setFrameDropping(bool drop);
   void setGenericName(const std::string &genericName);
   void setImageNumber(long number) ;
   void setNumberOfZero(unsigned int noz);
+  void setReadAhead(unsigned int nbThreads, unsigned int bufferSize=0);
   void setStep(long step);
+
+private:
+  std::string getImageFileName(long number) const;
+  void stopReadAhead();
 } ;
 
 #endif
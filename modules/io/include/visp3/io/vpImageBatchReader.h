@@ -0,0 +1,142 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2017 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * Description:
+ * Read a list of images by batches decoded in parallel.
+ *
+ *****************************************************************************/
+
+/*!
+  \file vpImageBatchReader.h
+  \brief Read a list of images by batches decoded in parallel.
+*/
+
+#ifndef vpImageBatchReader_H
+#define vpImageBatchReader_H
+
+#include <string>
+#include <vector>
+
+#include <visp3/core/vpImage.h>
+#include <visp3/core/vpRGBa.h>
+
+/*!
+  \class vpImageBatchReader
+
+  \ingroup group_io_image
+
+  \brief Iterate over a list of image files which are decoded in parallel by
+  batches.
+
+  Contrary to vpImageIo::readBatch() which keeps all the images in memory,
+  this class only keeps a batch of decoded images. When all the images of
+  the batch are consumed by next(), the following files are decoded in
+  parallel with vpImageIo::read() (using OpenMP when available). Images are
+  delivered in the order of the list.
+
+  An unreadable file does not stop the iteration: next() returns true and
+  getError() gives the reason of the failure.
+
+  \code
+#include <visp3/io/vpImageBatchReader.h>
+
+int main()
+{
+  std::vector<std::string> filenames;
+  // Here the code to fill the list of files
+
+  vpImageBatchReader reader(filenames);
+  vpImage<unsigned char> I;
+  while (reader.next(I)) {
+    if (! reader.getError().empty()) {
+      std::cerr << reader.getError() << std::endl;
+      continue;
+    }
+    std::cout << "Process " << reader.getFilename() << std::endl;
+  }
+}
+  \endcode
+*/
+class VISP_EXPORT vpImageBatchReader
+{
+private:
+  std::vector<std::string> m_filenames;
+  unsigned int m_batchSize;
+  //! Index of the file delivered by the next call to next()
+  size_t m_next;
+  //! Index of the file delivered by the last call to next()
+  size_t m_current;
+  //! Range [m_begin, m_end) of the files decoded in the buffer
+  size_t m_begin;
+  size_t m_end;
+  int m_bufferType;
+  std::vector<vpImage<unsigned char> > m_grey;
+  std::vector<vpImage<vpRGBa> > m_color;
+  std::vector<vpImage<uint16_t> > m_depth;
+  std::vector<std::string> m_errors;
+  std::string m_error;
+
+public:
+  vpImageBatchReader();
+  explicit vpImageBatchReader(const std::vector<std::string> &filenames, unsigned int batchSize=0);
+
+  /*!
+    Return the number of images per batch.
+  */
+  inline unsigned int getBatchSize() const { return m_batchSize; }
+  /*!
+    Return the error message of the image given by the last call to next(),
+    or an empty string if it was read.
+  */
+  inline const std::string &getError() const { return m_error; }
+  std::string getFilename() const;
+  /*!
+    Return the index in the list of the image given by the last call to next().
+  */
+  inline size_t getIndex() const { return m_current; }
+  /*!
+    Return the number of files in the list.
+  */
+  inline size_t getNbFiles() const { return m_filenames.size(); }
+
+  bool next(vpImage<unsigned char> &I);
+  bool next(vpImage<vpRGBa> &I);
+  bool next(vpImage<uint16_t> &I);
+
+  void rewind();
+  void setBatchSize(unsigned int batchSize);
+  void setFileNames(const std::vector<std::string> &filenames);
+
+private:
+  template <class Type>
+  bool next(vpImage<Type> &I, std::vector<vpImage<Type> > &buffer, int type);
+};
+
+#endif
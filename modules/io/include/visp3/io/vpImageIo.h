@@ -52,6 +52,8 @@
 
 #include <stdio.h>
 #include <iostream>
+#include <string>
+#include <vector>
 
 #if defined(_WIN32)
 // Include WinSock2.h before windows.h to ensure that winsock.h is not included by windows.h 
@@ -78,6 +80,14 @@
   \brief Read/write images with various image format.
 
   This class has its own implementation of PGM and PPM images read/write.
+  It also implements the QOI (Quite OK Image) lossless format (*.qoi). QOI is
+  much faster to encode and decode than PNG, for a slightly lower compression
+  ratio. This makes it suited to record images at a high frame rate.
+
+  16 bits depth maps (vpImage<uint16_t>) can be saved as QOI images, as 16 bits
+  PGM P5 images or, if libpng is installed, as 16 bits PNG images. A QOI depth
+  image stores the most significant byte of each depth value in the red channel
+  and the least significant byte in the green channel.
 
   This class may benefit from optional 3rd parties:
   - libpng: If installed this optional 3rd party is used to read/write PNG images.
@@ -115,6 +125,15 @@ int main()
   This other example available in tutorial-image-reader.cpp shows how to read/write
   jpeg images. It supposes that \c libjpeg is installed.
   \include tutorial-image-reader.cpp
+
+  When libpng is used, setPNGCompression() allows to trade the compression
+  ratio of the PNG files for the encoding speed. This setting is global to the
+  process: it applies to every PNG file written afterwards, from any thread.
+  \code
+  vpImageIo::setPNGCompression(1, false); // fastest zlib level, no filtering
+  vpImageIo::write(I, "image.png");
+  vpImageIo::write(depth, "depth.qoi");   // fast lossless depth map
+  \endcode
 */
 
 class VISP_EXPORT vpImageIo
@@ -128,6 +147,7 @@ private:
     FORMAT_PPM,
     FORMAT_JPEG,
     FORMAT_PNG,
+    FORMAT_QOI,
     // Formats supported by opencv
     FORMAT_TIFF,
     FORMAT_BMP,
@@ -145,18 +165,39 @@ public:
 
   static void read(vpImage<unsigned char> &I, const std::string &filename) ;
   static void read(vpImage<vpRGBa> &I, const std::string &filename) ;
+  static void read(vpImage<uint16_t> &I, const std::string &filename) ;
   
   static void write(const vpImage<unsigned char> &I, const std::string &filename) ;
   static void write(const vpImage<vpRGBa> &I, const std::string &filename) ;
+  static void write(const vpImage<uint16_t> &I, const std::string &filename) ;
+
+  static unsigned int readBatch(std::vector<vpImage<unsigned char> > &I, const std::vector<std::string> &filenames,
+                                std::vector<std::string> &errors) ;
+  static unsigned int readBatch(std::vector<vpImage<vpRGBa> > &I, const std::vector<std::string> &filenames,
+                                std::vector<std::string> &errors) ;
+  static unsigned int readBatch(std::vector<vpImage<uint16_t> > &I, const std::vector<std::string> &filenames,
+                                std::vector<std::string> &errors) ;
+
+  static unsigned int writeBatch(const std::vector<vpImage<unsigned char> > &I, const std::vector<std::string> &filenames,
+                                 std::vector<std::string> &errors) ;
+  static unsigned int writeBatch(const std::vector<vpImage<vpRGBa> > &I, const std::vector<std::string> &filenames,
+                                 std::vector<std::string> &errors) ;
+  static unsigned int writeBatch(const std::vector<vpImage<uint16_t> > &I, const std::vector<std::string> &filenames,
+                                 std::vector<std::string> &errors) ;
 
   static void readPFM(vpImage<float> &I, const std::string &filename) ;
 
   static void readPGM(vpImage<unsigned char> &I, const std::string &filename) ;
   static void readPGM(vpImage<vpRGBa> &I, const std::string &filename) ;
+  static void readPGM(vpImage<uint16_t> &I, const std::string &filename) ;
 
   static void readPPM(vpImage<unsigned char> &I, const std::string &filename) ;
   static void readPPM(vpImage<vpRGBa> &I, const std::string &filename) ;
 
+  static void readQOI(vpImage<unsigned char> &I, const std::string &filename) ;
+  static void readQOI(vpImage<vpRGBa> &I, const std::string &filename) ;
+  static void readQOI(vpImage<uint16_t> &I, const std::string &filename) ;
+
 #if (defined(VISP_HAVE_JPEG) || defined(VISP_HAVE_OPENCV))
   static void readJPEG(vpImage<unsigned char> &I, const std::string &filename) ;
   static void readJPEG(vpImage<vpRGBa> &I, const std::string &filename) ;
@@ -166,16 +207,26 @@ public:
   static void readPNG(vpImage<unsigned char> &I, const std::string &filename) ;
   static void readPNG(vpImage<vpRGBa> &I, const std::string &filename) ;
 #endif
+#if defined(VISP_HAVE_PNG)
+  static void readPNG(vpImage<uint16_t> &I, const std::string &filename) ;
+#endif
+
+  static void setPNGCompression(int level, bool filtering=true) ;
 
   static void writePFM(const vpImage<float> &I, const std::string &filename) ;
 
   static void writePGM(const vpImage<unsigned char> &I, const std::string &filename) ;
   static void writePGM(const vpImage<short> &I, const std::string &filename) ;
   static void writePGM(const vpImage<vpRGBa> &I, const std::string &filename) ;
+  static void writePGM(const vpImage<uint16_t> &I, const std::string &filename) ;
 
   static void writePPM(const vpImage<unsigned char> &I, const std::string &filename) ;
   static void writePPM(const vpImage<vpRGBa> &I, const std::string &filename) ;
 
+  static void writeQOI(const vpImage<unsigned char> &I, const std::string &filename) ;
+  static void writeQOI(const vpImage<vpRGBa> &I, const std::string &filename) ;
+  static void writeQOI(const vpImage<uint16_t> &I, const std::string &filename) ;
+
 #if (defined(VISP_HAVE_JPEG) || defined(VISP_HAVE_OPENCV))
   static void writeJPEG(const vpImage<unsigned char> &I, const std::string &filename) ;
   static void writeJPEG(const vpImage<vpRGBa> &I, const std::string &filename) ;
@@ -185,6 +236,9 @@ public:
   static void writePNG(const vpImage<unsigned char> &I, const std::string &filename) ;
   static void writePNG(const vpImage<vpRGBa> &I, const std::string &filename) ;
 #endif
+#if defined(VISP_HAVE_PNG)
+  static void writePNG(const vpImage<uint16_t> &I, const std::string &filename) ;
+#endif
 
   } ;
 #endif
@@ -0,0 +1,212 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2017 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * Description:
+ * Single file container of raw frames.
+ *
+ *****************************************************************************/
+
+/*!
+  \file vpRawRecord.h
+  \brief Single file container of raw frames (images, depth maps, point clouds).
+*/
+
+#ifndef vpRawRecord_H
+#define vpRawRecord_H
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <visp3/core/vpColVector.h>
+#include <visp3/core/vpImage.h>
+#include <visp3/core/vpRGBa.h>
+
+/*!
+  \class vpRawRecord
+
+  \ingroup group_io_video
+
+  \brief Record and replay raw frames stored in a single file.
+
+  A recording is a single append-only file (by convention with the ".vpraw"
+  extension) that contains a sequence of frames without any compression. Each
+  frame has a type (grey level image, color image, 16 bits depth map, float
+  image or point cloud), a size, a timestamp and a stream identifier that allows
+  to interleave several sensors in the same recording, for example a color
+  image, the corresponding depth map and the point cloud.
+
+  When the recording is closed, an index of all the frames is appended at the
+  end of the file. Reading a frame by its index then needs a single seek. If
+  the index is missing, for example when the recording application was
+  interrupted, open() rebuilds it by walking through the frame headers.
+
+  Compared to a sequence of image files, there is only one file to open, and
+  no encoding or decoding is done. This makes this container suited for high
+  frame rate capture and replay.
+
+  The following example shows how to record color images with their depth map.
+  \code
+#include <visp3/core/vpTime.h>
+#include <visp3/io/vpRawRecord.h>
+
+int main()
+{
+  vpImage<vpRGBa> I(480, 640);
+  vpImage<uint16_t> depth(480, 640);
+
+  vpRawRecord record;
+  record.create("recording.vpraw");
+  for (unsigned int i = 0; i < 100; i++) {
+    // Here the code to acquire I and depth
+    double t = vpTime::measureTimeMs();
+    record.write(I, t, 0);     // stream 0: color images
+    record.write(depth, t, 1); // stream 1: depth maps
+  }
+  record.close();
+}
+  \endcode
+
+  The next example shows how to replay the recording.
+  \code
+#include <visp3/io/vpRawRecord.h>
+
+int main()
+{
+  vpImage<vpRGBa> I;
+  vpImage<uint16_t> depth;
+
+  vpRawRecord record;
+  record.open("recording.vpraw", true); // with memory mapping
+  for (unsigned int i = 0; i < record.getNbFrames(); i++) {
+    if (record.getFrameType(i) == vpRawRecord::FRAME_RGBA)
+      record.read(i, I);
+    else if (record.getFrameType(i) == vpRawRecord::FRAME_DEPTH)
+      record.read(i, depth);
+    std::cout << "Frame " << i << " of stream " << record.getStream(i)
+              << " at " << record.getTimestamp(i) << " ms" << std::endl;
+  }
+  record.close();
+}
+  \endcode
+
+  vpVideoWriter and vpVideoReader use this container when the file name has
+  the ".vpraw" extension.
+*/
+class VISP_EXPORT vpRawRecord
+{
+public:
+  //! Types of the recorded frames.
+  typedef enum
+  {
+    FRAME_GREY = 1,       //!< vpImage<unsigned char>.
+    FRAME_RGBA = 2,       //!< vpImage<vpRGBa>.
+    FRAME_DEPTH = 3,      //!< vpImage<uint16_t>.
+    FRAME_FLOAT = 4,      //!< vpImage<float>.
+    FRAME_POINTCLOUD = 5  //!< Point cloud as a vector of vpColVector.
+  } vpFrameType;
+
+private:
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+  struct vpFrameInfo
+  {
+    unsigned int type;
+    unsigned int stream;
+    unsigned int width;
+    unsigned int height;
+    double timestamp;
+    unsigned long long size;   // payload size in bytes
+    unsigned long long offset; // position of the payload in the file
+  };
+
+  vpRawRecord(const vpRawRecord &);
+  vpRawRecord &operator=(const vpRawRecord &);
+#endif
+
+  std::string m_filename;
+  bool m_writing;
+  bool m_reading;
+  std::ofstream m_ofs;
+  std::ifstream m_ifs;
+  unsigned long long m_writePos;
+  std::vector<vpFrameInfo> m_index;
+  const unsigned char *m_map;
+  unsigned long long m_mapSize;
+
+public:
+  vpRawRecord();
+  virtual ~vpRawRecord();
+
+  void close();
+  void create(const std::string &filename);
+
+  vpFrameType getFrameType(unsigned int index) const;
+  unsigned int getHeight(unsigned int index) const;
+  /*!
+    Return the number of frames in the recording.
+  */
+  inline unsigned int getNbFrames() const { return (unsigned int)m_index.size(); }
+  unsigned int getStream(unsigned int index) const;
+  double getTimestamp(unsigned int index) const;
+  unsigned int getWidth(unsigned int index) const;
+
+  /*!
+    Return true if a recording is opened for reading.
+  */
+  inline bool isOpenForReading() const { return m_reading; }
+  /*!
+    Return true if a recording is created for writing.
+  */
+  inline bool isOpenForWriting() const { return m_writing; }
+
+  void open(const std::string &filename, bool useMemoryMapping=false);
+
+  void read(unsigned int index, vpImage<unsigned char> &I);
+  void read(unsigned int index, vpImage<vpRGBa> &I);
+  void read(unsigned int index, vpImage<uint16_t> &I);
+  void read(unsigned int index, vpImage<float> &I);
+  void read(unsigned int index, std::vector<vpColVector> &pointcloud);
+
+  void write(const vpImage<unsigned char> &I, double timestamp, unsigned int stream=0);
+  void write(const vpImage<vpRGBa> &I, double timestamp, unsigned int stream=0);
+  void write(const vpImage<uint16_t> &I, double timestamp, unsigned int stream=0);
+  void write(const vpImage<float> &I, double timestamp, unsigned int stream=0);
+  void write(const std::vector<vpColVector> &pointcloud, double timestamp, unsigned int stream=0);
+
+private:
+  void checkFrameSize(unsigned int index, const vpFrameInfo &info, unsigned long long elementSize) const;
+  const vpFrameInfo &getFrameInfo(unsigned int index) const;
+  void readAt(unsigned long long offset, void *data, unsigned long long size);
+  void rebuildIndex();
+  void writeFrame(vpFrameType type, unsigned int width, unsigned int height, double timestamp,
+                  unsigned int stream, const void *data, unsigned long long size);
+};
+
+#endif
@@ -45,9 +45,12 @@
 #ifndef vpVideoReader_H
 #define vpVideoReader_H
 
+#include <list>
 #include <string>
+#include <vector>
 
 #include <visp3/io/vpDiskGrabber.h>
+#include <visp3/io/vpRawRecord.h>
 
 #if VISP_HAVE_OPENCV_VERSION >= 0x020200
 #include "opencv2/highgui/highgui.hpp"
@@ -141,6 +144,12 @@ int main()
 }
   \endcode
 
+  A recording written by vpVideoWriter or vpRawRecord in a single ".vpraw" file
+  is read like an image sequence: frame indexes start at 0 and getFrame() gives
+  a direct access to any frame. When the recording interleaves several streams
+  (color, depth, point cloud...), only the images of the stream of the first
+  recorded image are considered. The other streams can be read with vpRawRecord.
+
   Note that it is also possible to access to a specific frame using getFrame().
   \code
 #include <visp3/io/vpVideoReader.h>
@@ -161,6 +170,11 @@ int main()
   return 0;
 }
   \endcode
+
+  The indexes of the images of a sequence are found once, with a single listing
+  of the directory, when the reader is opened. Tools that go back and forth in a
+  sequence or a video can keep the last frames read by getFrame() in memory
+  with setFrameCacheSize(), so that an already decoded frame is not read again.
 */
 
 class VISP_EXPORT vpVideoReader : public vpFrameGrabber
@@ -173,6 +187,12 @@ private:
     cv::VideoCapture capture;
     cv::Mat frame;
 #endif
+    //!To read ".vpraw" recordings
+    vpRawRecord rawRecord;
+    //!Indexes in the recording of the images of the first image stream
+    std::vector<unsigned int> rawFrames;
+    //!Index of the next image acquired from the recording
+    long rawNextFrame;
     //!Types of available formats
     typedef enum
     {
@@ -196,6 +216,8 @@ private:
       FORMAT_WMV,
       FORMAT_FLV,
       FORMAT_MKV,
+      // Raw container
+      FORMAT_RAW,
       FORMAT_UNKNOWN
     } vpVideoFormatType;
 
@@ -219,6 +241,27 @@ private:
     //!The frame step
     long frameStep;
     double frameRate;
+    //!Read-ahead configuration for image sequences
+    bool frameDropping;
+    unsigned int readAheadBufferSize;
+    unsigned int readAheadThreads;
+    //!Sorted indexes of the images of the sequence, from a single directory listing
+    std::vector<long> imageIndexes;
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+    //!Frame decoded by getFrame()
+    struct vpCachedFrame
+    {
+      long index;
+      bool color;
+      vpImage<unsigned char> I;
+      vpImage<vpRGBa> Icolor;
+    };
+#endif
+    //!Last frames decoded by getFrame(), the most recently used first
+    std::list<vpCachedFrame> frameCache;
+    unsigned int frameCacheSize;
+    //!Position where the video has to be moved before the next acquire(), -1 if none
+    long videoSeekFrame;
 
 //private:
 //#ifndef DOXYGEN_SHOULD_SKIP_THIS
@@ -313,6 +356,13 @@ public:
       \return Returns the frame step value.
     */
     inline long getFrameStep() const { return frameStep;}
+    /*!
+      Return the maximum number of frames kept in memory by getFrame().
+
+      \sa setFrameCacheSize()
+    */
+    inline unsigned int getFrameCacheSize() const { return frameCacheSize; }
+    unsigned int getNbDroppedFrames() const;
     void open (vpImage< vpRGBa > &I);
     void open (vpImage< unsigned char > &I);
 
@@ -329,6 +379,8 @@ public:
     inline void resetFrameCounter() {frameCount = firstFrame;}
     void setFileName(const char *filename);
     void setFileName(const std::string &filename);
+    void setFrameCacheSize(unsigned int size);
+    void setFrameDropping(bool drop);
     /*!
       Enables to set the first frame index if you want to use the class like a grabber (ie with the
       acquire method).
@@ -364,6 +416,7 @@ public:
   inline void setFrameStep(const long frame_step) {
     this->frameStep = frame_step;
   }
+  void setReadAhead(unsigned int nbThreads, unsigned int bufferSize=0);
 
 private:
     vpVideoFormatType getFormat(const char *filename);
@@ -375,6 +428,10 @@ private:
     long extractImageIndex(const std::string &imageName, const std::string &format);
     bool checkImageNameFormat(const std::string &format);
     void getProperties();
+    void buildImageIndexes();
+    bool getCachedFrame(vpImage<unsigned char> &I, long frame_index);
+    bool getCachedFrame(vpImage<vpRGBa> &I, long frame_index);
+    void positionAfterCachedFrame(long frame_index);
 };
 
 #endif
@@ -47,6 +47,7 @@
 #include <string>
 
 #include <visp3/io/vpImageIo.h>
+#include <visp3/io/vpRawRecord.h>
 
 #if VISP_HAVE_OPENCV_VERSION >= 0x020200
 #  include <opencv2/highgui/highgui.hpp>
@@ -145,6 +146,41 @@ int main()
   return 0;
 }
   \endcode
+
+  With the ".vpraw" extension, all the frames are stored without compression
+  in a single vpRawRecord file, each frame being timestamped with
+  vpTime::measureTimeMs(). This avoids opening and closing a file per frame when
+  recording at a high frame rate. Such a recording can be read back with
+  vpVideoReader or vpRawRecord.
+
+  \code
+  writer.setFileName("./recording.vpraw");
+  writer.open(I);
+  for ( ; ; ) {
+    writer.saveFrame(I);
+  }
+  writer.close(); // writes the index of the frames
+  \endcode
+
+  When writing an image sequence, PNG or JPEG encoding and disk writes may
+  take long enough to stall the application loop. setAsyncWriting() enables
+  an asynchronous mode where saveFrame() only copies the image in a bounded
+  queue; a pool of background threads encodes and writes the queued images.
+  setAsyncPolicy() selects what saveFrame() does when the queue is full, and
+  setSyncPeriod() forces the written files to be flushed to the disk by batches.
+  close() waits until all the queued images are written.
+
+  \code
+  writer.setFileName("./image/image%04d.png");
+  writer.setAsyncWriting(4, 30); // 4 threads, up to 30 images in the queue
+  writer.setAsyncPolicy(vpVideoWriter::DROP_OLDEST_WHEN_FULL);
+  writer.open(I);
+  for ( ; ; ) {
+    writer.saveFrame(I); // does not wait for the encoding
+  }
+  writer.close();
+  std::cout << writer.getNbDroppedFrames() << " images dropped" << std::endl;
+  \endcode
 */
 
 class VISP_EXPORT vpVideoWriter
@@ -166,6 +202,8 @@ class VISP_EXPORT vpVideoWriter
       FORMAT_MPEG,
       FORMAT_MPEG4,
       FORMAT_MOV,
+      // Raw container
+      FORMAT_RAW,
       FORMAT_UNKNOWN
     } vpVideoFormatType;
 
@@ -191,6 +229,34 @@ class VISP_EXPORT vpVideoWriter
     unsigned int width;
     unsigned int height;
 
+    //!Container used with the ".vpraw" extension
+    vpRawRecord rawRecord;
+
+  public:
+    /*!
+      Behavior of saveFrame() when the queue of the asynchronous mode is full.
+    */
+    typedef enum
+    {
+      BLOCK_WHEN_FULL,       //!< Wait until an image of the queue is written.
+      DROP_NEWEST_WHEN_FULL, //!< Do not save the new image.
+      DROP_OLDEST_WHEN_FULL  //!< Remove the oldest image not yet written from the queue.
+    } vpAsyncPolicyType;
+
+  private:
+    //!Asynchronous writing configuration
+    vpAsyncPolicyType asyncPolicy;
+    unsigned int asyncQueueSize;
+    unsigned int asyncThreads;
+    unsigned int syncPeriod;
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+    class vpAsyncWriter;
+    vpAsyncWriter *asyncWriter;
+
+    vpVideoWriter(const vpVideoWriter &);
+    vpVideoWriter &operator=(const vpVideoWriter &);
+#endif
+
   public:
     vpVideoWriter();
     ~vpVideoWriter();
@@ -204,6 +270,10 @@ class VISP_EXPORT vpVideoWriter
     */
     inline unsigned int getCurrentFrameIndex() const {return frameCount;}
 
+    unsigned int getMaxQueueDepth() const;
+    unsigned int getNbDroppedFrames() const;
+    unsigned int getQueueDepth() const;
+
     void open (vpImage< vpRGBa > &I);
     void open (vpImage< unsigned char > &I);
     /*!
@@ -216,6 +286,9 @@ class VISP_EXPORT vpVideoWriter
     void saveFrame (vpImage< vpRGBa > &I);
     void saveFrame (vpImage< unsigned char > &I);
 
+    void setAsyncPolicy(const vpAsyncPolicyType &policy);
+    void setAsyncWriting(unsigned int nbThreads, unsigned int queueSize=0);
+
 #if VISP_HAVE_OPENCV_VERSION >= 0x020100
     inline void setCodec(const int fourcc_codec) {this->fourcc = fourcc_codec;}
 #endif
@@ -240,6 +313,7 @@ class VISP_EXPORT vpVideoWriter
       this->framerate = frame_rate;
     }
 #endif
+    void setSyncPeriod(unsigned int nbFrames);
 
     private:
       vpVideoFormatType getFormat(const char *filename);
@@ -0,0 +1,186 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2017 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * Description:
+ * Read a list of images by batches decoded in parallel.
+ *
+ *****************************************************************************/
+
+/*!
+  \file vpImageBatchReader.cpp
+  \brief Read a list of images by batches decoded in parallel.
+*/
+
+#include <algorithm>
+
+#include <visp3/io/vpImageBatchReader.h>
+#include <visp3/io/vpImageIo.h>
+
+#if defined(VISP_HAVE_OPENMP)
+#  include <omp.h>
+#endif
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+namespace
+{
+enum { vpBufferNone, vpBufferGrey, vpBufferColor, vpBufferDepth };
+
+unsigned int vpDefaultBatchSize()
+{
+#if defined(VISP_HAVE_OPENMP)
+  return 2 * (unsigned int)omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+}
+#endif
+
+/*!
+  Default constructor. The list of files has to be set with setFileNames().
+*/
+vpImageBatchReader::vpImageBatchReader()
+  : m_filenames(), m_batchSize(vpDefaultBatchSize()), m_next(0), m_current(0), m_begin(0), m_end(0),
+    m_bufferType(vpBufferNone), m_grey(), m_color(), m_depth(), m_errors(), m_error()
+{
+}
+
+/*!
+  Constructor.
+
+  \param filenames : Names of the image files to read, in the delivery order.
+  \param batchSize : Number of images decoded in parallel. If 0, it is set to
+  twice the number of OpenMP threads.
+*/
+vpImageBatchReader::vpImageBatchReader(const std::vector<std::string> &filenames, unsigned int batchSize)
+  : m_filenames(filenames), m_batchSize(batchSize > 0 ? batchSize : vpDefaultBatchSize()), m_next(0), m_current(0),
+    m_begin(0), m_end(0), m_bufferType(vpBufferNone), m_grey(), m_color(), m_depth(), m_errors(), m_error()
+{
+}
+
+/*!
+  Return the name of the image file given by the last call to next().
+*/
+std::string vpImageBatchReader::getFilename() const
+{
+  return (m_current < m_filenames.size()) ? m_filenames[m_current] : std::string();
+}
+
+/*!
+  Get the next grey level image of the list.
+
+  \param I : Next image. Left unchanged if the file cannot be read.
+  \return false when all the images were delivered, true otherwise. If the
+  file cannot be read, getError() is not empty.
+*/
+bool vpImageBatchReader::next(vpImage<unsigned char> &I) { return next(I, m_grey, vpBufferGrey); }
+
+/*!
+  Get the next color image of the list.
+
+  \param I : Next image. Left unchanged if the file cannot be read.
+  \return false when all the images were delivered, true otherwise. If the
+  file cannot be read, getError() is not empty.
+*/
+bool vpImageBatchReader::next(vpImage<vpRGBa> &I) { return next(I, m_color, vpBufferColor); }
+
+/*!
+  Get the next depth map of the list.
+
+  \param I : Next depth map. Left unchanged if the file cannot be read.
+  \return false when all the images were delivered, true otherwise. If the
+  file cannot be read, getError() is not empty.
+*/
+bool vpImageBatchReader::next(vpImage<uint16_t> &I) { return next(I, m_depth, vpBufferDepth); }
+
+template <class Type>
+bool vpImageBatchReader::next(vpImage<Type> &I, std::vector<vpImage<Type> > &buffer, int type)
+{
+  if (m_next >= m_filenames.size()) {
+    return false;
+  }
+
+  if (m_bufferType != type || m_next < m_begin || m_next >= m_end) {
+    // Decode the next batch
+    m_begin = m_next;
+    m_end = std::min(m_filenames.size(), m_begin + m_batchSize);
+    std::vector<std::string> filenames(m_filenames.begin() + (std::ptrdiff_t)m_begin,
+                                       m_filenames.begin() + (std::ptrdiff_t)m_end);
+    vpImageIo::readBatch(buffer, filenames, m_errors);
+    m_bufferType = type;
+  }
+
+  m_current = m_next;
+  m_next ++;
+  size_t k = m_current - m_begin;
+  m_error = m_errors[k];
+  if (m_error.empty()) {
+    // Give the decoded image without copy, keeping the display of I
+    vpDisplay *display = I.display;
+    swap(I, buffer[k]);
+    I.display = display;
+    buffer[k].display = NULL;
+  }
+  return true;
+}
+
+/*!
+  Restart the iteration from the first file of the list.
+*/
+void vpImageBatchReader::rewind()
+{
+  m_next = 0;
+  m_current = 0;
+  m_begin = m_end = 0;
+  m_bufferType = vpBufferNone;
+  m_error.clear();
+}
+
+/*!
+  Set the number of images decoded in parallel.
+
+  \param batchSize : Number of images per batch. If 0, it is set to twice
+  the number of OpenMP threads.
+*/
+void vpImageBatchReader::setBatchSize(unsigned int batchSize)
+{
+  m_batchSize = (batchSize > 0) ? batchSize : vpDefaultBatchSize();
+}
+
+/*!
+  Set the list of image files to read and restart the iteration.
+
+  \param filenames : Names of the image files to read, in the delivery order.
+*/
+void vpImageBatchReader::setFileNames(const std::vector<std::string> &filenames)
+{
+  m_filenames = filenames;
+  rewind();
+}
@@ -45,73 +45,225 @@
 #include <visp3/io/vpImageIo.h>
 #include <visp3/core/vpImageConvert.h> //image  conversion
 #include <visp3/core/vpIoTools.h>
+#include <visp3/core/vpMutex.h>
 
-void vp_decodeHeaderPNM(const std::string &filename, std::ifstream &fd, const std::string &magic,
-                     unsigned int &w, unsigned int &h, unsigned int &maxval);
+#if defined(VISP_HAVE_CPP11_COMPATIBILITY)
+#  include <atomic>
+#endif
+
+#if defined(VISP_HAVE_OPENMP)
+#  include <omp.h>
+#endif
+
+#if !defined(_WIN32) && (defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__))) // UNIX
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#  define VP_IMAGEIO_HAVE_MMAP
+#endif
 
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
-/*!
- * Decode the PNM image header.
- * \param filename[in] : File name.
- * \param fd[in] : File desdcriptor.
- * \param magic[in] : Magic number for identifying the file type.
- * \param w[out] : Image width.
- * \param h[out] : Image height.
- * \param maxval[out] : Maximum pixel value.
- */
-void vp_decodeHeaderPNM(const std::string &filename, std::ifstream &fd, const std::string &magic, unsigned int &w, unsigned int &h, unsigned int &maxval)
+/*
+  Reader of the binary PNM like files (PGM P5, PPM P6, PFM P8). On unix-like
+  systems the file is memory mapped: the header is decoded in place and the
+  payload is accessed without intermediate buffer. Otherwise the file is read
+  with an ifstream. Both cases share the same header parser.
+
+  The writers are not mapped: they already write the payload with a single
+  fwrite() from the image or from one conversion buffer, and a mapping would
+  need the file to be resized first for no saving.
+*/
+class vpPNMReader
 {
-  std::string line;
-  unsigned int nb_elt = 4, cpt_elt=0;
-  while(cpt_elt != nb_elt) {
-    // Skip empty lines or lines starting with # (comment)
-    while (std::getline(fd, line) && (line.compare(0, 1, "#") == 0 || line.size() == 0)) {};
+public:
+  vpPNMReader(const std::string &filename, const std::string &magic, unsigned int maxval_max)
+    : m_filename(filename), m_width(0), m_height(0), m_maxval(0),
+#if defined(VP_IMAGEIO_HAVE_MMAP)
+      m_data(NULL), m_size(0), m_offset(0)
+#else
+      m_fd(), m_buffer()
+#endif
+  {
+    unsigned int w_max = 100000, h_max = 100000;
+
+#if defined(VP_IMAGEIO_HAVE_MMAP)
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+      throw (vpImageException(vpImageException::ioError, "Cannot open file \"%s\"", filename.c_str())) ;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+      ::close(fd);
+      throw (vpImageException(vpImageException::ioError,
+                              "Cannot read header of file \"%s\"",  filename.c_str()));
+    }
+    m_size = (size_t)st.st_size;
+    void *data = mmap(NULL, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // the mapping remains valid
+    if (data == MAP_FAILED) {
+      throw (vpImageException(vpImageException::ioError, "Cannot map file \"%s\"", filename.c_str())) ;
+    }
+    m_data = static_cast<const unsigned char *>(data);
+#  if defined(MADV_SEQUENTIAL)
+    madvise(data, m_size, MADV_SEQUENTIAL);
+#  endif
+#else
+    m_fd.open(filename.c_str(), std::ios::binary);
+    if(! m_fd.is_open()) {
+      throw (vpImageException(vpImageException::ioError, "Cannot open file \"%s\"", filename.c_str())) ;
+    }
+#endif
+    try {
+      decodeHeader(magic);
+    }
+    catch(...) {
+      close();
+      throw;
+    }
 
-    if (fd.eof()) {
-      fd.close();
+    if (m_width > w_max || m_height > h_max) {
+      close();
+      throw(vpException(vpException::badValue, "Bad image size in \"%s\"",  filename.c_str()));
+    }
+    if (m_maxval > maxval_max) {
+      close();
       throw (vpImageException(vpImageException::ioError,
-            "Cannot read header of file \"%s\"",  filename.c_str()));
+                              "Bad maxval in \"%s\"",  filename.c_str()));
     }
+  }
 
-    std::vector<std::string> header = vpIoTools::splitChain(line, std::string(" "));
+  ~vpPNMReader()
+  {
+    close();
+  }
 
-    if(header.size() == 0) {
-      fd.close();
+  unsigned int getHeight() const { return m_height; }
+  unsigned int getMaxval() const { return m_maxval; }
+  unsigned int getWidth() const { return m_width; }
+
+  /*
+    Return a pointer to the \e nbyte bytes of the payload. The pointer is
+    valid until the reader is destroyed.
+  */
+  const unsigned char *getPayload(size_t nbyte)
+  {
+#if defined(VP_IMAGEIO_HAVE_MMAP)
+    if (m_size - m_offset < nbyte) {
       throw (vpImageException(vpImageException::ioError,
-                              "Cannot read header of file \"%s\"",  filename.c_str()));
+                              "Read only %d of %d bytes in file \"%s\"", (int)(m_size - m_offset), (int)nbyte, m_filename.c_str()));
+    }
+    return m_data + m_offset;
+#else
+    m_buffer.resize(nbyte);
+    read(nbyte > 0 ? &m_buffer[0] : NULL, nbyte);
+    return nbyte > 0 ? &m_buffer[0] : NULL;
+#endif
+  }
+
+  //! Copy the \e nbyte bytes of the payload in \e dst.
+  void read(void *dst, size_t nbyte)
+  {
+#if defined(VP_IMAGEIO_HAVE_MMAP)
+    memcpy(dst, getPayload(nbyte), nbyte);
+#else
+    m_fd.read((char *)dst, (std::streamsize)nbyte);
+    if (! m_fd) {
+      std::streamsize count = m_fd.gcount();
+      close();
+      throw (vpImageException(vpImageException::ioError,
+                              "Read only %d of %d bytes in file \"%s\"", (int)count, (int)nbyte, m_filename.c_str()));
     }
+#endif
+  }
 
-    if (cpt_elt == 0) { // decode magic
-      if (header[0].compare(0, magic.size(), magic) != 0) {
-        fd.close();
-        throw (vpImageException(vpImageException::ioError,
-                                "\"%s\" is not a PNM file with magic number %s", filename.c_str(), magic.c_str()));
-      }
-      cpt_elt ++;
-      header.erase(header.begin(), header.begin()+1); // erase first element that is processed
+private:
+  void close()
+  {
+#if defined(VP_IMAGEIO_HAVE_MMAP)
+    if (m_data != NULL) {
+      munmap(const_cast<unsigned char *>(m_data), m_size);
+      m_data = NULL;
     }
-    while(header.size()) {
-      if (cpt_elt == 1) { // decode width
-        std::istringstream ss(header[0]);
-        ss >> w;
-        cpt_elt ++;
-        header.erase(header.begin(), header.begin()+1); // erase first element that is processed
+#else
+    if (m_fd.is_open())
+      m_fd.close();
+#endif
+  }
+
+  /*
+    Decode the header: 4 elements (magic number, width, height, maxval)
+    separated by spaces, on lines that are not empty or comments. The payload
+    starts after the line of the last element.
+  */
+  void decodeHeader(const std::string &magic)
+  {
+    unsigned int nb_elt = 4, cpt_elt = 0;
+    std::string line;
+    while (cpt_elt != nb_elt) {
+      if (! getLine(line)) {
+        throw (vpImageException(vpImageException::ioError,
+                                "Cannot read header of file \"%s\"",  m_filename.c_str()));
       }
-      else if (cpt_elt == 2) { // decode height
-        std::istringstream ss(header[0]);
-        ss >> h;
-        cpt_elt ++;
-        header.erase(header.begin(), header.begin()+1); // erase first element that is processed
+      // Skip empty lines or lines starting with # (comment)
+      if (line.size() == 0 || line[0] == '#')
+        continue;
+
+      std::vector<std::string> header = vpIoTools::splitChain(line, std::string(" "));
+      if (header.size() == 0) {
+        throw (vpImageException(vpImageException::ioError,
+                                "Cannot read header of file \"%s\"",  m_filename.c_str()));
       }
-      else if (cpt_elt == 3) { // decode maxval
-        std::istringstream ss(header[0]);
-        ss >> maxval;
-        cpt_elt ++;
-        header.erase(header.begin(), header.begin()+1); // erase first element that is processed
+      for (size_t i = 0; i < header.size() && cpt_elt < nb_elt; i++, cpt_elt++) {
+        if (cpt_elt == 0) {
+          if (header[i].compare(0, magic.size(), magic) != 0) {
+            throw (vpImageException(vpImageException::ioError,
+                                    "\"%s\" is not a PNM file with magic number %s", m_filename.c_str(), magic.c_str()));
+          }
+        }
+        else {
+          std::istringstream ss(header[i]);
+          if (cpt_elt == 1)
+            ss >> m_width;
+          else if (cpt_elt == 2)
+            ss >> m_height;
+          else
+            ss >> m_maxval;
+        }
       }
     }
   }
-}
+
+  // Read the next line of the header, without the end of line. Return false at the end of the file.
+  bool getLine(std::string &line)
+  {
+#if defined(VP_IMAGEIO_HAVE_MMAP)
+    if (m_offset >= m_size)
+      return false;
+    size_t end = m_offset;
+    while (end < m_size && m_data[end] != '\n')
+      end ++;
+    line.assign((const char *)m_data + m_offset, end - m_offset);
+    m_offset = std::min(end + 1, m_size);
+    return true;
+#else
+    return ! std::getline(m_fd, line).fail();
+#endif
+  }
+
+  std::string m_filename;
+  unsigned int m_width;
+  unsigned int m_height;
+  unsigned int m_maxval;
+#if defined(VP_IMAGEIO_HAVE_MMAP)
+  const unsigned char *m_data;
+  size_t m_size;
+  size_t m_offset;
+#else
+  std::ifstream m_fd;
+  std::vector<unsigned char> m_buffer;
+#endif
+};
 #endif
 
 vpImageIo::vpImageFormatType
@@ -139,6 +291,10 @@ vpImageIo::getFormat(const std::string &filename)
     return FORMAT_PNG;
   else if (ext.compare(".png") == 0)
     return FORMAT_PNG;
+  else if (ext.compare(".QOI") == 0)
+    return FORMAT_QOI;
+  else if (ext.compare(".qoi") == 0)
+    return FORMAT_QOI;
   // Formats supported by opencv
   else if (ext.compare(".TIFF") == 0)
     return FORMAT_TIFF;
@@ -194,7 +350,7 @@ std::string vpImageIo::getExtension(const std::string &filename)
   only if the new image size is different, else we re-use the same
   memory space.
 
-  Always supported formats are *.pgm and *.ppm.
+  Always supported formats are *.pgm, *.ppm and *.qoi.
   If \c libjpeg 3rd party is used, we support also *.jpg and *.jpeg files.
   If \c libpng 3rd party is used, we support also *.png files.
   If OpenCV 3rd party is used, we support *.jpg, *.jpeg, *.jp2, *.rs, *.ras, *.tiff, *.tif, *.png, *.bmp, *.pbm files.
@@ -235,6 +391,8 @@ vpImageIo::read(vpImage<unsigned char> &I, const std::string &filename)
     try_opencv_reader = true;
 #endif
     break;
+  case FORMAT_QOI :
+    readQOI(I,final_filename); break;
   case FORMAT_TIFF :
   case FORMAT_BMP :
   case FORMAT_DIB :
@@ -278,7 +436,7 @@ vpImageIo::read(vpImage<unsigned char> &I, const std::string &filename)
   only if the new image size is different, else we re-use the same
   memory space.
 
-  Always supported formats are *.pgm and *.ppm.
+  Always supported formats are *.pgm, *.ppm and *.qoi.
   If \c libjpeg 3rd party is used, we support also *.jpg and *.jpeg files.
   If \c libpng 3rd party is used, we support also *.png files.
   If OpenCV 3rd party is used, we support *.jpg, *.jpeg, *.jp2, *.rs, *.ras, *.tiff, *.tif, *.png, *.bmp, *.pbm files.
@@ -318,6 +476,8 @@ vpImageIo::read(vpImage<vpRGBa> &I, const std::string &filename)
     try_opencv_reader = true;
 #endif
     break;
+  case FORMAT_QOI :
+    readQOI(I,final_filename); break;
   case FORMAT_TIFF :
   case FORMAT_BMP :
   case FORMAT_DIB :
@@ -357,7 +517,7 @@ vpImageIo::read(vpImage<vpRGBa> &I, const std::string &filename)
   Write the content of the image in the file which name is given by \e
   filename.
 
-  Always supported formats are *.pgm and *.ppm.
+  Always supported formats are *.pgm, *.ppm and *.qoi.
   If \c libjpeg 3rd party is used, we support also *.jpg and *.jpeg files.
   If \c libpng 3rd party is used, we support also *.png files.
   If OpenCV 3rd party is used, we support *.jpg, *.jpeg, *.jp2, *.rs, *.ras, *.tiff, *.tif, *.png, *.bmp, *.pbm files.
@@ -389,6 +549,8 @@ vpImageIo::write(const vpImage<unsigned char> &I, const std::string &filename)
     try_opencv_writer = true;
 #endif
     break;
+  case FORMAT_QOI :
+    writeQOI(I,filename); break;
   case FORMAT_TIFF :
   case FORMAT_BMP :
   case FORMAT_DIB :
@@ -418,7 +580,7 @@ vpImageIo::write(const vpImage<unsigned char> &I, const std::string &filename)
   Write the content of the image in the file which name is given by \e
   filename.
 
-  Always supported formats are *.pgm and *.ppm.
+  Always supported formats are *.pgm, *.ppm and *.qoi.
   If \c libjpeg 3rd party is used, we support also *.jpg and *.jpeg files.
   If \c libpng 3rd party is used, we support also *.png files.
   If OpenCV 3rd party is used, we support *.jpg, *.jpeg, *.jp2, *.rs, *.ras, *.tiff, *.tif, *.png, *.bmp, *.pbm files.
@@ -450,6 +612,8 @@ vpImageIo::write(const vpImage<vpRGBa> &I, const std::string &filename)
     try_opencv_writer = true;
 #endif
     break;
+  case FORMAT_QOI :
+    writeQOI(I,filename); break;
   case FORMAT_TIFF :
   case FORMAT_BMP :
   case FORMAT_DIB :
@@ -475,6 +639,76 @@ vpImageIo::write(const vpImage<vpRGBa> &I, const std::string &filename)
   }
 }
 
+/*!
+  Read the contents of the depth map file, allocate memory for the
+  corresponding image, update its content, and return a reference to the image.
+
+  If the image has been already initialized, memory allocation is done
+  only if the new image size is different, else we re-use the same
+  memory space.
+
+  Supported formats are *.pgm (16 bits PGM P5) and *.qoi.
+  If \c libpng 3rd party is used, we support also 16 bits *.png files.
+
+  \param I : Depth map to set with the \e filename content.
+  \param filename : Name of the file containing the image.
+ */
+void
+vpImageIo::read(vpImage<uint16_t> &I, const std::string &filename)
+{
+  bool exist = vpIoTools::checkFilename(filename);
+  if (!exist) {
+    std::string message = "Cannot read file: \"" + std::string(filename) + "\" doesn't exist";
+    throw (vpImageException(vpImageException::ioError, message));
+  }
+  //Allows to use ~ symbol or env variables in path
+  std::string final_filename = vpIoTools::path(filename);
+
+  switch(getFormat(final_filename)){
+  case FORMAT_PGM :
+    readPGM(I,final_filename); break;
+  case FORMAT_QOI :
+    readQOI(I,final_filename); break;
+#if defined(VISP_HAVE_PNG)
+  case FORMAT_PNG :
+    readPNG(I,final_filename); break;
+#endif
+  default: {
+    std::string message = "Cannot read file \"" + std::string(final_filename) + "\": Image format not supported for depth maps";
+    throw (vpImageException(vpImageException::ioError, message)) ;
+  }
+  }
+}
+
+/*!
+  Write the content of the depth map in the file which name is given by \e
+  filename.
+
+  Supported formats are *.pgm (16 bits PGM P5) and *.qoi. QOI is the fastest
+  lossless format.
+  If \c libpng 3rd party is used, we support also 16 bits *.png files.
+
+  \param I : Depth map to write.
+  \param filename : Name of the file containing the image.
+ */
+void
+vpImageIo::write(const vpImage<uint16_t> &I, const std::string &filename)
+{
+  switch(getFormat(filename)){
+  case FORMAT_PGM :
+    writePGM(I,filename); break;
+  case FORMAT_QOI :
+    writeQOI(I,filename); break;
+#if defined(VISP_HAVE_PNG)
+  case FORMAT_PNG :
+    writePNG(I,filename); break;
+#endif
+  default:
+    throw (vpImageException(vpImageException::ioError,
+                            "Cannot write file: Image format not supported for depth maps")) ;
+  }
+}
+
 //--------------------------------------------------------------------------
 // PFM
 //--------------------------------------------------------------------------
@@ -598,6 +832,55 @@ vpImageIo::writePGM(const vpImage<short> &I, const std::string &filename)
 
   vpImageIo::writePGM(Iuc, filename) ;
 }
+/*!
+  Write the content of the depth map in a 16 bits portable gray pixmap (PGM P5)
+  file, with a maximum value of 65535. Each value is stored on two bytes, most
+  significant byte first.
+
+  \param I : Image to save as a (PGM P5) file.
+  \param filename : Name of the file containing the image.
+*/
+void
+vpImageIo::writePGM(const vpImage<uint16_t> &I, const std::string &filename)
+{
+  FILE* fd;
+
+  // Test the filename
+  if (filename.empty())   {
+    throw (vpImageException(vpImageException::ioError,
+           "Cannot create PGM file: filename empty")) ;
+  }
+
+  fd = fopen(filename.c_str(), "wb");
+
+  if (fd == NULL) {
+    throw (vpImageException(vpImageException::ioError,
+           "Cannot create PGM file \"%s\"", filename.c_str())) ;
+  }
+
+  // Write the head
+  fprintf(fd, "P5\n");					// Magic number
+  fprintf(fd, "%u %u\n", I.getWidth(), I.getHeight());	// Image size
+  fprintf(fd, "65535\n");				// Max level
+
+  size_t n = I.getSize();
+  std::vector<unsigned char> buffer(2 * n);
+  for (size_t i = 0; i < n; i++) {
+    buffer[2*i] = (unsigned char)(I.bitmap[i] >> 8);
+    buffer[2*i+1] = (unsigned char)(I.bitmap[i] & 0xff);
+  }
+
+  size_t ierr = (n > 0) ? fwrite(&buffer[0], 1, buffer.size(), fd) : 0;
+  if (ierr != buffer.size()) {
+    fclose(fd);
+    throw (vpImageException(vpImageException::ioError,
+           "Cannot write PGM file \"%s\"", filename.c_str())) ;
+  }
+
+  fflush(fd);
+  fclose(fd);
+}
+
 /*!
   Write the content of the image bitmap in the file which name is given by \e
   filename. This function writes a portable gray pixmap (PGM P5) file.
@@ -668,43 +951,14 @@ vpImageIo::writePGM(const vpImage<vpRGBa> &I, const std::string &filename)
 void
 vpImageIo::readPFM(vpImage<float> &I, const std::string &filename)
 {
-  unsigned int w=0, h=0, maxval=0;
-  unsigned int w_max = 100000, h_max = 100000, maxval_max = 255;
-  std::string magic("P8");
-
-  std::ifstream fd(filename.c_str(), std::ios::binary);
-
-  // Open the filename
-  if(! fd.is_open()) {
-    throw (vpImageException(vpImageException::ioError, "Cannot open file \"%s\"", filename.c_str())) ;
-  }
-
-  vp_decodeHeaderPNM(filename, fd, magic, w, h, maxval);
-
-  if (w > w_max || h > h_max) {
-    fd.close();
-    throw(vpException(vpException::badValue, "Bad image size in \"%s\"",  filename.c_str()));
-  }
-  if (maxval > maxval_max)
-  {
-    fd.close();
-    throw (vpImageException(vpImageException::ioError,
-                            "Bad maxval in \"%s\"",  filename.c_str()));
-  }
+  vpPNMReader reader(filename, "P8", 255);
 
+  unsigned int h = reader.getHeight(), w = reader.getWidth();
   if ((h != I.getHeight())||( w != I.getWidth())) {
     I.resize(h,w) ;
   }
 
-  unsigned int nbyte = I.getHeight()*I.getWidth();
-  fd.read ((char *)I.bitmap, sizeof(float) * nbyte);
-  if (! fd) {
-    fd.close();
-    throw (vpImageException(vpImageException::ioError,
-                            "Read only %d of %d bytes in file \"%s\"", fd.gcount(), nbyte, filename.c_str()));
-  }
-
-  fd.close();
+  reader.read(I.bitmap, sizeof(float) * I.getSize());
 }
 
 
@@ -726,43 +980,14 @@ vpImageIo::readPFM(vpImage<float> &I, const std::string &filename)
 void
 vpImageIo::readPGM(vpImage<unsigned char> &I, const std::string &filename)
 {
-  unsigned int w=0, h=0, maxval=0;
-  unsigned int w_max = 100000, h_max = 100000, maxval_max = 255;
-  std::string magic("P5");
-
-  std::ifstream fd(filename.c_str(), std::ios::binary);
-
-  // Open the filename
-  if(! fd.is_open()) {
-    throw (vpImageException(vpImageException::ioError, "Cannot open file \"%s\"", filename.c_str())) ;
-  }
-
-  vp_decodeHeaderPNM(filename, fd, magic, w, h, maxval);
-
-  if (w > w_max || h > h_max) {
-    fd.close();
-    throw(vpException(vpException::badValue, "Bad image size in \"%s\"",  filename.c_str()));
-  }
-  if (maxval > maxval_max)
-  {
-    fd.close();
-    throw (vpImageException(vpImageException::ioError,
-                            "Bad maxval in \"%s\"",  filename.c_str()));
-  }
+  vpPNMReader reader(filename, "P5", 255);
 
+  unsigned int h = reader.getHeight(), w = reader.getWidth();
   if ((h != I.getHeight())||( w != I.getWidth())) {
     I.resize(h,w) ;
   }
 
-  unsigned int nbyte = I.getHeight()*I.getWidth();
-  fd.read ((char *)I.bitmap, nbyte);
-  if (! fd) {
-    fd.close();
-    throw (vpImageException(vpImageException::ioError,
-                            "Read only %d of %d bytes in file \"%s\"", fd.gcount(), nbyte, filename.c_str()));
-  }
-
-  fd.close();
+  reader.read(I.bitmap, I.getSize());
 }
 
 /*!
@@ -793,6 +1018,43 @@ vpImageIo::readPGM(vpImage<vpRGBa> &I, const std::string &filename)
   vpImageConvert::convert(Itmp, I) ;
 }
 
+/*!
+  Read a 16 bits PGM P5 file, for example a depth map.
+
+  Following the PGM specification, when the maximum value of the file is
+  greater than 255 each value is stored on two bytes, most significant byte
+  first. Otherwise each value is stored on one byte.
+
+  If the image has been already initialized, memory allocation is done
+  only if the new image size is different, else we re-use the same
+  memory space.
+
+  \param I : Image to set with the \e filename content.
+  \param filename : Name of the file containing the image.
+*/
+void
+vpImageIo::readPGM(vpImage<uint16_t> &I, const std::string &filename)
+{
+  vpPNMReader reader(filename, "P5", 65535);
+
+  unsigned int h = reader.getHeight(), w = reader.getWidth();
+  if ((h != I.getHeight())||( w != I.getWidth())) {
+    I.resize(h,w) ;
+  }
+
+  unsigned int n = I.getSize();
+  if (reader.getMaxval() > 255) {
+    const unsigned char *src = reader.getPayload(2 * (size_t)n);
+    for (unsigned int i = 0; i < n; i++)
+      I.bitmap[i] = (uint16_t)((src[2*i] << 8) | src[2*i+1]);
+  }
+  else {
+    const unsigned char *src = reader.getPayload(n);
+    for (unsigned int i = 0; i < n; i++)
+      I.bitmap[i] = src[i];
+  }
+}
+
 
 //--------------------------------------------------------------------------
 // PPM
@@ -839,54 +1101,16 @@ vpImageIo::readPPM(vpImage<unsigned char> &I, const std::string &filename)
 void
 vpImageIo::readPPM(vpImage<vpRGBa> &I, const std::string &filename)
 {
-  unsigned int w=0, h=0, maxval=0;
-  unsigned int w_max = 100000, h_max = 100000, maxval_max = 255;
-  std::string magic("P6");
-
-  std::ifstream fd(filename.c_str(), std::ios::binary);
-
-  // Open the filename
-  if(! fd.is_open()) {
-    throw (vpImageException(vpImageException::ioError, "Cannot open file \"%s\"", filename.c_str())) ;
-  }
-
-  vp_decodeHeaderPNM(filename, fd, magic, w, h, maxval);
-
-  if (w > w_max || h > h_max) {
-    fd.close();
-    throw(vpException(vpException::badValue, "Bad image size in \"%s\"",  filename.c_str()));
-  }
-  if (maxval > maxval_max)
-  {
-    fd.close();
-    throw (vpImageException(vpImageException::ioError,
-                            "Bad maxval in \"%s\"",  filename.c_str()));
-  }
+  vpPNMReader reader(filename, "P6", 255);
 
+  unsigned int h = reader.getHeight(), w = reader.getWidth();
   if ((h != I.getHeight())||( w != I.getWidth())) {
     I.resize(h,w) ;
   }
 
-  for(unsigned int i=0;i<I.getHeight();i++) {
-    for(unsigned int j=0;j<I.getWidth();j++) {
-      unsigned char rgb[3];
-      fd.read((char *)&rgb, 3);
-
-      if (! fd) {
-        fd.close();
-        throw (vpImageException(vpImageException::ioError,
-                                "Read only %d of %d bytes in file \"%s\"",
-                                (i*I.getWidth() + j)*3 + fd.gcount(), I.getSize()*3, filename.c_str()));
-      }
-
-      I[i][j].R = rgb[0];
-      I[i][j].G = rgb[1];
-      I[i][j].B = rgb[2];
-      I[i][j].A = vpRGBa::alpha_default;
-    }
-  }
-
-  fd.close();
+  // Convert the whole RGB payload at once
+  const unsigned char *rgb = reader.getPayload(3 * (size_t)I.getSize());
+  vpImageConvert::RGBToRGBa(const_cast<unsigned char *>(rgb), (unsigned char *)I.bitmap, I.getSize());
 }
 
 /*!
@@ -939,22 +1163,16 @@ vpImageIo::writePPM(const vpImage<vpRGBa> &I, const std::string &filename)
   fprintf(f,"%u %u\n", I.getWidth(), I.getHeight());	// Image size
   fprintf(f,"%d\n", 255);	        	// Max level
 
-  for(unsigned int i=0;i<I.getHeight();i++)
-  {
-    for(unsigned int j=0;j<I.getWidth();j++)
-    {
-      vpRGBa v = I[i][j];
-      unsigned char rgb[3];
-      rgb[0] = v.R;
-      rgb[1] = v.G;
-      rgb[2] = v.B;
-
-      size_t res = fwrite(&rgb, 1, 3, f);
-      if (res != 3) {
-        fclose(f);
-        throw (vpImageException(vpImageException::ioError,
-                                "cannot write file \"%s\"", filename.c_str())) ;
-      }
+  // Convert the whole image to RGB and write it at once
+  size_t nbyte = 3 * (size_t)I.getSize();
+  std::vector<unsigned char> rgb(nbyte);
+  if (nbyte > 0) {
+    vpImageConvert::RGBaToRGB((unsigned char *)I.bitmap, &rgb[0], I.getSize());
+    size_t res = fwrite(&rgb[0], 1, nbyte, f);
+    if (res != nbyte) {
+      fclose(f);
+      throw (vpImageException(vpImageException::ioError,
+                              "cannot write file \"%s\"", filename.c_str())) ;
     }
   }
 
@@ -963,43 +1181,400 @@ vpImageIo::writePPM(const vpImage<vpRGBa> &I, const std::string &filename)
 }
 
 //--------------------------------------------------------------------------
-// JPEG
+// QOI
 //--------------------------------------------------------------------------
 
-#if defined(VISP_HAVE_JPEG)
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+/*
+  Implementation of the QOI (Quite OK Image) format specification 1.0,
+  https://qoiformat.org. Pixels are exchanged with the codec as RGBA quads
+  through small adapters, so that grey level images and depth maps are encoded
+  without intermediate color image.
+*/
+namespace
+{
+const unsigned int vpQoiHeaderSize = 14;
+const unsigned char vpQoiPadding[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
 
-/*!
-  Write the content of the image bitmap in the file which name is given by \e
-  filename. This function writes a JPEG file.
+inline unsigned int vpQoiHash(const unsigned char *px)
+{
+  return (px[0] * 3u + px[1] * 5u + px[2] * 7u + px[3] * 11u) % 64u;
+}
 
-  \param I : Image to save as a JPEG file.
-  \param filename : Name of the file containing the image.
-*/
-void
-vpImageIo::writeJPEG(const vpImage<unsigned char> &I, const std::string &filename)
+struct vpQoiGreyAdapter
 {
-  struct jpeg_compress_struct cinfo;
-  struct jpeg_error_mgr jerr;
-  FILE *file;
+  static void get(const unsigned char *src, unsigned char *px) { px[0] = px[1] = px[2] = *src; px[3] = 255; }
+};
 
-  cinfo.err = jpeg_std_error(&jerr);
-  jpeg_create_compress(&cinfo);
+struct vpQoiRGBaAdapter
+{
+  static void get(const vpRGBa *src, unsigned char *px) { px[0] = src->R; px[1] = src->G; px[2] = src->B; px[3] = src->A; }
+  static void set(const unsigned char *px, vpRGBa *dst) { dst->R = px[0]; dst->G = px[1]; dst->B = px[2]; dst->A = px[3]; }
+};
 
-  // Test the filename
-  if (filename.empty())   {
-     throw (vpImageException(vpImageException::ioError,
-           "Cannot create JPEG file: filename empty")) ;
+struct vpQoiDepthAdapter
+{
+  static void get(const uint16_t *src, unsigned char *px)
+  {
+    px[0] = (unsigned char)(*src >> 8); px[1] = (unsigned char)(*src & 0xff); px[2] = 0; px[3] = 255;
   }
+  static void set(const unsigned char *px, uint16_t *dst) { *dst = (uint16_t)((px[0] << 8) | px[1]); }
+};
 
-  file = fopen(filename.c_str(), "wb");
+template <class Adapter, class Type>
+void vpQoiEncode(const Type *src, unsigned int width, unsigned int height, unsigned char channels,
+                 std::vector<unsigned char> &out)
+{
+  size_t npix = (size_t)width * height;
+  out.resize(vpQoiHeaderSize + npix * (channels + 1) + sizeof(vpQoiPadding));
+  unsigned char *p = &out[0];
+
+  memcpy(p, "qoif", 4);
+  p[4] = (unsigned char)(width >> 24); p[5] = (unsigned char)(width >> 16);
+  p[6] = (unsigned char)(width >> 8); p[7] = (unsigned char)width;
+  p[8] = (unsigned char)(height >> 24); p[9] = (unsigned char)(height >> 16);
+  p[10] = (unsigned char)(height >> 8); p[11] = (unsigned char)height;
+  p[12] = channels;
+  p[13] = 0; // sRGB with linear alpha
+  p += vpQoiHeaderSize;
+
+  unsigned char index[64][4];
+  memset(index, 0, sizeof(index));
+  unsigned char prev[4] = { 0, 0, 0, 255 };
+  unsigned char px[4];
+  unsigned int run = 0;
+
+  for (size_t i = 0; i < npix; i++) {
+    Adapter::get(src + i, px);
+    if (memcmp(px, prev, 4) == 0) {
+      run++;
+      if (run == 62 || i + 1 == npix) {
+        *p++ = (unsigned char)(0xc0 | (run - 1)); // QOI_OP_RUN
+        run = 0;
+      }
+      continue;
+    }
+    if (run > 0) {
+      *p++ = (unsigned char)(0xc0 | (run - 1));
+      run = 0;
+    }
 
-  if (file == NULL) {
-    throw (vpImageException(vpImageException::ioError,
-                            "Cannot create JPEG file \"%s\"", filename.c_str())) ;
+    unsigned int h = vpQoiHash(px);
+    if (memcmp(index[h], px, 4) == 0) {
+      *p++ = (unsigned char)h; // QOI_OP_INDEX
+    }
+    else {
+      memcpy(index[h], px, 4);
+      if (px[3] == prev[3]) {
+        signed char vr = (signed char)(px[0] - prev[0]);
+        signed char vg = (signed char)(px[1] - prev[1]);
+        signed char vb = (signed char)(px[2] - prev[2]);
+        signed char vg_r = (signed char)(vr - vg);
+        signed char vg_b = (signed char)(vb - vg);
+        if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2) {
+          *p++ = (unsigned char)(0x40 | ((vr + 2) << 4) | ((vg + 2) << 2) | (vb + 2)); // QOI_OP_DIFF
+        }
+        else if (vg_r > -9 && vg_r < 8 && vg > -33 && vg < 32 && vg_b > -9 && vg_b < 8) {
+          *p++ = (unsigned char)(0x80 | (vg + 32)); // QOI_OP_LUMA
+          *p++ = (unsigned char)(((vg_r + 8) << 4) | (vg_b + 8));
+        }
+        else {
+          *p++ = 0xfe; // QOI_OP_RGB
+          *p++ = px[0]; *p++ = px[1]; *p++ = px[2];
+        }
+      }
+      else {
+        *p++ = 0xff; // QOI_OP_RGBA
+        *p++ = px[0]; *p++ = px[1]; *p++ = px[2]; *p++ = px[3];
+      }
+    }
+    memcpy(prev, px, 4);
   }
 
-  unsigned int width = I.getWidth();
-  unsigned int height = I.getHeight();
+  memcpy(p, vpQoiPadding, sizeof(vpQoiPadding));
+  p += sizeof(vpQoiPadding);
+  out.resize((size_t)(p - &out[0]));
+}
+
+template <class Adapter, class Type>
+void vpQoiDecode(const unsigned char *data, size_t size, Type *dst, size_t npix)
+{
+  unsigned char index[64][4];
+  memset(index, 0, sizeof(index));
+  unsigned char px[4] = { 0, 0, 0, 255 };
+  unsigned int run = 0;
+  size_t p = vpQoiHeaderSize;
+  size_t end = size - sizeof(vpQoiPadding);
+
+  for (size_t i = 0; i < npix; i++) {
+    if (run > 0) {
+      run--;
+    }
+    else if (p < end) {
+      unsigned char b1 = data[p++];
+      if (b1 == 0xfe) { // QOI_OP_RGB
+        if (p + 3 > end)
+          throw (vpImageException(vpImageException::ioError, "Truncated QOI data"));
+        px[0] = data[p]; px[1] = data[p + 1]; px[2] = data[p + 2];
+        p += 3;
+      }
+      else if (b1 == 0xff) { // QOI_OP_RGBA
+        if (p + 4 > end)
+          throw (vpImageException(vpImageException::ioError, "Truncated QOI data"));
+        px[0] = data[p]; px[1] = data[p + 1]; px[2] = data[p + 2]; px[3] = data[p + 3];
+        p += 4;
+      }
+      else if ((b1 & 0xc0) == 0x00) { // QOI_OP_INDEX
+        memcpy(px, index[b1], 4);
+      }
+      else if ((b1 & 0xc0) == 0x40) { // QOI_OP_DIFF
+        px[0] = (unsigned char)(px[0] + ((b1 >> 4) & 0x03) - 2);
+        px[1] = (unsigned char)(px[1] + ((b1 >> 2) & 0x03) - 2);
+        px[2] = (unsigned char)(px[2] + (b1 & 0x03) - 2);
+      }
+      else if ((b1 & 0xc0) == 0x80) { // QOI_OP_LUMA
+        if (p + 1 > end)
+          throw (vpImageException(vpImageException::ioError, "Truncated QOI data"));
+        unsigned char b2 = data[p++];
+        int vg = (b1 & 0x3f) - 32;
+        px[0] = (unsigned char)(px[0] + vg - 8 + ((b2 >> 4) & 0x0f));
+        px[1] = (unsigned char)(px[1] + vg);
+        px[2] = (unsigned char)(px[2] + vg - 8 + (b2 & 0x0f));
+      }
+      else { // QOI_OP_RUN
+        run = (b1 & 0x3f);
+      }
+      memcpy(index[vpQoiHash(px)], px, 4);
+    }
+    else {
+      throw (vpImageException(vpImageException::ioError, "Truncated QOI data"));
+    }
+    Adapter::set(px, dst + i);
+  }
+}
+
+void vpQoiWriteFile(const std::vector<unsigned char> &buffer, const std::string &filename)
+{
+  if (filename.empty()) {
+    throw (vpImageException(vpImageException::ioError, "Cannot create QOI file: filename empty")) ;
+  }
+  FILE *f = fopen(filename.c_str(), "wb");
+  if (f == NULL) {
+    throw (vpImageException(vpImageException::ioError, "Cannot create QOI file \"%s\"", filename.c_str())) ;
+  }
+  size_t res = fwrite(&buffer[0], 1, buffer.size(), f);
+  fclose(f);
+  if (res != buffer.size()) {
+    throw (vpImageException(vpImageException::ioError, "Cannot write file \"%s\"", filename.c_str())) ;
+  }
+}
+
+// Read the whole file and decode the QOI header
+void vpQoiReadFile(const std::string &filename, std::vector<unsigned char> &buffer, unsigned int &width,
+                   unsigned int &height)
+{
+  std::ifstream fd(filename.c_str(), std::ios::binary);
+  if (!fd.is_open()) {
+    throw (vpImageException(vpImageException::ioError, "Cannot open file \"%s\"", filename.c_str())) ;
+  }
+  fd.seekg(0, std::ios::end);
+  std::streamoff size = fd.tellg();
+  fd.seekg(0, std::ios::beg);
+  if (size < (std::streamoff)(vpQoiHeaderSize + sizeof(vpQoiPadding))) {
+    throw (vpImageException(vpImageException::ioError, "\"%s\" is not a QOI file", filename.c_str()));
+  }
+  buffer.resize((size_t)size);
+  fd.read((char *)&buffer[0], size);
+  if (!fd) {
+    throw (vpImageException(vpImageException::ioError, "Cannot read file \"%s\"", filename.c_str()));
+  }
+
+  const unsigned char *p = &buffer[0];
+  width = ((unsigned int)p[4] << 24) | ((unsigned int)p[5] << 16) | ((unsigned int)p[6] << 8) | p[7];
+  height = ((unsigned int)p[8] << 24) | ((unsigned int)p[9] << 16) | ((unsigned int)p[10] << 8) | p[11];
+  if (memcmp(p, "qoif", 4) != 0 || (p[12] != 3 && p[12] != 4)) {
+    throw (vpImageException(vpImageException::ioError, "\"%s\" is not a QOI file", filename.c_str()));
+  }
+  // A byte of the payload encodes at most 62 pixels (QOI_OP_RUN): a larger image
+  // is a truncated or corrupted file, which must not lead to a huge allocation
+  unsigned long long payload = (unsigned long long)buffer.size() - vpQoiHeaderSize - sizeof(vpQoiPadding);
+  if (width > 100000 || height > 100000 || (unsigned long long)width * height > 62 * payload) {
+    throw (vpImageException(vpImageException::ioError, "Bad image size in \"%s\"", filename.c_str()));
+  }
+}
+}
+#endif
+
+/*!
+  Write the content of the grey level image in a QOI file. The grey level is
+  copied in the three color channels.
+
+  \param I : Image to save as a QOI file.
+  \param filename : Name of the file containing the image.
+*/
+void
+vpImageIo::writeQOI(const vpImage<unsigned char> &I, const std::string &filename)
+{
+  std::vector<unsigned char> buffer;
+  vpQoiEncode<vpQoiGreyAdapter>(I.bitmap, I.getWidth(), I.getHeight(), 3, buffer);
+  vpQoiWriteFile(buffer, filename);
+}
+
+/*!
+  Write the content of the color image in a QOI file with an alpha channel.
+
+  \param I : Image to save as a QOI file.
+  \param filename : Name of the file containing the image.
+*/
+void
+vpImageIo::writeQOI(const vpImage<vpRGBa> &I, const std::string &filename)
+{
+  std::vector<unsigned char> buffer;
+  vpQoiEncode<vpQoiRGBaAdapter>(I.bitmap, I.getWidth(), I.getHeight(), 4, buffer);
+  vpQoiWriteFile(buffer, filename);
+}
+
+/*!
+  Write the content of the depth map in a QOI file. The most significant byte
+  of each value is stored in the red channel, the least significant byte in the
+  green channel, and the blue channel is set to 0. Small depth variations
+  between neighbor pixels are then coded on one or two bytes.
+
+  \param I : Depth map to save as a QOI file.
+  \param filename : Name of the file containing the image.
+
+  \sa readQOI(vpImage<uint16_t> &, const std::string &)
+*/
+void
+vpImageIo::writeQOI(const vpImage<uint16_t> &I, const std::string &filename)
+{
+  std::vector<unsigned char> buffer;
+  vpQoiEncode<vpQoiDepthAdapter>(I.bitmap, I.getWidth(), I.getHeight(), 3, buffer);
+  vpQoiWriteFile(buffer, filename);
+}
+
+/*!
+  Read the contents of the QOI file, allocate memory for the corresponding
+  gray level image, if necessary convert the data in gray level, and set the
+  bitmap with the gray level data.
+
+  When the three color channels of all the pixels are equal, as in the files
+  written by writeQOI(const vpImage<unsigned char> &, const std::string &), the
+  gray levels are read back exactly. Otherwise the color image is converted
+  with vpImageConvert::convert(), as for the other color formats.
+
+  If the image has been already initialized, memory allocation is done
+  only if the new image size is different, else we re-use the same
+  memory space.
+
+  \param I : Image to set with the \e filename content.
+  \param filename : Name of the file containing the image.
+*/
+void
+vpImageIo::readQOI(vpImage<unsigned char> &I, const std::string &filename)
+{
+  vpImage<vpRGBa> Itmp;
+  vpImageIo::readQOI(Itmp, filename);
+
+  bool grey = true;
+  for (unsigned int i = 0; i < Itmp.getSize() && grey; i++) {
+    grey = (Itmp.bitmap[i].R == Itmp.bitmap[i].G && Itmp.bitmap[i].G == Itmp.bitmap[i].B);
+  }
+  if (! grey) {
+    vpImageConvert::convert(Itmp, I);
+    return;
+  }
+
+  if ((Itmp.getHeight() != I.getHeight())||(Itmp.getWidth() != I.getWidth())) {
+    I.resize(Itmp.getHeight(), Itmp.getWidth()) ;
+  }
+  for (unsigned int i = 0; i < Itmp.getSize(); i++) {
+    I.bitmap[i] = Itmp.bitmap[i].R;
+  }
+}
+
+/*!
+  Read the contents of the QOI file, allocate memory for the corresponding
+  color image and set its bitmap. If the file has no alpha channel, the alpha
+  component is set to vpRGBa::alpha_default.
+
+  If the image has been already initialized, memory allocation is done
+  only if the new image size is different, else we re-use the same
+  memory space.
+
+  \param I : Image to set with the \e filename content.
+  \param filename : Name of the file containing the image.
+*/
+void
+vpImageIo::readQOI(vpImage<vpRGBa> &I, const std::string &filename)
+{
+  std::vector<unsigned char> buffer;
+  unsigned int w, h;
+  vpQoiReadFile(filename, buffer, w, h);
+  if ((h != I.getHeight())||( w != I.getWidth())) {
+    I.resize(h,w) ;
+  }
+  vpQoiDecode<vpQoiRGBaAdapter>(&buffer[0], buffer.size(), I.bitmap, I.getSize());
+}
+
+/*!
+  Read a depth map written by writeQOI(const vpImage<uint16_t> &, const std::string &).
+  Each depth value is rebuilt from the red (most significant byte) and green
+  (least significant byte) channels.
+
+  \param I : Depth map to set with the \e filename content.
+  \param filename : Name of the file containing the image.
+*/
+void
+vpImageIo::readQOI(vpImage<uint16_t> &I, const std::string &filename)
+{
+  std::vector<unsigned char> buffer;
+  unsigned int w, h;
+  vpQoiReadFile(filename, buffer, w, h);
+  if ((h != I.getHeight())||( w != I.getWidth())) {
+    I.resize(h,w) ;
+  }
+  vpQoiDecode<vpQoiDepthAdapter>(&buffer[0], buffer.size(), I.bitmap, I.getSize());
+}
+
+//--------------------------------------------------------------------------
+// JPEG
+//--------------------------------------------------------------------------
+
+#if defined(VISP_HAVE_JPEG)
+
+/*!
+  Write the content of the image bitmap in the file which name is given by \e
+  filename. This function writes a JPEG file.
+
+  \param I : Image to save as a JPEG file.
+  \param filename : Name of the file containing the image.
+*/
+void
+vpImageIo::writeJPEG(const vpImage<unsigned char> &I, const std::string &filename)
+{
+  struct jpeg_compress_struct cinfo;
+  struct jpeg_error_mgr jerr;
+  FILE *file;
+
+  cinfo.err = jpeg_std_error(&jerr);
+  jpeg_create_compress(&cinfo);
+
+  // Test the filename
+  if (filename.empty())   {
+     throw (vpImageException(vpImageException::ioError,
+           "Cannot create JPEG file: filename empty")) ;
+  }
+
+  file = fopen(filename.c_str(), "wb");
+
+  if (file == NULL) {
+    throw (vpImageException(vpImageException::ioError,
+                            "Cannot create JPEG file \"%s\"", filename.c_str())) ;
+  }
+
+  unsigned int width = I.getWidth();
+  unsigned int height = I.getHeight();
 
   jpeg_stdio_dest(&cinfo, file);
 
@@ -1417,8 +1992,103 @@ vpImageIo::readJPEG(vpImage<vpRGBa> &I, const std::string &filename)
 // PNG
 //--------------------------------------------------------------------------
 
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+namespace
+{
+/*
+  PNG encoding settings, see vpImageIo::setPNGCompression(). They are read by
+  the writers that may run in other threads (vpVideoWriter asynchronous mode,
+  vpImageIo::writeBatch()), that is why the zlib level (from -1 to 9) and the
+  filtering flag are packed in a single value set and read at once.
+*/
+int vp_packPNGSettings(int level, bool filtering)
+{
+  return (level + 1) | (filtering ? 0 : 0x10);
+}
+
+#if defined(VISP_HAVE_CPP11_COMPATIBILITY)
+std::atomic<int> vp_pngSettings(vp_packPNGSettings(-1, true));
+
+void vp_storePNGSettings(int settings) { vp_pngSettings.store(settings); }
+
+int vp_loadPNGSettings() { return vp_pngSettings.load(); }
+#elif defined(VISP_HAVE_PTHREAD) || (defined(_WIN32) && !defined(WINRT_8_0))
+vpMutex vp_pngSettingsMutex;
+int vp_pngSettings = vp_packPNGSettings(-1, true);
+
+void vp_storePNGSettings(int settings)
+{
+  vpMutex::vpScopedLock lock(vp_pngSettingsMutex);
+  vp_pngSettings = settings;
+}
+
+int vp_loadPNGSettings()
+{
+  vpMutex::vpScopedLock lock(vp_pngSettingsMutex);
+  return vp_pngSettings;
+}
+#else
+int vp_pngSettings = vp_packPNGSettings(-1, true);
+
+void vp_storePNGSettings(int settings) { vp_pngSettings = settings; }
+
+int vp_loadPNGSettings() { return vp_pngSettings; }
+#endif
+
+#if defined(VISP_HAVE_PNG) || (VISP_HAVE_OPENCV_VERSION >= 0x020408)
+// Current zlib level, negative for the default one, and row filtering
+void vp_getPNGSettings(int &level, bool &filtering)
+{
+  int settings = vp_loadPNGSettings();
+  level = (settings & 0x0f) - 1;
+  filtering = (settings & 0x10) == 0;
+}
+#endif
+}
+#endif
+
+/*!
+  Set the zlib compression level and the row filtering used to write PNG
+  images. Lower levels and no filtering speed up the encoding at the expense of
+  larger files, which matters when images are recorded at a high frame rate.
+
+  These settings are global: they apply to all the PNG files written
+  afterwards by the process, from any thread, including the ones written by
+  vpImageIo::writeBatch() and by vpVideoWriter in asynchronous mode. A call
+  during a write is safe, the file being written with either the previous
+  or the new settings.
+
+  \param level : zlib compression level between 0 (no compression) and 9 (best
+  compression). A negative value selects the zlib default level (6).
+  \param filtering : If false, rows are not filtered before the compression.
+  This option is only used when ViSP is built with libpng.
+*/
+void
+vpImageIo::setPNGCompression(int level, bool filtering)
+{
+  level = (level > 9) ? 9 : level;
+  level = (level < 0) ? -1 : level;
+  vp_storePNGSettings(vp_packPNGSettings(level, filtering));
+}
+
 #if defined(VISP_HAVE_PNG)
 
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+namespace
+{
+void vp_setPNGCompression(png_structp png_ptr)
+{
+  int level;
+  bool filtering;
+  vp_getPNGSettings(level, filtering);
+  if (level >= 0)
+    png_set_compression_level(png_ptr, level);
+  if (! filtering)
+    png_set_filter(png_ptr, PNG_FILTER_TYPE_BASE, PNG_FILTER_NONE);
+}
+}
+#endif
+
 /*!
   Write the content of the image bitmap in the file which name is given by \e
   filename. This function writes a PNG file.
@@ -1476,6 +2146,7 @@ vpImageIo::writePNG(const vpImage<unsigned char> &I, const std::string &filename
 
   /* setup libpng for using standard C fwrite() function with our FILE pointer */
   png_init_io (png_ptr, file);
+  vp_setPNGCompression(png_ptr);
 
   unsigned int width = I.getWidth();
   unsigned int height = I.getHeight();
@@ -1498,29 +2169,15 @@ vpImageIo::writePNG(const vpImage<unsigned char> &I, const std::string &filename
 
   png_write_info(png_ptr, info_ptr);
 
+  // Rows are given to libpng without copy
   png_bytep* row_ptrs = new png_bytep[height];
   for (unsigned int i = 0; i < height; i++)
-    row_ptrs[i] = new png_byte[width];
-
-  unsigned char* input = (unsigned char*)I.bitmap;
-
-  for (unsigned int i = 0; i < height; i++)
-  {
-    png_byte* row = row_ptrs[i];
-    for(unsigned int j = 0; j < width; j++)
-    {
-      row[j] = *(input);
-      input++;
-    }
-  }
+    row_ptrs[i] = (png_bytep)I[i];
 
   png_write_image(png_ptr, row_ptrs);
 
   png_write_end(png_ptr, NULL);
 
-  for(unsigned int j = 0; j < height; j++)
-    delete[] row_ptrs[j];
-
   delete[] row_ptrs;
 
   png_destroy_write_struct (&png_ptr, &info_ptr);
@@ -1585,6 +2242,7 @@ vpImageIo::writePNG(const vpImage<vpRGBa> &I, const std::string &filename)
 
   /* setup libpng for using standard C fwrite() function with our FILE pointer */
   png_init_io (png_ptr, file);
+  vp_setPNGCompression(png_ptr);
 
   unsigned int width = I.getWidth();
   unsigned int height = I.getHeight();
@@ -1607,31 +2265,17 @@ vpImageIo::writePNG(const vpImage<vpRGBa> &I, const std::string &filename)
 
   png_write_info(png_ptr, info_ptr);
 
-  png_bytep* row_ptrs = new png_bytep[height];
-  for (unsigned int i = 0; i < height; i++)
-    row_ptrs[i] = new png_byte[3*width];
-
-  unsigned char* input = (unsigned char*)I.bitmap;;
+  // Rows are given to libpng without copy, the alpha channel being stripped by libpng
+  png_set_filler(png_ptr, 0, PNG_FILLER_AFTER);
 
+  png_bytep* row_ptrs = new png_bytep[height];
   for (unsigned int i = 0; i < height; i++)
-  {
-    png_byte* row = row_ptrs[i];
-    for(unsigned int j = 0; j < width; j++)
-    {
-      row[3*j] = *(input);input++;
-      row[3*j+1] = *(input);input++;
-      row[3*j+2] = *(input);input++;
-      input++;
-    }
-  }
+    row_ptrs[i] = (png_bytep)I[i];
 
   png_write_image(png_ptr, row_ptrs);
 
   png_write_end(png_ptr, NULL);
 
-  for(unsigned int j = 0; j < height; j++)
-    delete[] row_ptrs[j];
-
   delete[] row_ptrs;
 
   png_destroy_write_struct (&png_ptr, &info_ptr);
@@ -2022,6 +2666,197 @@ vpImageIo::readPNG(vpImage<vpRGBa> &I, const std::string &filename)
   fclose(file);
 }
 
+/*!
+  Write the content of the depth map in a 16 bits grey level PNG file.
+
+  \param I : Depth map to save as a PNG file.
+  \param filename : Name of the file containing the image.
+
+  \sa setPNGCompression()
+*/
+void
+vpImageIo::writePNG(const vpImage<uint16_t> &I, const std::string &filename)
+{
+  // Test the filename
+  if (filename.empty())   {
+     throw (vpImageException(vpImageException::ioError,
+           "Cannot create PNG file: filename empty")) ;
+  }
+
+  FILE *file = fopen(filename.c_str(), "wb");
+
+  if (file == NULL) {
+    throw (vpImageException(vpImageException::ioError,
+                            "Cannot create PNG file \"%s\"", filename.c_str())) ;
+  }
+
+  png_structp png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING,NULL, NULL, NULL);
+  if (!png_ptr)
+  {
+    fclose (file);
+    throw (vpImageException(vpImageException::ioError,
+           "PNG write error")) ;
+  }
+
+  png_infop info_ptr = png_create_info_struct(png_ptr);
+  if (!info_ptr)
+  {
+    fclose (file);
+    png_destroy_write_struct (&png_ptr, NULL);
+    throw (vpImageException(vpImageException::ioError,
+           "PNG write error")) ;
+  }
+
+  png_bytep* row_ptrs = new png_bytep[I.getHeight()];
+
+  /* initialize the setjmp for returning properly after a libpng error occured */
+  if (setjmp (png_jmpbuf (png_ptr)))
+  {
+    fclose (file);
+    delete[] row_ptrs;
+    png_destroy_write_struct (&png_ptr, &info_ptr);
+    throw (vpImageException(vpImageException::ioError,
+           "PNG write error")) ;
+  }
+
+  png_init_io (png_ptr, file);
+  vp_setPNGCompression(png_ptr);
+
+  png_set_IHDR(png_ptr, info_ptr, I.getWidth(), I.getHeight(),
+         16, PNG_COLOR_TYPE_GRAY, PNG_INTERLACE_NONE,
+         PNG_COMPRESSION_TYPE_BASE, PNG_FILTER_TYPE_BASE);
+
+  png_write_info(png_ptr, info_ptr);
+
+  // PNG stores the most significant byte first
+  uint16_t endianness = 1;
+  if (*(unsigned char *)&endianness == 1)
+    png_set_swap(png_ptr);
+
+  for (unsigned int i = 0; i < I.getHeight(); i++)
+    row_ptrs[i] = (png_bytep)I[i];
+
+  png_write_image(png_ptr, row_ptrs);
+  png_write_end(png_ptr, NULL);
+
+  delete[] row_ptrs;
+  png_destroy_write_struct (&png_ptr, &info_ptr);
+  fclose(file);
+}
+
+/*!
+  Read a grey level PNG file in a depth map. 16 bits values are read as is,
+  lower bit depths are expanded to 8 bits. Color images are not supported.
+
+  If the image has been already initialized, memory allocation is done
+  only if the new image size is different, else we re-use the same
+  memory space.
+
+  \param I : Depth map to set with the \e filename content.
+  \param filename : Name of the file containing the image.
+*/
+void
+vpImageIo::readPNG(vpImage<uint16_t> &I, const std::string &filename)
+{
+  png_byte magic[8];
+  // Test the filename
+  if (filename.empty())   {
+    throw (vpImageException(vpImageException::ioError,
+           "Cannot read PNG image: filename empty")) ;
+  }
+
+  FILE *file = fopen(filename.c_str(), "rb");
+
+  if (file == NULL) {
+     throw (vpImageException(vpImageException::ioError,
+           "Cannot read file \"%s\"", filename.c_str())) ;
+  }
+
+  if (fread (magic, 1, sizeof (magic), file) != sizeof (magic) || png_sig_cmp (magic,0, sizeof (magic)))
+  {
+    fclose (file);
+    throw (vpImageException(vpImageException::ioError,
+          "Cannot read PNG file: \"%s\" is not a valid PNG image", filename.c_str())) ;
+  }
+
+  png_structp png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+  if (png_ptr == NULL)
+  {
+    fclose (file);
+    throw (vpImageException(vpImageException::ioError,
+          "error reading png file")) ;
+  }
+
+  png_infop info_ptr = png_create_info_struct (png_ptr);
+  if (info_ptr == NULL)
+  {
+    fclose (file);
+    png_destroy_read_struct (&png_ptr, NULL, NULL);
+    throw (vpImageException(vpImageException::ioError,
+          "error reading png file")) ;
+  }
+
+  std::vector<png_bytep> row_ptrs;
+  std::vector<unsigned char> data;
+
+  /* initialize the setjmp for returning properly after a libpng error occured */
+  if (setjmp (png_jmpbuf (png_ptr)))
+  {
+    fclose (file);
+    png_destroy_read_struct (&png_ptr, &info_ptr, NULL);
+    throw (vpImageException(vpImageException::ioError,
+           "PNG read error")) ;
+  }
+
+  png_init_io (png_ptr, file);
+  png_set_sig_bytes (png_ptr, sizeof (magic));
+  png_read_info (png_ptr, info_ptr);
+
+  unsigned int width = png_get_image_width(png_ptr, info_ptr);
+  unsigned int height = png_get_image_height(png_ptr, info_ptr);
+  unsigned int bit_depth = png_get_bit_depth (png_ptr, info_ptr);
+  unsigned int color_type = png_get_color_type (png_ptr, info_ptr);
+
+  if (color_type != PNG_COLOR_TYPE_GRAY && color_type != PNG_COLOR_TYPE_GRAY_ALPHA)
+  {
+    fclose (file);
+    png_destroy_read_struct (&png_ptr, &info_ptr, NULL);
+    throw (vpImageException(vpImageException::ioError,
+           "\"%s\" is not a grey level PNG image", filename.c_str())) ;
+  }
+  if (color_type == PNG_COLOR_TYPE_GRAY_ALPHA)
+    png_set_strip_alpha(png_ptr);
+  if (bit_depth < 8)
+    png_set_expand (png_ptr);
+  uint16_t endianness = 1;
+  if (bit_depth == 16 && *(unsigned char *)&endianness == 1)
+    png_set_swap(png_ptr);
+  png_read_update_info (png_ptr, info_ptr);
+
+  if ((height != I.getHeight())||( width != I.getWidth())) {
+    I.resize(height,width) ;
+  }
+
+  row_ptrs.resize(height);
+  if (bit_depth == 16) {
+    for (unsigned int i = 0; i < height; i++)
+      row_ptrs[i] = (png_bytep)I[i];
+    png_read_image(png_ptr, &row_ptrs[0]);
+  }
+  else {
+    data.resize((size_t)width * height);
+    for (unsigned int i = 0; i < height; i++)
+      row_ptrs[i] = &data[(size_t)i * width];
+    png_read_image(png_ptr, &row_ptrs[0]);
+    for (size_t i = 0; i < data.size(); i++)
+      I.bitmap[i] = data[i];
+  }
+
+  png_read_end (png_ptr, NULL);
+  png_destroy_read_struct (&png_ptr, &info_ptr, NULL);
+  fclose(file);
+}
+
 #elif defined(VISP_HAVE_OPENCV)
 
 /*!
@@ -2037,7 +2872,19 @@ vpImageIo::writePNG(const vpImage<unsigned char> &I, const std::string &filename
 #if (VISP_HAVE_OPENCV_VERSION >= 0x020408)
   cv::Mat Ip;
   vpImageConvert::convert(I, Ip);
-  cv::imwrite(filename.c_str(), Ip);
+  std::vector<int> params;
+  int level;
+  bool filtering;
+  vp_getPNGSettings(level, filtering);
+  if (level >= 0) {
+#  if (VISP_HAVE_OPENCV_VERSION >= 0x030000)
+    params.push_back(cv::IMWRITE_PNG_COMPRESSION);
+#  else
+    params.push_back(CV_IMWRITE_PNG_COMPRESSION);
+#  endif
+    params.push_back(level);
+  }
+  cv::imwrite(filename.c_str(), Ip, params);
 #else
   IplImage* Ip = NULL;
   vpImageConvert::convert(I, Ip);
@@ -2061,7 +2908,19 @@ vpImageIo::writePNG(const vpImage<vpRGBa> &I, const std::string &filename)
 #if (VISP_HAVE_OPENCV_VERSION >= 0x020408)
   cv::Mat Ip;
   vpImageConvert::convert(I, Ip);
-  cv::imwrite(filename.c_str(), Ip);
+  std::vector<int> params;
+  int level;
+  bool filtering;
+  vp_getPNGSettings(level, filtering);
+  if (level >= 0) {
+#  if (VISP_HAVE_OPENCV_VERSION >= 0x030000)
+    params.push_back(cv::IMWRITE_PNG_COMPRESSION);
+#  else
+    params.push_back(CV_IMWRITE_PNG_COMPRESSION);
+#  endif
+    params.push_back(level);
+  }
+  cv::imwrite(filename.c_str(), Ip, params);
 #else
   IplImage* Ip = NULL;
   vpImageConvert::convert(I, Ip);
@@ -2161,3 +3020,196 @@ vpImageIo::readPNG(vpImage<vpRGBa> &I, const std::string &filename)
 }
 
 #endif
+
+//--------------------------------------------------------------------------
+// Batch
+//--------------------------------------------------------------------------
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+namespace
+{
+template <class Type>
+unsigned int vpReadBatch(std::vector<vpImage<Type> > &I, const std::vector<std::string> &filenames,
+                         std::vector<std::string> &errors)
+{
+  int n = (int)filenames.size();
+  I.resize(filenames.size());
+  errors.assign(filenames.size(), std::string());
+  unsigned int nbRead = 0;
+
+#ifdef VISP_HAVE_OPENMP
+#pragma omp parallel for schedule(dynamic) reduction(+:nbRead)
+#endif
+  for (int i = 0; i < n; i++) {
+    try {
+      vpImageIo::read(I[(size_t)i], filenames[(size_t)i]);
+      nbRead ++;
+    }
+    catch(const vpException &e) {
+      errors[(size_t)i] = e.getStringMessage();
+    }
+    catch(const std::exception &e) {
+      errors[(size_t)i] = e.what();
+    }
+    catch(...) {
+      errors[(size_t)i] = "Cannot read file \"" + filenames[(size_t)i] + "\"";
+    }
+  }
+  return nbRead;
+}
+
+template <class Type>
+unsigned int vpWriteBatch(const std::vector<vpImage<Type> > &I, const std::vector<std::string> &filenames,
+                          std::vector<std::string> &errors)
+{
+  if (I.size() != filenames.size()) {
+    throw (vpImageException(vpImageException::ioError,
+                            "Cannot write %d images in %d files", (int)I.size(), (int)filenames.size()));
+  }
+  int n = (int)filenames.size();
+  errors.assign(filenames.size(), std::string());
+  unsigned int nbWritten = 0;
+
+#ifdef VISP_HAVE_OPENMP
+#pragma omp parallel for schedule(dynamic) reduction(+:nbWritten)
+#endif
+  for (int i = 0; i < n; i++) {
+    try {
+      vpImageIo::write(I[(size_t)i], filenames[(size_t)i]);
+      nbWritten ++;
+    }
+    catch(const vpException &e) {
+      errors[(size_t)i] = e.getStringMessage();
+    }
+    catch(const std::exception &e) {
+      errors[(size_t)i] = e.what();
+    }
+    catch(...) {
+      errors[(size_t)i] = "Cannot write file \"" + filenames[(size_t)i] + "\"";
+    }
+  }
+  return nbWritten;
+}
+}
+#endif
+
+/*!
+  Read a set of grey level images. The files are decoded in parallel when ViSP
+  is built with OpenMP; the number of threads can be set with the
+  \c OMP_NUM_THREADS environment variable. A file that cannot be read does not
+  stop the reading of the other files.
+
+  \code
+  std::vector<std::string> filenames;
+  for (unsigned int i = 0; i < 100; i++) {
+    char name[FILENAME_MAX];
+    sprintf(name, "image%04u.png", i);
+    filenames.push_back(name);
+  }
+  std::vector<vpImage<unsigned char> > I;
+  std::vector<std::string> errors;
+  if (vpImageIo::readBatch(I, filenames, errors) != filenames.size()) {
+    for (size_t i = 0; i < errors.size(); i++)
+      if (! errors[i].empty())
+        std::cerr << errors[i] << std::endl;
+  }
+  \endcode
+
+  \param I : Images read, resized to the number of files. \e I[i] is the content of \e filenames[i].
+  \param filenames : Names of the files to read. The format of each file is given by its extension, as in read().
+  \param errors : Error messages, resized to the number of files. \e errors[i] is
+  empty if \e filenames[i] was read.
+  \return The number of images successfully read.
+
+  \sa vpImageBatchReader to read a large set of images with a bounded memory footprint.
+*/
+unsigned int
+vpImageIo::readBatch(std::vector<vpImage<unsigned char> > &I, const std::vector<std::string> &filenames,
+                     std::vector<std::string> &errors)
+{
+  return vpReadBatch(I, filenames, errors);
+}
+
+/*!
+  Read a set of color images in parallel. See readBatch(std::vector<vpImage<unsigned char> > &, const std::vector<std::string> &, std::vector<std::string> &)
+  for the details.
+
+  \param I : Images read, resized to the number of files. \e I[i] is the content of \e filenames[i].
+  \param filenames : Names of the files to read.
+  \param errors : Error messages, \e errors[i] is empty if \e filenames[i] was read.
+  \return The number of images successfully read.
+*/
+unsigned int
+vpImageIo::readBatch(std::vector<vpImage<vpRGBa> > &I, const std::vector<std::string> &filenames,
+                     std::vector<std::string> &errors)
+{
+  return vpReadBatch(I, filenames, errors);
+}
+
+/*!
+  Read a set of depth maps in parallel. See readBatch(std::vector<vpImage<unsigned char> > &, const std::vector<std::string> &, std::vector<std::string> &)
+  for the details.
+
+  \param I : Depth maps read, resized to the number of files. \e I[i] is the content of \e filenames[i].
+  \param filenames : Names of the files to read.
+  \param errors : Error messages, \e errors[i] is empty if \e filenames[i] was read.
+  \return The number of depth maps successfully read.
+*/
+unsigned int
+vpImageIo::readBatch(std::vector<vpImage<uint16_t> > &I, const std::vector<std::string> &filenames,
+                     std::vector<std::string> &errors)
+{
+  return vpReadBatch(I, filenames, errors);
+}
+
+/*!
+  Write a set of grey level images. The files are encoded in parallel when
+  ViSP is built with OpenMP. A file that cannot be written does not stop the
+  writing of the other files.
+
+  \param I : Images to write.
+  \param filenames : Names of the files, one per image. The format of each file is given by its extension, as in write().
+  \param errors : Error messages, resized to the number of files. \e errors[i] is
+  empty if \e I[i] was written.
+  \return The number of images successfully written.
+
+  \exception vpImageException::ioError : If the number of images and file names differ.
+*/
+unsigned int
+vpImageIo::writeBatch(const std::vector<vpImage<unsigned char> > &I, const std::vector<std::string> &filenames,
+                      std::vector<std::string> &errors)
+{
+  return vpWriteBatch(I, filenames, errors);
+}
+
+/*!
+  Write a set of color images in parallel. See writeBatch(const std::vector<vpImage<unsigned char> > &, const std::vector<std::string> &, std::vector<std::string> &)
+  for the details.
+
+  \param I : Images to write.
+  \param filenames : Names of the files, one per image.
+  \param errors : Error messages, \e errors[i] is empty if \e I[i] was written.
+  \return The number of images successfully written.
+*/
+unsigned int
+vpImageIo::writeBatch(const std::vector<vpImage<vpRGBa> > &I, const std::vector<std::string> &filenames,
+                      std::vector<std::string> &errors)
+{
+  return vpWriteBatch(I, filenames, errors);
+}
+
+/*!
+  Write a set of depth maps in parallel. See writeBatch(const std::vector<vpImage<unsigned char> > &, const std::vector<std::string> &, std::vector<std::string> &)
+  for the details.
+
+  \param I : Depth maps to write.
+  \param filenames : Names of the files, one per depth map.
+  \param errors : Error messages, \e errors[i] is empty if \e I[i] was written.
+  \return The number of depth maps successfully written.
+*/
+unsigned int
+vpImageIo::writeBatch(const std::vector<vpImage<uint16_t> > &I, const std::vector<std::string> &filenames,
+                      std::vector<std::string> &errors)
+{
+  return vpWriteBatch(I, filenames, errors);
+}
@@ -37,15 +37,246 @@
  *****************************************************************************/
 
 
+#include <visp3/core/vpThread.h>
 #include <visp3/io/vpDiskGrabber.h>
 
+#include "vpMonitor.h"
+
+#if defined(VISP_HAVE_PTHREAD) || (defined(_WIN32) && !defined(WINRT_8_0))
+#  define VP_DISK_GRABBER_THREAD_OK
+#endif
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+/*
+  Read-ahead of the images of a sequence. Background threads decode the next
+  images into a ring of slots. The consumer takes the image of the slot at the
+  head of the ring, waiting until it is decoded. Slots are swapped with the
+  consumer image, so that no copy is done.
+*/
+class vpDiskGrabber::vpReadAhead
+{
+public:
+  vpReadAhead(const vpDiskGrabber &grabber, unsigned int nbThreads, unsigned int bufferSize)
+    : m_grabber(grabber), m_mutex(), m_slots(bufferSize), m_threads(),
+      m_active(false), m_endReached(false), m_head(0), m_headNumber(0), m_imageType(TYPE_UCHAR),
+      m_nbDecoding(0), m_nbDropped(0), m_nbScheduled(0), m_step(1), m_stop(false)
+  {
+#ifdef VP_DISK_GRABBER_THREAD_OK
+    for (unsigned int i = 0; i < nbThreads; i++)
+      m_threads.push_back(new vpThread((vpThread::Fn) decodeThread, (vpThread::Args) this));
+#else
+    (void)nbThreads;
+#endif
+  }
+
+  ~vpReadAhead()
+  {
+    {
+      vpMonitor::vpScopedLock lock(m_mutex);
+      m_stop = true;
+      m_mutex.notifyAll();
+    }
+    for (size_t i = 0; i < m_threads.size(); i++) {
+      m_threads[i]->join();
+      delete m_threads[i];
+    }
+  }
+
+  unsigned int getNbDroppedFrames()
+  {
+    vpMonitor::vpScopedLock lock(m_mutex);
+    return m_nbDropped;
+  }
+
+  /*
+    Get image \e number in I and return the number of the image actually
+    delivered, that may be greater when frame dropping is enabled.
+  */
+  template <class Type>
+  long acquire(vpImage<Type> &I, long number, long step, bool dropping)
+  {
+    m_mutex.lock();
+    if (! m_active || m_imageType != getImageType(I) || m_step != step || m_headNumber != number
+        || (m_endReached && m_nbScheduled == 0)) {
+      // Restart the read-ahead from the requested image
+      while (m_nbDecoding > 0)
+        m_mutex.wait();
+      for (size_t i = 0; i < m_slots.size(); i++)
+        m_slots[i].state = SLOT_EMPTY;
+      m_active = true;
+      m_endReached = false;
+      m_head = 0;
+      m_headNumber = number;
+      m_imageType = getImageType(I);
+      m_nbScheduled = 0;
+      m_step = step;
+      m_mutex.notifyAll();
+    }
+
+    while (m_nbScheduled == 0 || m_slots[m_head].state == SLOT_DECODING)
+      m_mutex.wait();
+
+    if (dropping) {
+      // Jump to the most recent image among the ones already decoded
+      size_t last = 0;
+      while (last + 1 < m_nbScheduled && m_slots[(m_head + last + 1) % m_slots.size()].state == SLOT_READY)
+        last ++;
+      for (size_t i = 0; i < last; i++) {
+        m_slots[m_head].state = SLOT_EMPTY;
+        m_head = (m_head + 1) % m_slots.size();
+        m_headNumber += m_step;
+        m_nbScheduled --;
+        m_nbDropped ++;
+      }
+    }
+
+    vpSlot &slot = m_slots[m_head];
+    long acquiredNumber = slot.number;
+    bool failed = (slot.state == SLOT_FAILED);
+    std::string error = slot.error;
+    if (! failed) {
+      // Give the decoded image to the consumer without copy, but keep its display
+      vpImage<Type> &J = getImage(slot, I);
+      vpDisplay *display = I.display;
+      swap(I, J);
+      I.display = display;
+      J.display = NULL;
+    }
+    slot.state = SLOT_EMPTY;
+    m_head = (m_head + 1) % m_slots.size();
+    m_headNumber += m_step;
+    m_nbScheduled --;
+    // Slots were released for the decoding threads
+    m_mutex.notifyAll();
+    m_mutex.unlock();
+
+    if (failed)
+      throw(vpImageException(vpImageException::ioError, "%s", error.c_str()));
+
+    return acquiredNumber;
+  }
+
+private:
+  typedef enum {
+    SLOT_EMPTY,
+    SLOT_DECODING,
+    SLOT_READY,
+    SLOT_FAILED
+  } vpSlotState;
+
+  typedef enum {
+    TYPE_UCHAR,
+    TYPE_RGBA,
+    TYPE_FLOAT
+  } vpImageType;
+
+  struct vpSlot {
+    vpSlot() : state(SLOT_EMPTY), number(0), error(), Ic(), If(), Ig() {}
+    vpSlotState state;
+    long number;
+    std::string error;
+    vpImage<vpRGBa> Ic;
+    vpImage<float> If;
+    vpImage<unsigned char> Ig;
+  };
+
+  static vpImageType getImageType(const vpImage<unsigned char> &) { return TYPE_UCHAR; }
+  static vpImageType getImageType(const vpImage<vpRGBa> &) { return TYPE_RGBA; }
+  static vpImageType getImageType(const vpImage<float> &) { return TYPE_FLOAT; }
+
+  static vpImage<unsigned char> &getImage(vpSlot &slot, const vpImage<unsigned char> &) { return slot.Ig; }
+  static vpImage<vpRGBa> &getImage(vpSlot &slot, const vpImage<vpRGBa> &) { return slot.Ic; }
+  static vpImage<float> &getImage(vpSlot &slot, const vpImage<float> &) { return slot.If; }
+
+#ifdef VP_DISK_GRABBER_THREAD_OK
+  static vpThread::Return decodeThread(vpThread::Args args)
+  {
+    static_cast<vpReadAhead *>(args)->decodeLoop();
+    return 0;
+  }
+#endif
+
+  void decodeLoop()
+  {
+    for (;;) {
+      vpSlot *slot = NULL;
+      vpImageType imageType = TYPE_UCHAR;
+      {
+        vpMonitor::vpScopedLock lock(m_mutex);
+        while (! m_stop && ! (m_active && ! m_endReached && m_nbScheduled < m_slots.size()))
+          m_mutex.wait();
+        if (m_stop)
+          break;
+        slot = &m_slots[(m_head + m_nbScheduled) % m_slots.size()];
+        slot->number = m_headNumber + (long)m_nbScheduled * m_step;
+        slot->state = SLOT_DECODING;
+        imageType = m_imageType;
+        m_nbScheduled ++;
+        m_nbDecoding ++;
+      }
+
+      // The slot is owned by this thread until its state changes
+      bool success = true;
+      try {
+        std::string filename = m_grabber.getImageFileName(slot->number);
+        switch (imageType) {
+        case TYPE_UCHAR: vpImageIo::read(slot->Ig, filename); break;
+        case TYPE_RGBA: vpImageIo::read(slot->Ic, filename); break;
+        case TYPE_FLOAT: vpImageIo::readPFM(slot->If, filename); break;
+        }
+      }
+      catch(const vpException &e) {
+        success = false;
+        slot->error = e.getStringMessage();
+      }
+      catch(...) {
+        success = false;
+        slot->error = "Cannot read image";
+      }
+
+      vpMonitor::vpScopedLock lock(m_mutex);
+      slot->state = success ? SLOT_READY : SLOT_FAILED;
+      if (! success) {
+        // Most probably the end of the sequence; do not decode further
+        m_endReached = true;
+      }
+      m_nbDecoding --;
+      m_mutex.notifyAll();
+    }
+  }
+
+  const vpDiskGrabber &m_grabber;
+  vpMonitor m_mutex;
+  std::vector<vpSlot> m_slots;
+#ifdef VP_DISK_GRABBER_THREAD_OK
+  std::vector<vpThread *> m_threads;
+#else
+  std::vector<void *> m_threads;
+#endif
+  bool m_active;
+  bool m_endReached;
+  size_t m_head;
+  long m_headNumber;
+  vpImageType m_imageType;
+  unsigned int m_nbDecoding;
+  unsigned int m_nbDropped;
+  size_t m_nbScheduled;
+  long m_step;
+  bool m_stop;
+
+  vpReadAhead(const vpReadAhead &);
+  vpReadAhead &operator=(const vpReadAhead &);
+};
+#endif // DOXYGEN_SHOULD_SKIP_THIS
+
 
 /*!
   Elementary constructor.
 */
 vpDiskGrabber::vpDiskGrabber()
   : m_image_number(0), m_image_number_next(0), m_image_step(1), m_number_of_zero(0),
-    m_directory("/tmp"), m_base_name("I"), m_extension("pgm"), m_use_generic_name(false), m_generic_name("empty")
+    m_directory("/tmp"), m_base_name("I"), m_extension("pgm"), m_use_generic_name(false), m_generic_name("empty"),
+    m_frame_dropping(false), m_read_ahead_buffer_size(0), m_read_ahead_threads(0), m_read_ahead(NULL)
 {
   init = false;
 }
@@ -55,11 +286,49 @@ vpDiskGrabber::vpDiskGrabber()
 */
 vpDiskGrabber::vpDiskGrabber(const std::string &generic_name)
   : m_image_number(0), m_image_number_next(0), m_image_step(1), m_number_of_zero(0),
-    m_directory("/tmp"), m_base_name("I"), m_extension("pgm"), m_use_generic_name(true), m_generic_name(generic_name)
+    m_directory("/tmp"), m_base_name("I"), m_extension("pgm"), m_use_generic_name(true), m_generic_name(generic_name),
+    m_frame_dropping(false), m_read_ahead_buffer_size(0), m_read_ahead_threads(0), m_read_ahead(NULL)
 {
   init = false;
 }
 
+/*!
+  Copy constructor. The read-ahead state is not shared; the copy starts its
+  own decoding threads on its first acquisition.
+*/
+vpDiskGrabber::vpDiskGrabber(const vpDiskGrabber &grabber)
+  : vpFrameGrabber(grabber), m_image_number(0), m_image_number_next(0), m_image_step(1), m_number_of_zero(0),
+    m_directory(), m_base_name(), m_extension(), m_use_generic_name(false), m_generic_name(),
+    m_frame_dropping(false), m_read_ahead_buffer_size(0), m_read_ahead_threads(0), m_read_ahead(NULL)
+{
+  *this = grabber;
+}
+
+/*!
+  Copy operator. The read-ahead state is not shared; the copy starts its
+  own decoding threads on its first acquisition.
+*/
+vpDiskGrabber &vpDiskGrabber::operator=(const vpDiskGrabber &grabber)
+{
+  if (this != &grabber) {
+    stopReadAhead();
+    vpFrameGrabber::operator=(grabber);
+    m_image_number = grabber.m_image_number;
+    m_image_number_next = grabber.m_image_number_next;
+    m_image_step = grabber.m_image_step;
+    m_number_of_zero = grabber.m_number_of_zero;
+    m_directory = grabber.m_directory;
+    m_base_name = grabber.m_base_name;
+    m_extension = grabber.m_extension;
+    m_use_generic_name = grabber.m_use_generic_name;
+    m_generic_name = grabber.m_generic_name;
+    m_frame_dropping = grabber.m_frame_dropping;
+    m_read_ahead_buffer_size = grabber.m_read_ahead_buffer_size;
+    m_read_ahead_threads = grabber.m_read_ahead_threads;
+  }
+  return *this;
+}
+
 
 /*!
   Constructor.
@@ -77,7 +346,8 @@ vpDiskGrabber::vpDiskGrabber(const std::string &dir, const std::string &basename
                              int step, unsigned int noz,
                              const std::string &ext)
   : m_image_number(number), m_image_number_next(number), m_image_step(step), m_number_of_zero(noz),
-    m_directory(dir), m_base_name(basename), m_extension(ext), m_use_generic_name(false), m_generic_name("empty")
+    m_directory(dir), m_base_name(basename), m_extension(ext), m_use_generic_name(false), m_generic_name("empty"),
+    m_frame_dropping(false), m_read_ahead_buffer_size(0), m_read_ahead_threads(0), m_read_ahead(NULL)
 {
   init = false;
 }
@@ -152,21 +422,18 @@ vpDiskGrabber::open(vpImage<float> &I)
 void
 vpDiskGrabber::acquire(vpImage<unsigned char> &I)
 {
-  m_image_number = m_image_number_next;
-  std::stringstream ss;
-
-  if(m_use_generic_name) {
-    char filename[FILENAME_MAX];
-    sprintf(filename, m_generic_name.c_str(), m_image_number);
-    ss << filename;
+  if (m_read_ahead_threads > 0) {
+    if (m_read_ahead == NULL)
+      m_read_ahead = new vpReadAhead(*this, m_read_ahead_threads, m_read_ahead_buffer_size);
+    m_image_number = m_read_ahead->acquire(I, m_image_number_next, m_image_step, m_frame_dropping);
+    m_image_number_next = m_image_number + m_image_step;
   }
   else {
-    ss << m_directory << "/" << m_base_name << std::setfill('0') << std::setw(m_number_of_zero) << m_image_number << "." << m_extension;
+    m_image_number = m_image_number_next;
+    m_image_number_next += m_image_step;
+    vpImageIo::read(I, getImageFileName(m_image_number));
   }
 
-  m_image_number_next += m_image_step;
-  vpImageIo::read(I, ss.str()) ;
-
   width = I.getWidth();
   height = I.getHeight();
 }
@@ -180,22 +447,18 @@ vpDiskGrabber::acquire(vpImage<unsigned char> &I)
 void
 vpDiskGrabber::acquire(vpImage<vpRGBa> &I)
 {
-  m_image_number = m_image_number_next;
-  std::stringstream ss;
-
-  if(m_use_generic_name) {
-    char filename[FILENAME_MAX];
-    sprintf(filename, m_generic_name.c_str(), m_image_number);
-    ss << filename;
+  if (m_read_ahead_threads > 0) {
+    if (m_read_ahead == NULL)
+      m_read_ahead = new vpReadAhead(*this, m_read_ahead_threads, m_read_ahead_buffer_size);
+    m_image_number = m_read_ahead->acquire(I, m_image_number_next, m_image_step, m_frame_dropping);
+    m_image_number_next = m_image_number + m_image_step;
   }
   else {
-    ss << m_directory << "/" << m_base_name << std::setfill('0') << std::setw(m_number_of_zero) << m_image_number << "." << m_extension;
+    m_image_number = m_image_number_next;
+    m_image_number_next += m_image_step;
+    vpImageIo::read(I, getImageFileName(m_image_number));
   }
 
-  m_image_number_next += m_image_step;
-
-  vpImageIo::read(I, ss.str()) ;
-
   width = I.getWidth();
   height = I.getHeight();
 }
@@ -209,21 +472,18 @@ vpDiskGrabber::acquire(vpImage<vpRGBa> &I)
 void
 vpDiskGrabber::acquire(vpImage<float> &I)
 {
-  m_image_number = m_image_number_next;
-  std::stringstream ss;
-  if(m_use_generic_name) {
-    char filename[FILENAME_MAX];
-    sprintf(filename, m_generic_name.c_str(), m_image_number);
-    ss << filename;
+  if (m_read_ahead_threads > 0) {
+    if (m_read_ahead == NULL)
+      m_read_ahead = new vpReadAhead(*this, m_read_ahead_threads, m_read_ahead_buffer_size);
+    m_image_number = m_read_ahead->acquire(I, m_image_number_next, m_image_step, m_frame_dropping);
+    m_image_number_next = m_image_number + m_image_step;
   }
   else {
-    ss << m_directory << "/" << m_base_name << std::setfill('0') << std::setw(m_number_of_zero) << m_image_number << "." << m_extension;
+    m_image_number = m_image_number_next;
+    m_image_number_next += m_image_step;
+    vpImageIo::readPFM(I, getImageFileName(m_image_number));
   }
 
-  m_image_number_next += m_image_step;
-
-  vpImageIo::readPFM(I, ss.str());
-
   width = I.getWidth();
   height = I.getHeight();
 }
@@ -238,20 +498,11 @@ vpDiskGrabber::acquire(vpImage<float> &I)
 void
 vpDiskGrabber::acquire(vpImage<unsigned char> &I, long img_number)
 {
-  m_image_number = m_image_number_next;
-  std::stringstream ss;
-  if(m_use_generic_name) {
-    char filename[FILENAME_MAX];
-    sprintf(filename, m_generic_name.c_str(), m_image_number);
-    ss << filename;
-  }
-  else {
-    ss << m_directory << "/" << m_base_name << std::setfill('0') << std::setw(m_number_of_zero) << img_number << "." << m_extension;
-  }
+  m_image_number = img_number;
+  m_image_number_next = img_number + m_image_step;
+  std::string filename = getImageFileName(m_image_number);
 
-  m_image_number_next += m_image_step;
-
-  vpImageIo::read(I, ss.str());
+  vpImageIo::read(I, filename);
 
   width = I.getWidth();
   height = I.getHeight();
@@ -267,20 +518,11 @@ vpDiskGrabber::acquire(vpImage<unsigned char> &I, long img_number)
 void
 vpDiskGrabber::acquire(vpImage<vpRGBa> &I, long img_number)
 {
-  m_image_number = m_image_number_next;
-  std::stringstream ss;
-  if(m_use_generic_name) {
-    char filename[FILENAME_MAX];
-    sprintf(filename, m_generic_name.c_str(), m_image_number);
-    ss << filename;
-  }
-  else {
-    ss << m_directory << "/" << m_base_name << std::setfill('0') << std::setw(m_number_of_zero) << img_number << "." << m_extension;
-  }
-
-  m_image_number_next += m_image_step;
+  m_image_number = img_number;
+  m_image_number_next = img_number + m_image_step;
+  std::string filename = getImageFileName(m_image_number);
 
-  vpImageIo::read(I, ss.str());
+  vpImageIo::read(I, filename);
 
   width = I.getWidth();
   height = I.getHeight();
@@ -297,20 +539,11 @@ vpDiskGrabber::acquire(vpImage<vpRGBa> &I, long img_number)
 void
 vpDiskGrabber::acquire(vpImage<float> &I, long img_number)
 {
-  m_image_number = m_image_number_next;
-  std::stringstream ss;
-  if(m_use_generic_name) {
-    char filename[FILENAME_MAX];
-    sprintf(filename, m_generic_name.c_str(), m_image_number);
-    ss << filename;
-  }
-  else {
-    ss << m_directory << "/" << m_base_name << std::setfill('0') << std::setw(m_number_of_zero) << img_number << "." << m_extension;
-  }
-
-  m_image_number_next += m_image_step;
+  m_image_number = img_number;
+  m_image_number_next = img_number + m_image_step;
+  std::string filename = getImageFileName(m_image_number);
 
-  vpImageIo::readPFM(I, ss.str());
+  vpImageIo::readPFM(I, filename);
 
   width = I.getWidth();
   height = I.getHeight();
@@ -331,10 +564,11 @@ vpDiskGrabber::close()
 /*!
   Destructor
 
-  In fact nothing to destroy...
+  Stops the read-ahead decoding threads if any.
  */
 vpDiskGrabber::~vpDiskGrabber()
 {
+  stopReadAhead();
 }
 
 
@@ -344,6 +578,7 @@ vpDiskGrabber::~vpDiskGrabber()
 void
 vpDiskGrabber::setDirectory(const std::string &dir)
 {
+  stopReadAhead();
   m_directory = dir;
 }
 
@@ -353,6 +588,7 @@ vpDiskGrabber::setDirectory(const std::string &dir)
 void
 vpDiskGrabber::setBaseName(const std::string &name)
 {
+  stopReadAhead();
   m_base_name = name;
 }
 
@@ -362,6 +598,7 @@ vpDiskGrabber::setBaseName(const std::string &name)
 void
 vpDiskGrabber::setExtension(const std::string &ext)
 {
+  stopReadAhead();
   m_extension = ext;
 }
 
@@ -384,17 +621,115 @@ vpDiskGrabber::setStep(long step)
   m_image_step = step;
 }
 /*!
-  Set the step between two images.
+  Set the number of digits used to code the image number.
 */
 void
 vpDiskGrabber::setNumberOfZero(unsigned int noz)
 {
+  stopReadAhead();
   m_number_of_zero = noz;
 }
 
+/*!
+  Set the generic name of the image sequence, for example "image%04d.jpg".
+*/
 void
 vpDiskGrabber::setGenericName(const std::string &generic_name)
 {
+  stopReadAhead();
   m_generic_name = generic_name;
   m_use_generic_name = true;
 }
+
+/*!
+  Enable or disable frame dropping in read-ahead mode.
+
+  When enabled and several images following the expected one are already
+  decoded, acquire() delivers the most recent of them and drops the others.
+  This allows a consumer slower than the decoders to stay synchronized with
+  the sequence. The number of skipped images is given by getNbDroppedFrames().
+  Without read-ahead, no image is dropped.
+
+  \sa setReadAhead()
+*/
+void
+vpDiskGrabber::setFrameDropping(bool drop)
+{
+  m_frame_dropping = drop;
+}
+
+/*!
+  Enable the read-ahead mode where the next images of the sequence are
+  decoded in advance by \e nbThreads background threads. Decoded images are
+  stored in a ring of \e bufferSize images and are delivered in the sequence
+  order by acquire().
+
+  Changing the image number with setImageNumber() or the step with setStep()
+  is supported; the images decoded in advance are then discarded.
+
+  The read-ahead mode requires pthread or the Windows threading API;
+  otherwise images are read by the calling thread.
+
+  \param nbThreads : Number of decoding threads. Set to 0 to disable read-ahead (default).
+  \param bufferSize : Maximum number of images decoded in advance. If 0, it is set to
+  twice the number of threads.
+
+  \sa setFrameDropping()
+*/
+void
+vpDiskGrabber::setReadAhead(unsigned int nbThreads, unsigned int bufferSize)
+{
+  stopReadAhead();
+#ifdef VP_DISK_GRABBER_THREAD_OK
+  m_read_ahead_threads = nbThreads;
+#else
+  if (nbThreads > 0)
+    std::cerr << "Pthread or WIN32 API is needed to use the read-ahead mode." << std::endl;
+  m_read_ahead_threads = 0;
+#endif
+  m_read_ahead_buffer_size = (bufferSize > 0) ? bufferSize : 2*nbThreads;
+}
+
+/*!
+  Return the number of images skipped by acquire() since the read-ahead mode
+  was enabled.
+
+  \sa setFrameDropping()
+*/
+unsigned int
+vpDiskGrabber::getNbDroppedFrames() const
+{
+  if (m_read_ahead == NULL)
+    return 0;
+  return m_read_ahead->getNbDroppedFrames();
+}
+
+/*!
+  Build the name of the file of image \e number.
+*/
+std::string
+vpDiskGrabber::getImageFileName(long number) const
+{
+  std::stringstream ss;
+  if(m_use_generic_name) {
+    char filename[FILENAME_MAX];
+    sprintf(filename, m_generic_name.c_str(), number);
+    ss << filename;
+  }
+  else {
+    ss << m_directory << "/" << m_base_name << std::setfill('0') << std::setw(m_number_of_zero) << number << "." << m_extension;
+  }
+  return ss.str();
+}
+
+/*!
+  Stop the read-ahead decoding threads and release the decoded images.
+*/
+void
+vpDiskGrabber::stopReadAhead()
+{
+  if (m_read_ahead != NULL) {
+    delete m_read_ahead;
+    m_read_ahead = NULL;
+  }
+}
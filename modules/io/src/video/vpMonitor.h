@@ -0,0 +1,153 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2017 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * Description:
+ * Mutex and condition variable used by the background threads of the
+ * video reader and writer.
+ *
+ *****************************************************************************/
+
+#ifndef __vpMonitor_h_
+#define __vpMonitor_h_
+
+#include <visp3/core/vpConfig.h>
+
+#if defined(VISP_HAVE_PTHREAD) || (defined(_WIN32) && !defined(WINRT_8_0))
+
+#if defined(VISP_HAVE_PTHREAD)
+#  include <pthread.h>
+#elif defined(_WIN32)
+// Include WinSock2.h before windows.h to ensure that winsock.h is not included by windows.h
+// since winsock.h and winsock2.h are incompatible
+#  include <WinSock2.h>
+#  include <windows.h>
+#endif
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+/*
+  Mutex associated with a condition variable, so that a thread can sleep until
+  another thread changes the state protected by the mutex. vpMutex gives no
+  access to its native handle, that is why the mutex is not a vpMutex.
+
+  wait() has to be called with the mutex locked, in a loop that checks the
+  awaited state, since a thread may be woken up while the state did not change.
+  notifyAll() has to be called after each change of the state.
+*/
+class vpMonitor
+{
+public:
+  vpMonitor()
+  {
+#if defined(VISP_HAVE_PTHREAD)
+    pthread_mutex_init(&m_mutex, NULL);
+    pthread_cond_init(&m_cond, NULL);
+#elif defined(_WIN32)
+    InitializeCriticalSection(&m_mutex);
+    InitializeConditionVariable(&m_cond);
+#endif
+  }
+
+  ~vpMonitor()
+  {
+#if defined(VISP_HAVE_PTHREAD)
+    pthread_cond_destroy(&m_cond);
+    pthread_mutex_destroy(&m_mutex);
+#elif defined(_WIN32)
+    DeleteCriticalSection(&m_mutex);
+#endif
+  }
+
+  void lock()
+  {
+#if defined(VISP_HAVE_PTHREAD)
+    pthread_mutex_lock(&m_mutex);
+#elif defined(_WIN32)
+    EnterCriticalSection(&m_mutex);
+#endif
+  }
+
+  void unlock()
+  {
+#if defined(VISP_HAVE_PTHREAD)
+    pthread_mutex_unlock(&m_mutex);
+#elif defined(_WIN32)
+    LeaveCriticalSection(&m_mutex);
+#endif
+  }
+
+  // Wake up all the threads waiting in wait()
+  void notifyAll()
+  {
+#if defined(VISP_HAVE_PTHREAD)
+    pthread_cond_broadcast(&m_cond);
+#elif defined(_WIN32)
+    WakeAllConditionVariable(&m_cond);
+#endif
+  }
+
+  // Release the mutex, sleep until notifyAll() is called and lock the mutex again
+  void wait()
+  {
+#if defined(VISP_HAVE_PTHREAD)
+    pthread_cond_wait(&m_cond, &m_mutex);
+#elif defined(_WIN32)
+    SleepConditionVariableCS(&m_cond, &m_mutex, INFINITE);
+#endif
+  }
+
+  class vpScopedLock
+  {
+  public:
+    vpScopedLock(vpMonitor &monitor) : m_monitor(monitor) { m_monitor.lock(); }
+    ~vpScopedLock() { m_monitor.unlock(); }
+
+  private:
+    vpMonitor &m_monitor;
+
+    vpScopedLock(const vpScopedLock &);
+    vpScopedLock &operator=(const vpScopedLock &);
+  };
+
+private:
+#if defined(VISP_HAVE_PTHREAD)
+  pthread_mutex_t m_mutex;
+  pthread_cond_t m_cond;
+#elif defined(_WIN32)
+  CRITICAL_SECTION m_mutex;
+  CONDITION_VARIABLE m_cond;
+#endif
+
+  vpMonitor(const vpMonitor &);
+  vpMonitor &operator=(const vpMonitor &);
+};
+#endif // DOXYGEN_SHOULD_SKIP_THIS
+
+#endif
+#endif
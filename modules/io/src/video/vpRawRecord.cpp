@@ -0,0 +1,623 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2017 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * Description:
+ * Single file container of raw frames.
+ *
+ *****************************************************************************/
+
+/*!
+  \file vpRawRecord.cpp
+  \brief Single file container of raw frames (images, depth maps, point clouds).
+*/
+
+#include <string.h>
+
+#include <visp3/core/vpException.h>
+#include <visp3/core/vpImageConvert.h>
+#include <visp3/io/vpRawRecord.h>
+
+#if !defined(_WIN32) && (defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__))) // UNIX
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#  define VP_RAWRECORD_HAVE_MMAP
+#endif
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+/*
+  File layout, all the values are stored in the byte order of the host that
+  recorded the file:
+
+  - file header (16 bytes): "VISPRAW" followed by a null character, the format
+    version (uint32) and a byte order marker (uint32 0x01020304).
+  - frames: a frame header (48 bytes) followed by the payload. The frame header
+    contains the magic number "VPFR" (uint32), the frame type, stream, width,
+    height (uint32), a reserved field (uint32), the timestamp (double), the
+    payload size (uint64) and a reserved field (uint64).
+  - index: one 48 bytes entry per frame, with the same layout as the frame
+    header except that the last field is the position of the payload in the file.
+  - trailer (24 bytes): position of the index (uint64), number of frames (uint64)
+    and "VPRAWIDX".
+*/
+namespace
+{
+const char vpRawRecordMagic[8] = { 'V', 'I', 'S', 'P', 'R', 'A', 'W', '\0' };
+const char vpRawRecordIndexMagic[8] = { 'V', 'P', 'R', 'A', 'W', 'I', 'D', 'X' };
+const unsigned int vpRawRecordVersion = 1;
+const unsigned int vpRawRecordByteOrder = 0x01020304;
+const unsigned int vpRawRecordFrameMagic = 0x52465056; // "VPFR"
+const unsigned int vpRawRecordFileHeaderSize = 16;
+const unsigned int vpRawRecordFrameHeaderSize = 48;
+const unsigned int vpRawRecordTrailerSize = 24;
+
+void vpEncodeFrameHeader(unsigned char *buf, unsigned int type, unsigned int stream, unsigned int width,
+                         unsigned int height, double timestamp, unsigned long long size,
+                         unsigned long long last)
+{
+  unsigned int u[6] = { vpRawRecordFrameMagic, type, stream, width, height, 0 };
+  memcpy(buf, u, sizeof(u));
+  memcpy(buf + 24, &timestamp, sizeof(double));
+  memcpy(buf + 32, &size, sizeof(unsigned long long));
+  memcpy(buf + 40, &last, sizeof(unsigned long long));
+}
+
+bool vpDecodeFrameHeader(const unsigned char *buf, unsigned int &type, unsigned int &stream, unsigned int &width,
+                         unsigned int &height, double &timestamp, unsigned long long &size,
+                         unsigned long long &last)
+{
+  unsigned int u[6];
+  memcpy(u, buf, sizeof(u));
+  if (u[0] != vpRawRecordFrameMagic)
+    return false;
+  type = u[1];
+  stream = u[2];
+  width = u[3];
+  height = u[4];
+  memcpy(&timestamp, buf + 24, sizeof(double));
+  memcpy(&size, buf + 32, sizeof(unsigned long long));
+  memcpy(&last, buf + 40, sizeof(unsigned long long));
+  return true;
+}
+}
+#endif
+
+/*!
+  Default constructor. Use create() to record frames or open() to read a recording.
+*/
+vpRawRecord::vpRawRecord()
+  : m_filename(), m_writing(false), m_reading(false), m_ofs(), m_ifs(), m_writePos(0), m_index(),
+    m_map(NULL), m_mapSize(0)
+{
+}
+
+/*!
+  Destructor that calls close().
+*/
+vpRawRecord::~vpRawRecord()
+{
+  try {
+    close();
+  }
+  catch(...) {
+  }
+}
+
+/*!
+  Close the recording. When the recording was created with create(), the index
+  of the frames is appended to the file.
+
+  \exception vpException::ioError : If the index cannot be written.
+*/
+void vpRawRecord::close()
+{
+  if (m_writing) {
+    m_writing = false;
+    std::vector<unsigned char> buf(vpRawRecordFrameHeaderSize * m_index.size() + vpRawRecordTrailerSize);
+    unsigned char *ptr = &buf[0];
+    for (size_t i = 0; i < m_index.size(); i++, ptr += vpRawRecordFrameHeaderSize) {
+      const vpFrameInfo &info = m_index[i];
+      vpEncodeFrameHeader(ptr, info.type, info.stream, info.width, info.height, info.timestamp, info.size, info.offset);
+    }
+    unsigned long long nbFrames = m_index.size();
+    memcpy(ptr, &m_writePos, sizeof(unsigned long long));
+    memcpy(ptr + 8, &nbFrames, sizeof(unsigned long long));
+    memcpy(ptr + 16, vpRawRecordIndexMagic, 8);
+    m_ofs.write((const char *)&buf[0], (std::streamsize)buf.size());
+    m_ofs.close();
+    bool fail = m_ofs.fail();
+    m_ofs.clear();
+    m_index.clear();
+    if (fail) {
+      throw(vpException(vpException::ioError, "Cannot write the index of the recording \"%s\"", m_filename.c_str()));
+    }
+  }
+  if (m_reading) {
+    m_reading = false;
+#if defined(VP_RAWRECORD_HAVE_MMAP)
+    if (m_map != NULL) {
+      munmap(const_cast<unsigned char *>(m_map), (size_t)m_mapSize);
+    }
+#endif
+    m_map = NULL;
+    m_mapSize = 0;
+    if (m_ifs.is_open())
+      m_ifs.close();
+    m_ifs.clear();
+    m_index.clear();
+  }
+}
+
+/*!
+  Create a new recording. If the file exists, it is overwritten.
+
+  \param filename : Name of the recording file, by convention with the ".vpraw" extension.
+
+  \exception vpException::ioError : If the file cannot be created.
+*/
+void vpRawRecord::create(const std::string &filename)
+{
+  close();
+
+  m_ofs.open(filename.c_str(), std::ios::binary | std::ios::trunc);
+  if (!m_ofs.is_open()) {
+    m_ofs.clear();
+    throw(vpException(vpException::ioError, "Cannot create the recording \"%s\"", filename.c_str()));
+  }
+  m_filename = filename;
+
+  unsigned char header[vpRawRecordFileHeaderSize];
+  memcpy(header, vpRawRecordMagic, 8);
+  memcpy(header + 8, &vpRawRecordVersion, sizeof(unsigned int));
+  memcpy(header + 12, &vpRawRecordByteOrder, sizeof(unsigned int));
+  m_ofs.write((const char *)header, vpRawRecordFileHeaderSize);
+  if (m_ofs.fail()) {
+    m_ofs.close();
+    m_ofs.clear();
+    throw(vpException(vpException::ioError, "Cannot write in the recording \"%s\"", filename.c_str()));
+  }
+
+  m_writePos = vpRawRecordFileHeaderSize;
+  m_index.clear();
+  m_writing = true;
+}
+
+/*!
+  Open an existing recording for reading.
+
+  \param filename : Name of the recording file.
+  \param useMemoryMapping : If true, the whole file is mapped in memory when the
+  platform supports it. Frames are then read without any system call, which is
+  faster for random access. Otherwise frames are read with a seek followed by a
+  single read.
+
+  \exception vpException::ioError : If the file cannot be opened or is not a recording.
+*/
+void vpRawRecord::open(const std::string &filename, bool useMemoryMapping)
+{
+  close();
+
+  m_ifs.open(filename.c_str(), std::ios::binary);
+  if (!m_ifs.is_open()) {
+    m_ifs.clear();
+    throw(vpException(vpException::ioError, "Cannot open the recording \"%s\"", filename.c_str()));
+  }
+  m_filename = filename;
+  m_ifs.seekg(0, std::ios::end);
+  m_mapSize = (unsigned long long)m_ifs.tellg();
+  m_reading = true;
+
+#if defined(VP_RAWRECORD_HAVE_MMAP)
+  if (useMemoryMapping && m_mapSize > 0) {
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd >= 0) {
+      void *data = mmap(NULL, (size_t)m_mapSize, PROT_READ, MAP_PRIVATE, fd, 0);
+      ::close(fd);
+      if (data != MAP_FAILED) {
+        m_map = static_cast<const unsigned char *>(data);
+      }
+    }
+  }
+#else
+  (void)useMemoryMapping;
+#endif
+
+  try {
+    unsigned char header[vpRawRecordFileHeaderSize];
+    readAt(0, header, vpRawRecordFileHeaderSize);
+    unsigned int version, byteOrder;
+    memcpy(&version, header + 8, sizeof(unsigned int));
+    memcpy(&byteOrder, header + 12, sizeof(unsigned int));
+    if (memcmp(header, vpRawRecordMagic, 8) != 0) {
+      throw(vpException(vpException::ioError, "\"%s\" is not a ViSP raw recording", filename.c_str()));
+    }
+    if (version != vpRawRecordVersion || byteOrder != vpRawRecordByteOrder) {
+      throw(vpException(vpException::ioError, "Unsupported version or byte order in the recording \"%s\"",
+                        filename.c_str()));
+    }
+
+    // Use the index stored at the end of the file if it is complete
+    bool indexed = false;
+    if (m_mapSize >= vpRawRecordFileHeaderSize + vpRawRecordTrailerSize) {
+      unsigned char trailer[vpRawRecordTrailerSize];
+      readAt(m_mapSize - vpRawRecordTrailerSize, trailer, vpRawRecordTrailerSize);
+      unsigned long long indexPos, nbFrames;
+      memcpy(&indexPos, trailer, sizeof(unsigned long long));
+      memcpy(&nbFrames, trailer + 8, sizeof(unsigned long long));
+      if (memcmp(trailer + 16, vpRawRecordIndexMagic, 8) == 0 && indexPos >= vpRawRecordFileHeaderSize &&
+          indexPos <= m_mapSize - vpRawRecordTrailerSize && (m_mapSize - indexPos - vpRawRecordTrailerSize) / vpRawRecordFrameHeaderSize == nbFrames &&
+          (m_mapSize - indexPos - vpRawRecordTrailerSize) % vpRawRecordFrameHeaderSize == 0) {
+        std::vector<unsigned char> buf((size_t)(nbFrames * vpRawRecordFrameHeaderSize));
+        if (nbFrames > 0)
+          readAt(indexPos, &buf[0], buf.size());
+        m_index.resize((size_t)nbFrames);
+        indexed = true;
+        for (size_t i = 0; i < m_index.size() && indexed; i++) {
+          vpFrameInfo &info = m_index[i];
+          indexed = vpDecodeFrameHeader(&buf[i * vpRawRecordFrameHeaderSize], info.type, info.stream, info.width,
+                                        info.height, info.timestamp, info.size, info.offset) &&
+                    info.offset <= indexPos && info.size <= indexPos - info.offset;
+        }
+      }
+    }
+    if (!indexed) {
+      rebuildIndex();
+    }
+  }
+  catch(...) {
+    close();
+    throw;
+  }
+}
+
+/*!
+  Rebuild the index of a recording which was not closed properly by walking
+  through the frame headers. An incomplete last frame is ignored.
+*/
+void vpRawRecord::rebuildIndex()
+{
+  m_index.clear();
+  unsigned long long pos = vpRawRecordFileHeaderSize;
+  unsigned char buf[vpRawRecordFrameHeaderSize];
+  while (m_mapSize - pos >= vpRawRecordFrameHeaderSize) {
+    vpFrameInfo info;
+    unsigned long long reserved;
+    readAt(pos, buf, vpRawRecordFrameHeaderSize);
+    if (!vpDecodeFrameHeader(buf, info.type, info.stream, info.width, info.height, info.timestamp, info.size,
+                             reserved)) {
+      break;
+    }
+    info.offset = pos + vpRawRecordFrameHeaderSize;
+    if (info.size > m_mapSize - info.offset) {
+      break;
+    }
+    m_index.push_back(info);
+    pos = info.offset + info.size;
+  }
+}
+
+/*!
+  Read \e size bytes at position \e offset of the recording.
+*/
+void vpRawRecord::readAt(unsigned long long offset, void *data, unsigned long long size)
+{
+  if (offset > m_mapSize || size > m_mapSize - offset) {
+    throw(vpException(vpException::ioError, "Truncated recording \"%s\"", m_filename.c_str()));
+  }
+  if (m_map != NULL) {
+    memcpy(data, m_map + offset, (size_t)size);
+    return;
+  }
+  m_ifs.clear();
+  m_ifs.seekg((std::streamoff)offset, std::ios::beg);
+  m_ifs.read((char *)data, (std::streamsize)size);
+  if (m_ifs.fail()) {
+    throw(vpException(vpException::ioError, "Cannot read the recording \"%s\"", m_filename.c_str()));
+  }
+}
+
+const vpRawRecord::vpFrameInfo &vpRawRecord::getFrameInfo(unsigned int index) const
+{
+  if (index >= m_index.size()) {
+    throw(vpException(vpException::badValue, "Frame %u is out of the recording \"%s\" of %u frames", index,
+                      m_filename.c_str(), (unsigned int)m_index.size()));
+  }
+  return m_index[index];
+}
+
+/*
+  Check that the payload of the frame \e index holds exactly width x height
+  elements of \e elementSize bytes, so that a corrupted size cannot make
+  read() overflow the image or leave it partially filled.
+*/
+void vpRawRecord::checkFrameSize(unsigned int index, const vpFrameInfo &info, unsigned long long elementSize) const
+{
+  if (info.size % elementSize != 0 || info.size / elementSize != (unsigned long long)info.width * info.height) {
+    throw(vpException(vpException::ioError,
+                      "Frame %u of the recording \"%s\" has a size of %llu bytes instead of %u x %u x %llu", index,
+                      m_filename.c_str(), info.size, info.width, info.height, elementSize));
+  }
+}
+
+/*!
+  Return the type of the frame \e index.
+*/
+vpRawRecord::vpFrameType vpRawRecord::getFrameType(unsigned int index) const
+{
+  return (vpFrameType)getFrameInfo(index).type;
+}
+
+/*!
+  Return the height of the image \e index. For a point cloud, return the
+  number of coordinates of each point.
+*/
+unsigned int vpRawRecord::getHeight(unsigned int index) const { return getFrameInfo(index).height; }
+
+/*!
+  Return the stream identifier of the frame \e index.
+*/
+unsigned int vpRawRecord::getStream(unsigned int index) const { return getFrameInfo(index).stream; }
+
+/*!
+  Return the timestamp of the frame \e index as given to write().
+*/
+double vpRawRecord::getTimestamp(unsigned int index) const { return getFrameInfo(index).timestamp; }
+
+/*!
+  Return the width of the image \e index. For a point cloud, return the
+  number of points.
+*/
+unsigned int vpRawRecord::getWidth(unsigned int index) const { return getFrameInfo(index).width; }
+
+/*!
+  Read the frame \e index as a grey level image. A color frame is converted
+  in grey level.
+
+  \exception vpException::badValue : If the frame is not a grey level or color image.
+*/
+void vpRawRecord::read(unsigned int index, vpImage<unsigned char> &I)
+{
+  const vpFrameInfo &info = getFrameInfo(index);
+  if (info.type == FRAME_GREY) {
+    checkFrameSize(index, info, sizeof(unsigned char));
+    I.resize(info.height, info.width);
+    readAt(info.offset, I.bitmap, I.getSize());
+  }
+  else if (info.type == FRAME_RGBA) {
+    vpImage<vpRGBa> Irgba;
+    read(index, Irgba);
+    vpImageConvert::convert(Irgba, I);
+  }
+  else {
+    throw(vpException(vpException::badValue, "Frame %u is not an image", index));
+  }
+}
+
+/*!
+  Read the frame \e index as a color image. A grey level frame is converted
+  in color.
+
+  \exception vpException::badValue : If the frame is not a grey level or color image.
+*/
+void vpRawRecord::read(unsigned int index, vpImage<vpRGBa> &I)
+{
+  const vpFrameInfo &info = getFrameInfo(index);
+  if (info.type == FRAME_RGBA) {
+    checkFrameSize(index, info, sizeof(vpRGBa));
+    I.resize(info.height, info.width);
+    readAt(info.offset, I.bitmap, sizeof(vpRGBa) * (unsigned long long)I.getSize());
+  }
+  else if (info.type == FRAME_GREY) {
+    vpImage<unsigned char> Igrey;
+    read(index, Igrey);
+    vpImageConvert::convert(Igrey, I);
+  }
+  else {
+    throw(vpException(vpException::badValue, "Frame %u is not an image", index));
+  }
+}
+
+/*!
+  Read the depth map \e index.
+
+  \exception vpException::badValue : If the frame is not a depth map.
+*/
+void vpRawRecord::read(unsigned int index, vpImage<uint16_t> &I)
+{
+  const vpFrameInfo &info = getFrameInfo(index);
+  if (info.type != FRAME_DEPTH) {
+    throw(vpException(vpException::badValue, "Frame %u is not a depth map", index));
+  }
+  checkFrameSize(index, info, sizeof(uint16_t));
+  I.resize(info.height, info.width);
+  readAt(info.offset, I.bitmap, sizeof(uint16_t) * (unsigned long long)I.getSize());
+}
+
+/*!
+  Read the float image \e index.
+
+  \exception vpException::badValue : If the frame is not a float image.
+*/
+void vpRawRecord::read(unsigned int index, vpImage<float> &I)
+{
+  const vpFrameInfo &info = getFrameInfo(index);
+  if (info.type != FRAME_FLOAT) {
+    throw(vpException(vpException::badValue, "Frame %u is not a float image", index));
+  }
+  checkFrameSize(index, info, sizeof(float));
+  I.resize(info.height, info.width);
+  readAt(info.offset, I.bitmap, sizeof(float) * (unsigned long long)I.getSize());
+}
+
+/*!
+  Read the point cloud \e index.
+
+  \exception vpException::badValue : If the frame is not a point cloud.
+*/
+void vpRawRecord::read(unsigned int index, std::vector<vpColVector> &pointcloud)
+{
+  const vpFrameInfo &info = getFrameInfo(index);
+  if (info.type != FRAME_POINTCLOUD) {
+    throw(vpException(vpException::badValue, "Frame %u is not a point cloud", index));
+  }
+  checkFrameSize(index, info, sizeof(float));
+  std::vector<float> data((size_t)info.width * info.height);
+  if (!data.empty())
+    readAt(info.offset, &data[0], sizeof(float) * (unsigned long long)data.size());
+
+  pointcloud.resize(info.width);
+  for (unsigned int i = 0; i < info.width; i++) {
+    vpColVector &v = pointcloud[i];
+    v.resize(info.height, false);
+    const float *p = &data[(size_t)i * info.height];
+    for (unsigned int j = 0; j < info.height; j++)
+      v[j] = p[j];
+  }
+}
+
+/*!
+  Append a grey level image to the recording.
+
+  \param I : Image to record.
+  \param timestamp : Timestamp of the image, for example from vpTime::measureTimeMs().
+  \param stream : Identifier of the sensor or of the data stream.
+
+  \exception vpException::ioError : If the recording is not created or cannot be written.
+*/
+void vpRawRecord::write(const vpImage<unsigned char> &I, double timestamp, unsigned int stream)
+{
+  writeFrame(FRAME_GREY, I.getWidth(), I.getHeight(), timestamp, stream, I.bitmap, I.getSize());
+}
+
+/*!
+  Append a color image to the recording.
+
+  \param I : Image to record.
+  \param timestamp : Timestamp of the image, for example from vpTime::measureTimeMs().
+  \param stream : Identifier of the sensor or of the data stream.
+
+  \exception vpException::ioError : If the recording is not created or cannot be written.
+*/
+void vpRawRecord::write(const vpImage<vpRGBa> &I, double timestamp, unsigned int stream)
+{
+  writeFrame(FRAME_RGBA, I.getWidth(), I.getHeight(), timestamp, stream, I.bitmap,
+             sizeof(vpRGBa) * (unsigned long long)I.getSize());
+}
+
+/*!
+  Append a depth map to the recording.
+
+  \param I : Depth map to record.
+  \param timestamp : Timestamp of the depth map, for example from vpTime::measureTimeMs().
+  \param stream : Identifier of the sensor or of the data stream.
+
+  \exception vpException::ioError : If the recording is not created or cannot be written.
+*/
+void vpRawRecord::write(const vpImage<uint16_t> &I, double timestamp, unsigned int stream)
+{
+  writeFrame(FRAME_DEPTH, I.getWidth(), I.getHeight(), timestamp, stream, I.bitmap,
+             sizeof(uint16_t) * (unsigned long long)I.getSize());
+}
+
+/*!
+  Append a float image to the recording.
+
+  \param I : Image to record.
+  \param timestamp : Timestamp of the image, for example from vpTime::measureTimeMs().
+  \param stream : Identifier of the sensor or of the data stream.
+
+  \exception vpException::ioError : If the recording is not created or cannot be written.
+*/
+void vpRawRecord::write(const vpImage<float> &I, double timestamp, unsigned int stream)
+{
+  writeFrame(FRAME_FLOAT, I.getWidth(), I.getHeight(), timestamp, stream, I.bitmap,
+             sizeof(float) * (unsigned long long)I.getSize());
+}
+
+/*!
+  Append a point cloud to the recording. All the points must have the same
+  number of coordinates, for example 4 for the homogeneous coordinates
+  returned by vpRealSense2::acquire(). Coordinates are stored in single
+  precision.
+
+  \param pointcloud : Point cloud to record.
+  \param timestamp : Timestamp of the point cloud, for example from vpTime::measureTimeMs().
+  \param stream : Identifier of the sensor or of the data stream.
+
+  \exception vpException::dimensionError : If the points do not have the same size.
+  \exception vpException::ioError : If the recording is not created or cannot be written.
+*/
+void vpRawRecord::write(const std::vector<vpColVector> &pointcloud, double timestamp, unsigned int stream)
+{
+  unsigned int nbPoints = (unsigned int)pointcloud.size();
+  unsigned int dim = nbPoints > 0 ? pointcloud[0].getRows() : 0;
+  std::vector<float> data((size_t)nbPoints * dim);
+  for (unsigned int i = 0; i < nbPoints; i++) {
+    const vpColVector &v = pointcloud[i];
+    if (v.getRows() != dim) {
+      throw(vpException(vpException::dimensionError, "Point %u of the point cloud has %u coordinates instead of %u",
+                        i, v.getRows(), dim));
+    }
+    float *p = &data[(size_t)i * dim];
+    for (unsigned int j = 0; j < dim; j++)
+      p[j] = (float)v[j];
+  }
+  writeFrame(FRAME_POINTCLOUD, nbPoints, dim, timestamp, stream, data.empty() ? NULL : &data[0],
+             sizeof(float) * (unsigned long long)data.size());
+}
+
+void vpRawRecord::writeFrame(vpFrameType type, unsigned int width, unsigned int height, double timestamp,
+                             unsigned int stream, const void *data, unsigned long long size)
+{
+  if (!m_writing) {
+    throw(vpException(vpException::ioError, "The recording is not created"));
+  }
+
+  unsigned char header[vpRawRecordFrameHeaderSize];
+  vpEncodeFrameHeader(header, (unsigned int)type, stream, width, height, timestamp, size, 0);
+  m_ofs.write((const char *)header, vpRawRecordFrameHeaderSize);
+  if (size > 0)
+    m_ofs.write((const char *)data, (std::streamsize)size);
+  if (m_ofs.fail()) {
+    throw(vpException(vpException::ioError, "Cannot write in the recording \"%s\"", m_filename.c_str()));
+  }
+
+  vpFrameInfo info;
+  info.type = (unsigned int)type;
+  info.stream = stream;
+  info.width = width;
+  info.height = height;
+  info.timestamp = timestamp;
+  info.size = size;
+  info.offset = m_writePos + vpRawRecordFrameHeaderSize;
+  m_index.push_back(info);
+  m_writePos = info.offset + size;
+}
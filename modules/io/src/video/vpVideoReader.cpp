@@ -46,10 +46,59 @@
 #include <visp3/io/vpVideoReader.h>
 #include <visp3/core/vpIoTools.h>
 
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <limits>   // numeric_limits
 #include <cctype>
+#include <cstring>
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+namespace
+{
+template <class Type> void vpCopyFrame(const vpImage<Type> &src, vpImage<Type> &dst)
+{
+  // Reuse the memory of dst, and keep its display
+  if (dst.getHeight() != src.getHeight() || dst.getWidth() != src.getWidth())
+    dst.resize(src.getHeight(), src.getWidth());
+  if (src.getSize() > 0)
+    memcpy((void *)dst.bitmap, (const void *)src.bitmap, src.getSize() * sizeof(Type));
+}
+
+template <class Entry, class Type>
+bool vpFindCachedFrame(std::list<Entry> &cache, long index, bool color, vpImage<Type> Entry::*image, vpImage<Type> &I)
+{
+  for (typename std::list<Entry>::iterator it = cache.begin(); it != cache.end(); ++it) {
+    if (it->index == index && it->color == color) {
+      // Move the frame at the front of the list, as the most recently used
+      cache.splice(cache.begin(), cache, it);
+      vpCopyFrame(cache.front().*image, I);
+      return true;
+    }
+  }
+  return false;
+}
+
+template <class Entry, class Type>
+void vpCacheFrame(std::list<Entry> &cache, size_t maxSize, long index, bool color, vpImage<Type> Entry::*image,
+                  const vpImage<Type> &I)
+{
+  if (maxSize == 0 || I.getSize() == 0)
+    return;
+
+  if (cache.size() >= maxSize) {
+    // Reuse the least recently used frame and its memory
+    cache.splice(cache.begin(), cache, --cache.end());
+  }
+  else {
+    cache.push_front(Entry());
+  }
+  cache.front().index = index;
+  cache.front().color = color;
+  vpCopyFrame(I, cache.front().*image);
+}
+}
+#endif
 
 /*!
 Basic constructor.
@@ -59,9 +108,11 @@ vpVideoReader::vpVideoReader()
 #if VISP_HAVE_OPENCV_VERSION >= 0x020100
   capture(), frame(),
 #endif
+  rawRecord(), rawFrames(), rawNextFrame(0),
   formatType(FORMAT_UNKNOWN), initFileName(false), isOpen(false), frameCount(0),
   firstFrame(0), lastFrame(0), firstFrameIndexIsSet(false), lastFrameIndexIsSet(false),
-  frameStep(1), frameRate(0.)
+  frameStep(1), frameRate(0.), frameDropping(false), readAheadBufferSize(0), readAheadThreads(0),
+  imageIndexes(), frameCache(), frameCacheSize(0), videoSeekFrame(-1)
 {
 }
 
@@ -100,6 +151,8 @@ void vpVideoReader::setFileName(const char *filename)
   }
 
   strcpy(this->fileName, filename);
+  imageIndexes.clear();
+  frameCache.clear();
 
   formatType = getFormat(fileName);
 
@@ -151,12 +204,42 @@ void vpVideoReader::getProperties()
     imSequence = new vpDiskGrabber;
     imSequence->setGenericName(fileName);
     imSequence->setStep(frameStep);
+    imSequence->setReadAhead(readAheadThreads, readAheadBufferSize);
+    imSequence->setFrameDropping(frameDropping);
     if (firstFrameIndexIsSet)
     {
       imSequence->setImageNumber(firstFrame);
     }
+    if (!firstFrameIndexIsSet || !lastFrameIndexIsSet)
+    {
+      buildImageIndexes();
+    }
     frameRate = -1.;
   }
+  else if (formatType == FORMAT_RAW)
+  {
+    rawRecord.open(fileName, true);
+    rawFrames.clear();
+    unsigned int stream = 0;
+    for (unsigned int i = 0; i < rawRecord.getNbFrames(); i++) {
+      vpRawRecord::vpFrameType type = rawRecord.getFrameType(i);
+      if (type != vpRawRecord::FRAME_GREY && type != vpRawRecord::FRAME_RGBA)
+        continue;
+      if (rawFrames.empty())
+        stream = rawRecord.getStream(i);
+      if (rawRecord.getStream(i) == stream)
+        rawFrames.push_back(i);
+    }
+    if (rawFrames.empty()) {
+      throw (vpException(vpException::ioError, "No image in the recording %s", fileName));
+    }
+    width = rawRecord.getWidth(rawFrames[0]);
+    height = rawRecord.getHeight(rawFrames[0]);
+    // Mean frame rate from the timestamps
+    double duration = rawRecord.getTimestamp(rawFrames.back()) - rawRecord.getTimestamp(rawFrames[0]);
+    frameRate = (rawFrames.size() > 1 && duration > 0.) ? 1000. * (rawFrames.size() - 1) / duration : -1.;
+    rawNextFrame = 0;
+  }
   else if (isVideoExtensionSupported())
   {
 #if VISP_HAVE_OPENCV_VERSION >= 0x020100
@@ -291,9 +374,27 @@ void vpVideoReader::acquire(vpImage< vpRGBa > &I)
       imSequence->setImageNumber(frameCount);
     }
   }
+  else if (formatType == FORMAT_RAW)
+  {
+    frameCount = rawNextFrame;
+    if (frameCount >= 0 && frameCount < (long)rawFrames.size())
+      rawRecord.read(rawFrames[(size_t)frameCount], I);
+    if (frameCount + frameStep <= lastFrame && frameCount + frameStep >= firstFrame) {
+      rawNextFrame = frameCount + frameStep;
+    }
+  }
 #if VISP_HAVE_OPENCV_VERSION >= 0x020100
   else
   {
+    if (videoSeekFrame >= 0) {
+      // Move to the frame that follows the last one given by the cache of getFrame()
+#if VISP_HAVE_OPENCV_VERSION >= 0x030000
+      capture.set(cv::CAP_PROP_POS_FRAMES, videoSeekFrame);
+#else
+      capture.set(CV_CAP_PROP_POS_FRAMES, videoSeekFrame);
+#endif
+      videoSeekFrame = -1;
+    }
     capture >> frame;
     if (frameStep == 1) {
       frameCount ++;
@@ -372,9 +473,27 @@ void vpVideoReader::acquire(vpImage< unsigned char > &I)
       imSequence->setImageNumber(frameCount);
     }
   }
+  else if (formatType == FORMAT_RAW)
+  {
+    frameCount = rawNextFrame;
+    if (frameCount >= 0 && frameCount < (long)rawFrames.size())
+      rawRecord.read(rawFrames[(size_t)frameCount], I);
+    if (frameCount + frameStep <= lastFrame && frameCount + frameStep >= firstFrame) {
+      rawNextFrame = frameCount + frameStep;
+    }
+  }
 #if VISP_HAVE_OPENCV_VERSION >= 0x020100
   else
   {
+    if (videoSeekFrame >= 0) {
+      // Move to the frame that follows the last one given by the cache of getFrame()
+#if VISP_HAVE_OPENCV_VERSION >= 0x030000
+      capture.set(cv::CAP_PROP_POS_FRAMES, videoSeekFrame);
+#else
+      capture.set(CV_CAP_PROP_POS_FRAMES, videoSeekFrame);
+#endif
+      videoSeekFrame = -1;
+    }
     capture >> frame;
     if (frameStep == 1) {
       frameCount ++;
@@ -442,6 +561,13 @@ one after one.
 */
 bool vpVideoReader::getFrame(vpImage<vpRGBa> &I, long frame_index)
 {
+  if (getCachedFrame(I, frame_index))
+  {
+    return true;
+  }
+
+  // Only the decoded frames are cached, not the previous content of I at the end of a video
+  bool decoded = true;
   if (imSequence != NULL)
   {
     try
@@ -464,10 +590,25 @@ bool vpVideoReader::getFrame(vpImage<vpRGBa> &I, long frame_index)
       return false;
     }
   }
+  else if (formatType == FORMAT_RAW)
+  {
+    if (frame_index < 0 || frame_index >= (long)rawFrames.size())
+    {
+      vpERROR_TRACE("Couldn't find the %ld th frame", frame_index);
+      return false;
+    }
+    rawRecord.read(rawFrames[(size_t)frame_index], I);
+    width = I.getWidth();
+    height = I.getHeight();
+    frameCount = frame_index;
+    rawNextFrame = frame_index; // the next acquire() gives this frame, as for image sequences
+  }
   else
   {
 #if defined(VISP_HAVE_OPENCV) && (VISP_HAVE_OPENCV_VERSION >= 0x030000)
-    if (!capture.set(cv::CAP_PROP_POS_FRAMES, frame_index))
+    videoSeekFrame = -1;
+    // Seeking is costly, even to the current position
+    if ((long)capture.get(cv::CAP_PROP_POS_FRAMES) != frame_index && !capture.set(cv::CAP_PROP_POS_FRAMES, frame_index))
     {
       vpERROR_TRACE("Couldn't find the %ld th frame", frame_index);
       return false;
@@ -475,7 +616,8 @@ bool vpVideoReader::getFrame(vpImage<vpRGBa> &I, long frame_index)
 
     capture >> frame;
     frameCount = frame_index + frameStep;  // next index
-    capture.set(cv::CAP_PROP_POS_FRAMES, frameCount);
+    if (frameStep != 1)
+      capture.set(cv::CAP_PROP_POS_FRAMES, frameCount);
     if (frame.empty())
     {
     // New trial that makes things working with opencv 3.0.0
@@ -492,7 +634,9 @@ bool vpVideoReader::getFrame(vpImage<vpRGBa> &I, long frame_index)
     else
       vpImageConvert::convert(frame, I);
 #elif defined(VISP_HAVE_OPENCV) && (VISP_HAVE_OPENCV_VERSION >= 0x020100)
-    if (!capture.set(CV_CAP_PROP_POS_FRAMES, frame_index))
+    videoSeekFrame = -1;
+    // Seeking is costly, even to the current position
+    if ((long)capture.get(CV_CAP_PROP_POS_FRAMES) != frame_index && !capture.set(CV_CAP_PROP_POS_FRAMES, frame_index))
     {
       vpERROR_TRACE("Couldn't find the %ld th frame", frame_index);
       return false;
@@ -500,13 +644,18 @@ bool vpVideoReader::getFrame(vpImage<vpRGBa> &I, long frame_index)
 
     capture >> frame;
     frameCount = frame_index + frameStep;  // next index
-    capture.set(CV_CAP_PROP_POS_FRAMES, frameCount);
-    if (frame.empty())
+    if (frameStep != 1)
+      capture.set(CV_CAP_PROP_POS_FRAMES, frameCount);
+    if (frame.empty()) {
       setLastFrameIndex(frameCount - frameStep);
+      decoded = false;
+    }
     else
       vpImageConvert::convert(frame, I);
 #endif
   }
+  if (decoded)
+    vpCacheFrame(frameCache, frameCacheSize, frame_index, true, &vpCachedFrame::Icolor, I);
   return true;
 }
 
@@ -525,6 +674,13 @@ one after one.
 */
 bool vpVideoReader::getFrame(vpImage<unsigned char> &I, long frame_index)
 {
+  if (getCachedFrame(I, frame_index))
+  {
+    return true;
+  }
+
+  // Only the decoded frames are cached, not the previous content of I at the end of a video
+  bool decoded = true;
   if (imSequence != NULL)
   {
     try
@@ -547,10 +703,25 @@ bool vpVideoReader::getFrame(vpImage<unsigned char> &I, long frame_index)
       return false;
     }
   }
+  else if (formatType == FORMAT_RAW)
+  {
+    if (frame_index < 0 || frame_index >= (long)rawFrames.size())
+    {
+      vpERROR_TRACE("Couldn't find the %ld th frame", frame_index);
+      return false;
+    }
+    rawRecord.read(rawFrames[(size_t)frame_index], I);
+    width = I.getWidth();
+    height = I.getHeight();
+    frameCount = frame_index;
+    rawNextFrame = frame_index; // the next acquire() gives this frame, as for image sequences
+  }
   else
   {
 #if VISP_HAVE_OPENCV_VERSION >= 0x030000
-  if (!capture.set(cv::CAP_PROP_POS_FRAMES, frame_index))
+  videoSeekFrame = -1;
+  // Seeking is costly, even to the current position
+  if ((long)capture.get(cv::CAP_PROP_POS_FRAMES) != frame_index && !capture.set(cv::CAP_PROP_POS_FRAMES, frame_index))
   {
     vpERROR_TRACE("Couldn't find the %ld th frame", frame_index);
     return false;
@@ -575,7 +746,9 @@ bool vpVideoReader::getFrame(vpImage<unsigned char> &I, long frame_index)
     vpImageConvert::convert(frame, I);
   }
 #elif VISP_HAVE_OPENCV_VERSION >= 0x020100
-  if (!capture.set(CV_CAP_PROP_POS_FRAMES, frame_index))
+  videoSeekFrame = -1;
+  // Seeking is costly, even to the current position
+  if ((long)capture.get(CV_CAP_PROP_POS_FRAMES) != frame_index && !capture.set(CV_CAP_PROP_POS_FRAMES, frame_index))
   {
     vpERROR_TRACE("Couldn't find the %ld th frame", frame_index); // next index
     return false;
@@ -590,12 +763,16 @@ bool vpVideoReader::getFrame(vpImage<unsigned char> &I, long frame_index)
     frameCount += frameStep - 1; // next index
     capture.set(CV_CAP_PROP_POS_FRAMES, frameCount);
   }
-  if (frame.empty())
+  if (frame.empty()) {
     setLastFrameIndex(frameCount - frameStep);
+    decoded = false;
+  }
   else
     vpImageConvert::convert(frame, I);
 #endif
   }
+  if (decoded)
+    vpCacheFrame(frameCache, frameCacheSize, frame_index, false, &vpCachedFrame::I, I);
   return true;
 }
 
@@ -700,6 +877,10 @@ vpVideoReader::vpVideoFormatType
     return FORMAT_MKV;
   else if (ext.compare(".mkv") == 0)
     return FORMAT_MKV;
+  else if (ext.compare(".VPRAW") == 0)
+    return FORMAT_RAW;
+  else if (ext.compare(".vpraw") == 0)
+    return FORMAT_RAW;
   else
     return FORMAT_UNKNOWN;
 }
@@ -727,25 +908,14 @@ void vpVideoReader::findLastFrameIndex()
   {
     if (! lastFrameIndexIsSet)
     {
-      std::string imageNameFormat = vpIoTools::getName(std::string(fileName));
-      std::string dirName = vpIoTools::getParent(std::string(fileName));
-      if (dirName == "")
-      {
-        dirName = ".";
-      }
-      std::vector<std::string> files = vpIoTools::getDirFiles(dirName);
-      lastFrame = 0;
-      for (size_t i = 0 ; i < files.size(); i++) {
-        // Checking that file name satisfies image format,
-        // specified by imageNameFormat, and extracting imageIndex
-        long imageIndex = extractImageIndex(files[i], imageNameFormat);
-        if ((imageIndex != -1) && (imageIndex > lastFrame))
-        {
-          lastFrame = imageIndex;
-        }
-      }
+      lastFrame = imageIndexes.empty() ? 0 : std::max(0L, imageIndexes.back());
     }
   }
+  else if (formatType == FORMAT_RAW)
+  {
+    if (! lastFrameIndexIsSet)
+      lastFrame = (long)rawFrames.size() - 1;
+  }
 
 #if VISP_HAVE_OPENCV_VERSION >= 0x030000
   else if (!lastFrameIndexIsSet)
@@ -778,25 +948,15 @@ void vpVideoReader::findFirstFrameIndex()
   if (imSequence != NULL)
   {
     if (!firstFrameIndexIsSet) {
-      std::string imageNameFormat = vpIoTools::getName(std::string(fileName));
-      std::string dirName = vpIoTools::getParent(std::string(fileName));
-      if (dirName == "")
-      {
-        dirName = ".";
-      }
-      std::vector<std::string> files = vpIoTools::getDirFiles(dirName);
-      firstFrame = -1;
-      for (size_t i = 0 ; i < files.size(); i++) {
-        // Checking that file name satisfies image format, specified by imageNameFormat, and extracting imageIndex
-        long imageIndex = extractImageIndex(files[i], imageNameFormat);
-        if ((imageIndex != -1) && (imageIndex < firstFrame || firstFrame == -1))
-        {
-          firstFrame = imageIndex;
-        }
-      }
+      firstFrame = imageIndexes.empty() ? -1 : imageIndexes.front();
       imSequence->setImageNumber(firstFrame);
     }
   }
+  else if (formatType == FORMAT_RAW)
+  {
+    if (!firstFrameIndexIsSet)
+      firstFrame = 0;
+  }
 #if VISP_HAVE_OPENCV_VERSION >= 0x020100
   else if (!firstFrameIndexIsSet)
   {
@@ -959,3 +1119,151 @@ bool vpVideoReader::checkImageNameFormat(const std::string &format)
   }
   return true;
 }
+
+/*!
+  Enable the read-ahead mode when reading a sequence of images. The next
+  images of the sequence are decoded in advance by \e nbThreads background
+  threads into a ring of \e bufferSize images; acquire() delivers them in the
+  sequence order. This option has no effect on video files.
+
+  \param nbThreads : Number of decoding threads. Set to 0 to disable read-ahead (default).
+  \param bufferSize : Maximum number of images decoded in advance. If 0, it is set to
+  twice the number of threads.
+
+  \sa vpDiskGrabber::setReadAhead(), setFrameDropping()
+*/
+void vpVideoReader::setReadAhead(unsigned int nbThreads, unsigned int bufferSize)
+{
+  readAheadThreads = nbThreads;
+  readAheadBufferSize = bufferSize;
+  if (imSequence != NULL)
+    imSequence->setReadAhead(readAheadThreads, readAheadBufferSize);
+}
+
+/*!
+  Enable or disable frame dropping when images are read ahead. When enabled and
+  the consumer is slower than the decoding threads, acquire() delivers the most
+  recent decoded image and skips the older ones. getFrameIndex() gives the index
+  of the delivered image.
+
+  \sa setReadAhead(), getNbDroppedFrames()
+*/
+void vpVideoReader::setFrameDropping(bool drop)
+{
+  frameDropping = drop;
+  if (imSequence != NULL)
+    imSequence->setFrameDropping(frameDropping);
+}
+
+/*!
+  Return the number of images skipped by acquire() when frame dropping is enabled.
+
+  \sa setFrameDropping()
+*/
+unsigned int vpVideoReader::getNbDroppedFrames() const
+{
+  if (imSequence != NULL)
+    return imSequence->getNbDroppedFrames();
+  return 0;
+}
+
+/*!
+  Set the maximum number of frames kept in memory by getFrame(). When a frame
+  already read by getFrame() is requested again, it is copied from memory
+  instead of being read and decoded again. The least recently used frames are
+  released first. This is useful to go back and forth in a sequence or a video.
+
+  \param size : Maximum number of frames in memory. Set to 0 to disable the
+  cache (default).
+*/
+void vpVideoReader::setFrameCacheSize(unsigned int size)
+{
+  frameCacheSize = size;
+  while (frameCache.size() > frameCacheSize)
+    frameCache.pop_back();
+}
+
+/*!
+  List the directory of the image sequence once and keep the sorted indexes of
+  the images whose name matches the file name template.
+*/
+void vpVideoReader::buildImageIndexes()
+{
+  std::string imageNameFormat = vpIoTools::getName(std::string(fileName));
+  std::string dirName = vpIoTools::getParent(std::string(fileName));
+  if (dirName == "")
+  {
+    dirName = ".";
+  }
+  std::vector<std::string> files = vpIoTools::getDirFiles(dirName);
+  imageIndexes.clear();
+  imageIndexes.reserve(files.size());
+  for (size_t i = 0 ; i < files.size(); i++) {
+    // Checking that file name satisfies image format, specified by imageNameFormat, and extracting imageIndex
+    long imageIndex = extractImageIndex(files[i], imageNameFormat);
+    if (imageIndex != -1)
+    {
+      imageIndexes.push_back(imageIndex);
+    }
+  }
+  std::sort(imageIndexes.begin(), imageIndexes.end());
+}
+
+/*!
+  Get a frame from the cache of getFrame() and update the reader position as
+  if the frame was read.
+
+  \return true if the frame was in the cache.
+*/
+bool vpVideoReader::getCachedFrame(vpImage<unsigned char> &I, long frame_index)
+{
+  if (frameCacheSize == 0 || !vpFindCachedFrame(frameCache, frame_index, false, &vpCachedFrame::I, I))
+    return false;
+
+  width = I.getWidth();
+  height = I.getHeight();
+  positionAfterCachedFrame(frame_index);
+  return true;
+}
+
+/*!
+  Get a frame from the cache of getFrame() and update the reader position as
+  if the frame was read.
+
+  \return true if the frame was in the cache.
+*/
+bool vpVideoReader::getCachedFrame(vpImage<vpRGBa> &I, long frame_index)
+{
+  if (frameCacheSize == 0 || !vpFindCachedFrame(frameCache, frame_index, true, &vpCachedFrame::Icolor, I))
+    return false;
+
+  width = I.getWidth();
+  height = I.getHeight();
+  positionAfterCachedFrame(frame_index);
+  return true;
+}
+
+/*!
+  Update the position of the reader as getFrame() does after reading the frame
+  \e frame_index, so that acquire() gives the same images whether the frame
+  comes from the cache or not.
+*/
+void vpVideoReader::positionAfterCachedFrame(long frame_index)
+{
+  if (imSequence != NULL)
+  {
+    frameCount = frame_index;
+    imSequence->setImageNumber(frameCount);
+  }
+  else if (formatType == FORMAT_RAW)
+  {
+    frameCount = frame_index;
+    rawNextFrame = frame_index;
+  }
+  else
+  {
+    // The video is moved only if acquire() is called
+    frameCount = frame_index + frameStep;
+    videoSeekFrame = frameCount;
+  }
+}
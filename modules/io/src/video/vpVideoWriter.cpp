@@ -42,13 +42,248 @@
   \brief Write image sequences.
 */
 
+#include <deque>
+#include <string.h>
+
 #include <visp3/core/vpDebug.h>
+#include <visp3/core/vpThread.h>
+#include <visp3/core/vpTime.h>
 #include <visp3/io/vpVideoWriter.h>
 
+#include "vpMonitor.h"
+
+#if !defined(_WIN32) && (defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__))) // UNIX
+#  include <fcntl.h>
+#  include <unistd.h>
+#endif
+
+#if defined(VISP_HAVE_PTHREAD) || (defined(_WIN32) && !defined(WINRT_8_0))
+#  define VP_VIDEO_WRITER_THREAD_OK
+#endif
+
 #if VISP_HAVE_OPENCV_VERSION >= 0x020200
 #  include <opencv2/imgproc/imgproc.hpp>
 #endif
 
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+/*
+  Asynchronous writing of an image sequence. saveFrame() copies the image in
+  a free slot and appends it to the queue of pending images; background
+  threads encode and write the pending images.
+*/
+class vpVideoWriter::vpAsyncWriter
+{
+public:
+  vpAsyncWriter(unsigned int nbThreads, unsigned int queueSize, vpAsyncPolicyType policy, unsigned int syncPeriod)
+    : m_mutex(), m_slots(queueSize), m_free(), m_pending(), m_toSync(), m_threads(), m_error(),
+      m_maxQueueDepth(0), m_nbDropped(0), m_nbWriting(0), m_policy(policy), m_stop(false), m_syncPeriod(syncPeriod)
+  {
+    for (size_t i = 0; i < m_slots.size(); i++)
+      m_free.push_back(m_slots.size() - 1 - i);
+#ifdef VP_VIDEO_WRITER_THREAD_OK
+    for (unsigned int i = 0; i < nbThreads; i++)
+      m_threads.push_back(new vpThread((vpThread::Fn) writeThread, (vpThread::Args) this));
+#else
+    (void)nbThreads;
+#endif
+  }
+
+  ~vpAsyncWriter()
+  {
+    flush();
+    {
+      vpMonitor::vpScopedLock lock(m_mutex);
+      m_stop = true;
+      m_mutex.notifyAll();
+    }
+    for (size_t i = 0; i < m_threads.size(); i++) {
+      m_threads[i]->join();
+      delete m_threads[i];
+    }
+    syncFiles(m_toSync);
+  }
+
+  // Wait until all the queued images are written and return the first error if any.
+  std::string flush()
+  {
+    vpMonitor::vpScopedLock lock(m_mutex);
+    while (! m_pending.empty() || m_nbWriting > 0)
+      m_mutex.wait();
+    std::string error = m_error;
+    m_error.clear();
+    return error;
+  }
+
+  unsigned int getMaxQueueDepth()
+  {
+    vpMonitor::vpScopedLock lock(m_mutex);
+    return m_maxQueueDepth;
+  }
+
+  unsigned int getNbDroppedFrames()
+  {
+    vpMonitor::vpScopedLock lock(m_mutex);
+    return m_nbDropped;
+  }
+
+  unsigned int getQueueDepth()
+  {
+    vpMonitor::vpScopedLock lock(m_mutex);
+    return (unsigned int)m_pending.size() + m_nbWriting;
+  }
+
+  template <class Type>
+  void push(const vpImage<Type> &I, const std::string &filename)
+  {
+    m_mutex.lock();
+    while (m_free.empty()) {
+      if (m_policy == DROP_NEWEST_WHEN_FULL) {
+        m_nbDropped ++;
+        m_mutex.unlock();
+        return;
+      }
+      if (m_policy == DROP_OLDEST_WHEN_FULL && ! m_pending.empty()) {
+        m_free.push_back(m_pending.front());
+        m_pending.pop_front();
+        m_nbDropped ++;
+        break;
+      }
+      // Block until a slot is released
+      m_mutex.wait();
+    }
+    size_t index = m_free.back();
+    m_free.pop_back();
+    m_mutex.unlock();
+
+    // The slot is owned by the caller until it is queued
+    vpSlot &slot = m_slots[index];
+    vpImage<Type> &J = getImage(slot, I);
+    if (J.getHeight() != I.getHeight() || J.getWidth() != I.getWidth())
+      J.resize(I.getHeight(), I.getWidth());
+    if (I.getSize() > 0)
+      memcpy((unsigned char *)J.bitmap, I.bitmap, I.getSize() * sizeof(Type));
+    slot.filename = filename;
+    slot.color = isColor(I);
+
+    vpMonitor::vpScopedLock lock(m_mutex);
+    m_pending.push_back(index);
+    unsigned int depth = (unsigned int)m_pending.size() + m_nbWriting;
+    if (depth > m_maxQueueDepth)
+      m_maxQueueDepth = depth;
+    m_mutex.notifyAll();
+  }
+
+private:
+  struct vpSlot {
+    vpSlot() : filename(), color(false), Ic(), Ig() {}
+    std::string filename;
+    bool color;
+    vpImage<vpRGBa> Ic;
+    vpImage<unsigned char> Ig;
+  };
+
+  static bool isColor(const vpImage<unsigned char> &) { return false; }
+  static bool isColor(const vpImage<vpRGBa> &) { return true; }
+  static vpImage<unsigned char> &getImage(vpSlot &slot, const vpImage<unsigned char> &) { return slot.Ig; }
+  static vpImage<vpRGBa> &getImage(vpSlot &slot, const vpImage<vpRGBa> &) { return slot.Ic; }
+
+  // Flush the content of the files to the disk
+  static void syncFiles(const std::vector<std::string> &files)
+  {
+#if !defined(_WIN32) && (defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__))) // UNIX
+    for (size_t i = 0; i < files.size(); i++) {
+      int fd = ::open(files[i].c_str(), O_RDONLY);
+      if (fd >= 0) {
+        fsync(fd);
+        ::close(fd);
+      }
+    }
+#else
+    (void)files;
+#endif
+  }
+
+#ifdef VP_VIDEO_WRITER_THREAD_OK
+  static vpThread::Return writeThread(vpThread::Args args)
+  {
+    static_cast<vpAsyncWriter *>(args)->writeLoop();
+    return 0;
+  }
+#endif
+
+  void writeLoop()
+  {
+    for (;;) {
+      size_t index = 0;
+      {
+        vpMonitor::vpScopedLock lock(m_mutex);
+        while (! m_stop && m_pending.empty())
+          m_mutex.wait();
+        if (m_pending.empty())
+          break;
+        index = m_pending.front();
+        m_pending.pop_front();
+        m_nbWriting ++;
+      }
+
+      vpSlot &slot = m_slots[index];
+      std::string error;
+      try {
+        if (slot.color)
+          vpImageIo::write(slot.Ic, slot.filename);
+        else
+          vpImageIo::write(slot.Ig, slot.filename);
+      }
+      catch(const vpException &e) {
+        error = e.getStringMessage();
+      }
+      catch(...) {
+        error = "Cannot write " + slot.filename;
+      }
+
+      std::vector<std::string> toSync;
+      {
+        vpMonitor::vpScopedLock lock(m_mutex);
+        if (error.empty()) {
+          if (m_syncPeriod > 0) {
+            m_toSync.push_back(slot.filename);
+            if (m_toSync.size() >= m_syncPeriod)
+              toSync.swap(m_toSync);
+          }
+        }
+        else if (m_error.empty()) {
+          m_error = error;
+        }
+        m_free.push_back(index);
+        m_nbWriting --;
+        m_mutex.notifyAll();
+      }
+      syncFiles(toSync);
+    }
+  }
+
+  vpMonitor m_mutex;
+  std::vector<vpSlot> m_slots;
+  std::vector<size_t> m_free;
+  std::deque<size_t> m_pending;
+  std::vector<std::string> m_toSync;
+#ifdef VP_VIDEO_WRITER_THREAD_OK
+  std::vector<vpThread *> m_threads;
+#else
+  std::vector<void *> m_threads;
+#endif
+  std::string m_error;
+  unsigned int m_maxQueueDepth;
+  unsigned int m_nbDropped;
+  unsigned int m_nbWriting;
+  vpAsyncPolicyType m_policy;
+  bool m_stop;
+  unsigned int m_syncPeriod;
+
+  vpAsyncWriter(const vpAsyncWriter &);
+  vpAsyncWriter &operator=(const vpAsyncWriter &);
+};
+#endif // DOXYGEN_SHOULD_SKIP_THIS
 
 /*!
   Basic constructor.
@@ -58,7 +293,8 @@ vpVideoWriter::vpVideoWriter() :
     writer(), fourcc(0), framerate(0.),
 #endif
     formatType(FORMAT_UNKNOWN), initFileName(false), isOpen(false), frameCount(0),
-    firstFrame(0), width(0), height(0)
+    firstFrame(0), width(0), height(0), rawRecord(), asyncPolicy(BLOCK_WHEN_FULL), asyncQueueSize(0), asyncThreads(0),
+    syncPeriod(0), asyncWriter(NULL)
 {
   initFileName = false;
   firstFrame = 0;
@@ -80,6 +316,10 @@ vpVideoWriter::vpVideoWriter() :
 */
 vpVideoWriter::~vpVideoWriter()
 {
+  if (asyncWriter != NULL) {
+    delete asyncWriter;
+    asyncWriter = NULL;
+  }
 }
 
 
@@ -146,6 +386,15 @@ void vpVideoWriter::open(vpImage< vpRGBa > &I)
   {
     width = I.getWidth();
     height = I.getHeight();
+
+    if (asyncWriter != NULL) {
+      delete asyncWriter;
+      asyncWriter = NULL;
+    }
+#ifdef VP_VIDEO_WRITER_THREAD_OK
+    if (asyncThreads > 0)
+      asyncWriter = new vpAsyncWriter(asyncThreads, asyncQueueSize, asyncPolicy, syncPeriod);
+#endif
   }
   else if (formatType == FORMAT_AVI ||
            formatType == FORMAT_MPEG ||
@@ -164,6 +413,12 @@ void vpVideoWriter::open(vpImage< vpRGBa > &I)
     throw (vpException(vpException::fatalError ,"To encode video files ViSP should be build with opencv 3rd >= 2.1.0 party libraries."));
 #endif
   }
+  else if (formatType == FORMAT_RAW)
+  {
+    width = I.getWidth();
+    height = I.getHeight();
+    rawRecord.create(fileName);
+  }
 
   frameCount = firstFrame;
 
@@ -191,6 +446,15 @@ void vpVideoWriter::open(vpImage< unsigned char > &I)
   {
     width = I.getWidth();
     height = I.getHeight();
+
+    if (asyncWriter != NULL) {
+      delete asyncWriter;
+      asyncWriter = NULL;
+    }
+#ifdef VP_VIDEO_WRITER_THREAD_OK
+    if (asyncThreads > 0)
+      asyncWriter = new vpAsyncWriter(asyncThreads, asyncQueueSize, asyncPolicy, syncPeriod);
+#endif
   }
   else if (formatType == FORMAT_AVI ||
            formatType == FORMAT_MPEG ||
@@ -209,6 +473,12 @@ void vpVideoWriter::open(vpImage< unsigned char > &I)
     throw (vpException(vpException::fatalError ,"To encode video files ViSP should be build with opencv 3rd >= 2.1.0 party libraries."));
 #endif
   }
+  else if (formatType == FORMAT_RAW)
+  {
+    width = I.getWidth();
+    height = I.getHeight();
+    rawRecord.create(fileName);
+  }
 
   frameCount = firstFrame;
 
@@ -241,7 +511,14 @@ void vpVideoWriter::saveFrame (vpImage< vpRGBa > &I)
 
     sprintf(name,fileName,frameCount);
 
-    vpImageIo::write(I, name);
+    if (asyncWriter != NULL)
+      asyncWriter->push(I, name);
+    else
+      vpImageIo::write(I, name);
+  }
+  else if (formatType == FORMAT_RAW)
+  {
+    rawRecord.write(I, vpTime::measureTimeMs());
   }
   else
   {
@@ -280,7 +557,14 @@ void vpVideoWriter::saveFrame (vpImage< unsigned char > &I)
 
     sprintf(name,fileName,frameCount);
 
-    vpImageIo::write(I, name);
+    if (asyncWriter != NULL)
+      asyncWriter->push(I, name);
+    else
+      vpImageIo::write(I, name);
+  }
+  else if (formatType == FORMAT_RAW)
+  {
+    rawRecord.write(I, vpTime::measureTimeMs());
   }
   else
   {
@@ -311,8 +595,99 @@ void vpVideoWriter::close()
     vpERROR_TRACE("The video has to be open first with the open method");
     throw (vpException(vpException::notInitialized,"file not yet opened"));
   }
+
+  if (asyncWriter != NULL) {
+    // Wait until all the queued images are written
+    std::string error = asyncWriter->flush();
+    if (! error.empty())
+      throw (vpImageException(vpImageException::ioError, "%s", error.c_str()));
+  }
+  if (rawRecord.isOpenForWriting()) {
+    rawRecord.close();
+  }
+}
+
+
+/*!
+  Enable the asynchronous writing of image sequences. saveFrame() then copies
+  the image in a queue of at most \e queueSize images and returns; \e nbThreads
+  background threads encode and write the queued images. This mode has to be
+  set before open() and has no effect on video files.
+
+  The asynchronous mode requires pthread or the Windows threading API; otherwise
+  the images are written by the calling thread.
+
+  \param nbThreads : Number of encoding threads. Set to 0 to disable the asynchronous mode (default).
+  \param queueSize : Maximum number of images waiting to be written. If 0, it is set to
+  twice the number of threads.
+
+  \sa setAsyncPolicy(), setSyncPeriod(), getQueueDepth(), getNbDroppedFrames()
+*/
+void vpVideoWriter::setAsyncWriting(unsigned int nbThreads, unsigned int queueSize)
+{
+#ifdef VP_VIDEO_WRITER_THREAD_OK
+  asyncThreads = nbThreads;
+#else
+  if (nbThreads > 0)
+    std::cerr << "Pthread or WIN32 API is needed to use the asynchronous writing mode." << std::endl;
+  asyncThreads = 0;
+#endif
+  asyncQueueSize = (queueSize > 0) ? queueSize : 2*nbThreads;
 }
 
+/*!
+  Set the behavior of saveFrame() when the queue of the asynchronous mode is full.
+  By default, saveFrame() waits until an image is written (BLOCK_WHEN_FULL).
+  With DROP_NEWEST_WHEN_FULL or DROP_OLDEST_WHEN_FULL, saveFrame() never waits and
+  an image is dropped; the frame counter is incremented anyway so that the file
+  name of the next images still corresponds to their index.
+
+  \sa setAsyncWriting(), getNbDroppedFrames()
+*/
+void vpVideoWriter::setAsyncPolicy(const vpAsyncPolicyType &policy)
+{
+  asyncPolicy = policy;
+}
+
+/*!
+  In asynchronous mode, flush the written files to the disk (fsync) by batches
+  of \e nbFrames images instead of relying on the system cache. Set to 0 to
+  disable (default). This is only available on unix-like systems.
+
+  \sa setAsyncWriting()
+*/
+void vpVideoWriter::setSyncPeriod(unsigned int nbFrames)
+{
+  syncPeriod = nbFrames;
+}
+
+/*!
+  Return the maximum number of images that were waiting to be written in
+  asynchronous mode since open().
+*/
+unsigned int vpVideoWriter::getMaxQueueDepth() const
+{
+  return (asyncWriter != NULL) ? asyncWriter->getMaxQueueDepth() : 0;
+}
+
+/*!
+  Return the number of images dropped since open() because the queue of the
+  asynchronous mode was full.
+
+  \sa setAsyncPolicy()
+*/
+unsigned int vpVideoWriter::getNbDroppedFrames() const
+{
+  return (asyncWriter != NULL) ? asyncWriter->getNbDroppedFrames() : 0;
+}
+
+/*!
+  Return the number of images waiting to be written in asynchronous mode.
+*/
+unsigned int vpVideoWriter::getQueueDepth() const
+{
+  return (asyncWriter != NULL) ? asyncWriter->getQueueDepth() : 0;
+}
 
 /*!
   Gets the format of the file(s) which has/have to be written.
@@ -370,6 +745,10 @@ vpVideoWriter::getFormat(const char *filename)
     return FORMAT_MOV;
   else if (ext.compare(".mov") == 0)
     return FORMAT_MOV;
+  else if (ext.compare(".VPRAW") == 0)
+    return FORMAT_RAW;
+  else if (ext.compare(".vpraw") == 0)
+    return FORMAT_RAW;
   else
     return FORMAT_UNKNOWN;
 }
@@ -161,6 +161,26 @@ public:
 
   //!set the gain for the virtual visual servoing algorithm 
   static void setLambda(const double &lambda){gain = lambda;}
+  /*!
+    Enable a robust estimation (Tukey M-estimator) in the multi-image virtual visual servoing
+    calibration to reduce the influence of badly detected points.
+    \param robust : True to enable the robust estimation.
+    \param noiseThreshold : Minimal noise threshold (in pixel) of the M-estimator.
+  */
+  static void setRobustEstimation(const bool robust, const double noiseThreshold=1.0)
+  {
+    robustEstimation = robust;
+    robustThreshold = noiseThreshold;
+  }
+  /*!
+    Use a sparse solver in the multi-image virtual visual servoing calibration instead of the
+    pseudo-inverse of the full interaction matrix. The solver exploits the block-arrow structure of
+    the system (each view only depends on its own pose and on the intrinsics): the per-view blocks
+    of the normal equations are built in parallel and the poses are eliminated with a Schur
+    complement on the intrinsic parameters. The memory and time cost are then linear in the number of views.
+    \param sparse : True to use the sparse solver.
+  */
+  static void setSparseSolver(const bool sparse){sparseSolver = sparse;}
   int writeData(const char *filename) ;
 
 private:
@@ -199,6 +219,9 @@ private:
   static double threshold;
   static unsigned int nbIterMax;
   static double gain;
+  static bool sparseSolver;
+  static bool robustEstimation;
+  static double robustThreshold;
 
 } ;
 
@@ -298,6 +298,16 @@ class VISP_EXPORT vpHomography : public vpArray2D<double>
                     vpHomography &aHb,
                     bool normalization=true);
 
+    static void fastDLT(const std::vector<double> &xb, const std::vector<double> &yb,
+                        const std::vector<double> &xa, const std::vector<double> &ya,
+                        vpHomography &aHb,
+                        bool singlePrecision=false);
+    static void batchDLT(const std::vector<double> &xb, const std::vector<double> &yb,
+                         const std::vector<double> &xa, const std::vector<double> &ya,
+                         const std::vector<unsigned int> &subsets, unsigned int subsetSize,
+                         std::vector<vpHomography> &aHb, std::vector<bool> &success,
+                         bool singlePrecision=false);
+
     static void HLM(const std::vector<double> &xb, const std::vector<double> &yb,
                     const std::vector<double> &xa, const std::vector<double> &ya,
                     bool isplanar,
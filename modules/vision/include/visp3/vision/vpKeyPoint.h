@@ -684,6 +684,25 @@ public:
     }
   }
 
+  /*!
+     Set the grid used to bucket the keypoints returned by detect(). The image is divided into
+     \p nbRows x \p nbCols cells and only the \p maxPerCell keypoints with the highest response are kept
+     in each cell. Combined with setMaxFeatures(), this bounds the descriptor extraction and matching cost
+     while keeping the keypoints spread over the image.
+
+     \param nbRows : Number of rows of the grid.
+     \param nbCols : Number of columns of the grid.
+     \param maxPerCell : Maximum number of keypoints per cell, 0 means no limit.
+   */
+  inline void setDetectionGrid(const unsigned int nbRows, const unsigned int nbCols, const unsigned int maxPerCell) {
+    if(nbRows == 0 || nbCols == 0) {
+      throw vpException(vpException::badValue, "The number of rows and columns of the detection grid must be greater than zero.");
+    }
+    m_detectionGridRows = nbRows;
+    m_detectionGridCols = nbCols;
+    m_detectionGridMaxPerCell = maxPerCell;
+  }
+
   /*!
      Set the method to decide if the object is present or not.
 
@@ -889,6 +908,18 @@ public:
     }
   }
 
+  /*!
+    Set the maximum number of keypoints returned by detect(). The keypoints with the highest response are kept,
+    in a round-robin manner over the cells if a detection grid is used (see setDetectionGrid()).
+
+    \param maxFeatures : Maximum number of keypoints, a negative value means no limit. With 0, detect()
+    returns no keypoint, and the adaptive detection threshold (see setUseAdaptiveDetectionThreshold())
+    falls back to the budget given by setDetectionGrid().
+  */
+  inline void setMaxFeatures(const int maxFeatures) {
+    m_maxFeatures = maxFeatures;
+  }
+
   /*!
     Set the percentage value for defining the cardinality of the consensus group.
 
@@ -941,6 +972,30 @@ public:
     }
   }
 
+  /*!
+    Use or not the parallel RANSAC implementation of vpPose when the pose is estimated
+    with the ViSP method (see setUseRansacVVS()).
+
+    \param parallel : If true, the RANSAC hypotheses are evaluated in parallel.
+
+    \note Need Pthread or OpenMP.
+    \sa setRansacParallelNbThreads
+  */
+  inline void setRansacParallel(const bool parallel) {
+    m_ransacParallel = parallel;
+  }
+
+  /*!
+    Set the number of threads to use for the parallel RANSAC pose estimation.
+
+    \param nthreads : Number of threads, if 0 the number of CPU threads is determined automatically.
+
+    \sa setRansacParallel
+  */
+  inline void setRansacParallelNbThreads(const unsigned int nthreads) {
+    m_ransacParallelNbThreads = nthreads;
+  }
+
   /*!
     Set the maximum error (in meter) to determine if a point is an inlier or not.
 
@@ -954,6 +1009,19 @@ public:
     }
   }
 
+  /*!
+    Set if the threshold of the detectors has to be adapted from one call of detect() to the next one
+    to keep the number of raw detections between once and four times the keypoints budget (see setMaxFeatures()
+    and setDetectionGrid()). The threshold changes by one per call, so the number of detections converges
+    over several frames.
+    Only FAST, AGAST and ORB detectors are supported (OpenCV >= 3.0).
+
+    \param useAdaptiveThreshold : True to adapt the detection thresholds across frames.
+  */
+  inline void setUseAdaptiveDetectionThreshold(const bool useAdaptiveThreshold) {
+    m_useAdaptiveDetectionThreshold = useAdaptiveThreshold;
+  }
+
   /*!
     Set if multiple affine transformations must be used to detect and extract keypoints.
 
@@ -1024,6 +1092,12 @@ private:
   vpMatrix m_covarianceMatrix;
   //! Current id associated to the training image used for the learning.
   int m_currentImageId;
+  //! Number of columns of the grid used to bucket the detected keypoints.
+  unsigned int m_detectionGridCols;
+  //! Maximum number of keypoints kept in each cell of the detection grid (0 means no limit).
+  unsigned int m_detectionGridMaxPerCell;
+  //! Number of rows of the grid used to bucket the detected keypoints.
+  unsigned int m_detectionGridRows;
   //! Method (based on descriptor distances) to decide if the object is present or not.
   vpDetectionMethodType m_detectionMethod;
   //! Detection score to decide if the object is present or not.
@@ -1074,6 +1148,8 @@ private:
   double m_matchingTime;
   //! List of pairs between the keypoint and the 3D point after the Ransac.
   std::vector<std::pair<cv::KeyPoint, cv::Point3f> > m_matchRansacKeyPointsToPoints;
+  //! Maximum number of keypoints returned by detect() (negative value means no limit).
+  int m_maxFeatures;
   //! Maximum number of iterations for the Ransac method.
   int m_nbRansacIterations;
   //! Minimum number of inliers for the Ransac method.
@@ -1095,6 +1171,10 @@ private:
   std::vector<vpImagePoint> m_ransacInliers;
   //! List of outliers.
   std::vector<vpImagePoint> m_ransacOutliers;
+  //! If true, use the parallel RANSAC implementation of vpPose
+  bool m_ransacParallel;
+  //! Number of threads for the parallel RANSAC (0 to let the number of threads be determined automatically)
+  unsigned int m_ransacParallelNbThreads;
   //! Maximum reprojection error (in pixel for the OpenCV method) to decide if a point is an inlier or not.
   double m_ransacReprojectionError;
   //! Maximum error (in meter for the ViSP method) to decide if a point is an inlier or not.
@@ -1108,6 +1188,8 @@ private:
   std::vector<cv::Point3f> m_trainPoints;
   //! List of 3D points in vpPoint format (in the object frame) corresponding to the train keypoints.
   std::vector<vpPoint> m_trainVpPoints;
+  //! If true, the detector thresholds are adapted across frames to fit the keypoints budget.
+  bool m_useAdaptiveDetectionThreshold;
   //! If true, use multiple affine transformations to cober the 6 affine parameters
   bool m_useAffineDetection;
 #if (VISP_HAVE_OPENCV_VERSION >= 0x020400 && VISP_HAVE_OPENCV_VERSION < 0x030000)
@@ -1129,8 +1211,12 @@ private:
   bool m_useSingleMatchFilter;
 
 
+  void adaptDetectionThreshold(const cv::Ptr<cv::FeatureDetector> &detector, const size_t nbDetections);
+
   void affineSkew(double tilt, double phi, cv::Mat& img, cv::Mat& mask, cv::Mat& Ai);
 
+  void bucketKeyPoints(std::vector<cv::KeyPoint> &keyPoints, const cv::Size &imageSize) const;
+
   double computePoseEstimationError(const std::vector<std::pair<cv::KeyPoint, cv::Point3f> > &matchKeyPoints,
                                     const vpCameraParameters &cam, const vpHomogeneousMatrix &cMo_est);
 
@@ -52,6 +52,9 @@
 double vpCalibration::threshold = 1e-10f;
 unsigned int vpCalibration::nbIterMax = 4000;
 double vpCalibration::gain = 0.25;
+bool vpCalibration::sparseSolver = false;
+bool vpCalibration::robustEstimation = false;
+double vpCalibration::robustThreshold = 1.0;
 /*!
   Basic initialisation (called by the constructors)
 */
@@ -465,10 +468,33 @@ int vpCalibration::computeCalibrationMulti(vpCalibrationMethodType method,
 {
   try{
     unsigned int nbPose = (unsigned int) table_cal.size();
-    for(unsigned int i=0;i<nbPose;i++){
-      if(table_cal[i].get_npt()>3)
-        table_cal[i].computePose(cam_est,table_cal[i].cMo);
+
+    // The initial poses of the views are independent from each other
+    bool poseFailed = false;
+    vpException poseException(vpException::fatalError);
+#ifdef VISP_HAVE_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for(int i=0;i<(int)nbPose;i++){
+      if(table_cal[(size_t)i].get_npt()>3) {
+        try {
+          table_cal[(size_t)i].computePose(cam_est,table_cal[(size_t)i].cMo);
+        }
+        catch(const vpException &e) {
+          // An exception cannot cross the parallel region
+#ifdef VISP_HAVE_OPENMP
+#pragma omp critical
+#endif
+          {
+            poseFailed = true;
+            poseException = e;
+          }
+        }
+      }
     }
+    if (poseFailed)
+      throw poseException;
+
     switch (method) {
     case CALIB_LAGRANGE : {
       if(nbPose > 1){
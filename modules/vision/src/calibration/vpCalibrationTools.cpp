@@ -41,6 +41,7 @@
 #include <visp3/core/vpMath.h>
 #include <visp3/vision/vpPose.h>
 #include <visp3/core/vpPixelMeterConversion.h>
+#include <visp3/core/vpRobust.h>
 
 #include <cmath>    // std::fabs
 #include <limits>   // numeric_limits
@@ -48,6 +49,233 @@
 #undef MAX
 #undef MIN
 
+namespace {
+  /*
+    Interaction matrix rows of a point for the 6 pose parameters and the 4 intrinsic parameters
+    (u0, v0, px, py) of the perspective projection model without distortion.
+  */
+  inline void computeInteractionWithoutDistortion(double x, double y, double z, double px, double py,
+                                                  double Lp[2][6], double Li[2][4])
+  {
+    double inv_z = 1/z;
+
+    double X =   x*inv_z ;
+    double Y =   y*inv_z ;
+
+    Lp[0][0] =  px * (-inv_z) ;
+    Lp[0][1] =  0 ;
+    Lp[0][2] =  px*(X*inv_z) ;
+    Lp[0][3] =  px*X*Y ;
+    Lp[0][4] =  -px*(1+X*X) ;
+    Lp[0][5] =  px*Y ;
+
+    Li[0][0] = 1 ;
+    Li[0][1] = 0 ;
+    Li[0][2] = X ;
+    Li[0][3] = 0 ;
+
+    Lp[1][0] = 0 ;
+    Lp[1][1] = py*(-inv_z) ;
+    Lp[1][2] = py*(Y*inv_z) ;
+    Lp[1][3] = py* (1+Y*Y) ;
+    Lp[1][4] = -py*X*Y ;
+    Lp[1][5] = -py*X ;
+
+    Li[1][0] = 0 ;
+    Li[1][1] = 1 ;
+    Li[1][2] = 0 ;
+    Li[1][3] = Y ;
+  }
+
+  /*
+    Interaction matrix rows of a point for the 6 pose parameters and the 6 intrinsic parameters
+    (u0, v0, px, py, kdu, kud) of the perspective projection model with distortion. The first two rows
+    correspond to the distorted to undistorted model, the last two to the undistorted to distorted model.
+  */
+  inline void computeInteractionWithDistortion(double x, double y, double z, double up, double vp,
+                                               const vpCameraParameters &cam,
+                                               double Lp[4][6], double Li[4][6])
+  {
+    double px = cam.get_px() ;
+    double py = cam.get_py() ;
+    double u0 = cam.get_u0() ;
+    double v0 = cam.get_v0() ;
+
+    double inv_px = 1/px ;
+    double inv_py = 1/py ;
+
+    double kud = cam.get_kud() ;
+    double kdu = cam.get_kdu() ;
+
+    double k2ud = 2*kud;
+    double k2du = 2*kdu;
+
+    double inv_z = 1/z;
+    double X =   x*inv_z ;
+    double Y =   y*inv_z ;
+
+    double X2 = X*X;
+    double Y2 = Y*Y;
+    double XY = X*Y;
+
+    double up0 = up - u0;
+    double vp0 = vp - v0;
+
+    double xp0 = up0 * inv_px;
+    double xp02 = xp0 *xp0 ;
+
+    double yp0 = vp0 * inv_py;
+    double yp02 = yp0 * yp0;
+
+    double r2du = xp02 + yp02 ;
+    double kr2du = kdu * r2du;
+
+    double r2ud = X2 + Y2 ;
+    double kr2ud = 1 + kud * r2ud;
+
+    double Axx = px*(kr2ud+k2ud*X2);
+    double Axy = px*k2ud*XY;
+    double Ayy = py*(kr2ud+k2ud*Y2);
+    double Ayx = py*k2ud*XY;
+
+    Lp[0][0] =  px * (-inv_z) ;
+    Lp[0][1] =  0 ;
+    Lp[0][2] =  px*X*inv_z ;
+    Lp[0][3] =  px*X*Y ;
+    Lp[0][4] =  -px*(1+X2) ;
+    Lp[0][5] =  px*Y ;
+
+    Li[0][0] = 1 + kr2du + k2du*xp02  ;
+    Li[0][1] = k2du*up0*yp0*inv_py ;
+    Li[0][2] = X + k2du*xp02*xp0 ;
+    Li[0][3] = k2du*up0*yp02*inv_py ;
+    Li[0][4] = -(up0)*(r2du) ;
+    Li[0][5] = 0 ;
+
+    Lp[1][0] = 0 ;
+    Lp[1][1] = py*(-inv_z) ;
+    Lp[1][2] = py*Y*inv_z ;
+    Lp[1][3] = py* (1+Y2) ;
+    Lp[1][4] = -py*XY ;
+    Lp[1][5] = -py*X ;
+
+    Li[1][0] = k2du*xp0*vp0*inv_px ;
+    Li[1][1] = 1 + kr2du + k2du*yp02;
+    Li[1][2] = k2du*vp0*xp02*inv_px;
+    Li[1][3] = Y + k2du*yp02*yp0;
+    Li[1][4] = -vp0*r2du ;
+    Li[1][5] = 0 ;
+
+    //---undistorted to distorted
+    Lp[2][0] = Axx*(-inv_z) ;
+    Lp[2][1] = Axy*(-inv_z) ;
+    Lp[2][2] = Axx*(X*inv_z) + Axy*(Y*inv_z) ;
+    Lp[2][3] = Axx*X*Y +  Axy*(1+Y2);
+    Lp[2][4] = -Axx*(1+X2) - Axy*XY;
+    Lp[2][5] = Axx*Y -Axy*X;
+
+    Li[2][0] = 1 ;
+    Li[2][1] = 0 ;
+    Li[2][2] = X*kr2ud ;
+    Li[2][3] = 0;
+    Li[2][4] = 0 ;
+    Li[2][5] = px*X*r2ud ;
+
+    Lp[3][0] = Ayx*(-inv_z) ;
+    Lp[3][1] = Ayy*(-inv_z) ;
+    Lp[3][2] = Ayx*(X*inv_z) + Ayy*(Y*inv_z) ;
+    Lp[3][3] = Ayx*XY + Ayy*(1+Y2) ;
+    Lp[3][4] = -Ayx*(1+X2) -Ayy*XY ;
+    Lp[3][5] = Ayx*Y -Ayy*X;
+
+    Li[3][0] = 0 ;
+    Li[3][1] = 1;
+    Li[3][2] = 0;
+    Li[3][3] = Y*kr2ud ;
+    Li[3][4] = 0 ;
+    Li[3][5] = py*Y*r2ud ;
+  }
+
+  /*
+    Add the contribution of one weighted row of the interaction matrix to the normal equations
+    of the block-arrow system of one view:
+    U += w^2 Lp^T Lp, W += w^2 Lp^T Li, V += w^2 Li^T Li, b += w^2 Lp^T e, c += w^2 Li^T e.
+    Only the upper triangular parts of U and V are updated.
+  */
+  inline void accumulateBlockArrowRow(const double *Lp, const double *Li, unsigned int nbIntrinsic,
+                                      double e, double w,
+                                      vpMatrix &U, vpMatrix &W, vpMatrix &V, vpColVector &b, vpColVector &c)
+  {
+    double w2 = w*w;
+    for (unsigned int i = 0; i < 6; i++) {
+      double wLp = w2*Lp[i];
+      for (unsigned int j = i; j < 6; j++)
+        U[i][j] += wLp*Lp[j];
+      for (unsigned int j = 0; j < nbIntrinsic; j++)
+        W[i][j] += wLp*Li[j];
+      b[i] += wLp*e;
+    }
+    for (unsigned int i = 0; i < nbIntrinsic; i++) {
+      double wLi = w2*Li[i];
+      for (unsigned int j = i; j < nbIntrinsic; j++)
+        V[i][j] += wLi*Li[j];
+      c[i] += wLi*e;
+    }
+  }
+
+  inline void copyUpperToLower(vpMatrix &M)
+  {
+    for (unsigned int i = 1; i < M.getRows(); i++)
+      for (unsigned int j = 0; j < i; j++)
+        M[i][j] = M[j][i];
+  }
+
+  /*
+    Solve the normal equations of the block-arrow system made of one 6x6 pose block U[p]
+    per view, coupled to the intrinsic parameters by W[p]. The pose blocks are eliminated
+    (Schur complement on the intrinsics), the reduced system is solved for the intrinsics
+    and the pose updates are recovered by back-substitution.
+    The solution e is ordered as the dense system: the 6 pose parameters of each view
+    followed by the intrinsic parameters.
+  */
+  void solveBlockArrowSystem(const std::vector<vpMatrix> &U, const std::vector<vpMatrix> &W,
+                             const vpMatrix &V, const std::vector<vpColVector> &b, const vpColVector &c,
+                             vpColVector &e)
+  {
+    unsigned int nbPose = (unsigned int)U.size();
+    unsigned int nbIntrinsic = V.getRows();
+
+    // As we deal with normal equations, the singular values are the square of the ones
+    // of the interaction matrix: 1e-20 corresponds to the 1e-10 used with the dense solver
+    const double svThreshold = 1e-20;
+
+    std::vector<vpMatrix> Uinv_W(nbPose);
+    std::vector<vpColVector> Uinv_b(nbPose);
+    vpMatrix S = V;
+    vpColVector rhs = c;
+    for (unsigned int p = 0; p < nbPose; p++) {
+      vpMatrix Uinv = U[p].pseudoInverse(svThreshold);
+      Uinv_W[p] = Uinv*W[p];
+      Uinv_b[p] = Uinv*b[p];
+
+      vpMatrix Wt = W[p].t();
+      S -= Wt*Uinv_W[p];
+      rhs -= Wt*Uinv_b[p];
+    }
+
+    vpColVector e_intrinsic = S.pseudoInverse(svThreshold)*rhs;
+
+    e.resize(6*nbPose + nbIntrinsic);
+    for (unsigned int p = 0; p < nbPose; p++) {
+      vpColVector e_pose = Uinv_b[p] - Uinv_W[p]*e_intrinsic;
+      for (unsigned int i = 0; i < 6; i++)
+        e[6*p + i] = e_pose[i];
+    }
+    for (unsigned int i = 0; i < nbIntrinsic; i++)
+      e[6*nbPose + i] = e_intrinsic[i];
+  }
+}
+
 void
 vpCalibration::calibLagrange(vpCameraParameters &cam_est, vpHomogeneousMatrix &cMo_est)
 {
@@ -215,8 +443,14 @@ vpCalibration::calibVVS(vpCameraParameters &cam_est,
                         vpHomogeneousMatrix &cMo_est,
                         bool verbose)
 {
-  std::ios::fmtflags original_flags( std::cout.flags() );
-  std::cout.precision(10);
+  // The format of std::cout is only changed when printing, so that single image
+  // calibrations can be computed in parallel
+  std::ios::fmtflags original_flags = std::ios::fmtflags();
+  std::streamsize original_precision = 0;
+  if (verbose) {
+    original_flags = std::cout.flags();
+    original_precision = std::cout.precision(10);
+  }
   unsigned int   n_points = npt ;
 
   vpColVector oX(n_points), cX(n_points)  ;
@@ -360,10 +594,12 @@ vpCalibration::calibVVS(vpCameraParameters &cam_est,
   this->cMo_dist = cMo_est;
   this->residual = r;
   this->residual_dist = r;
-  if (verbose)
+  if (verbose) {
     std::cout <<  " std dev " << sqrt(r/n_points) << std::endl;
-  // Restore ostream format
-  std::cout.flags(original_flags);
+    // Restore ostream format
+    std::cout.flags(original_flags);
+    std::cout.precision(original_precision);
+  }
 }
 
 void
@@ -374,14 +610,16 @@ vpCalibration::calibVVSMulti(std::vector<vpCalibration> &table_cal,
 {
   std::ios::fmtflags original_flags( std::cout.flags() );
   std::cout.precision(10);
-  unsigned int nbPoint[256]; //number of points by image
-  unsigned int nbPointTotal = 0; //total number of points
   unsigned int nbPose = (unsigned int)table_cal.size();
+  std::vector<unsigned int> nbPoint(nbPose); //number of points by image
+  std::vector<unsigned int> firstPoint(nbPose); //indice of the first point of each image
+  unsigned int nbPointTotal = 0; //total number of points
   unsigned int nbPose6 = 6*nbPose;
 
   for (unsigned int i=0; i<nbPose ; i++)
   {
     nbPoint[i] = table_cal[i].npt;
+    firstPoint[i] = nbPointTotal;
     nbPointTotal += nbPoint[i];
   }
 
@@ -427,6 +665,11 @@ vpCalibration::calibVVSMulti(std::vector<vpCalibration> &table_cal,
       curPoint++;
     }
   }
+
+  vpRobust robust(2*nbPointTotal);
+  robust.setThreshold(robustThreshold);
+  vpColVector w(2*nbPointTotal, 1.0);
+
   //  double lambda = 0.1 ;
   unsigned int iter = 0 ;
 
@@ -475,65 +718,78 @@ vpCalibration::calibVVSMulti(std::vector<vpCalibration> &table_cal,
     error = P-Pd ;
     //r = r/nbPointTotal ;
 
-    vpMatrix L(nbPointTotal*2,nbPose6+4) ;
-    curPoint = 0 ; //current point indice
-    for (unsigned int p=0; p<nbPose ; p++)
-    {
-      unsigned int q = 6*p;
-      for (unsigned int i=0 ; i < nbPoint[p]; i++)
-      {
-        unsigned int curPoint2 = 2*curPoint;
-        unsigned int curPoint21 = curPoint2 + 1;
-
-        double x = cX[curPoint] ;
-        double y = cY[curPoint] ;
-        double z = cZ[curPoint] ;
+    if (robustEstimation)
+      robust.MEstimator(vpRobust::TUKEY, error, w);
 
-        double inv_z = 1/z;
+    vpColVector e ;
+    if (sparseSolver) {
+      // Block-arrow structure: the rows of a view only depend on its pose and on the intrinsics
+      std::vector<vpMatrix> U(nbPose), W(nbPose), V(nbPose);
+      std::vector<vpColVector> b(nbPose), c(nbPose);
+
+#ifdef VISP_HAVE_OPENMP
+#pragma omp parallel for
+#endif
+      for (int p = 0; p < (int)nbPose; p++)
+      {
+        U[(size_t)p].resize(6, 6);
+        W[(size_t)p].resize(6, 4);
+        V[(size_t)p].resize(4, 4);
+        b[(size_t)p].resize(6);
+        c[(size_t)p].resize(4);
+
+        double Lp[2][6], Li[2][4];
+        for (unsigned int i=0 ; i < nbPoint[(size_t)p]; i++)
+        {
+          unsigned int curPt = firstPoint[(size_t)p] + i;
+          unsigned int curPt2 = 2*curPt;
+          computeInteractionWithoutDistortion(cX[curPt], cY[curPt], cZ[curPt], px, py, Lp, Li);
+          for (unsigned int k = 0; k < 2; k++)
+            accumulateBlockArrowRow(Lp[k], Li[k], 4, error[curPt2+k], w[curPt2+k],
+                                    U[(size_t)p], W[(size_t)p], V[(size_t)p], b[(size_t)p], c[(size_t)p]);
+        }
+        copyUpperToLower(U[(size_t)p]);
+      }
 
-        double X =   x*inv_z ;
-        double Y =   y*inv_z ;
+      vpMatrix V_sum(4, 4);
+      vpColVector c_sum(4);
+      for (unsigned int p = 0 ; p < nbPose ; p++)
+      {
+        V_sum += V[p];
+        c_sum += c[p];
+      }
+      copyUpperToLower(V_sum);
 
-        //---------------
+      solveBlockArrowSystem(U, W, V_sum, b, c_sum, e);
+    }
+    else {
+      vpMatrix L(nbPointTotal*2,nbPose6+4) ;
+      double Lp[2][6], Li[2][4];
+      curPoint = 0 ; //current point indice
+      for (unsigned int p=0; p<nbPose ; p++)
+      {
+        unsigned int q = 6*p;
+        for (unsigned int i=0 ; i < nbPoint[p]; i++)
         {
+          unsigned int curPoint2 = 2*curPoint;
+
+          computeInteractionWithoutDistortion(cX[curPoint], cY[curPoint], cZ[curPoint], px, py, Lp, Li);
+          for (unsigned int k = 0; k < 2; k++)
           {
-            L[curPoint2][q] =  px * (-inv_z) ;
-            L[curPoint2][q+1] =  0 ;
-            L[curPoint2][q+2] =  px*(X*inv_z) ;
-            L[curPoint2][q+3] =  px*X*Y ;
-            L[curPoint2][q+4] =  -px*(1+X*X) ;
-            L[curPoint2][q+5] =  px*Y ;
-          }
-          {
-            L[curPoint2][nbPose6]= 1 ;
-            L[curPoint2][nbPose6+1]= 0 ;
-            L[curPoint2][nbPose6+2]= X ;
-            L[curPoint2][nbPose6+3]= 0;
-          }
-          {
-            L[curPoint21][q] = 0 ;
-            L[curPoint21][q+1] = py*(-inv_z) ;
-            L[curPoint21][q+2] = py*(Y*inv_z) ;
-            L[curPoint21][q+3] = py* (1+Y*Y) ;
-            L[curPoint21][q+4] = -py*X*Y ;
-            L[curPoint21][q+5] = -py*X ;
-          }
-          {
-            L[curPoint21][nbPose6]= 0 ;
-            L[curPoint21][nbPose6+1]= 1 ;
-            L[curPoint21][nbPose6+2]= 0;
-            L[curPoint21][nbPose6+3]= Y ;
+            for (unsigned int j = 0; j < 6; j++)
+              L[curPoint2+k][q+j] = w[curPoint2+k]*Lp[k][j];
+            for (unsigned int j = 0; j < 4; j++)
+              L[curPoint2+k][nbPose6+j] = w[curPoint2+k]*Li[k][j];
+            error[curPoint2+k] *= w[curPoint2+k];
           }
+          curPoint++;
+        }    // end interaction
+      }
+      vpMatrix Lp_ ;
+      Lp_ = L.pseudoInverse(1e-10) ;
 
-        }
-        curPoint++;
-      }    // end interaction
+      e = Lp_*error ;
     }
-    vpMatrix Lp ;
-    Lp = L.pseudoInverse(1e-10) ;
-
-    vpColVector e ;
-    e = Lp*error ;
 
     vpColVector Tc, Tc_v(nbPose6) ;
     Tc = -e*gain ;
@@ -834,13 +1090,15 @@ vpCalibration::calibVVSWithDistortionMulti(std::vector<vpCalibration> &table_cal
 {
   std::ios::fmtflags original_flags( std::cout.flags() );
   std::cout.precision(10);
-  unsigned int nbPoint[1024]; //number of points by image
-  unsigned int nbPointTotal = 0; //total number of points
   unsigned int nbPose = (unsigned int)table_cal.size();
+  std::vector<unsigned int> nbPoint(nbPose); //number of points by image
+  std::vector<unsigned int> firstPoint(nbPose); //indice of the first point of each image
+  unsigned int nbPointTotal = 0; //total number of points
   unsigned int nbPose6 = 6*nbPose;
   for (unsigned int i=0; i<nbPose ; i++)
   {
     nbPoint[i] = table_cal[i].npt;
+    firstPoint[i] = nbPointTotal;
     nbPointTotal += nbPoint[i];
   }
 
@@ -886,6 +1144,11 @@ vpCalibration::calibVVSWithDistortionMulti(std::vector<vpCalibration> &table_cal
       curPoint++;
     }
   }
+
+  vpRobust robust(4*nbPointTotal);
+  robust.setThreshold(robustThreshold);
+  vpColVector w(4*nbPointTotal, 1.0);
+
   //  double lambda = 0.1 ;
   unsigned int iter = 0 ;
 
@@ -914,9 +1177,6 @@ vpCalibration::calibVVSWithDistortionMulti(std::vector<vpCalibration> &table_cal
       }
     }
 
-
-    vpMatrix L(nbPointTotal*4,nbPose6+6) ;
-    curPoint = 0 ; //current point indice
     double px = cam_est.get_px() ;
     double py = cam_est.get_py() ;
     double u0 = cam_est.get_u0() ;
@@ -928,26 +1188,15 @@ vpCalibration::calibVVSWithDistortionMulti(std::vector<vpCalibration> &table_cal
     double kud = cam_est.get_kud() ;
     double kdu = cam_est.get_kdu() ;
 
-    double k2ud = 2*kud;
-    double k2du = 2*kdu;
-
+    curPoint = 0 ; //current point indice
     for (unsigned int p=0; p<nbPose ; p++)
     {
-      unsigned int q = 6*p;
       for (unsigned int i=0 ; i < nbPoint[p]; i++)
       {
         unsigned int curPoint4 = 4*curPoint;
-        double x = cX[curPoint] ;
-        double y = cY[curPoint] ;
-        double z = cZ[curPoint] ;
-
-        double inv_z = 1/z;
-        double X =   x*inv_z ;
-        double Y =   y*inv_z ;
-
-        double X2 = X*X;
-        double Y2 = Y*Y;
-        double XY = X*Y;
+        double inv_z = 1/cZ[curPoint];
+        double X =   cX[curPoint]*inv_z ;
+        double Y =   cY[curPoint]*inv_z ;
 
         double up = u[curPoint] ;
         double vp = v[curPoint] ;
@@ -959,25 +1208,17 @@ vpCalibration::calibVVSWithDistortionMulti(std::vector<vpCalibration> &table_cal
         double vp0 = vp - v0;
 
         double xp0 = up0 * inv_px;
-        double xp02 = xp0 *xp0 ;
-
         double yp0 = vp0 * inv_py;
-        double yp02 = yp0 * yp0;
 
-        double r2du = xp02 + yp02 ;
+        double r2du = xp0*xp0 + yp0*yp0 ;
         double kr2du = kdu * r2du;
 
         P[curPoint4] =   u0 + px*X - kr2du *(up0) ;
         P[curPoint4+1] = v0 + py*Y - kr2du *(vp0) ;
 
-        double r2ud = X2 + Y2 ;
+        double r2ud = X*X + Y*Y ;
         double kr2ud = 1 + kud * r2ud;
 
-        double Axx = px*(kr2ud+k2ud*X2);
-        double Axy = px*k2ud*XY;
-        double Ayy = py*(kr2ud+k2ud*Y2);
-        double Ayx = py*k2ud*XY;
-
         Pd[curPoint4+2] = up ;
         Pd[curPoint4+3] = vp ;
 
@@ -989,91 +1230,90 @@ vpCalibration::calibVVSWithDistortionMulti(std::vector<vpCalibration> &table_cal
              vpMath::sqr(P[curPoint4+2]-Pd[curPoint4+2]) +
              vpMath::sqr(P[curPoint4+3]-Pd[curPoint4+3]))*0.5 ;
 
-        unsigned int curInd = curPoint4;
-        //---------------
-        {
-          {
-            L[curInd][q] =  px * (-inv_z) ;
-            L[curInd][q+1] =  0 ;
-            L[curInd][q+2] =  px*X*inv_z ;
-            L[curInd][q+3] =  px*X*Y ;
-            L[curInd][q+4] =  -px*(1+X2) ;
-            L[curInd][q+5] =  px*Y ;
-          }
-          {
-            L[curInd][nbPose6]= 1 + kr2du + k2du*xp02  ;
-            L[curInd][nbPose6+1]= k2du*up0*yp0*inv_py ;
-            L[curInd][nbPose6+2]= X + k2du*xp02*xp0 ;
-            L[curInd][nbPose6+3]= k2du*up0*yp02*inv_py ;
-            L[curInd][nbPose6+4] = -(up0)*(r2du) ;
-            L[curInd][nbPose6+5] = 0 ;
-          }
-            curInd++;
-          {
-            L[curInd][q] = 0 ;
-            L[curInd][q+1] = py*(-inv_z) ;
-            L[curInd][q+2] = py*Y*inv_z ;
-            L[curInd][q+3] = py* (1+Y2) ;
-            L[curInd][q+4] = -py*XY ;
-            L[curInd][q+5] = -py*X ;
-          }
-          {
-            L[curInd][nbPose6]= k2du*xp0*vp0*inv_px ;
-            L[curInd][nbPose6+1]= 1 + kr2du + k2du*yp02;
-            L[curInd][nbPose6+2]= k2du*vp0*xp02*inv_px;
-            L[curInd][nbPose6+3]= Y + k2du*yp02*yp0;
-            L[curInd][nbPose6+4] = -vp0*r2du ;
-            L[curInd][nbPose6+5] = 0 ;
-          }
-            curInd++;
-  //---undistorted to distorted
-          {
-            L[curInd][q] = Axx*(-inv_z) ;
-            L[curInd][q+1] = Axy*(-inv_z) ;
-            L[curInd][q+2] = Axx*(X*inv_z) + Axy*(Y*inv_z) ;
-            L[curInd][q+3] = Axx*X*Y +  Axy*(1+Y2);
-            L[curInd][q+4] = -Axx*(1+X2) - Axy*XY;
-            L[curInd][q+5] = Axx*Y -Axy*X;
-          }
-          {
-            L[curInd][nbPose6]= 1 ;
-            L[curInd][nbPose6+1]= 0 ;
-            L[curInd][nbPose6+2]= X*kr2ud ;
-            L[curInd][nbPose6+3]= 0;
-            L[curInd][nbPose6+4] = 0 ;
-            L[curInd][nbPose6+5] = px*X*r2ud ;
-          }
-            curInd++;
-          {
-            L[curInd][q] = Ayx*(-inv_z) ;
-            L[curInd][q+1] = Ayy*(-inv_z) ;
-            L[curInd][q+2] = Ayx*(X*inv_z) + Ayy*(Y*inv_z) ;
-            L[curInd][q+3] = Ayx*XY + Ayy*(1+Y2) ;
-            L[curInd][q+4] = -Ayx*(1+X2) -Ayy*XY ;
-            L[curInd][q+5] = Ayx*Y -Ayy*X;
-          }
-          {
-            L[curInd][nbPose6]= 0 ;
-            L[curInd][nbPose6+1]= 1;
-            L[curInd][nbPose6+2]= 0;
-            L[curInd][nbPose6+3]= Y*kr2ud ;
-            L[curInd][nbPose6+4] = 0 ;
-            L[curInd][nbPose6+5] = py*Y*r2ud ;
-          }
-        }  // end interaction
         curPoint++;
-      }    // end interaction
+      }
     }
 
     vpColVector error ;
     error = P-Pd ;
     //r = r/nbPointTotal ;
 
-    vpMatrix Lp ;
-    /*double rank =*/
-    L.pseudoInverse(Lp,1e-10) ;
+    if (robustEstimation)
+      robust.MEstimator(vpRobust::TUKEY, error, w);
+
     vpColVector e ;
-    e = Lp*error ;
+    if (sparseSolver) {
+      // Block-arrow structure: the rows of a view only depend on its pose and on the intrinsics
+      std::vector<vpMatrix> U(nbPose), W(nbPose), V(nbPose);
+      std::vector<vpColVector> b(nbPose), c(nbPose);
+
+#ifdef VISP_HAVE_OPENMP
+#pragma omp parallel for
+#endif
+      for (int p = 0; p < (int)nbPose; p++)
+      {
+        U[(size_t)p].resize(6, 6);
+        W[(size_t)p].resize(6, 6);
+        V[(size_t)p].resize(6, 6);
+        b[(size_t)p].resize(6);
+        c[(size_t)p].resize(6);
+
+        double Lp[4][6], Li[4][6];
+        for (unsigned int i=0 ; i < nbPoint[(size_t)p]; i++)
+        {
+          unsigned int curPt = firstPoint[(size_t)p] + i;
+          unsigned int curPt4 = 4*curPt;
+          computeInteractionWithDistortion(cX[curPt], cY[curPt], cZ[curPt], u[curPt], v[curPt], cam_est, Lp, Li);
+          for (unsigned int k = 0; k < 4; k++)
+            accumulateBlockArrowRow(Lp[k], Li[k], 6, error[curPt4+k], w[curPt4+k],
+                                    U[(size_t)p], W[(size_t)p], V[(size_t)p], b[(size_t)p], c[(size_t)p]);
+        }
+        copyUpperToLower(U[(size_t)p]);
+      }
+
+      vpMatrix V_sum(6, 6);
+      vpColVector c_sum(6);
+      for (unsigned int p = 0 ; p < nbPose ; p++)
+      {
+        V_sum += V[p];
+        c_sum += c[p];
+      }
+      copyUpperToLower(V_sum);
+
+      solveBlockArrowSystem(U, W, V_sum, b, c_sum, e);
+    }
+    else {
+      vpMatrix L(nbPointTotal*4,nbPose6+6) ;
+      double Lp[4][6], Li[4][6];
+      curPoint = 0 ; //current point indice
+      for (unsigned int p=0; p<nbPose ; p++)
+      {
+        unsigned int q = 6*p;
+        for (unsigned int i=0 ; i < nbPoint[p]; i++)
+        {
+          unsigned int curPoint4 = 4*curPoint;
+
+          computeInteractionWithDistortion(cX[curPoint], cY[curPoint], cZ[curPoint], u[curPoint], v[curPoint],
+                                           cam_est, Lp, Li);
+          for (unsigned int k = 0; k < 4; k++)
+          {
+            for (unsigned int j = 0; j < 6; j++)
+            {
+              L[curPoint4+k][q+j] = w[curPoint4+k]*Lp[k][j];
+              L[curPoint4+k][nbPose6+j] = w[curPoint4+k]*Li[k][j];
+            }
+            error[curPoint4+k] *= w[curPoint4+k];
+          }
+          curPoint++;
+        }    // end interaction
+      }
+
+      vpMatrix Lp_ ;
+      /*double rank =*/
+      L.pseudoInverse(Lp_,1e-10) ;
+      e = Lp_*error ;
+    }
+
     vpColVector Tc, Tc_v(6*nbPose) ;
     Tc = -e*gain ;
     for (unsigned int i = 0 ; i < 6*nbPose ; i++)
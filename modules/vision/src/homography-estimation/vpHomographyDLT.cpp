@@ -51,6 +51,222 @@
 #include <cmath>    // std::fabs
 #include <limits>   // numeric_limits
 
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+namespace
+{
+// Hartley normalization of a subset of points stored in contiguous arrays.
+// When index is NULL, the n first points are used.
+template <typename Real>
+void normalizePoints(const double *x, const double *y, const unsigned int *index, unsigned int n,
+                     Real *xn, Real *yn, double &xg, double &yg, double &coef)
+{
+  xg = 0;
+  yg = 0;
+  for (unsigned int i = 0; i < n; i++) {
+    unsigned int k = index ? index[i] : i;
+    xg += x[k];
+    yg += y[k];
+  }
+  xg /= n;
+  yg /= n;
+
+  double distance = 0;
+  for (unsigned int i = 0; i < n; i++) {
+    unsigned int k = index ? index[i] : i;
+    double xni = x[k] - xg;
+    double yni = y[k] - yg;
+    distance += sqrt(xni*xni + yni*yni);
+  }
+  distance /= n;
+  if (std::fabs(distance) <= std::numeric_limits<double>::epsilon())
+    coef = 1;
+  else
+    coef = sqrt(2.0) / distance;
+
+  // Contiguous loop without dependencies that the compiler vectorizes
+  const Real c = (Real)coef, cxg = (Real)(coef*xg), cyg = (Real)(coef*yg);
+  if (index) {
+    for (unsigned int i = 0; i < n; i++) {
+      xn[i] = (Real)x[index[i]];
+      yn[i] = (Real)y[index[i]];
+    }
+  }
+  else {
+    for (unsigned int i = 0; i < n; i++) {
+      xn[i] = (Real)x[i];
+      yn[i] = (Real)y[i];
+    }
+  }
+  for (unsigned int i = 0; i < n; i++) {
+    xn[i] = c * xn[i] - cxg;
+    yn[i] = c * yn[i] - cyg;
+  }
+}
+
+// Cyclic Jacobi eigen decomposition of the 9x9 symmetric matrix A.
+// On return A is diagonal (eigenvalues) and the columns of V are the
+// eigenvectors.
+template <typename Real>
+void jacobiEigen9(Real A[9][9], Real V[9][9])
+{
+  for (unsigned int i = 0; i < 9; i++)
+    for (unsigned int j = 0; j < 9; j++)
+      V[i][j] = (i == j) ? Real(1) : Real(0);
+
+  Real norm = 0;
+  for (unsigned int i = 0; i < 9; i++)
+    for (unsigned int j = 0; j < 9; j++)
+      norm += A[i][j]*A[i][j];
+  const Real eps = std::numeric_limits<Real>::epsilon();
+  const Real tol = eps * eps * norm;
+
+  for (unsigned int sweep = 0; sweep < 50; sweep++) {
+    Real off = 0;
+    for (unsigned int p = 0; p < 8; p++)
+      for (unsigned int q = p+1; q < 9; q++)
+        off += A[p][q]*A[p][q];
+    if (off <= tol)
+      break;
+
+    for (unsigned int p = 0; p < 8; p++) {
+      for (unsigned int q = p+1; q < 9; q++) {
+        Real apq = A[p][q];
+        if (std::fabs(apq) <= std::numeric_limits<Real>::min())
+          continue;
+        Real theta = (A[q][q] - A[p][p]) / (2 * apq);
+        Real t = Real(1) / (std::fabs(theta) + std::sqrt(theta*theta + Real(1)));
+        if (theta < 0)
+          t = -t;
+        Real c = Real(1) / std::sqrt(t*t + Real(1));
+        Real s = t * c;
+
+        for (unsigned int k = 0; k < 9; k++) {
+          Real akp = A[k][p], akq = A[k][q];
+          A[k][p] = c*akp - s*akq;
+          A[k][q] = s*akp + c*akq;
+        }
+        for (unsigned int k = 0; k < 9; k++) {
+          Real apk = A[p][k], aqk = A[q][k];
+          A[p][k] = c*apk - s*aqk;
+          A[q][k] = s*apk + c*aqk;
+        }
+        for (unsigned int k = 0; k < 9; k++) {
+          Real vkp = V[k][p], vkq = V[k][q];
+          V[k][p] = c*vkp - s*vkq;
+          V[k][q] = s*vkp + c*vkq;
+        }
+      }
+    }
+  }
+}
+
+// Estimate aHb from n matched points (all the points when index is NULL)
+// by solving the 9x9 normal equations of the normalized DLT system.
+// xn buffer must contain at least 4*n elements. Returns false when the
+// configuration is degenerate.
+template <typename Real>
+bool estimateHomography(const double *xb, const double *yb, const double *xa, const double *ya,
+                        const unsigned int *index, unsigned int n, Real *buffer, double aHb[9])
+{
+  Real *xbn = buffer, *ybn = buffer + n, *xan = buffer + 2*n, *yan = buffer + 3*n;
+  double xg1, yg1, coef1, xg2, yg2, coef2;
+  normalizePoints(xb, yb, index, n, xbn, ybn, xg1, yg1, coef1);
+  normalizePoints(xa, ya, index, n, xan, yan, xg2, yg2, coef2);
+
+  // Upper triangle of A^T A, with for each point the two rows
+  // r1 = ( 0   0   0  -xb -yb -1  xb*ya  yb*ya  ya)
+  // r2 = ( xb  yb  1   0   0   0 -xb*xa -yb*xa -xa)
+  Real M[9][9];
+  for (unsigned int i = 0; i < 9; i++)
+    for (unsigned int j = 0; j < 9; j++)
+      M[i][j] = 0;
+
+  for (unsigned int i = 0; i < n; i++) {
+    const Real r1[9] = { 0, 0, 0, -xbn[i], -ybn[i], -1, xbn[i]*yan[i], ybn[i]*yan[i], yan[i] };
+    const Real r2[9] = { xbn[i], ybn[i], 1, 0, 0, 0, -xbn[i]*xan[i], -ybn[i]*xan[i], -xan[i] };
+    for (unsigned int j = 0; j < 9; j++)
+      for (unsigned int k = j; k < 9; k++)
+        M[j][k] += r1[j]*r1[k] + r2[j]*r2[k];
+  }
+  for (unsigned int j = 1; j < 9; j++)
+    for (unsigned int k = 0; k < j; k++)
+      M[j][k] = M[k][j];
+
+  Real V[9][9];
+  jacobiEigen9(M, V);
+
+  // h is the eigenvector associated to the smallest eigenvalue. The
+  // second smallest one should not vanish (rank 8).
+  unsigned int iMin = 0;
+  Real lambdaMax = M[0][0];
+  for (unsigned int i = 1; i < 9; i++) {
+    if (M[i][i] < M[iMin][iMin])
+      iMin = i;
+    if (M[i][i] > lambdaMax)
+      lambdaMax = M[i][i];
+  }
+  Real lambda2 = std::numeric_limits<Real>::max();
+  for (unsigned int i = 0; i < 9; i++)
+    if (i != iMin && M[i][i] < lambda2)
+      lambda2 = M[i][i];
+  const Real rankThreshold = (sizeof(Real) == sizeof(float)) ? Real(1e-6) : Real(1e-12);
+  if (! (lambda2 > rankThreshold * lambdaMax))
+    return false;
+
+  double Hn[9];
+  for (unsigned int i = 0; i < 9; i++)
+    Hn[i] = (double)V[i][iMin];
+
+  // Denormalization: aHb = T2^-1 aHbn T1 with T = [c 0 -c*xg ; 0 c -c*yg ; 0 0 1]
+  double HT1[9];
+  for (unsigned int i = 0; i < 3; i++) {
+    const double *h = Hn + 3*i;
+    HT1[3*i]   = h[0]*coef1;
+    HT1[3*i+1] = h[1]*coef1;
+    HT1[3*i+2] = h[2] - coef1*(h[0]*xg1 + h[1]*yg1);
+  }
+  for (unsigned int j = 0; j < 3; j++) {
+    aHb[j]   = HT1[j]/coef2 + xg2*HT1[6+j];
+    aHb[3+j] = HT1[3+j]/coef2 + yg2*HT1[6+j];
+    aHb[6+j] = HT1[6+j];
+  }
+  return true;
+}
+
+template <typename Real>
+void estimateHomographies(const std::vector<double> &xb, const std::vector<double> &yb,
+                          const std::vector<double> &xa, const std::vector<double> &ya,
+                          const std::vector<unsigned int> &subsets, unsigned int subsetSize,
+                          std::vector<vpHomography> &aHb, std::vector<unsigned char> &success)
+{
+  int nbHomographies = (int)(subsets.size() / subsetSize);
+
+#ifdef VISP_HAVE_OPENMP
+#pragma omp parallel
+#endif
+  {
+    std::vector<Real> buffer(4*subsetSize);
+    double H[9];
+
+#ifdef VISP_HAVE_OPENMP
+#pragma omp for schedule(static)
+#endif
+    for (int k = 0; k < nbHomographies; k++) {
+      success[(size_t)k] = estimateHomography<Real>(&xb[0], &yb[0], &xa[0], &ya[0],
+                                                    &subsets[(size_t)k*subsetSize], subsetSize, &buffer[0], H) ? 1 : 0;
+      if (success[(size_t)k]) {
+        for (unsigned int i = 0; i < 9; i++)
+          aHb[(size_t)k].data[i] = H[i];
+      }
+      else {
+        aHb[(size_t)k].eye();
+      }
+    }
+  }
+}
+}
+#endif // #ifndef DOXYGEN_SHOULD_SKIP_THIS
+
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 
 void
@@ -384,3 +600,121 @@ void vpHomography::DLT(const std::vector<double> &xb, const std::vector<double>
     throw(me);
   }
 }
+
+/*!
+  From couples of matched points \f$^a{\bf p}=(x_a,y_a,1)\f$ in image a
+  and \f$^b{\bf p}=(x_b,y_b,1)\f$ in image b with homogeneous coordinates, computes the
+  homography matrix by resolving \f$^a{\bf p} = ^a{\bf H}_b\; ^b{\bf p}\f$
+  using the normalized DLT algorithm.
+
+  It estimates the same homography as DLT() with Hartley normalization, but instead of
+  building the \f$2n \times 9\f$ matrix \f$\bf A\f$ and computing its SVD, the
+  \f$9 \times 9\f$ normal matrix \f${\bf A}^T {\bf A}\f$ is accumulated on the fly
+  and \f$\bf h\f$ is obtained as the eigenvector associated to its smallest eigenvalue.
+  The cost is linear in the number of points and no dynamic matrix is allocated.
+
+  At least 4 couples of points are needed.
+
+  \param xb, yb : Coordinates vector of matched points in image b. These coordinates are expressed in meters.
+  \param xa, ya : Coordinates vector of matched points in image a. These coordinates are expressed in meters.
+  \param aHb : Estimated homography that relies the transformation from image a to image b.
+  \param singlePrecision : When set to true, the normal equations are accumulated and solved in
+  single precision. This is faster but less accurate; coordinates are always normalized first.
+
+  \exception vpMatrixException::rankDeficient : When the rank of the matrix
+  that should be 8 is deficient.
+
+  \sa DLT(), batchDLT()
+*/
+void vpHomography::fastDLT(const std::vector<double> &xb, const std::vector<double> &yb,
+                           const std::vector<double> &xa, const std::vector<double> &ya,
+                           vpHomography &aHb, bool singlePrecision)
+{
+  unsigned int n = (unsigned int) xb.size();
+  if (yb.size() != n || xa.size() != n || ya.size() != n)
+    throw(vpException(vpException::dimensionError,
+                      "Bad dimension for DLT homography estimation"));
+
+  // 4 point are required
+  if(n<4)
+    throw(vpException(vpException::fatalError, "There must be at least 4 matched points"));
+
+  double H[9];
+  bool success;
+  if (singlePrecision) {
+    std::vector<float> buffer(4*n);
+    success = estimateHomography<float>(&xb[0], &yb[0], &xa[0], &ya[0], NULL, n, &buffer[0], H);
+  }
+  else {
+    std::vector<double> buffer(4*n);
+    success = estimateHomography<double>(&xb[0], &yb[0], &xa[0], &ya[0], NULL, n, &buffer[0], H);
+  }
+  if (! success)
+    throw(vpMatrixException(vpMatrixException::rankDeficient,
+                            "Matrix rank is deficient (should be 8)"));
+
+  for (unsigned int i = 0; i < 9; i++)
+    aHb.data[i] = H[i];
+}
+
+/*!
+  Estimate several homographies at once with the normalized DLT algorithm of fastDLT().
+  Each homography is estimated from a subset of the matched points, for example the
+  minimal 4 points samples of RANSAC hypotheses, or the points of the different planes
+  of a scene. Subsets are processed in parallel when OpenMP is available.
+
+  \param xb, yb : Coordinates vector of matched points in image b. These coordinates are expressed in meters.
+  \param xa, ya : Coordinates vector of matched points in image a. These coordinates are expressed in meters.
+  \param subsets : Indexes of the points in the coordinates vectors. The k-th subset is made of the
+  indexes subsets[k*subsetSize] to subsets[(k+1)*subsetSize-1].
+  \param subsetSize : Number of points per subset. Should be at least 4.
+  \param aHb : Estimated homographies, one per subset. When the estimation fails, the
+  corresponding homography is set to identity.
+  \param success : For each subset, true if the homography was estimated, false if the
+  points configuration is degenerate.
+  \param singlePrecision : When set to true, computations are done in single precision.
+
+  \exception vpException::dimensionError : When the coordinates vectors have not the same size
+  or when the size of \e subsets is not a multiple of \e subsetSize.
+  \exception vpException::badValue : When a subset contains less than 4 points or an index
+  is out of range.
+
+  \sa fastDLT()
+*/
+void vpHomography::batchDLT(const std::vector<double> &xb, const std::vector<double> &yb,
+                            const std::vector<double> &xa, const std::vector<double> &ya,
+                            const std::vector<unsigned int> &subsets, unsigned int subsetSize,
+                            std::vector<vpHomography> &aHb, std::vector<bool> &success,
+                            bool singlePrecision)
+{
+  size_t n = xb.size();
+  if (yb.size() != n || xa.size() != n || ya.size() != n)
+    throw(vpException(vpException::dimensionError,
+                      "Bad dimension for DLT homography estimation"));
+  if (subsetSize < 4)
+    throw(vpException(vpException::badValue, "There must be at least 4 matched points per subset"));
+  if (subsets.size() % subsetSize != 0)
+    throw(vpException(vpException::dimensionError,
+                      "The number of indexes %d is not a multiple of the subset size %d",
+                      (int)subsets.size(), (int)subsetSize));
+  for (size_t i = 0; i < subsets.size(); i++) {
+    if (subsets[i] >= n)
+      throw(vpException(vpException::badValue, "Point index %d out of range", (int)subsets[i]));
+  }
+
+  size_t nbHomographies = subsets.size() / subsetSize;
+  aHb.resize(nbHomographies);
+  // std::vector<bool> cannot be written concurrently
+  std::vector<unsigned char> status(nbHomographies);
+
+  if (nbHomographies > 0) {
+    if (singlePrecision)
+      estimateHomographies<float>(xb, yb, xa, ya, subsets, subsetSize, aHb, status);
+    else
+      estimateHomographies<double>(xb, yb, xa, ya, subsets, subsetSize, aHb, status);
+  }
+
+  success.resize(nbHomographies);
+  for (size_t k = 0; k < nbHomographies; k++)
+    success[k] = (status[k] != 0);
+}
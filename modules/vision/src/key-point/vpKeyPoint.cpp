@@ -114,6 +114,26 @@ namespace {
     return vpImagePoint(pair.first.pt.y, pair.first.pt.x);
   }
 
+  //Keypoint with its rank (by decreasing response) inside its grid cell, used for bucketing
+  struct BucketedKeyPoint {
+    size_t index;
+    unsigned int rank;
+    float response;
+  };
+
+  inline bool compareKeyPointIndexByResponse(const std::pair<float, size_t> &p1, const std::pair<float, size_t> &p2) {
+    return p1.first > p2.first;
+  }
+
+  //Keypoints are first ordered by rank in their cell so that each cell contributes
+  //its best keypoint before any cell contributes its second one
+  inline bool compareBucketedKeyPoint(const BucketedKeyPoint &kp1, const BucketedKeyPoint &kp2) {
+    if(kp1.rank != kp2.rank) {
+      return kp1.rank < kp2.rank;
+    }
+    return kp1.response > kp2.response;
+  }
+
   //Keep this function to know how to detect big endian with code
   //bool isBigEndian() {
   //  union {
@@ -302,17 +322,19 @@ namespace {
  */
 vpKeyPoint::vpKeyPoint(const vpFeatureDetectorType &detectorType, const vpFeatureDescriptorType &descriptorType,
                        const std::string &matcherName, const vpFilterMatchingType &filterType)
-  : m_computeCovariance(false), m_covarianceMatrix(), m_currentImageId(0), m_detectionMethod(detectionScore),
+  : m_computeCovariance(false), m_covarianceMatrix(), m_currentImageId(0), m_detectionGridCols(1),
+    m_detectionGridMaxPerCell(0), m_detectionGridRows(1), m_detectionMethod(detectionScore),
     m_detectionScore(0.15), m_detectionThreshold(100.0), m_detectionTime(0.), m_detectorNames(),
     m_detectors(), m_extractionTime(0.), m_extractorNames(), m_extractors(), m_filteredMatches(), m_filterType(filterType),
     m_imageFormat(jpgImageFormat), m_knnMatches(), m_mapOfImageId(), m_mapOfImages(),
     m_matcher(), m_matcherName(matcherName),
     m_matches(), m_matchingFactorThreshold(2.0), m_matchingRatioThreshold(0.85), m_matchingTime(0.),
-    m_matchRansacKeyPointsToPoints(), m_nbRansacIterations(200), m_nbRansacMinInlierCount(100), m_objectFilteredPoints(),
+    m_matchRansacKeyPointsToPoints(), m_maxFeatures(-1), m_nbRansacIterations(200), m_nbRansacMinInlierCount(100), m_objectFilteredPoints(),
     m_poseTime(0.), m_queryDescriptors(), m_queryFilteredKeyPoints(), m_queryKeyPoints(),
-    m_ransacConsensusPercentage(20.0), m_ransacInliers(), m_ransacOutliers(), m_ransacReprojectionError(6.0),
+    m_ransacConsensusPercentage(20.0), m_ransacInliers(), m_ransacOutliers(), m_ransacParallel(false),
+    m_ransacParallelNbThreads(0), m_ransacReprojectionError(6.0),
     m_ransacThreshold(0.01), m_trainDescriptors(), m_trainKeyPoints(), m_trainPoints(),
-    m_trainVpPoints(), m_useAffineDetection(false),
+    m_trainVpPoints(), m_useAdaptiveDetectionThreshold(false), m_useAffineDetection(false),
 #if (VISP_HAVE_OPENCV_VERSION >= 0x020400 && VISP_HAVE_OPENCV_VERSION < 0x030000)
     m_useBruteForceCrossCheck(true),
 #endif
@@ -337,17 +359,19 @@ vpKeyPoint::vpKeyPoint(const vpFeatureDetectorType &detectorType, const vpFeatur
  */
 vpKeyPoint::vpKeyPoint(const std::string &detectorName, const std::string &extractorName,
                        const std::string &matcherName, const vpFilterMatchingType &filterType)
-  : m_computeCovariance(false), m_covarianceMatrix(), m_currentImageId(0), m_detectionMethod(detectionScore),
+  : m_computeCovariance(false), m_covarianceMatrix(), m_currentImageId(0), m_detectionGridCols(1),
+    m_detectionGridMaxPerCell(0), m_detectionGridRows(1), m_detectionMethod(detectionScore),
     m_detectionScore(0.15), m_detectionThreshold(100.0), m_detectionTime(0.), m_detectorNames(),
     m_detectors(), m_extractionTime(0.), m_extractorNames(), m_extractors(), m_filteredMatches(), m_filterType(filterType),
     m_imageFormat(jpgImageFormat), m_knnMatches(), m_mapOfImageId(), m_mapOfImages(),
     m_matcher(), m_matcherName(matcherName),
     m_matches(), m_matchingFactorThreshold(2.0), m_matchingRatioThreshold(0.85), m_matchingTime(0.),
-    m_matchRansacKeyPointsToPoints(), m_nbRansacIterations(200), m_nbRansacMinInlierCount(100), m_objectFilteredPoints(),
+    m_matchRansacKeyPointsToPoints(), m_maxFeatures(-1), m_nbRansacIterations(200), m_nbRansacMinInlierCount(100), m_objectFilteredPoints(),
     m_poseTime(0.), m_queryDescriptors(), m_queryFilteredKeyPoints(), m_queryKeyPoints(),
-    m_ransacConsensusPercentage(20.0), m_ransacInliers(), m_ransacOutliers(), m_ransacReprojectionError(6.0),
+    m_ransacConsensusPercentage(20.0), m_ransacInliers(), m_ransacOutliers(), m_ransacParallel(false),
+    m_ransacParallelNbThreads(0), m_ransacReprojectionError(6.0),
     m_ransacThreshold(0.01), m_trainDescriptors(), m_trainKeyPoints(), m_trainPoints(),
-    m_trainVpPoints(), m_useAffineDetection(false),
+    m_trainVpPoints(), m_useAdaptiveDetectionThreshold(false), m_useAffineDetection(false),
 #if (VISP_HAVE_OPENCV_VERSION >= 0x020400 && VISP_HAVE_OPENCV_VERSION < 0x030000)
     m_useBruteForceCrossCheck(true),
 #endif
@@ -372,17 +396,19 @@ vpKeyPoint::vpKeyPoint(const std::string &detectorName, const std::string &extra
  */
 vpKeyPoint::vpKeyPoint(const std::vector<std::string> &detectorNames, const std::vector<std::string> &extractorNames,
                        const std::string &matcherName, const vpFilterMatchingType &filterType)
-  : m_computeCovariance(false), m_covarianceMatrix(), m_currentImageId(0), m_detectionMethod(detectionScore),
+  : m_computeCovariance(false), m_covarianceMatrix(), m_currentImageId(0), m_detectionGridCols(1),
+    m_detectionGridMaxPerCell(0), m_detectionGridRows(1), m_detectionMethod(detectionScore),
     m_detectionScore(0.15), m_detectionThreshold(100.0), m_detectionTime(0.), m_detectorNames(detectorNames),
     m_detectors(), m_extractionTime(0.), m_extractorNames(extractorNames), m_extractors(), m_filteredMatches(),
     m_filterType(filterType), m_imageFormat(jpgImageFormat), m_knnMatches(), m_mapOfImageId(), m_mapOfImages(),
     m_matcher(),
     m_matcherName(matcherName), m_matches(), m_matchingFactorThreshold(2.0), m_matchingRatioThreshold(0.85), m_matchingTime(0.),
-    m_matchRansacKeyPointsToPoints(), m_nbRansacIterations(200), m_nbRansacMinInlierCount(100), m_objectFilteredPoints(),
+    m_matchRansacKeyPointsToPoints(), m_maxFeatures(-1), m_nbRansacIterations(200), m_nbRansacMinInlierCount(100), m_objectFilteredPoints(),
     m_poseTime(0.), m_queryDescriptors(), m_queryFilteredKeyPoints(), m_queryKeyPoints(),
-    m_ransacConsensusPercentage(20.0), m_ransacInliers(), m_ransacOutliers(), m_ransacReprojectionError(6.0),
+    m_ransacConsensusPercentage(20.0), m_ransacInliers(), m_ransacOutliers(), m_ransacParallel(false),
+    m_ransacParallelNbThreads(0), m_ransacReprojectionError(6.0),
     m_ransacThreshold(0.01), m_trainDescriptors(), m_trainKeyPoints(), m_trainPoints(),
-    m_trainVpPoints(), m_useAffineDetection(false),
+    m_trainVpPoints(), m_useAdaptiveDetectionThreshold(false), m_useAffineDetection(false),
 #if (VISP_HAVE_OPENCV_VERSION >= 0x020400 && VISP_HAVE_OPENCV_VERSION < 0x030000)
     m_useBruteForceCrossCheck(true),
 #endif
@@ -1112,6 +1138,8 @@ bool vpKeyPoint::computePose(const std::vector<vpPoint> &objectVpPoints, vpHomog
   pose.setRansacNbInliersToReachConsensus(nbInlierToReachConsensus);
   pose.setRansacThreshold(m_ransacThreshold);
   pose.setRansacMaxTrials(m_nbRansacIterations);
+  pose.setUseParallelRansac(m_ransacParallel);
+  pose.setNbParallelRansacThreads(static_cast<int>(m_ransacParallelNbThreads));
 
   bool isRansacPoseEstimationOk = false;
   try {
@@ -1311,11 +1339,131 @@ void vpKeyPoint::detect(const cv::Mat &matImg, std::vector<cv::KeyPoint> &keyPoi
     std::vector<cv::KeyPoint> kp;
     it->second->detect(matImg, kp, mask);
     keyPoints.insert(keyPoints.end(), kp.begin(), kp.end());
+
+    if(m_useAdaptiveDetectionThreshold) {
+      adaptDetectionThreshold(it->second, kp.size());
+    }
   }
 
+  bucketKeyPoints(keyPoints, matImg.size());
+
   elapsedTime = vpTime::measureTimeMs() - t;
 }
 
+/*!
+   Adapt the threshold of a detector for the next frame so that the number of raw detections
+   stays between once and four times the keypoints budget: the threshold is increased by one when
+   there are more than four times the budget and decreased by one when there are fewer than the budget.
+   The budget is setMaxFeatures() if it is positive, otherwise the number of cells times the maximum
+   number of keypoints per cell (see setDetectionGrid()); without budget the threshold is left unchanged.
+   Only FAST, AGAST and ORB detectors are adapted (OpenCV >= 3.0), other detectors are left unchanged.
+
+   \param detector : Detector whose threshold has to be adapted.
+   \param nbDetections : Number of keypoints detected in the current frame by this detector.
+ */
+void vpKeyPoint::adaptDetectionThreshold(const cv::Ptr<cv::FeatureDetector> &detector, const size_t nbDetections) {
+#if (VISP_HAVE_OPENCV_VERSION >= 0x030000)
+  unsigned int maxFeatures = 0;
+  if(m_maxFeatures > 0) {
+    maxFeatures = (unsigned int) m_maxFeatures;
+  } else if(m_detectionGridMaxPerCell > 0) {
+    maxFeatures = m_detectionGridMaxPerCell * m_detectionGridRows * m_detectionGridCols;
+  }
+
+  if(maxFeatures == 0) {
+    return;
+  }
+
+  //Too many detections: increase the threshold, too few: decrease it
+  int step = 0;
+  if(nbDetections > 4 * (size_t) maxFeatures) {
+    step = 1;
+  } else if(nbDetections < (size_t) maxFeatures) {
+    step = -1;
+  }
+
+  if(step == 0) {
+    return;
+  }
+
+  cv::Ptr<cv::FastFeatureDetector> fast = detector.dynamicCast<cv::FastFeatureDetector>();
+  if(fast) {
+    fast->setThreshold((std::max)(1, fast->getThreshold() + step));
+    return;
+  }
+
+  cv::Ptr<cv::AgastFeatureDetector> agast = detector.dynamicCast<cv::AgastFeatureDetector>();
+  if(agast) {
+    agast->setThreshold((std::max)(1, agast->getThreshold() + step));
+    return;
+  }
+
+  cv::Ptr<cv::ORB> orb = detector.dynamicCast<cv::ORB>();
+  if(orb) {
+    orb->setFastThreshold((std::max)(1, orb->getFastThreshold() + step));
+  }
+#else
+  (void)detector;
+  (void)nbDetections;
+#endif
+}
+
+/*!
+   Apply the detection budget to the list of detected keypoints: keep at most
+   setDetectionGrid() \e maxPerCell keypoints with the highest response in each grid cell and at
+   most setMaxFeatures() keypoints in total. When the global budget is reached, the best keypoint of each cell
+   is kept before the second best of any cell, to preserve the spatial distribution.
+
+   \param keyPoints : List of keypoints to filter in place.
+   \param imageSize : Size of the image, used to compute the grid cells.
+ */
+void vpKeyPoint::bucketKeyPoints(std::vector<cv::KeyPoint> &keyPoints, const cv::Size &imageSize) const {
+  if(keyPoints.empty() || (m_detectionGridMaxPerCell == 0 && m_maxFeatures < 0)) {
+    return;
+  }
+
+  //Sort the keypoint indexes by decreasing response
+  std::vector<std::pair<float, size_t> > sortedIndexes(keyPoints.size());
+  for(size_t i = 0; i < keyPoints.size(); i++) {
+    sortedIndexes[i] = std::pair<float, size_t>(keyPoints[i].response, i);
+  }
+  std::stable_sort(sortedIndexes.begin(), sortedIndexes.end(), compareKeyPointIndexByResponse);
+
+  //Rank of each keypoint inside its cell
+  unsigned int nbRows = (std::max)(1u, m_detectionGridRows), nbCols = (std::max)(1u, m_detectionGridCols);
+  double cellHeight = (double) imageSize.height / nbRows, cellWidth = (double) imageSize.width / nbCols;
+  std::vector<unsigned int> cellCount(nbRows * nbCols, 0);
+  std::vector<BucketedKeyPoint> bucketedKeyPoints;
+  bucketedKeyPoints.reserve(keyPoints.size());
+
+  for(size_t i = 0; i < sortedIndexes.size(); i++) {
+    const cv::KeyPoint &kp = keyPoints[sortedIndexes[i].second];
+    int row = (std::max)(0, (std::min)((int) (kp.pt.y / cellHeight), (int) nbRows - 1));
+    int col = (std::max)(0, (std::min)((int) (kp.pt.x / cellWidth), (int) nbCols - 1));
+
+    unsigned int &count = cellCount[(size_t) row * nbCols + (size_t) col];
+    if(m_detectionGridMaxPerCell == 0 || count < m_detectionGridMaxPerCell) {
+      BucketedKeyPoint bkp;
+      bkp.index = sortedIndexes[i].second;
+      bkp.rank = count;
+      bkp.response = kp.response;
+      bucketedKeyPoints.push_back(bkp);
+      count++;
+    }
+  }
+
+  if(m_maxFeatures >= 0 && bucketedKeyPoints.size() > (size_t) m_maxFeatures) {
+    std::stable_sort(bucketedKeyPoints.begin(), bucketedKeyPoints.end(), compareBucketedKeyPoint);
+    bucketedKeyPoints.resize((size_t) m_maxFeatures);
+  }
+
+  std::vector<cv::KeyPoint> keptKeyPoints(bucketedKeyPoints.size());
+  for(size_t i = 0; i < bucketedKeyPoints.size(); i++) {
+    keptKeyPoints[i] = keyPoints[bucketedKeyPoints[i].index];
+  }
+  keyPoints.swap(keptKeyPoints);
+}
+
 /*!
    Display the reference and the detected keypoints in the images.
 
@@ -1687,22 +1835,33 @@ void vpKeyPoint::filterMatches() {
     double stdev = std::sqrt(sq_sum / distance_vec.size() - mean * mean);
     double threshold = min_dist + stdev;
 
-    for(size_t i = 0; i < m_knnMatches.size(); i++) {
-      if(m_knnMatches[i].size() >= 2) {
+    //The ratio test is evaluated independently for each query keypoint, the flags are
+    //then gathered sequentially to keep the matches ordered by query index
+    std::vector<unsigned char> keepMatch(m_knnMatches.size(), 0);
+    bool useStdThreshold = (m_filterType == stdAndRatioDistanceThreshold);
+#ifdef VISP_HAVE_OPENMP
+    #pragma omp parallel for if(m_knnMatches.size() > 1000)
+#endif
+    for(int i = 0; i < static_cast<int>(m_knnMatches.size()); i++) {
+      if(m_knnMatches[(size_t) i].size() >= 2) {
         //Calculate ratio of the descriptor distance between the two nearest neighbors of the keypoint
-        float ratio = m_knnMatches[i][0].distance / m_knnMatches[i][1].distance;
+        float ratio = m_knnMatches[(size_t) i][0].distance / m_knnMatches[(size_t) i][1].distance;
 //        float ratio = std::sqrt((vecMatches[i][0].distance * vecMatches[i][0].distance)
 //            / (vecMatches[i][1].distance * vecMatches[i][1].distance));
-        double dist = m_knnMatches[i][0].distance;
+        double dist = m_knnMatches[(size_t) i][0].distance;
 
-        if(ratio < m_matchingRatioThreshold || (m_filterType == stdAndRatioDistanceThreshold && dist < threshold)) {
-          m.push_back(cv::DMatch((int) queryKpts.size(), m_knnMatches[i][0].trainIdx, m_knnMatches[i][0].distance));
+        keepMatch[(size_t) i] = (ratio < m_matchingRatioThreshold || (useStdThreshold && dist < threshold)) ? 1 : 0;
+      }
+    }
 
-          if(!m_trainPoints.empty()) {
-            trainPts.push_back(m_trainPoints[(size_t)m_knnMatches[i][0].trainIdx]);
-          }
-          queryKpts.push_back(m_queryKeyPoints[(size_t)m_knnMatches[i][0].queryIdx]);
+    for(size_t i = 0; i < m_knnMatches.size(); i++) {
+      if(keepMatch[i]) {
+        m.push_back(cv::DMatch((int) queryKpts.size(), m_knnMatches[i][0].trainIdx, m_knnMatches[i][0].distance));
+
+        if(!m_trainPoints.empty()) {
+          trainPts.push_back(m_trainPoints[(size_t)m_knnMatches[i][0].trainIdx]);
         }
+        queryKpts.push_back(m_queryKeyPoints[(size_t)m_knnMatches[i][0].queryIdx]);
       }
     }
   } else {
@@ -3367,19 +3526,28 @@ bool vpKeyPoint::matchPointAndDetect(const vpImage<unsigned char> &I, vpRect &bo
       cv::Mat homographyMatrix = cv::findHomography(points1, points2, cv::RANSAC);
 #endif
 
+      //Compute the reprojection errors in parallel, the inliers are gathered afterwards
+      //to keep the same ordering than the matches
+      std::vector<unsigned char> isInlier(m_filteredMatches.size(), 0);
+      if(!homographyMatrix.empty()) {
+        const double *H = homographyMatrix.ptr<double>(0);
+#ifdef VISP_HAVE_OPENMP
+        #pragma omp parallel for if(m_filteredMatches.size() > 1000)
+#endif
+        for(int i = 0; i < static_cast<int>(m_filteredMatches.size()); i++) {
+          //Compute reprojection error
+          double x = points1[(size_t) i].x, y = points1[(size_t) i].y;
+          double w = H[6]*x + H[7]*y + H[8];
+          double err_x = (H[0]*x + H[1]*y + H[2]) / w - points2[(size_t) i].x;
+          double err_y = (H[3]*x + H[4]*y + H[5]) / w - points2[(size_t) i].y;
+          double reprojectionError = std::sqrt(err_x*err_x + err_y*err_y);
+
+          isInlier[(size_t) i] = (reprojectionError < 6.0) ? 1 : 0;
+        }
+      }
+
       for(size_t i = 0; i < m_filteredMatches.size(); i++ ) {
-        //Compute reprojection error
-        cv::Mat realPoint = cv::Mat(3, 1, CV_64F);
-        realPoint.at<double>(0,0) = points1[i].x;
-        realPoint.at<double>(1,0) = points1[i].y;
-        realPoint.at<double>(2,0) = 1.f;
-
-        cv::Mat reprojectedPoint = homographyMatrix * realPoint;
-        double err_x = (reprojectedPoint.at<double>(0,0) / reprojectedPoint.at<double>(2,0)) - points2[i].x;
-        double err_y = (reprojectedPoint.at<double>(1,0) / reprojectedPoint.at<double>(2,0)) - points2[i].y;
-        double reprojectionError = std::sqrt(err_x*err_x + err_y*err_y);
-
-        if(reprojectionError < 6.0) {
+        if(isInlier[i]) {
           inliers.push_back(vpImagePoint((double) points2[i].y, (double) points2[i].x));
           if(imPts1 != NULL) {
             imPts1->push_back(vpImagePoint((double) points1[i].y, (double) points1[i].x));
@@ -3502,6 +3670,9 @@ bool vpKeyPoint::matchPointAndDetect(const vpImage<unsigned char> &I, const vpCa
     See http://www.ipol.im/pub/algo/my_affine_sift/ for the details.
     See https://github.com/Itseez/opencv/blob/master/samples/python2/asift.py for the Python implementation by Itseez
     and Matt Sheckells for the current implementation in C++.
+    When OpenMP is available, the affine views are processed in parallel in two stages
+    (affine simulation + detection, then extraction); the wall-clock time of each stage is
+    available with getDetectionTime() and getExtractionTime().
     \param I : Input image
     \param listOfKeypoints : List of detected keypoints in the multiple images after affine transformations
     \param listOfDescriptors : Corresponding list of descriptors
@@ -3584,19 +3755,22 @@ void vpKeyPoint::detectExtractAffine(const vpImage<unsigned char> &I,std::vector
     listOfAffineI->resize(listOfAffineParams.size());
   }
 
+  //Warped images and inverse affine transformations are kept between the detection
+  //and the extraction stages so that each stage can be timed and run in parallel over the views
+  std::vector<cv::Mat> listOfWarpedImages(listOfAffineParams.size());
+  std::vector<cv::Mat> listOfInverseAffine(listOfAffineParams.size());
+
+  //Stage 1: affine simulation and keypoint detection
+  double t = vpTime::measureTimeMs();
 #ifdef VISP_HAVE_OPENMP
-  #pragma omp parallel for
+  #pragma omp parallel for schedule(dynamic)
 #endif
   for(int cpt = 0; cpt < static_cast<int>(listOfAffineParams.size()); cpt++) {
-    std::vector<cv::KeyPoint> keypoints;
-    cv::Mat descriptors;
-
     cv::Mat timg, mask, Ai;
     img.copyTo(timg);
 
     affineSkew(listOfAffineParams[(size_t) cpt].first, listOfAffineParams[(size_t) cpt].second, timg, mask, Ai);
 
-
     if(listOfAffineI != NULL) {
       cv::Mat img_disp;
       bitwise_and(mask, timg, img_disp);
@@ -3605,14 +3779,8 @@ void vpKeyPoint::detectExtractAffine(const vpImage<unsigned char> &I,std::vector
       (*listOfAffineI)[(size_t) cpt] = tI;
     }
 
-#if 0
-    cv::Mat img_disp;
-    cv::bitwise_and(mask, timg, img_disp);
-    cv::namedWindow( "Skew", cv::WINDOW_AUTOSIZE ); // Create a window for display.
-    cv::imshow( "Skew", img_disp );
-    cv::waitKey(0);
-#endif
-
+    std::vector<cv::KeyPoint> &keypoints = listOfKeypoints[(size_t) cpt];
+    keypoints.clear();
     for(std::map<std::string, cv::Ptr<cv::FeatureDetector> >::const_iterator it = m_detectors.begin();
         it != m_detectors.end(); ++it) {
       std::vector<cv::KeyPoint> kp;
@@ -3620,19 +3788,36 @@ void vpKeyPoint::detectExtractAffine(const vpImage<unsigned char> &I,std::vector
       keypoints.insert(keypoints.end(), kp.begin(), kp.end());
     }
 
+    listOfWarpedImages[(size_t) cpt] = timg;
+    listOfInverseAffine[(size_t) cpt] = Ai;
+  }
+  m_detectionTime = vpTime::measureTimeMs() - t;
+
+  //Stage 2: descriptor extraction and back-projection in the input image frame
+  t = vpTime::measureTimeMs();
+#ifdef VISP_HAVE_OPENMP
+  #pragma omp parallel for schedule(dynamic)
+#endif
+  for(int cpt = 0; cpt < static_cast<int>(listOfAffineParams.size()); cpt++) {
+    std::vector<cv::KeyPoint> &keypoints = listOfKeypoints[(size_t) cpt];
+    const cv::Mat &Ai = listOfInverseAffine[(size_t) cpt];
+
     double elapsedTime;
-    extract(timg, keypoints, descriptors, elapsedTime);
+    extract(listOfWarpedImages[(size_t) cpt], keypoints, listOfDescriptors[(size_t) cpt], elapsedTime);
 
+    //Ai is a 2x3 CV_32F matrix, apply it directly instead of allocating a cv::Mat per keypoint
+    const float a00 = Ai.at<float>(0, 0), a01 = Ai.at<float>(0, 1), a02 = Ai.at<float>(0, 2);
+    const float a10 = Ai.at<float>(1, 0), a11 = Ai.at<float>(1, 1), a12 = Ai.at<float>(1, 2);
     for(size_t i = 0; i < keypoints.size(); i++) {
-      cv::Point3f kpt(keypoints[i].pt.x, keypoints[i].pt.y, 1.f);
-      cv::Mat kpt_t = Ai * cv::Mat(kpt);
-      keypoints[i].pt.x = kpt_t.at<float>(0, 0);
-      keypoints[i].pt.y = kpt_t.at<float>(1, 0);
+      const float x = keypoints[i].pt.x, y = keypoints[i].pt.y;
+      keypoints[i].pt.x = a00 * x + a01 * y + a02;
+      keypoints[i].pt.y = a10 * x + a11 * y + a12;
     }
 
-    listOfKeypoints[(size_t) cpt] = keypoints;
-    listOfDescriptors[(size_t) cpt] = descriptors;
+    //Release the warped image as soon as possible
+    listOfWarpedImages[(size_t) cpt].release();
   }
+  m_extractionTime = vpTime::measureTimeMs() - t;
 #endif
 }
 
@@ -3644,19 +3829,21 @@ void vpKeyPoint::reset() {
   referenceImagePointsList.clear(); currentImagePointsList.clear(); matchedReferencePoints.clear(); _reference_computed = false;
 
 
-  m_computeCovariance = false; m_covarianceMatrix = vpMatrix(); m_currentImageId = 0; m_detectionMethod = detectionScore;
+  m_computeCovariance = false; m_covarianceMatrix = vpMatrix(); m_currentImageId = 0;
+  m_detectionGridCols = 1; m_detectionGridMaxPerCell = 0; m_detectionGridRows = 1; m_detectionMethod = detectionScore;
   m_detectionScore = 0.15; m_detectionThreshold = 100.0; m_detectionTime = 0.0; m_detectorNames.clear();
   m_detectors.clear(); m_extractionTime = 0.0; m_extractorNames.clear(); m_extractors.clear(); m_filteredMatches.clear();
   m_filterType = ratioDistanceThreshold;
   m_imageFormat = jpgImageFormat; m_knnMatches.clear(); m_mapOfImageId.clear(); m_mapOfImages.clear();
   m_matcher = cv::Ptr<cv::DescriptorMatcher>(); m_matcherName = "BruteForce-Hamming";
   m_matches.clear(); m_matchingFactorThreshold = 2.0; m_matchingRatioThreshold = 0.85; m_matchingTime = 0.0;
-  m_matchRansacKeyPointsToPoints.clear(); m_nbRansacIterations = 200; m_nbRansacMinInlierCount = 100;
+  m_matchRansacKeyPointsToPoints.clear(); m_maxFeatures = -1; m_nbRansacIterations = 200; m_nbRansacMinInlierCount = 100;
   m_objectFilteredPoints.clear();
   m_poseTime = 0.0; m_queryDescriptors = cv::Mat(); m_queryFilteredKeyPoints.clear(); m_queryKeyPoints.clear();
-  m_ransacConsensusPercentage = 20.0; m_ransacInliers.clear(); m_ransacOutliers.clear(); m_ransacReprojectionError = 6.0;
+  m_ransacConsensusPercentage = 20.0; m_ransacInliers.clear(); m_ransacOutliers.clear();
+  m_ransacParallel = false; m_ransacParallelNbThreads = 0; m_ransacReprojectionError = 6.0;
   m_ransacThreshold = 0.01; m_trainDescriptors = cv::Mat(); m_trainKeyPoints.clear(); m_trainPoints.clear();
-  m_trainVpPoints.clear(); m_useAffineDetection = false;
+  m_trainVpPoints.clear(); m_useAdaptiveDetectionThreshold = false; m_useAffineDetection = false;
 #if (VISP_HAVE_OPENCV_VERSION >= 0x020400 && VISP_HAVE_OPENCV_VERSION < 0x030000)
   m_useBruteForceCrossCheck = true;
 #endif
@@ -0,0 +1,212 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2017 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * Description:
+ * Test the sparse solver and the robust estimation of the multi-image
+ * calibration.
+ *
+ *****************************************************************************/
+
+/*!
+  \example testCalibrationSparse.cpp
+
+  Calibrate a camera from synthetic views of a planar grid with the dense and
+  the sparse (Schur complement) solvers of vpCalibration::computeCalibrationMulti()
+  and check that they give the same intrinsics and poses, close to the ground
+  truth. Check also that the robust estimation (Tukey M-estimator) reduces the
+  influence of outliers injected in the image points.
+*/
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <visp3/core/vpGaussRand.h>
+#include <visp3/core/vpMeterPixelConversion.h>
+#include <visp3/core/vpThetaUVector.h>
+#include <visp3/vision/vpCalibration.h>
+
+namespace {
+  // Intrinsics and poses used to generate the image points
+  void createViews(std::vector<vpHomogeneousMatrix> &cMo) {
+    cMo.clear();
+    for (unsigned int i = 0; i < 8; i++) {
+      // Grid tilted by 30 degrees in various directions, centered in the image
+      double a = vpMath::rad(45. * i);
+      vpHomogeneousMatrix cMg(0.01 * std::cos(3. * i), 0.01 * std::sin(2. * i), 0.4 + 0.02 * (i % 3),
+                              vpMath::rad(30.) * std::cos(a), vpMath::rad(30.) * std::sin(a), vpMath::rad(15. * i));
+      cMo.push_back(cMg * vpHomogeneousMatrix(-0.08, -0.06, 0., 0., 0., 0.));
+    }
+  }
+
+  // Image points of a 9 x 7 planar grid in each view, with noise and outliers
+  std::vector<vpCalibration> createCalibration(const vpCameraParameters &cam, const std::vector<vpHomogeneousMatrix> &cMo,
+                                               double noise, unsigned int nbOutliersPerView) {
+    vpGaussRand gauss(noise, 0., 42);
+    std::vector<vpCalibration> table_cal(cMo.size());
+    for (size_t v = 0; v < cMo.size(); v++) {
+      table_cal[v].clearPoint();
+      unsigned int n = 0;
+      for (unsigned int i = 0; i < 7; i++) {
+        for (unsigned int j = 0; j < 9; j++, n++) {
+          vpColVector oP(4, 1.);
+          oP[0] = 0.02 * j;
+          oP[1] = 0.02 * i;
+          oP[2] = 0.;
+          vpColVector cP = cMo[v] * oP;
+          double u = 0., v_ = 0.;
+          vpMeterPixelConversion::convertPoint(cam, cP[0] / cP[2], cP[1] / cP[2], u, v_);
+          u += gauss();
+          v_ += gauss();
+          // Outliers spread over the grid, at a different place in each view
+          if ((n + 5 * v) % 13 == 0 && n / 13 < nbOutliersPerView) {
+            u += 25.;
+            v_ -= 20.;
+          }
+          vpImagePoint ip(v_, u);
+          table_cal[v].addPoint(oP[0], oP[1], oP[2], ip);
+        }
+      }
+    }
+    return table_cal;
+  }
+
+  vpCameraParameters calibrate(std::vector<vpCalibration> &table_cal, bool sparse, bool robust) {
+    vpCalibration::setSparseSolver(sparse);
+    vpCalibration::setRobustEstimation(robust, 0.5);
+    vpCameraParameters cam(550., 560., 300., 260.);
+    double error;
+    vpCalibration::computeCalibrationMulti(vpCalibration::CALIB_VIRTUAL_VS_DIST, table_cal, cam, error, false);
+    vpCalibration::setSparseSolver(false);
+    vpCalibration::setRobustEstimation(false);
+    return cam;
+  }
+
+  double intrinsicsError(const vpCameraParameters &cam1, const vpCameraParameters &cam2) {
+    return (std::max)((std::max)(std::fabs(cam1.get_px() - cam2.get_px()), std::fabs(cam1.get_py() - cam2.get_py())),
+                      (std::max)(std::fabs(cam1.get_u0() - cam2.get_u0()), std::fabs(cam1.get_v0() - cam2.get_v0())));
+  }
+
+  double distortionError(const vpCameraParameters &cam1, const vpCameraParameters &cam2) {
+    return (std::max)(std::fabs(cam1.get_kud() - cam2.get_kud()), std::fabs(cam1.get_kdu() - cam2.get_kdu()));
+  }
+
+  // Largest translation (in meter) and rotation (in radian) differences between the poses
+  void poseError(const vpHomogeneousMatrix &cMo1, const vpHomogeneousMatrix &cMo2, double &t, double &r) {
+    vpHomogeneousMatrix M = cMo1.inverse() * cMo2;
+    t = M.getTranslationVector().euclideanNorm();
+    vpThetaUVector tu(M.getRotationMatrix());
+    r = std::sqrt(tu[0] * tu[0] + tu[1] * tu[1] + tu[2] * tu[2]);
+  }
+
+  bool checkPoses(const std::vector<vpCalibration> &cal1, const std::vector<vpHomogeneousMatrix> &cMo2,
+                  bool withDistortion, double tolerance, const std::string &name) {
+    for (size_t i = 0; i < cal1.size(); i++) {
+      double t, r;
+      poseError(withDistortion ? cal1[i].cMo_dist : cal1[i].cMo, cMo2[i], t, r);
+      if (t > tolerance || r > tolerance) {
+        std::cerr << name << ": the pose of view " << i << " differs by " << t << " m and " << r << " rad" << std::endl;
+        return false;
+      }
+    }
+    return true;
+  }
+
+  std::vector<vpHomogeneousMatrix> getPoses(const std::vector<vpCalibration> &table_cal, bool withDistortion) {
+    std::vector<vpHomogeneousMatrix> cMo(table_cal.size());
+    for (size_t i = 0; i < table_cal.size(); i++)
+      cMo[i] = withDistortion ? table_cal[i].cMo_dist : table_cal[i].cMo;
+    return cMo;
+  }
+}
+
+int main()
+{
+  try {
+    vpCameraParameters cam_true(600., 610., 320., 240.);
+    std::vector<vpHomogeneousMatrix> cMo_true;
+    createViews(cMo_true);
+
+    // Dense and sparse solvers on noisy data
+    std::vector<vpCalibration> cal_dense = createCalibration(cam_true, cMo_true, 0.2, 0);
+    std::vector<vpCalibration> cal_sparse = cal_dense;
+    vpCameraParameters cam_dense = calibrate(cal_dense, false, false);
+    vpCameraParameters cam_sparse = calibrate(cal_sparse, true, false);
+
+    std::cout << "Dense solver: px " << cam_dense.get_px() << " py " << cam_dense.get_py() << " u0 "
+              << cam_dense.get_u0() << " v0 " << cam_dense.get_v0() << std::endl;
+    std::cout << "Sparse solver: px " << cam_sparse.get_px() << " py " << cam_sparse.get_py() << " u0 "
+              << cam_sparse.get_u0() << " v0 " << cam_sparse.get_v0() << std::endl;
+
+    const double tolerance = 1e-6;
+    if (intrinsicsError(cal_dense[0].cam, cal_sparse[0].cam) > tolerance ||
+        intrinsicsError(cam_dense, cam_sparse) > tolerance || distortionError(cam_dense, cam_sparse) > tolerance) {
+      std::cerr << "The dense and sparse solvers give different intrinsics" << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (! checkPoses(cal_sparse, getPoses(cal_dense, false), false, tolerance, "Sparse / dense solvers") ||
+        ! checkPoses(cal_sparse, getPoses(cal_dense, true), true, tolerance, "Sparse / dense solvers with distortion"))
+      return EXIT_FAILURE;
+
+    // Both are close to the ground truth
+    if (intrinsicsError(cal_sparse[0].cam, cam_true) > 1.) {
+      std::cerr << "The intrinsics differ by " << intrinsicsError(cal_sparse[0].cam, cam_true) << " px from the ground truth" << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (! checkPoses(cal_sparse, cMo_true, false, 5e-3, "Ground truth"))
+      return EXIT_FAILURE;
+
+    // Outliers: the robust estimation keeps the intrinsics close to the ground truth with both solvers
+    std::vector<vpCalibration> cal_outliers = createCalibration(cam_true, cMo_true, 0.2, 4);
+    std::vector<vpCalibration> cal_robust_dense = cal_outliers, cal_robust_sparse = cal_outliers;
+    calibrate(cal_outliers, true, false);
+    calibrate(cal_robust_dense, false, true);
+    calibrate(cal_robust_sparse, true, true);
+    double error = intrinsicsError(cal_outliers[0].cam, cam_true);
+    double error_robust = intrinsicsError(cal_robust_sparse[0].cam, cam_true);
+    std::cout << "Intrinsics error with outliers: " << error << " px, with the robust estimation: " << error_robust
+              << " px" << std::endl;
+    if (error_robust > 1. || error_robust > 0.25 * error) {
+      std::cerr << "The robust estimation does not reduce the influence of the outliers" << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (intrinsicsError(cal_robust_dense[0].cam, cal_robust_sparse[0].cam) > tolerance ||
+        ! checkPoses(cal_robust_sparse, getPoses(cal_robust_dense, false), false, tolerance, "Robust sparse / dense solvers"))
+      return EXIT_FAILURE;
+  }
+  catch(const vpException &e) {
+    std::cerr << "Catch an exception: " << e.getStringMessage() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "testCalibrationSparse is ok." << std::endl;
+  return EXIT_SUCCESS;
+}
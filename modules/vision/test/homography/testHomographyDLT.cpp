@@ -0,0 +1,146 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2017 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * Description:
+ * Test homography estimation from normal equations.
+ *
+ *****************************************************************************/
+
+/*!
+  \file testHomographyDLT.cpp
+  \brief Compare the homographies estimated by vpHomography::fastDLT() and
+  vpHomography::batchDLT() with the ones estimated by vpHomography::DLT().
+*/
+
+/*!
+  \example testHomographyDLT.cpp
+*/
+
+#include <iostream>
+#include <limits>
+#include <stdlib.h>
+
+#include <visp3/core/vpMath.h>
+#include <visp3/core/vpTime.h>
+#include <visp3/vision/vpHomography.h>
+
+namespace
+{
+bool compare(const std::string &s, const vpHomography &H, const vpHomography &Href, double threshold)
+{
+  // Homographies are defined up to a scale factor
+  vpHomography Hn = H / H[2][2];
+  vpHomography Hrefn = Href / Href[2][2];
+  double error = 0;
+  for (unsigned int i=0; i<9; i++)
+    error = std::max(error, std::fabs(Hn.data[i]-Hrefn.data[i]));
+
+  if (error > threshold) {
+    std::cout << s << ": max error " << error << " above " << threshold << std::endl;
+    std::cout << "H:\n" << Hn << "\nreference:\n" << Hrefn << std::endl;
+    return false;
+  }
+  return true;
+}
+}
+
+int main()
+{
+  try {
+    vpHomography aHb;
+    aHb[0][0] = 1.1;  aHb[0][1] = 0.05; aHb[0][2] = 0.1;
+    aHb[1][0] = -0.08; aHb[1][1] = 0.95; aHb[1][2] = -0.05;
+    aHb[2][0] = 0.1;  aHb[2][1] = -0.15; aHb[2][2] = 1.;
+
+    srand(0);
+    unsigned int n = 200;
+    std::vector<double> xa(n), ya(n), xb(n), yb(n);
+    for (unsigned int i=0; i<n; i++) {
+      xb[i] = (double)rand()/RAND_MAX - 0.5;
+      yb[i] = (double)rand()/RAND_MAX - 0.5;
+      double w = aHb[2][0]*xb[i] + aHb[2][1]*yb[i] + aHb[2][2];
+      xa[i] = (aHb[0][0]*xb[i] + aHb[0][1]*yb[i] + aHb[0][2]) / w + 1e-4*((double)rand()/RAND_MAX - 0.5);
+      ya[i] = (aHb[1][0]*xb[i] + aHb[1][1]*yb[i] + aHb[1][2]) / w + 1e-4*((double)rand()/RAND_MAX - 0.5);
+    }
+
+    vpHomography H_dlt, H_fast, H_float;
+    vpHomography::DLT(xb, yb, xa, ya, H_dlt, true);
+    vpHomography::fastDLT(xb, yb, xa, ya, H_fast);
+    vpHomography::fastDLT(xb, yb, xa, ya, H_float, true);
+
+    if (! compare("fastDLT() double", H_fast, H_dlt, 1e-9))
+      return EXIT_FAILURE;
+    if (! compare("fastDLT() float", H_float, H_dlt, 1e-3))
+      return EXIT_FAILURE;
+
+    // Minimal 4 points subsets as for RANSAC hypotheses, plus a degenerate one
+    unsigned int nbSubsets = 1000;
+    std::vector<unsigned int> subsets;
+    for (unsigned int k=0; k<nbSubsets; k++) {
+      for (unsigned int i=0; i<4; i++)
+        subsets.push_back((4*k + i*37) % n);
+    }
+    subsets.push_back(0); subsets.push_back(0); subsets.push_back(1); subsets.push_back(1);
+
+    double t = vpTime::measureTimeMs();
+    std::vector<vpHomography> H_batch;
+    std::vector<bool> success;
+    vpHomography::batchDLT(xb, yb, xa, ya, subsets, 4, H_batch, success);
+    t = vpTime::measureTimeMs() - t;
+    std::cout << "batchDLT() on " << nbSubsets+1 << " subsets: " << t << " ms" << std::endl;
+
+    if (H_batch.size() != nbSubsets+1 || success.size() != nbSubsets+1 || success[nbSubsets]) {
+      std::cout << "batchDLT() should fail on the degenerate subset" << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    t = vpTime::measureTimeMs();
+    for (unsigned int k=0; k<nbSubsets; k++) {
+      std::vector<double> xa_(4), ya_(4), xb_(4), yb_(4);
+      for (unsigned int i=0; i<4; i++) {
+        unsigned int idx = subsets[4*k+i];
+        xa_[i] = xa[idx]; ya_[i] = ya[idx]; xb_[i] = xb[idx]; yb_[i] = yb[idx];
+      }
+      vpHomography H;
+      vpHomography::DLT(xb_, yb_, xa_, ya_, H, true);
+      if (! success[k] || ! compare("batchDLT()", H_batch[k], H, 1e-6))
+        return EXIT_FAILURE;
+    }
+    t = vpTime::measureTimeMs() - t;
+    std::cout << "DLT() on " << nbSubsets << " subsets: " << t << " ms" << std::endl;
+
+    std::cout << "All tests succeed" << std::endl;
+    return EXIT_SUCCESS;
+  }
+  catch(vpException &e) {
+    std::cout << "Catch an exception: " << e << std::endl;
+    return EXIT_FAILURE;
+  }
+}
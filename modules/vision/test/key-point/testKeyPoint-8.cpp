@@ -0,0 +1,186 @@
+/****************************************************************************
+ *
+ * This file is part of the ViSP software.
+ * Copyright (C) 2005 - 2017 by Inria. All rights reserved.
+ *
+ * This software is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * See the file LICENSE.txt at the root directory of this source
+ * distribution for additional information about the GNU GPL.
+ *
+ * For using ViSP with software that can not be combined with the GNU
+ * GPL, please contact Inria about acquiring a ViSP Professional
+ * Edition License.
+ *
+ * See http://visp.inria.fr for more information.
+ *
+ * This software was developed at:
+ * Inria Rennes - Bretagne Atlantique
+ * Campus Universitaire de Beaulieu
+ * 35042 Rennes Cedex
+ * France
+ *
+ * If you have questions regarding the use of this file, please contact
+ * Inria at visp@inria.fr
+ *
+ * This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+ * WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * Description:
+ * Test the keypoints budget of vpKeyPoint::detect().
+ *
+ *****************************************************************************/
+
+/*!
+  \example testKeyPoint-8.cpp
+
+  Test the grid bucketing (setDetectionGrid()) and the total keypoints budget
+  (setMaxFeatures()) of vpKeyPoint::detect() on a synthetic image: each cell
+  keeps its keypoints with the highest response up to the per cell cap, and
+  the total budget keeps the best keypoint of each cell first.
+*/
+
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+#include <visp3/core/vpConfig.h>
+
+#if defined(VISP_HAVE_OPENCV) && (VISP_HAVE_OPENCV_VERSION >= 0x020301)
+
+#include <visp3/core/vpImage.h>
+#include <visp3/vision/vpKeyPoint.h>
+
+namespace {
+  const unsigned int nbRows = 4;
+  const unsigned int nbCols = 4;
+
+  // Blocks of pseudo random intensities, with many corners everywhere in the image
+  void createImage(vpImage<unsigned char> &I) {
+    I.resize(240, 320);
+    for (unsigned int i = 0; i < I.getHeight(); i++) {
+      for (unsigned int j = 0; j < I.getWidth(); j++) {
+        unsigned int bi = i / 8, bj = j / 8;
+        I[i][j] = (unsigned char) ((bi * 7919 + bj * 104729 + bi * bj * 31) % 256);
+      }
+    }
+  }
+
+  // Responses of the keypoints of each cell of the grid, by decreasing order
+  std::vector<std::vector<float> > getCellResponses(const std::vector<cv::KeyPoint> &keyPoints,
+                                                    const vpImage<unsigned char> &I) {
+    std::vector<std::vector<float> > responses(nbRows * nbCols);
+    double cellHeight = (double) I.getHeight() / nbRows, cellWidth = (double) I.getWidth() / nbCols;
+    for (size_t i = 0; i < keyPoints.size(); i++) {
+      int row = (std::max)(0, (std::min)((int) (keyPoints[i].pt.y / cellHeight), (int) nbRows - 1));
+      int col = (std::max)(0, (std::min)((int) (keyPoints[i].pt.x / cellWidth), (int) nbCols - 1));
+      responses[(size_t) row * nbCols + (size_t) col].push_back(keyPoints[i].response);
+    }
+    for (size_t i = 0; i < responses.size(); i++) {
+      std::sort(responses[i].begin(), responses[i].end(), std::greater<float>());
+    }
+    return responses;
+  }
+}
+
+int main() {
+  try {
+    vpImage<unsigned char> I;
+    createImage(I);
+
+    vpKeyPoint keypoints("FAST", "ORB", "BruteForce-Hamming");
+    std::vector<cv::KeyPoint> allKeyPoints, keyPoints;
+    keypoints.detect(I, allKeyPoints);
+    std::vector<std::vector<float> > allResponses = getCellResponses(allKeyPoints, I);
+    for (size_t i = 0; i < allResponses.size(); i++) {
+      if (allResponses[i].size() < 4) {
+        std::cerr << "Not enough keypoints detected in the cell " << i << " of the synthetic image" << std::endl;
+        return -1;
+      }
+    }
+
+    // Per cell cap: the 3 keypoints with the highest response of each cell are kept
+    const unsigned int maxPerCell = 3;
+    keypoints.setDetectionGrid(nbRows, nbCols, maxPerCell);
+    keypoints.detect(I, keyPoints);
+    if (keyPoints.size() != nbRows * nbCols * maxPerCell) {
+      std::cerr << "Per cell cap: " << keyPoints.size() << " keypoints instead of " << nbRows * nbCols * maxPerCell
+                << std::endl;
+      return -1;
+    }
+    std::vector<std::vector<float> > responses = getCellResponses(keyPoints, I);
+    for (size_t i = 0; i < responses.size(); i++) {
+      if (! std::equal(responses[i].begin(), responses[i].end(), allResponses[i].begin()) ||
+          responses[i].size() != maxPerCell) {
+        std::cerr << "Per cell cap: cell " << i << " does not keep its best keypoints" << std::endl;
+        return -1;
+      }
+    }
+
+    // Total budget: each cell keeps its best keypoint before any cell keeps its second one
+    const int maxFeatures = 20;
+    keypoints.setMaxFeatures(maxFeatures);
+    keypoints.detect(I, keyPoints);
+    if (keyPoints.size() != (size_t) maxFeatures) {
+      std::cerr << "Total budget: " << keyPoints.size() << " keypoints instead of " << maxFeatures << std::endl;
+      return -1;
+    }
+    responses = getCellResponses(keyPoints, I);
+    for (size_t i = 0; i < responses.size(); i++) {
+      if (responses[i].empty() || responses[i].size() > 2 ||
+          ! std::equal(responses[i].begin(), responses[i].end(), allResponses[i].begin())) {
+        std::cerr << "Total budget: cell " << i << " keeps " << responses[i].size() << " keypoints" << std::endl;
+        return -1;
+      }
+    }
+
+    // Total budget without grid: the keypoints with the highest response are kept
+    keypoints.setDetectionGrid(1, 1, 0);
+    keypoints.detect(I, keyPoints);
+    std::vector<float> bestResponses, keptResponses;
+    for (size_t i = 0; i < allKeyPoints.size(); i++)
+      bestResponses.push_back(allKeyPoints[i].response);
+    std::sort(bestResponses.begin(), bestResponses.end(), std::greater<float>());
+    for (size_t i = 0; i < keyPoints.size(); i++)
+      keptResponses.push_back(keyPoints[i].response);
+    std::sort(keptResponses.begin(), keptResponses.end(), std::greater<float>());
+    if (keptResponses.size() != (size_t) maxFeatures ||
+        ! std::equal(keptResponses.begin(), keptResponses.end(), bestResponses.begin())) {
+      std::cerr << "Total budget without grid: the best keypoints are not kept" << std::endl;
+      return -1;
+    }
+
+    // A budget of 0 keypoints
+    keypoints.setMaxFeatures(0);
+    keypoints.detect(I, keyPoints);
+    if (! keyPoints.empty()) {
+      std::cerr << "Budget of 0 keypoints: " << keyPoints.size() << " keypoints returned" << std::endl;
+      return -1;
+    }
+
+    // No budget
+    keypoints.setMaxFeatures(-1);
+    keypoints.detect(I, keyPoints);
+    if (keyPoints.size() != allKeyPoints.size()) {
+      std::cerr << "No budget: " << keyPoints.size() << " keypoints instead of " << allKeyPoints.size() << std::endl;
+      return -1;
+    }
+  } catch(vpException &e) {
+    std::cerr << e.what() << std::endl;
+    return -1;
+  }
+
+  std::cout << "testKeyPoint-8 is ok !" << std::endl;
+  return 0;
+}
+#else
+int main() {
+  std::cerr << "You need OpenCV library." << std::endl;
+
+  return 0;
+}
+
+#endif